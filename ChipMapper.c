@@ -8,75 +8,76 @@
 
 bool OpenedFM = false;
 
-void chip_reg_write(UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT8 Offset,
+// ChipInf is the handle returned by the chip's device_start function
+void chip_reg_write(UINT8 ChipType, void *ChipInf, UINT8 Port, UINT8 Offset,
                     UINT8 Data) {
-  if (ChipID > 1)
+  if (ChipInf == NULL)
     return;
   switch (ChipType) {
   case 0x00: // SN76496
-    sn764xx_w(ChipID, Port, Data);
+    sn764xx_w(ChipInf, Port, Data);
     break;
   case 0x01: // YM2413
-    ym2413_w(ChipID, 0, Offset);
-    ym2413_w(ChipID, 1, Data);
+    ym2413_w(ChipInf, 0, Offset);
+    ym2413_w(ChipInf, 1, Data);
     break;
   case 0x02: // YM2151
-    ym2151_w(ChipID, 0, Offset);
-    ym2151_w(ChipID, 1, Data);
+    ym2151_w(ChipInf, 0, Offset);
+    ym2151_w(ChipInf, 1, Data);
     break;
   case 0x03: // YM3812
-    ym3812_w(ChipID, 0, Offset);
-    ym3812_w(ChipID, 1, Data);
+    ym3812_w(ChipInf, 0, Offset);
+    ym3812_w(ChipInf, 1, Data);
     break;
   case 0x04: // YM3526
-    ym3526_w(ChipID, 0, Offset);
-    ym3526_w(ChipID, 1, Data);
+    ym3526_w(ChipInf, 0, Offset);
+    ym3526_w(ChipInf, 1, Data);
     break;
   case 0x05: // Y8950
-    y8950_w(ChipID, 0, Offset);
-    y8950_w(ChipID, 1, Data);
+    y8950_w(ChipInf, 0, Offset);
+    y8950_w(ChipInf, 1, Data);
     break;
   case 0x06: // YMF262
-    ymf262_w(ChipID, (Port << 1) | 0, Offset);
-    ymf262_w(ChipID, (Port << 1) | 1, Data);
+    ymf262_w(ChipInf, (Port << 1) | 0, Offset);
+    ymf262_w(ChipInf, (Port << 1) | 1, Data);
     break;
   case 0x07: // YMF278B
-    ymf278b_w(ChipID, (Port << 1) | 0, Offset);
-    ymf278b_w(ChipID, (Port << 1) | 1, Data);
+    ymf278b_w(ChipInf, (Port << 1) | 0, Offset);
+    ymf278b_w(ChipInf, (Port << 1) | 1, Data);
     break;
   case 0x08: // AY8910
-    ayxx_w(ChipID, 0, Offset);
-    ayxx_w(ChipID, 1, Data);
+    ayxx_w(ChipInf, 0, Offset);
+    ayxx_w(ChipInf, 1, Data);
     break;
   case 0x09: // K051649 (SCC)
-    k051649_w(ChipID, (Port << 1) | 0, Offset);
-    k051649_w(ChipID, (Port << 1) | 1, Data);
+    k051649_w(ChipInf, (Port << 1) | 0, Offset);
+    k051649_w(ChipInf, (Port << 1) | 1, Data);
     break;
   }
 }
 
-void chip_reg_write_ext(UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT16 Offset,
-                        UINT8 Data) {
-  chip_reg_write(ChipType, ChipID, Port, (UINT8)Offset, Data);
+void chip_reg_write_ext(UINT8 ChipType, void *ChipInf, UINT8 Port,
+                        UINT16 Offset, UINT8 Data) {
+  chip_reg_write(ChipType, ChipInf, Port, (UINT8)Offset, Data);
 }
 
-extern UINT8 ym3812_r(UINT8 ChipID, offs_t offset);
-extern UINT8 ym3526_r(UINT8 ChipID, offs_t offset);
-extern UINT8 y8950_r(UINT8 ChipID, offs_t offset);
-extern UINT8 ymf262_r(UINT8 ChipID, offs_t offset);
+extern UINT8 ym3812_r(void *param, offs_t offset);
+extern UINT8 ym3526_r(void *param, offs_t offset);
+extern UINT8 y8950_r(void *param, offs_t offset);
+extern UINT8 ymf262_r(void *param, offs_t offset);
 
-UINT8 chip_reg_read(UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT8 Offset) {
-  if (ChipID > 1)
+UINT8 chip_reg_read(UINT8 ChipType, void *ChipInf, UINT8 Port, UINT8 Offset) {
+  if (ChipInf == NULL)
     return 0xFF;
   switch (ChipType) {
   case 0x03: // YM3812
-    return ym3812_r(ChipID, 0);
+    return ym3812_r(ChipInf, 0);
   case 0x04: // YM3526
-    return ym3526_r(ChipID, 0);
+    return ym3526_r(ChipInf, 0);
   case 0x05: // Y8950
-    return y8950_r(ChipID, 0);
+    return y8950_r(ChipInf, 0);
   case 0x06: // YMF262
-    return ymf262_r(ChipID, (Port << 1) | 0);
+    return ymf262_r(ChipInf, (Port << 1) | 0);
   default:
     return 0xFF;
   }
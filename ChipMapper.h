@@ -9,7 +9,7 @@ void open_real_fm(void);
 void reset_real_fm(void);
 void setup_real_fm(UINT8 ChipType, UINT8 ChipID);
 void close_real_fm(void);
-void chip_reg_write(UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT8 Offset,
+void chip_reg_write(UINT8 ChipType, void *ChipInf, UINT8 Port, UINT8 Offset,
                     UINT8 Data);
 void OPL_Hardware_Detecton(void);
 void OPL_HW_WriteReg(UINT16 Reg, UINT8 Data);
@@ -23,6 +23,15 @@
 
 #include <zlib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2 mix bus kernels
+#if defined(__GNUC__) && !defined(__clang__)
+// SSE4.1/AVX2 kernels are compiled per function and selected at runtime
+#define SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+#endif
+
 #define FUINT8 unsigned int
 #define FUINT16 unsigned int
 
@@ -35,62 +44,22 @@
 
 #include "ChipMapper.h"
 
-typedef void (*strm_func)(UINT8 ChipID, stream_sample_t **outputs, int samples);
-
-typedef struct chip_audio_attributes CAUD_ATTR;
-struct chip_audio_attributes {
-  UINT32 SmpRate;
-  UINT16 Volume;
-  UINT8 ChipType;
-  UINT8 ChipID; // 0 - 1st chip, 1 - 2nd chip, etc.
-  // Resampler Type:
-  //	00 - Old
-  //	01 - Upsampling
-  //	02 - Copy
-  //	03 - Downsampling
-  UINT8 Resampler;
-  strm_func StreamUpdate;
-  UINT32 SmpP;     // Current Sample (Playback Rate)
-  UINT32 SmpLast;  // Sample Number Last
-  UINT32 SmpNext;  // Sample Number Next
-  WAVE_32BS LSmpl; // Last Sample
-  WAVE_32BS NSmpl; // Next Sample
-  CAUD_ATTR *Paired;
-};
-
-typedef struct chip_audio_struct {
-  CAUD_ATTR SN76496;
-  CAUD_ATTR YM2413;
-  CAUD_ATTR YM2151;
-  CAUD_ATTR YM3812;
-  CAUD_ATTR YM3526;
-  CAUD_ATTR Y8950;
-  CAUD_ATTR YMF262;
-  CAUD_ATTR YMF278B;
-  CAUD_ATTR AY8910;
-  CAUD_ATTR K051649;
-} CHIP_AUDIO;
-
-typedef struct chip_aud_list CA_LIST;
-struct chip_aud_list {
-  CAUD_ATTR *CAud;
-  CHIP_OPTS *COpts;
-  CA_LIST *next;
+// Event Types (00..09 are chip writes, the value is the chip type)
+#define VGMEVT_CMD 0x80  // execute the command at Pos (data blocks, DAC Ctrl)
+#define VGMEVT_END 0x81  // end of sound data / loop point (0x66)
+#define VGMEVT_EOF 0x82  // end of file reached without 0x66
+#define VGMEVT_STOP 0x83 // unknown command - stop playback
+
+struct vgm_event {
+  UINT32 Smpl; // absolute sample timestamp (without loops)
+  UINT32 Pos;  // file offset of the command
+  UINT8 Type;
+  UINT8 ChipID;
+  UINT8 Port;
+  UINT8 Reg;
+  UINT8 Data;
 };
 
-typedef struct daccontrol_data {
-  bool Enable;
-  UINT8 Bank;
-} DACCTRL_DATA;
-
-typedef struct pcmbank_table {
-  UINT8 ComprType;
-  UINT8 CmpSubType;
-  UINT8 BitDec;
-  UINT8 BitCmp;
-  UINT16 EntryCount;
-  void *Entries;
-} PCMBANK_TBL;
 
 
 INLINE UINT16 ReadLE16(const UINT8 *Data);
@@ -101,57 +70,100 @@ INLINE int gzgetLE16(gzFile hFile, UINT16 *RetValue);
 INLINE int gzgetLE32(gzFile hFile, UINT32 *RetValue);
 static UINT32 gcd(UINT32 x, UINT32 y);
 static UINT32 GetGZFileLength_Internal(FILE *hFile);
-static bool OpenVGMFile_Internal(gzFile hFile, UINT32 FileSize);
+static bool OpenVGMFile_Internal(VGM_PLAYER *Player, gzFile hFile,
+                                 UINT32 FileSize);
 static void ReadVGMHeader(gzFile hFile, VGM_HEADER *RetVGMHead);
 static UINT8 ReadGD3Tag(gzFile hFile, UINT32 GD3Offset, GD3_TAG *RetGD3Tag);
-static void ReadChipExtraData32(UINT32 StartOffset, VGMX_CHP_EXTRA32 *ChpExtra);
-static void ReadChipExtraData16(UINT32 StartOffset, VGMX_CHP_EXTRA16 *ChpExtra);
+static void ReadChipExtraData32(VGM_PLAYER *Player, UINT32 StartOffset,
+                                VGMX_CHP_EXTRA32 *ChpExtra);
+static void ReadChipExtraData16(VGM_PLAYER *Player, UINT32 StartOffset,
+                                VGMX_CHP_EXTRA16 *ChpExtra);
 static wchar_t *MakeEmptyWStr(void);
 static wchar_t *ReadWStrFromFile(gzFile hFile, UINT32 *FilePos, UINT32 EOFPos);
 static UINT32 GetVGMFileInfo_Internal(gzFile hFile, UINT32 FileSize,
                                       VGM_HEADER *RetVGMHead,
                                       GD3_TAG *RetGD3Tag);
 INLINE UINT32 MulDivRound(UINT64 Number, UINT64 Numerator, UINT64 Denominator);
-static UINT16 GetChipVolume(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 ChipNum,
+static UINT16 GetChipVolume(VGM_PLAYER *Player, UINT8 ChipID, UINT8 ChipNum,
                             UINT8 ChipCnt);
 
-static void RestartPlaying(void);
-static void Chips_GeneralActions(UINT8 Mode);
+static void RestartPlaying(VGM_PLAYER *Player);
+static void Chips_GeneralActions(VGM_PLAYER *Player, UINT8 Mode);
 
-INLINE INT32 SampleVGM2Pbk_I(INT32 SampleVal); // inline functions
-INLINE INT32 SamplePbk2VGM_I(INT32 SampleVal);
+INLINE INT32 SampleVGM2Pbk_I(VGM_PLAYER *Player,
+                             INT32 SampleVal); // inline functions
+INLINE INT32 SamplePbk2VGM_I(VGM_PLAYER *Player, INT32 SampleVal);
 static UINT8 StartThread(void);
 static UINT8 StopThread(void);
-static bool SetMuteControl(bool mute);
-
-static void InterpretFile(UINT32 SampleCount);
-static void AddPCMData(UINT8 Type, UINT32 DataSize, const UINT8 *Data);
-static bool DecompressDataBlk(VGM_PCM_DATA *Bank, UINT32 DataSize,
-                              const UINT8 *Data);
-static UINT8 GetDACFromPCMBank(void);
-static UINT8 *GetPointerFromPCMBank(UINT8 Type, UINT32 DataPos);
-static void ReadPCMTable(UINT32 DataSize, const UINT8 *Data);
-static void InterpretVGM(UINT32 SampleCount);
-
-static void GeneralChipLists(void);
-static void SetupResampler(CAUD_ATTR *CAA);
+static bool SetMuteControl(VGM_PLAYER *Player, bool mute);
+
+static void InterpretFile(VGM_PLAYER *Player, UINT32 SampleCount);
+static void AddPCMData(VGM_PLAYER *Player, UINT8 Type, UINT32 DataSize,
+                       const UINT8 *Data);
+static bool DecompressDataBlk(VGM_PLAYER *Player, VGM_PCM_DATA *Bank,
+                              UINT32 DataSize, const UINT8 *Data);
+static UINT8 *GetPointerFromPCMBank(VGM_PLAYER *Player, UINT8 Type,
+                                    UINT32 DataPos);
+static void ReadPCMTable(VGM_PLAYER *Player, UINT32 DataSize,
+                         const UINT8 *Data);
+static UINT32 AddVGMEvent(VGM_PLAYER *Player, UINT32 Smpl, UINT32 Pos,
+                          UINT8 Type, UINT8 ChipID, UINT8 Port, UINT8 Reg,
+                          UINT8 Data);
+static void CompileVGMEvents(VGM_PLAYER *Player);
+static void InterpretVGMCmd(VGM_PLAYER *Player, UINT32 CmdPos);
+static void InterpretVGM(VGM_PLAYER *Player, UINT32 SampleCount);
+static UINT32 SaveChipStates(VGM_PLAYER *Player, UINT8 *Data);
+static UINT32 LoadChipStates(VGM_PLAYER *Player, const UINT8 *Data);
+static void SaveSeekKey(VGM_PLAYER *Player, UINT32 PbkPos);
+static UINT32 CopySincHist(VGM_PLAYER *Player, UINT8 *Data, bool Restore);
+static void LoadSeekKey(VGM_PLAYER *Player, const SEEK_KEY *Key);
+static void FreeSeekKeys(VGM_PLAYER *Player);
+
+static CA_LIST *GroupChipList(bool PauseList, UINT16 *BufIdx);
+static void GeneralChipLists(VGM_PLAYER *Player);
+static void SetupResampler(VGM_PLAYER *Player, CAUD_ATTR *CAA);
+static double SincSin(double x);
+static SINC_FILTER *GetSincFilter(UINT32 InRate, UINT32 OutRate);
 
 INLINE INT16 Limit2Short(INT32 Value);
-static void null_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
-static void dual_opl2_stereo(UINT8 ChipID, stream_sample_t **outputs,
-                             int samples);
-static void ResampleChipStream(CA_LIST *CLst, WAVE_32BS *RetSample,
-                               UINT32 Length);
-static INT32 RecalcFadeVolume(void);
+static void null_update(void *param, stream_sample_t **outputs, int samples);
+static void dual_opl2_left(void *param, stream_sample_t **outputs, int samples);
+static void dual_opl2_right(void *param, stream_sample_t **outputs,
+                            int samples);
+static void UpdateChipGroup(VGM_PLAYER *Player, CA_LIST *CLst,
+                            stream_sample_t **Outputs, UINT32 Length);
+static void ResampleChipStream(VGM_PLAYER *Player, CA_LIST *CLst,
+                               INT32 **RetSample, UINT32 Length);
+static UINT8 GetCPUSimdLevel(void);
+static void SetupSimdKernels(void);
+static INT32 RecalcFadeVolume(VGM_PLAYER *Player);
+static UINT32 GetEventDelay(VGM_PLAYER *Player);
+typedef struct chip_task CHIP_TASK;
+typedef struct render_window RENDER_WINDOW;
+typedef struct resampler_pos RESMPL_POS;
+static CHIP_WORKERS *StartChipWorkers(UINT32 ThreadCount);
+static void StopChipWorkers(CHIP_WORKERS *CW);
+static void *ChipWorkerThread(void *Arg);
+static void RunChipTasks(CHIP_WORKERS *CW);
+static void RunChipTask(const RENDER_WINDOW *Win, const CHIP_TASK *Task);
+static UINT32 AdvanceGroupPos(const CAUD_ATTR *CAA, RESMPL_POS *Pos,
+                              UINT32 Length);
+static void QueueChipWrite(VGM_PLAYER *Player, const VGM_EVENT *Evt);
+static void QueueSegment(VGM_PLAYER *Player, WAVE_16BS *Buffer, UINT32 BufPos,
+                         UINT32 Length, INT32 MstVol);
+static void SubmitWindow(VGM_PLAYER *Player);
+static void FinishWindow(VGM_PLAYER *Player);
+static void DrainChipQueues(VGM_PLAYER *Player);
+static void RenderSegment(VGM_PLAYER *Player, WAVE_16BS *Buffer,
+                          UINT32 Length, INT32 MstVol);
 
 UINT64 TimeSpec2Int64(const struct timespec *ts);
+INLINE UINT64 GetProfileTime(void);
 
 UINT32 SampleRate;
 
 UINT32 VGMMaxLoop;
 UINT32 VGMPbRate;
-UINT32 FadeTime;
-UINT32 PauseTime;
 float VolumeLevel;
 bool SurroundSound;
 UINT8 HardStopOldVGMs;
@@ -159,6 +171,10 @@ bool FadeRAWLog;
 bool PauseEmulate;
 bool DoubleSSGVol;
 UINT8 ResampleMode;
+UINT8 SimdLevel;
+bool ProfileRender; // collect ProfileTime in FillBuffer (--bench)
+UINT32 ChipThreads; // threads that render the chips of a song, 0/1 - serial
+bool PSGBlep; // band-limited step synthesis in the AY8910/SN76496 cores
 UINT8 CHIP_SAMPLING_MODE;
 INT32 CHIP_SAMPLE_RATE;
 UINT16 FMPort;
@@ -171,69 +187,58 @@ UINT8 OPL_MODE;
 UINT8 OPL_CHIPS;
 stream_sample_t *DUMMYBUF[0x02] = {NULL, NULL};
 char *AppPaths[8];
-bool AutoStopSkip;
-UINT8 FileMode;
-VGM_HEADER VGMHead;
-VGM_HDR_EXTRA VGMHeadX;
-VGM_EXTRA VGMH_Extra;
-UINT32 VGMDataLen;
-UINT8 *VGMData;
-GD3_TAG VGMTag;
-#define PCM_BANK_COUNT 0x40
-VGM_PCM_BANK PCMBank[PCM_BANK_COUNT];
-PCMBANK_TBL PCMTbl;
-UINT8 DacCtrlUsed;
-UINT8 DacCtrlUsg[0xFF];
-DACCTRL_DATA DacCtrl[0xFF];
-CHIP_AUDIO ChipAudio[0x02];
-CAUD_ATTR CA_Paired[0x02][0x03];
-float MasterVol;
-CA_LIST ChipListBuffer[0x200];
-CA_LIST *ChipListAll;
-CA_LIST *ChipListPause;
-CA_LIST *CurChipList;
+static VGM_PLAYER *StreamPlayer; // the player that renders for StartStream
+// SimdLevel is final once the first song plays
+static pthread_once_t SimdKernelsOnce = PTHREAD_ONCE_INIT;
 
 #define SMPL_BUFSIZE 0x2000
-static INT32 *StreamBufs[0x02];
-
-float VolumeBak;
-// #endif
-
-UINT32 VGMPos;
-INT32 VGMSmplPos;
-INT32 VGMSmplPlayed;
-INT32 VGMSampleRate;
-static UINT32 VGMPbRateMul;
-static UINT32 VGMPbRateDiv;
-static UINT32 VGMSmplRateMul;
-static UINT32 VGMSmplRateDiv;
-static UINT32 PauseSmpls;
-bool VGMEnd;
-bool EndPlay;
-bool PausePlay;
-bool FadePlay;
-bool ForceVGMExec;
-UINT32 PlayingTime;
-UINT32 FadeStart;
-UINT32 VGMMaxLoopM;
-UINT32 VGMCurLoop;
-float VolumeLevelM;
-float FinalVol;
-
-static bool Interpreting;
-
-UINT8 IsVGMInit;
+#define RENDER_BUFSIZE (SMPL_BUFSIZE * 2) // chip output of a render window
+#define MIX_BUFSIZE 0x400
+
+#define SINC_PHASES 0x200
+#define SINC_TAPS 0x20      // filter length for upsampling
+#define SINC_TAPS_MAX 0x100 // filter length limit for downsampling
+#define SINC_CUTOFF 0.45    // passband edge, relative to the lower sample rate
+#define SINC_FLT_COUNT 0x20
+// the filter banks are shared by all players
+static SINC_FILTER SincFilters[SINC_FLT_COUNT];
+static UINT32 SincFltCount;
+static pthread_mutex_t SincFltMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Seek Keyframes - snapshots of the whole playback state, taken every few
+// seconds while playing, so that seeking only needs to interpret the commands
+// from the nearest snapshot on.
+#define SEEKKEY_SECONDS 5
+#define SEEKKEY_MAX 0x400 // about 85 minutes of playback
+struct seek_keyframe {
+  UINT32 PbkPos; // playback sample (including loops)
+  UINT32 VGMPos;
+  UINT32 EvtPos;
+  INT32 SmplOfs;
+  INT32 VGMSmplPos;
+  INT32 VGMSmplPlayed;
+  UINT32 VGMCurLoop;
+  UINT32 PlayingTime;
+  bool FadePlay;
+  UINT32 FadeStart;
+  UINT32 BnkDataPos[PCM_BANK_COUNT];
+  UINT32 BnkPos[PCM_BANK_COUNT];
+  UINT16 PCMTblCount;
+  UINT8 DacCtrlUsed;
+  UINT8 DacCtrlUsg[0xFF];
+  DACCTRL_DATA DacCtrl[0xFF];
+  CHIP_AUDIO ChipAudio[0x02]; // for the resampler state
+  CAUD_ATTR CA_Paired[0x02][0x03];
+  UINT8 *ChipStates; // followed by the sinc resampler histories
+};
 
 void VGMPlay_Init(void) {
   UINT8 CurChip;
   UINT8 CurCSet;
   UINT8 CurChn;
   CHIP_OPTS *TempCOpt;
-  CAUD_ATTR *TempCAud;
 
   SampleRate = 44100;
-  FadeTime = 5000;
-  PauseTime = 0;
 
   HardStopOldVGMs = 0x00;
   FadeRAWLog = false;
@@ -247,14 +252,17 @@ void VGMPlay_Init(void) {
   VGMMaxLoop = 0x02;
   VGMPbRate = 0;
   ResampleMode = 0x00;
+  SimdLevel = SIMD_AUTO;
+  ProfileRender = false;
+  ChipThreads = 0;
+  PSGBlep = true;
   CHIP_SAMPLING_MODE = 0x00;
   CHIP_SAMPLE_RATE = 0x00000000;
   PauseEmulate = false;
   DoubleSSGVol = false;
 
   for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-    TempCAud = (CAUD_ATTR *)&ChipAudio[CurCSet];
-    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, TempCAud++) {
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++) {
       TempCOpt = (CHIP_OPTS *)&ChipOpts[CurCSet] + CurChip;
 
       TempCOpt->Disabled = false;
@@ -265,17 +273,6 @@ void VGMPlay_Init(void) {
       TempCOpt->ChnMute2 = 0x00;
       TempCOpt->ChnMute3 = 0x00;
       TempCOpt->Panning = NULL;
-
-      TempCAud->ChipType = 0xFF;
-      TempCAud->ChipID = CurCSet;
-      TempCAud->Paired = NULL;
-    }
-
-    TempCAud = CA_Paired[CurCSet];
-    for (CurChip = 0x00; CurChip < 0x03; CurChip++, TempCAud++) {
-      TempCAud->ChipType = 0xFF;
-      TempCAud->ChipID = CurCSet;
-      TempCAud->Paired = NULL;
     }
 
     TempCOpt = (CHIP_OPTS *)&ChipOpts[CurCSet].SN76496;
@@ -307,10 +304,6 @@ void VGMPlay_Init(void) {
     AppPaths[CurChn] = NULL;
   AppPaths[0] = "";
 
-  FileMode = 0xFF;
-
-  PausePlay = false;
-
 #ifdef _DEBUG
   if (sizeof(CHIP_AUDIO) != sizeof(CAUD_ATTR) * CHIP_COUNT) {
     fprintf(stderr, "Fatal Error! ChipAudio structure invalid!\n");
@@ -328,14 +321,9 @@ void VGMPlay_Init(void) {
 }
 
 void VGMPlay_Init2(void) {
-
-
-  StreamBufs[0x00] = (INT32 *)malloc(SMPL_BUFSIZE * sizeof(INT32));
-  StreamBufs[0x01] = (INT32 *)malloc(SMPL_BUFSIZE * sizeof(INT32));
-
   if (CHIP_SAMPLE_RATE <= 0)
     CHIP_SAMPLE_RATE = SampleRate;
-  
+
   return;
 }
 
@@ -343,10 +331,10 @@ void VGMPlay_Deinit(void) {
   UINT8 CurChip;
   UINT8 CurCSet;
   CHIP_OPTS *TempCOpt;
-  free(StreamBufs[0x00]);
-  StreamBufs[0x00] = NULL;
-  free(StreamBufs[0x01]);
-  StreamBufs[0x01] = NULL;
+
+  for (CurChip = 0x00; CurChip < SincFltCount; CurChip++)
+    free(SincFilters[CurChip].Coefs);
+  SincFltCount = 0x00;
 
   for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
     for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++) {
@@ -362,6 +350,86 @@ void VGMPlay_Deinit(void) {
   return;
 }
 
+VGM_PLAYER *VGMPlayer_Create(void) {
+  // needs VGMPlay_Init2 to be called first
+  VGM_PLAYER *Player;
+  UINT8 CurChip;
+  UINT8 CurCSet;
+  CAUD_ATTR *TempCAud;
+
+  Player = (VGM_PLAYER *)calloc(1, sizeof(VGM_PLAYER));
+  if (Player == NULL)
+    return NULL;
+
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    Player->StreamBufs[CurCSet] = (INT32 *)malloc(SMPL_BUFSIZE * sizeof(INT32));
+    Player->GroupBufs[CurCSet] = (INT32 *)malloc(SMPL_BUFSIZE * sizeof(INT32));
+    Player->MixBufs[CurCSet] = (INT32 *)malloc(MIX_BUFSIZE * sizeof(INT32));
+    Player->SincBufs[CurCSet] =
+        (float *)malloc((SMPL_BUFSIZE + SINC_TAPS_MAX) * sizeof(float));
+    if (Player->StreamBufs[CurCSet] == NULL ||
+        Player->GroupBufs[CurCSet] == NULL ||
+        Player->MixBufs[CurCSet] == NULL || Player->SincBufs[CurCSet] == NULL) {
+      VGMPlayer_Destroy(Player);
+      return NULL;
+    }
+
+    TempCAud = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, TempCAud++) {
+      TempCAud->ChipType = 0xFF;
+      TempCAud->ChipID = CurCSet;
+    }
+
+    TempCAud = Player->CA_Paired[CurCSet];
+    for (CurChip = 0x00; CurChip < 0x03; CurChip++, TempCAud++) {
+      TempCAud->ChipType = 0xFF;
+      TempCAud->ChipID = CurCSet;
+    }
+  }
+
+  Player->FileMode = 0xFF;
+  Player->PausePlay = false;
+  Player->FadeTime = 5000;
+  Player->PauseTime = 0;
+
+  return Player;
+}
+
+void VGMPlayer_Destroy(VGM_PLAYER *Player) {
+  // the song must be stopped and closed already
+  UINT8 CurChip;
+  UINT8 CurCSet;
+  CAUD_ATTR *TempCAud;
+
+  if (Player == NULL)
+    return;
+
+  if (Player->ChipWork != NULL)
+    StopChipWorkers(Player->ChipWork);
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    free(Player->StreamBufs[CurCSet]);
+    free(Player->GroupBufs[CurCSet]);
+    free(Player->MixBufs[CurCSet]);
+    free(Player->SincBufs[CurCSet]);
+
+    TempCAud = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, TempCAud++) {
+      free(TempCAud->SincHist);
+      free(TempCAud->RenderBufs[0x00]);
+      free(TempCAud->RenderBufs[0x01]);
+    }
+    TempCAud = Player->CA_Paired[CurCSet];
+    for (CurChip = 0x00; CurChip < 0x03; CurChip++, TempCAud++) {
+      free(TempCAud->SincHist);
+      free(TempCAud->RenderBufs[0x00]);
+      free(TempCAud->RenderBufs[0x01]);
+    }
+  }
+  free(Player);
+
+  return;
+}
+
 // Note: Caller must free the returned string.
 char *FindFile(const char *FileName) {
   char *FullName;
@@ -506,163 +574,181 @@ static UINT32 gcd(UINT32 x, UINT32 y) {
   return x << shift;
 }
 
-void PlayVGM(void) {
+void PlayVGM(VGM_PLAYER *Player) {
   UINT8 CurChip;
   INT32 TempSLng;
 
   // PausePlay = false;
-  FadePlay = false;
-  MasterVol = 1.0f;
-  ForceVGMExec = false;
-  AutoStopSkip = false;
-  FadeStart = 0;
-  ForceVGMExec = true;
-
-  if (VGMHead.bytVolumeModifier <= VOLUME_MODIF_WRAP)
-    TempSLng = VGMHead.bytVolumeModifier;
-  else if (VGMHead.bytVolumeModifier == (VOLUME_MODIF_WRAP + 0x01))
+  Player->FadePlay = false;
+  Player->MasterVol = 1.0f;
+  Player->ForceVGMExec = false;
+  Player->AutoStopSkip = false;
+  Player->FadeStart = 0;
+  Player->ForceVGMExec = true;
+
+  if (Player->VGMHead.bytVolumeModifier <= VOLUME_MODIF_WRAP)
+    TempSLng = Player->VGMHead.bytVolumeModifier;
+  else if (Player->VGMHead.bytVolumeModifier == (VOLUME_MODIF_WRAP + 0x01))
     TempSLng = VOLUME_MODIF_WRAP - 0x100;
   else
-    TempSLng = VGMHead.bytVolumeModifier - 0x100;
-  VolumeLevelM = (float)(VolumeLevel * pow(2.0, TempSLng / (double)0x20));
+    TempSLng = Player->VGMHead.bytVolumeModifier - 0x100;
+  Player->VolumeLevelM =
+      (float)(VolumeLevel * pow(2.0, TempSLng / (double)0x20));
   
-  FinalVol = VolumeLevelM;
+  Player->FinalVol = Player->VolumeLevelM;
 
   if (!VGMMaxLoop) {
-    VGMMaxLoopM = 0x00;
+    Player->VGMMaxLoopM = 0x00;
   } else {
-    TempSLng = (VGMMaxLoop * VGMHead.bytLoopModifier + 0x08) / 0x10 -
-               VGMHead.bytLoopBase;
-    VGMMaxLoopM = (TempSLng >= 0x01) ? TempSLng : 0x01;
+    TempSLng = (VGMMaxLoop * Player->VGMHead.bytLoopModifier + 0x08) / 0x10 -
+               Player->VGMHead.bytLoopBase;
+    Player->VGMMaxLoopM = (TempSLng >= 0x01) ? TempSLng : 0x01;
   }
 
-  if (!VGMPbRate || !VGMHead.lngRate) {
-    VGMPbRateMul = 1;
-    VGMPbRateDiv = 1;
+  if (!VGMPbRate || !Player->VGMHead.lngRate) {
+    Player->VGMPbRateMul = 1;
+    Player->VGMPbRateDiv = 1;
   } else {
     // I prefer small Multiplers and Dividers, as they're used very often
-    TempSLng = gcd(VGMHead.lngRate, VGMPbRate);
-    VGMPbRateMul = VGMHead.lngRate / TempSLng;
-    VGMPbRateDiv = VGMPbRate / TempSLng;
+    TempSLng = gcd(Player->VGMHead.lngRate, VGMPbRate);
+    Player->VGMPbRateMul = Player->VGMHead.lngRate / TempSLng;
+    Player->VGMPbRateDiv = VGMPbRate / TempSLng;
   }
-  VGMSmplRateMul = SampleRate * VGMPbRateMul;
-  VGMSmplRateDiv = VGMSampleRate * VGMPbRateDiv;
+  Player->VGMSmplRateMul = SampleRate * Player->VGMPbRateMul;
+  Player->VGMSmplRateDiv = Player->VGMSampleRate * Player->VGMPbRateDiv;
   // same as above - to speed up the VGM <-> Playback calculation
-  TempSLng = gcd(VGMSmplRateMul, VGMSmplRateDiv);
-  VGMSmplRateMul /= TempSLng;
-  VGMSmplRateDiv /= TempSLng;
-
-  PlayingTime = 0;
-  EndPlay = false;
-
-  VGMPos = VGMHead.lngDataOffset;
-  VGMSmplPos = 0;
-  VGMSmplPlayed = 0;
-  VGMEnd = false;
-  VGMCurLoop = 0x00;
-  PauseSmpls = (PauseTime * SampleRate + 500) / 1000;
-  if (VGMPos >= VGMHead.lngEOFOffset)
-    VGMEnd = true;
+  TempSLng = gcd(Player->VGMSmplRateMul, Player->VGMSmplRateDiv);
+  Player->VGMSmplRateMul /= TempSLng;
+  Player->VGMSmplRateDiv /= TempSLng;
+
+  Player->PlayingTime = 0;
+  Player->EndPlay = false;
+
+  Player->VGMPos = Player->VGMHead.lngDataOffset;
+  Player->VGMEvtPos = 0x00;
+  Player->VGMSmplOfs = 0;
+  Player->VGMSmplPos = Player->VGMEvts[0x00].Smpl;
+  Player->VGMSmplPlayed = 0;
+  Player->VGMEnd = false;
+  Player->VGMCurLoop = 0x00;
+  Player->PauseSmpls = (Player->PauseTime * SampleRate + 500) / 1000;
+  if (Player->VGMPos >= Player->VGMHead.lngEOFOffset)
+    Player->VGMEnd = true;
 
 #ifdef CONSOLE_MODE
   memset(CmdList, 0x00, 0x100 * sizeof(UINT8));
 #endif
 
-  if (!PauseEmulate) {
-      PauseStream(PausePlay);
+  if (!PauseEmulate && Player == StreamPlayer) {
+      PauseStream(Player->PausePlay);
   }
 
-  Chips_GeneralActions(0x00); // Start chips
+  Chips_GeneralActions(Player, 0x00); // Start chips
   // also does Reset (0x01), Muting Mask (0x10) and Panning (0x20)
+  FreeSeekKeys(Player); // the snapshots belong to the previous chip instances
 }
 
-void StopVGM(void) {
+void StopVGM(VGM_PLAYER *Player) {
 
-  Chips_GeneralActions(0x02); // Stop chips
+  Chips_GeneralActions(Player, 0x02); // Stop chips
+  FreeSeekKeys(Player);
 
   return;
 }
 
-void RestartVGM(void) {
-  if (!VGMSmplPlayed)
+void RestartVGM(VGM_PLAYER *Player) {
+  if (!Player->VGMSmplPlayed)
     return;
 
-  RestartPlaying();
+  RestartPlaying(Player);
 
   return;
 }
 
-void PauseVGM(bool Pause) {
-  if (Pause == PausePlay)
+void PauseVGM(VGM_PLAYER *Player, bool Pause) {
+  if (Pause == Player->PausePlay)
     return;
 
 
-  if (!PauseEmulate) {
+  if (!PauseEmulate && Player == StreamPlayer) {
     PauseStream(Pause);
   }
-  PausePlay = Pause;
+  Player->PausePlay = Pause;
 
   return;
 }
 
-void SeekVGM(bool Relative, INT32 PlayBkSamples) {
+void SeekVGM(VGM_PLAYER *Player, bool Relative, INT32 PlayBkSamples) {
   INT32 Samples;
   UINT32 LoopSmpls;
+  INT32 DstPos;
+  UINT32 CurKey;
 
   if (Relative && !PlayBkSamples)
     return;
 
-  LoopSmpls = VGMCurLoop * SampleVGM2Pbk_I(VGMHead.lngLoopSamples);
+  LoopSmpls = Player->VGMCurLoop *
+              SampleVGM2Pbk_I(Player, Player->VGMHead.lngLoopSamples);
   if (!Relative)
-    Samples = PlayBkSamples - (LoopSmpls + VGMSmplPlayed);
+    Samples = PlayBkSamples - (LoopSmpls + Player->VGMSmplPlayed);
   else
     Samples = PlayBkSamples;
 
-  if (Samples < 0) {
-    Samples = LoopSmpls + VGMSmplPlayed + Samples;
-    if (Samples < 0)
-      Samples = 0;
-    RestartPlaying();
+  DstPos = (INT32)(LoopSmpls + Player->VGMSmplPlayed) + Samples;
+  if (DstPos < 0)
+    DstPos = 0;
+  // find the last snapshot before the destination
+  CurKey = Player->SeekKeyCount;
+  while (CurKey && Player->SeekKeys[CurKey - 1].PbkPos > (UINT32)DstPos)
+    CurKey--;
+  if (CurKey && (Samples < 0 || Player->SeekKeys[CurKey - 1].PbkPos >
+                                    LoopSmpls + Player->VGMSmplPlayed)) {
+    LoadSeekKey(Player, &Player->SeekKeys[CurKey - 1]);
+    Samples = DstPos - Player->SeekKeys[CurKey - 1].PbkPos;
+  } else if (Samples < 0) {
+    Samples = DstPos;
+    RestartPlaying(Player);
   }
 
-  ForceVGMExec = true;
-  InterpretFile(Samples);
-  ForceVGMExec = false;
+  Player->ForceVGMExec = true;
+  InterpretFile(Player, Samples);
+  Player->ForceVGMExec = false;
 #ifdef CONSOLE_MODE
-  if (FadePlay && FadeStart)
-    FadeStart += Samples;
+  if (Player->FadePlay && Player->FadeStart)
+    Player->FadeStart += Samples;
 #endif
 
   return;
 }
 
-void RefreshMuting(void) {
-  Chips_GeneralActions(0x10); // set muting mask
+void RefreshMuting(VGM_PLAYER *Player) {
+  Chips_GeneralActions(Player, 0x10); // set muting mask
 
   return;
 }
 
-void RefreshPanning(void) {
-  Chips_GeneralActions(0x20); // set panning
+void RefreshPanning(VGM_PLAYER *Player) {
+  Chips_GeneralActions(Player, 0x20); // set panning
 
   return;
 }
 
-void RefreshPlaybackOptions(void) {
+void RefreshPlaybackOptions(VGM_PLAYER *Player) {
   INT32 TempVol;
   UINT8 CurChip;
   CHIP_OPTS *TempCOpt1;
   CHIP_OPTS *TempCOpt2;
 
-  if (VGMHead.bytVolumeModifier <= VOLUME_MODIF_WRAP)
-    TempVol = VGMHead.bytVolumeModifier;
-  else if (VGMHead.bytVolumeModifier == (VOLUME_MODIF_WRAP + 0x01))
+  if (Player->VGMHead.bytVolumeModifier <= VOLUME_MODIF_WRAP)
+    TempVol = Player->VGMHead.bytVolumeModifier;
+  else if (Player->VGMHead.bytVolumeModifier == (VOLUME_MODIF_WRAP + 0x01))
     TempVol = VOLUME_MODIF_WRAP - 0x100;
   else
-    TempVol = VGMHead.bytVolumeModifier - 0x100;
-  VolumeLevelM = (float)(VolumeLevel * pow(2.0, TempVol / (double)0x20));
+    TempVol = Player->VGMHead.bytVolumeModifier - 0x100;
+  Player->VolumeLevelM =
+      (float)(VolumeLevel * pow(2.0, TempVol / (double)0x20));
 
-  FinalVol = VolumeLevelM * MasterVol;
+  Player->FinalVol = Player->VolumeLevelM * Player->MasterVol;
 
   // PauseSmpls = (PauseTime * SampleRate + 500) / 1000;
 
@@ -712,7 +798,7 @@ static UINT32 GetGZFileLength_Internal(FILE *hFile) {
   return FileSize;
 }
 
-bool OpenVGMFile(const char *FileName) {
+bool OpenVGMFile(VGM_PLAYER *Player, const char *FileName) {
   gzFile hFile;
   UINT32 FileSize;
   bool RetVal;
@@ -723,13 +809,14 @@ bool OpenVGMFile(const char *FileName) {
   if (hFile == NULL)
     return false;
 
-  RetVal = OpenVGMFile_Internal(hFile, FileSize);
+  RetVal = OpenVGMFile_Internal(Player, hFile, FileSize);
 
   gzclose(hFile);
   return RetVal;
 }
 
-static bool OpenVGMFile_Internal(gzFile hFile, UINT32 FileSize) {
+static bool OpenVGMFile_Internal(VGM_PLAYER *Player, gzFile hFile,
+                                 UINT32 FileSize) {
   UINT32 fccHeader;
   UINT32 CurPos;
   UINT32 HdrLimit;
@@ -740,16 +827,16 @@ static bool OpenVGMFile_Internal(gzFile hFile, UINT32 FileSize) {
   if (fccHeader != FCC_VGM)
     return false;
 
-  if (FileMode != 0xFF)
-    CloseVGMFile();
+  if (Player->FileMode != 0xFF)
+    CloseVGMFile(Player);
 
-  FileMode = 0x00;
-  VGMDataLen = FileSize;
+  Player->FileMode = 0x00;
+  Player->VGMDataLen = FileSize;
 
   gzseek(hFile, 0x00, SEEK_SET);
   // gzrewind(hFile);
-  ReadVGMHeader(hFile, &VGMHead);
-  if (VGMHead.fccVGM != FCC_VGM) {
+  ReadVGMHeader(hFile, &Player->VGMHead);
+  if (Player->VGMHead.fccVGM != FCC_VGM) {
     fprintf(stderr, "VGM signature matched on the first read, but not on the "
                     "second one!\n");
     fprintf(stderr, "This is a known zlib bug where gzseek fails. Please "
@@ -757,79 +844,85 @@ static bool OpenVGMFile_Internal(gzFile hFile, UINT32 FileSize) {
     return false;
   }
 
-  VGMSampleRate = 44100;
-  if (!VGMDataLen)
-    VGMDataLen = VGMHead.lngEOFOffset;
-  if (!VGMHead.lngEOFOffset || VGMHead.lngEOFOffset > VGMDataLen) {
+  Player->VGMSampleRate = 44100;
+  if (!Player->VGMDataLen)
+    Player->VGMDataLen = Player->VGMHead.lngEOFOffset;
+  if (!Player->VGMHead.lngEOFOffset ||
+      Player->VGMHead.lngEOFOffset > Player->VGMDataLen) {
     fprintf(stderr, "Warning! Invalid EOF Offset 0x%02X! (should be: 0x%02X)\n",
-            VGMHead.lngEOFOffset, VGMDataLen);
-    VGMHead.lngEOFOffset = VGMDataLen;
+            Player->VGMHead.lngEOFOffset, Player->VGMDataLen);
+    Player->VGMHead.lngEOFOffset = Player->VGMDataLen;
   }
-  if (VGMHead.lngLoopOffset && !VGMHead.lngLoopSamples) {
+  if (Player->VGMHead.lngLoopOffset && !Player->VGMHead.lngLoopSamples) {
     // 0-Sample-Loops causes the program to hangs in the playback routine
     fprintf(stderr, "Warning! Ignored Zero-Sample-Loop!\n");
-    VGMHead.lngLoopOffset = 0x00000000;
+    Player->VGMHead.lngLoopOffset = 0x00000000;
   }
-  if (VGMHead.lngDataOffset < 0x00000040) {
+  if (Player->VGMHead.lngDataOffset < 0x00000040) {
     fprintf(stderr, "Warning! Invalid Data Offset 0x%02X!\n",
-            VGMHead.lngDataOffset);
-    VGMHead.lngDataOffset = 0x00000040;
+            Player->VGMHead.lngDataOffset);
+    Player->VGMHead.lngDataOffset = 0x00000040;
   }
 
-  memset(&VGMHeadX, 0x00, sizeof(VGM_HDR_EXTRA));
-  memset(&VGMH_Extra, 0x00, sizeof(VGM_EXTRA));
+  memset(&Player->VGMHeadX, 0x00, sizeof(VGM_HDR_EXTRA));
+  memset(&Player->VGMH_Extra, 0x00, sizeof(VGM_EXTRA));
 
   // Read Data
-  VGMDataLen = VGMHead.lngEOFOffset;
-  VGMData = (UINT8 *)malloc(VGMDataLen);
-  if (VGMData == NULL)
+  Player->VGMDataLen = Player->VGMHead.lngEOFOffset;
+  Player->VGMData = (UINT8 *)malloc(Player->VGMDataLen);
+  if (Player->VGMData == NULL)
     return false;
   // gzseek(hFile, 0x00, SEEK_SET);
   gzrewind(hFile);
-  gzread(hFile, VGMData, VGMDataLen);
+  gzread(hFile, Player->VGMData, Player->VGMDataLen);
 
   // Read Extra Header Data
-  if (VGMHead.lngExtraOffset) {
+  if (Player->VGMHead.lngExtraOffset) {
     UINT32 *TempPtr;
 
-    CurPos = VGMHead.lngExtraOffset;
-    TempPtr = (UINT32 *)&VGMHeadX;
+    CurPos = Player->VGMHead.lngExtraOffset;
+    TempPtr = (UINT32 *)&Player->VGMHeadX;
     // Read Header Size
-    VGMHeadX.DataSize = ReadLE32(&VGMData[CurPos]);
-    if (VGMHeadX.DataSize > sizeof(VGM_HDR_EXTRA))
-      VGMHeadX.DataSize = sizeof(VGM_HDR_EXTRA);
-    HdrLimit = CurPos + VGMHeadX.DataSize;
+    Player->VGMHeadX.DataSize = ReadLE32(&Player->VGMData[CurPos]);
+    if (Player->VGMHeadX.DataSize > sizeof(VGM_HDR_EXTRA))
+      Player->VGMHeadX.DataSize = sizeof(VGM_HDR_EXTRA);
+    HdrLimit = CurPos + Player->VGMHeadX.DataSize;
     CurPos += 0x04;
     TempPtr++;
 
     // Read all relative offsets of this header and make them absolute.
     for (; CurPos < HdrLimit; CurPos += 0x04, TempPtr++) {
-      *TempPtr = ReadLE32(&VGMData[CurPos]);
+      *TempPtr = ReadLE32(&Player->VGMData[CurPos]);
       if (*TempPtr)
         *TempPtr += CurPos;
     }
 
-    ReadChipExtraData32(VGMHeadX.Chp2ClkOffset, &VGMH_Extra.Clocks);
-    ReadChipExtraData16(VGMHeadX.ChpVolOffset, &VGMH_Extra.Volumes);
+    ReadChipExtraData32(Player, Player->VGMHeadX.Chp2ClkOffset,
+                        &Player->VGMH_Extra.Clocks);
+    ReadChipExtraData16(Player, Player->VGMHeadX.ChpVolOffset,
+                        &Player->VGMH_Extra.Volumes);
   }
 
+  // Pre-decode the command stream into the event list
+  CompileVGMEvents(Player);
+
   // Read GD3 Tag
-  HdrLimit = ReadGD3Tag(hFile, VGMHead.lngGD3Offset, &VGMTag);
+  HdrLimit = ReadGD3Tag(hFile, Player->VGMHead.lngGD3Offset, &Player->VGMTag);
   if (HdrLimit == 0x10) {
-    VGMHead.lngGD3Offset = 0x00000000;
+    Player->VGMHead.lngGD3Offset = 0x00000000;
     // return false;
   }
-  if (!VGMHead.lngGD3Offset) {
+  if (!Player->VGMHead.lngGD3Offset) {
     // replace all NULL pointers with empty strings
-    VGMTag.strTrackNameE = MakeEmptyWStr();
-    VGMTag.strTrackNameJ = MakeEmptyWStr();
-    VGMTag.strGameNameE = MakeEmptyWStr();
-    VGMTag.strGameNameJ = MakeEmptyWStr();
-    VGMTag.strSystemNameE = MakeEmptyWStr();
-    VGMTag.strSystemNameJ = MakeEmptyWStr();
-    VGMTag.strAuthorNameE = MakeEmptyWStr();
-    VGMTag.strAuthorNameJ = MakeEmptyWStr();
-    VGMTag.strReleaseDate = MakeEmptyWStr();
+    Player->VGMTag.strTrackNameE = MakeEmptyWStr();
+    Player->VGMTag.strTrackNameJ = MakeEmptyWStr();
+    Player->VGMTag.strGameNameE = MakeEmptyWStr();
+    Player->VGMTag.strGameNameJ = MakeEmptyWStr();
+    Player->VGMTag.strSystemNameE = MakeEmptyWStr();
+    Player->VGMTag.strSystemNameJ = MakeEmptyWStr();
+    Player->VGMTag.strAuthorNameE = MakeEmptyWStr();
+    Player->VGMTag.strAuthorNameJ = MakeEmptyWStr();
+    Player->VGMTag.strReleaseDate = MakeEmptyWStr();
   }
 
   return true;
@@ -1007,20 +1100,20 @@ static UINT8 ReadGD3Tag(gzFile hFile, UINT32 GD3Offset, GD3_TAG *RetGD3Tag) {
   return ResVal;
 }
 
-static void ReadChipExtraData32(UINT32 StartOffset,
+static void ReadChipExtraData32(VGM_PLAYER *Player, UINT32 StartOffset,
                                 VGMX_CHP_EXTRA32 *ChpExtra) {
   UINT32 CurPos;
   UINT8 CurChp;
   VGMX_CHIP_DATA32 *TempCD;
 
-  if (!StartOffset || StartOffset >= VGMDataLen) {
+  if (!StartOffset || StartOffset >= Player->VGMDataLen) {
     ChpExtra->ChipCnt = 0x00;
     ChpExtra->CCData = NULL;
     return;
   }
 
   CurPos = StartOffset;
-  ChpExtra->ChipCnt = VGMData[CurPos];
+  ChpExtra->ChipCnt = Player->VGMData[CurPos];
   if (ChpExtra->ChipCnt)
     ChpExtra->CCData = (VGMX_CHIP_DATA32 *)malloc(sizeof(VGMX_CHIP_DATA32) *
                                                   ChpExtra->ChipCnt);
@@ -1030,28 +1123,28 @@ static void ReadChipExtraData32(UINT32 StartOffset,
 
   for (CurChp = 0x00; CurChp < ChpExtra->ChipCnt; CurChp++) {
     TempCD = &ChpExtra->CCData[CurChp];
-    TempCD->Type = VGMData[CurPos + 0x00];
-    TempCD->Data = ReadLE32(&VGMData[CurPos + 0x01]);
+    TempCD->Type = Player->VGMData[CurPos + 0x00];
+    TempCD->Data = ReadLE32(&Player->VGMData[CurPos + 0x01]);
     CurPos += 0x05;
   }
 
   return;
 }
 
-static void ReadChipExtraData16(UINT32 StartOffset,
+static void ReadChipExtraData16(VGM_PLAYER *Player, UINT32 StartOffset,
                                 VGMX_CHP_EXTRA16 *ChpExtra) {
   UINT32 CurPos;
   UINT8 CurChp;
   VGMX_CHIP_DATA16 *TempCD;
 
-  if (!StartOffset || StartOffset >= VGMDataLen) {
+  if (!StartOffset || StartOffset >= Player->VGMDataLen) {
     ChpExtra->ChipCnt = 0x00;
     ChpExtra->CCData = NULL;
     return;
   }
 
   CurPos = StartOffset;
-  ChpExtra->ChipCnt = VGMData[CurPos];
+  ChpExtra->ChipCnt = Player->VGMData[CurPos];
   if (ChpExtra->ChipCnt)
     ChpExtra->CCData = (VGMX_CHIP_DATA16 *)malloc(sizeof(VGMX_CHIP_DATA16) *
                                                   ChpExtra->ChipCnt);
@@ -1061,31 +1154,33 @@ static void ReadChipExtraData16(UINT32 StartOffset,
 
   for (CurChp = 0x00; CurChp < ChpExtra->ChipCnt; CurChp++) {
     TempCD = &ChpExtra->CCData[CurChp];
-    TempCD->Type = VGMData[CurPos + 0x00];
-    TempCD->Flags = VGMData[CurPos + 0x01];
-    TempCD->Data = ReadLE16(&VGMData[CurPos + 0x02]);
+    TempCD->Type = Player->VGMData[CurPos + 0x00];
+    TempCD->Flags = Player->VGMData[CurPos + 0x01];
+    TempCD->Data = ReadLE16(&Player->VGMData[CurPos + 0x02]);
     CurPos += 0x04;
   }
 
   return;
 }
 
-void CloseVGMFile(void) {
-  if (FileMode == 0xFF)
+void CloseVGMFile(VGM_PLAYER *Player) {
+  if (Player->FileMode == 0xFF)
     return;
 
-  VGMHead.fccVGM = 0x00;
-  free(VGMH_Extra.Clocks.CCData);
-  VGMH_Extra.Clocks.CCData = NULL;
-  free(VGMH_Extra.Volumes.CCData);
-  VGMH_Extra.Volumes.CCData = NULL;
-  free(VGMData);
-  VGMData = NULL;
+  Player->VGMHead.fccVGM = 0x00;
+  free(Player->VGMH_Extra.Clocks.CCData);
+  Player->VGMH_Extra.Clocks.CCData = NULL;
+  free(Player->VGMH_Extra.Volumes.CCData);
+  Player->VGMH_Extra.Volumes.CCData = NULL;
+  free(Player->VGMData);
+  Player->VGMData = NULL;
+  free(Player->VGMEvts);
+  Player->VGMEvts = NULL;
 
-  if (FileMode == 0x00)
-    FreeGD3Tag(&VGMTag);
+  if (Player->FileMode == 0x00)
+    FreeGD3Tag(&Player->VGMTag);
 
-  FileMode = 0xFF;
+  Player->FileMode = 0xFF;
 
   return;
 }
@@ -1220,7 +1315,7 @@ INLINE UINT32 MulDivRound(UINT64 Number, UINT64 Numerator, UINT64 Denominator) {
   return (UINT32)((Number * Numerator + Denominator / 2) / Denominator);
 }
 
-UINT32 CalcSampleMSec(UINT64 Value, UINT8 Mode) {
+UINT32 CalcSampleMSec(VGM_PLAYER *Player, UINT64 Value, UINT8 Mode) {
   UINT32 SmplRate;
   UINT32 PbMul;
   UINT32 PbDiv;
@@ -1231,9 +1326,9 @@ UINT32 CalcSampleMSec(UINT64 Value, UINT8 Mode) {
     PbMul = 1;
     PbDiv = 1;
   } else {
-    SmplRate = VGMSampleRate;
-    PbMul = VGMPbRateMul;
-    PbDiv = VGMPbRateDiv;
+    SmplRate = Player->VGMSampleRate;
+    PbMul = Player->VGMPbRateMul;
+    PbDiv = Player->VGMPbRateDiv;
   }
 
   switch (Mode & 0x01) {
@@ -1408,7 +1503,7 @@ const char *GetAccurateChipName(UINT8 ChipID, UINT8 SubType) {
   return RetStr;
 }
 
-UINT32 GetChipClock(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 *RetSubType) {
+UINT32 GetChipClock(VGM_PLAYER *Player, UINT8 ChipID, UINT8 *RetSubType) {
   UINT32 Clock;
   UINT8 SubType;
   UINT8 CurChp;
@@ -1418,36 +1513,36 @@ UINT32 GetChipClock(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 *RetSubType) {
   AllowBit31 = 0x00;
   switch (ChipID & 0x7F) {
   case 0x00: // SN76496 (PSG)
-    Clock = FileHead->lngHzPSG;
+    Clock = Player->VGMHead.lngHzPSG;
     break;
   case 0x01: // YM2413
-    Clock = FileHead->lngHzYM2413;
+    Clock = Player->VGMHead.lngHzYM2413;
     break;
   case 0x02: // YM2151
-    Clock = FileHead->lngHzYM2151;
+    Clock = Player->VGMHead.lngHzYM2151;
     break;
   case 0x03: // YM3812
-    Clock = FileHead->lngHzYM3812;
+    Clock = Player->VGMHead.lngHzYM3812;
     AllowBit31 = 0x01; // Dual OPL2, panned to the L/R speakers
     break;
   case 0x04: // YM3526
-    Clock = FileHead->lngHzYM3526;
+    Clock = Player->VGMHead.lngHzYM3526;
     break;
   case 0x05: // Y8950
-    Clock = FileHead->lngHzY8950;
+    Clock = Player->VGMHead.lngHzY8950;
     break;
   case 0x06: // YMF262
-    Clock = FileHead->lngHzYMF262;
+    Clock = Player->VGMHead.lngHzYMF262;
     break;
   case 0x07: // YMF278B
-    Clock = FileHead->lngHzYMF278B;
+    Clock = Player->VGMHead.lngHzYMF278B;
     break;
   case 0x08: // AY8910
-    Clock = FileHead->lngHzAY8910;
-    SubType = FileHead->bytAYType;
+    Clock = Player->VGMHead.lngHzAY8910;
+    SubType = Player->VGMHead.bytAYType;
     break;
   case 0x09: // K051649 (SCC)
-    Clock = FileHead->lngHzK051649;
+    Clock = Player->VGMHead.lngHzK051649;
     AllowBit31 = 0x01; // SCC/SCC+ Bit
     break;
   default:
@@ -1464,7 +1559,7 @@ UINT32 GetChipClock(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 *RetSubType) {
     UINT8 OrigType = INDEX_TO_ID[ChipID & 0x7F];
 
     ChipID &= 0x7F;
-    TempCX = &VGMH_Extra.Clocks;
+    TempCX = &Player->VGMH_Extra.Clocks;
     for (CurChp = 0x00; CurChp < TempCX->ChipCnt; CurChp++) {
       if (TempCX->CCData[CurChp].Type == OrigType) {
         if (TempCX->CCData[CurChp].Data)
@@ -1482,7 +1577,7 @@ UINT32 GetChipClock(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 *RetSubType) {
     return Clock & 0x3FFFFFFF;
 }
 
-static UINT16 GetChipVolume(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 ChipNum,
+static UINT16 GetChipVolume(VGM_PLAYER *Player, UINT8 ChipID, UINT8 ChipNum,
                             UINT8 ChipCnt) {
   const UINT16 CHIP_VOLS[CHIP_COUNT] = {0x80,  0x200, 0x100, 0x100,
                                         0x100, 0x100, 0x100, 0x100,
@@ -1497,7 +1592,7 @@ static UINT16 GetChipVolume(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 ChipNum,
   case 0x00: // SN76496
     // if T6W28, set Volume Divider to 01
     // Correctly call GetChipClock with our 10-chip index
-    if (GetChipClock(&VGMHead, (ChipID & 0x80) | 0x00, NULL) & 0x80000000) {
+    if (GetChipClock(Player, (ChipID & 0x80) | 0x00, NULL) & 0x80000000) {
       // The T6W28 consists of 2 "half" chips.
       ChipNum = 0x01;
       ChipCnt = 0x01;
@@ -1517,7 +1612,7 @@ static UINT16 GetChipVolume(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 ChipNum,
                                          0x0B, 0x0C, 0x0D, 0x12, 0x19};
   UINT8 OrigType = INDEX_TO_ID[ChipID & 0x7F];
 
-  TempCX = &VGMH_Extra.Volumes;
+  TempCX = &Player->VGMH_Extra.Volumes;
   TempCD = TempCX->CCData;
   for (CurChp = 0x00; CurChp < TempCX->ChipCnt; CurChp++, TempCD++) {
     if (TempCD->Type == OrigType && (TempCD->Flags & 0x01) == ChipNum) {
@@ -1538,41 +1633,315 @@ static UINT16 GetChipVolume(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 ChipNum,
   return Volume;
 }
 
-static void RestartPlaying(void) {
-  Interpreting = true; // Avoid any Thread-Call
+static void RestartPlaying(VGM_PLAYER *Player) {
+  Player->Interpreting = true; // Avoid any Thread-Call
 
-  VGMPos = VGMHead.lngDataOffset;
-  VGMSmplPos = 0;
-  VGMSmplPlayed = 0;
-  VGMEnd = false;
-  EndPlay = false;
-  VGMCurLoop = 0x00;
-  PauseSmpls = (PauseTime * SampleRate + 500) / 1000;
+  Player->VGMPos = Player->VGMHead.lngDataOffset;
+  Player->VGMEvtPos = 0x00;
+  Player->VGMSmplOfs = 0;
+  Player->VGMSmplPos = Player->VGMEvts[0x00].Smpl;
+  Player->VGMSmplPlayed = 0;
+  Player->VGMEnd = false;
+  Player->EndPlay = false;
+  Player->VGMCurLoop = 0x00;
+  Player->PauseSmpls = (Player->PauseTime * SampleRate + 500) / 1000;
 
-  Chips_GeneralActions(0x01); // Reset Chips
+  Chips_GeneralActions(Player, 0x01); // Reset Chips
   // also does Muting Mask (0x10) and Panning (0x20)
 
 
 
   // Last95 vars removed
-  Interpreting = false;
-  ForceVGMExec = true;
-  IsVGMInit = true;
-  InterpretFile(0);
-  IsVGMInit = false;
-  ForceVGMExec = false;
+  Player->Interpreting = false;
+  Player->ForceVGMExec = true;
+  Player->IsVGMInit = true;
+  InterpretFile(Player, 0);
+  Player->IsVGMInit = false;
+  Player->ForceVGMExec = false;
 #ifndef CONSOLE_MODE
-  FadePlay = false;
-  MasterVol = 1.0f;
-  FadeStart = 0;
-  FinalVol = VolumeLevelM;
-  PlayingTime = 0;
+  Player->FadePlay = false;
+  Player->MasterVol = 1.0f;
+  Player->FadeStart = 0;
+  Player->FinalVol = Player->VolumeLevelM;
+  Player->PlayingTime = 0;
 #endif
 
   return;
 }
 
-static void Chips_GeneralActions(UINT8 Mode) {
+static UINT32 SaveChipStates(VGM_PLAYER *Player, UINT8 *Data) {
+  // returns the size of the state data, Data == NULL only queries the size
+  UINT32 DataSize;
+  UINT8 *DstPtr;
+  CAUD_ATTR *CAA;
+  UINT8 CurChip;
+  UINT8 CurCSet;
+
+  DataSize = 0x00;
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
+      DstPtr = (Data != NULL) ? Data + DataSize : NULL;
+      if (CAA->ChipType == 0xFF) // chip unused
+        continue;
+      else if (CAA->ChipType == 0x00)
+        DataSize += device_save_state_sn764xx(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x01)
+        DataSize += device_save_state_ym2413(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x02)
+        DataSize += device_save_state_ym2151(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x03)
+        DataSize += device_save_state_ym3812(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x04)
+        DataSize += device_save_state_ym3526(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x05)
+        DataSize += device_save_state_y8950(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x06)
+        DataSize += device_save_state_ymf262(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x07)
+        DataSize += device_save_state_ymf278b(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x08)
+        DataSize += device_save_state_ayxx(CAA->Info, DstPtr);
+      else if (CAA->ChipType == 0x09)
+        DataSize += device_save_state_k051649(CAA->Info, DstPtr);
+    } // end for CurChip
+  } // end for CurCSet
+
+  for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+    DstPtr = (Data != NULL) ? Data + DataSize : NULL;
+    DataSize += device_save_state_daccontrol(
+        Player->DacInfo[Player->DacCtrlUsg[CurChip]], DstPtr);
+  }
+
+  return DataSize;
+}
+
+static UINT32 LoadChipStates(VGM_PLAYER *Player, const UINT8 *Data) {
+  // the chips and DACs must be the same ones that were saved
+  UINT32 DataPos;
+  CAUD_ATTR *CAA;
+  UINT8 CurChip;
+  UINT8 CurCSet;
+
+  DataPos = 0x00;
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
+      if (CAA->ChipType == 0xFF) // chip unused
+        continue;
+      else if (CAA->ChipType == 0x00)
+        DataPos += device_load_state_sn764xx(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x01)
+        DataPos += device_load_state_ym2413(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x02)
+        DataPos += device_load_state_ym2151(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x03)
+        DataPos += device_load_state_ym3812(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x04)
+        DataPos += device_load_state_ym3526(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x05)
+        DataPos += device_load_state_y8950(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x06)
+        DataPos += device_load_state_ymf262(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x07)
+        DataPos += device_load_state_ymf278b(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x08)
+        DataPos += device_load_state_ayxx(CAA->Info, Data + DataPos);
+      else if (CAA->ChipType == 0x09)
+        DataPos += device_load_state_k051649(CAA->Info, Data + DataPos);
+    } // end for CurChip
+  } // end for CurCSet
+
+  for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++)
+    DataPos += device_load_state_daccontrol(
+        Player->DacInfo[Player->DacCtrlUsg[CurChip]], Data + DataPos);
+
+  return DataPos;
+}
+
+static UINT32 CopySincHist(VGM_PLAYER *Player, UINT8 *Data, bool Restore) {
+  // saves or restores the input history of the sinc resamplers,
+  // returns the size of the data
+  CAUD_ATTR *CAA;
+  UINT32 DataPos;
+  UINT8 CurChip;
+  UINT8 CurCSet;
+
+  DataPos = 0x00;
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    for (CurChip = 0x00; CurChip < CHIP_COUNT + 0x03; CurChip++) {
+      if (CurChip < CHIP_COUNT)
+        CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet] + CurChip;
+      else
+        CAA = &Player->CA_Paired[CurCSet][CurChip - CHIP_COUNT];
+      if (CAA->ChipType == 0xFF || CAA->Resampler != 0x04 ||
+          CAA->SincHist == NULL)
+        continue;
+
+      if (Data != NULL) {
+        if (Restore)
+          memcpy(CAA->SincHist, Data + DataPos,
+                 SINC_TAPS_MAX * 0x02 * sizeof(float));
+        else
+          memcpy(Data + DataPos, CAA->SincHist,
+                 SINC_TAPS_MAX * 0x02 * sizeof(float));
+      }
+      DataPos += SINC_TAPS_MAX * 0x02 * sizeof(float);
+    }
+  }
+
+  return DataPos;
+}
+
+static void SaveSeekKey(VGM_PLAYER *Player, UINT32 PbkPos) {
+  SEEK_KEY *Key;
+  SEEK_KEY *NewKeys;
+  UINT32 NewAlloc;
+  UINT32 DataSize;
+  UINT8 CurBnk;
+
+  if (Player->SeekKeyCount >= SEEKKEY_MAX) {
+    Player->SeekKeyNext = 0xFFFFFFFF;
+    return;
+  }
+  if (Player->SeekKeyCount >= Player->SeekKeyAlloc) {
+    NewAlloc = Player->SeekKeyAlloc ? Player->SeekKeyAlloc * 2 : 0x20;
+    NewKeys = (SEEK_KEY *)realloc(Player->SeekKeys,
+                                  NewAlloc * sizeof(SEEK_KEY));
+    if (NewKeys == NULL) {
+      Player->SeekKeyNext = 0xFFFFFFFF;
+      return;
+    }
+    Player->SeekKeys = NewKeys;
+    Player->SeekKeyAlloc = NewAlloc;
+  }
+  DataSize = SaveChipStates(Player, NULL);
+  DataSize += CopySincHist(Player, NULL, false);
+  Key = &Player->SeekKeys[Player->SeekKeyCount];
+  Key->ChipStates = (UINT8 *)malloc(DataSize ? DataSize : 0x01);
+  if (Key->ChipStates == NULL) {
+    Player->SeekKeyNext = 0xFFFFFFFF;
+    return;
+  }
+  DataSize = SaveChipStates(Player, Key->ChipStates);
+  CopySincHist(Player, Key->ChipStates + DataSize, false);
+
+  Key->PbkPos = PbkPos;
+  Key->VGMPos = Player->VGMPos;
+  Key->EvtPos = Player->VGMEvtPos;
+  Key->SmplOfs = Player->VGMSmplOfs;
+  Key->VGMSmplPos = Player->VGMSmplPos;
+  Key->VGMSmplPlayed = Player->VGMSmplPlayed;
+  Key->VGMCurLoop = Player->VGMCurLoop;
+  Key->PlayingTime = Player->PlayingTime;
+  Key->FadePlay = Player->FadePlay;
+  Key->FadeStart = Player->FadeStart;
+  for (CurBnk = 0x00; CurBnk < PCM_BANK_COUNT; CurBnk++) {
+    Key->BnkDataPos[CurBnk] = Player->PCMBank[CurBnk].DataPos;
+    Key->BnkPos[CurBnk] = Player->PCMBank[CurBnk].BnkPos;
+  }
+  Key->PCMTblCount = Player->PCMTbl.EntryCount;
+  Key->DacCtrlUsed = Player->DacCtrlUsed;
+  memcpy(Key->DacCtrlUsg, Player->DacCtrlUsg, sizeof(Player->DacCtrlUsg));
+  memcpy(Key->DacCtrl, Player->DacCtrl, sizeof(Player->DacCtrl));
+  memcpy(Key->ChipAudio, Player->ChipAudio, sizeof(Player->ChipAudio));
+  memcpy(Key->CA_Paired, Player->CA_Paired, sizeof(Player->CA_Paired));
+  Player->SeekKeyCount++;
+
+  Player->SeekKeyNext = PbkPos + SEEKKEY_SECONDS * SampleRate;
+
+  return;
+}
+
+static void LoadSeekKey(VGM_PLAYER *Player, const SEEK_KEY *Key) {
+  CAUD_ATTR *CAA;
+  const CAUD_ATTR *KeyCAA;
+  VGM_PCM_BANK *TempPCM;
+  UINT32 DataSize;
+  UINT8 CurChip;
+  UINT8 CurCSet;
+
+  Player->Interpreting = true; // Avoid any Thread-Call
+
+  Player->VGMPos = Key->VGMPos;
+  Player->VGMEvtPos = Key->EvtPos;
+  Player->VGMSmplOfs = Key->SmplOfs;
+  Player->VGMSmplPos = Key->VGMSmplPos;
+  Player->VGMSmplPlayed = Key->VGMSmplPlayed;
+  Player->VGMCurLoop = Key->VGMCurLoop;
+  Player->VGMEnd = false;
+  Player->EndPlay = false;
+  Player->PauseSmpls = (Player->PauseTime * SampleRate + 500) / 1000;
+
+  for (CurChip = 0x00; CurChip < PCM_BANK_COUNT; CurChip++) {
+    Player->PCMBank[CurChip].DataPos = Key->BnkDataPos[CurChip];
+    Player->PCMBank[CurChip].BnkPos = Key->BnkPos[CurChip];
+  }
+  Player->PCMTbl.EntryCount = Key->PCMTblCount;
+  Player->DacCtrlUsed = Key->DacCtrlUsed;
+  memcpy(Player->DacCtrlUsg, Key->DacCtrlUsg, sizeof(Player->DacCtrlUsg));
+  memcpy(Player->DacCtrl, Key->DacCtrl, sizeof(Player->DacCtrl));
+
+  DataSize = LoadChipStates(Player, Key->ChipStates);
+  CopySincHist(Player, Key->ChipStates + DataSize, true);
+  // the sample data may have been reallocated since the snapshot
+  for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+    CurCSet = Player->DacCtrlUsg[CurChip];
+    TempPCM = &Player->PCMBank[Player->DacCtrl[CurCSet].Bank];
+    daccontrol_refresh_data(Player->DacInfo[CurCSet], TempPCM->Data,
+                            TempPCM->DataSize);
+  }
+
+  for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+    for (CurChip = 0x00; CurChip < CHIP_COUNT + 0x03; CurChip++) {
+      if (CurChip < CHIP_COUNT) {
+        CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet] + CurChip;
+        KeyCAA = (const CAUD_ATTR *)&Key->ChipAudio[CurCSet] + CurChip;
+      } else {
+        CAA = &Player->CA_Paired[CurCSet][CurChip - CHIP_COUNT];
+        KeyCAA = &Key->CA_Paired[CurCSet][CurChip - CHIP_COUNT];
+      }
+      CAA->SmpP = KeyCAA->SmpP;
+      CAA->SmpLast = KeyCAA->SmpLast;
+      CAA->SmpNext = KeyCAA->SmpNext;
+      CAA->LSmpl = KeyCAA->LSmpl;
+      CAA->NSmpl = KeyCAA->NSmpl;
+    }
+  }
+
+  Chips_GeneralActions(Player, 0x10); // set muting mask
+  Chips_GeneralActions(Player, 0x20); // set panning
+
+  Player->PlayingTime = Key->PlayingTime;
+  Player->FadePlay = Key->FadePlay;
+  Player->FadeStart = Key->FadeStart;
+  if (!Player->FadePlay) {
+    Player->MasterVol = 1.0f;
+    Player->FinalVol = Player->VolumeLevelM;
+  }
+  Player->SeekKeyNext = Player->SeekKeys[Player->SeekKeyCount - 1].PbkPos +
+                        SEEKKEY_SECONDS * SampleRate;
+
+  Player->Interpreting = false;
+
+  return;
+}
+
+static void FreeSeekKeys(VGM_PLAYER *Player) {
+  UINT32 CurKey;
+
+  for (CurKey = 0x00; CurKey < Player->SeekKeyCount; CurKey++)
+    free(Player->SeekKeys[CurKey].ChipStates);
+  free(Player->SeekKeys);
+  Player->SeekKeys = NULL;
+  Player->SeekKeyCount = 0x00;
+  Player->SeekKeyAlloc = 0x00;
+  Player->SeekKeyNext = SEEKKEY_SECONDS * SampleRate;
+
+  return;
+}
+
+static void Chips_GeneralActions(VGM_PLAYER *Player, UINT8 Mode) {
   UINT32 AbsVol;
   // UINT16 ChipVol;
   CAUD_ATTR *CAA;
@@ -1585,8 +1954,10 @@ static void Chips_GeneralActions(UINT8 Mode) {
 
   switch (Mode) {
   case 0x00: // Start Chips
+    // the chips select their kernels when starting
+    pthread_once(&SimdKernelsOnce, SetupSimdKernels);
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
         CAA->SmpRate = 0x00;
         CAA->Volume = 0x00;
@@ -1594,9 +1965,10 @@ static void Chips_GeneralActions(UINT8 Mode) {
         CAA->ChipID = CurCSet;
         CAA->Resampler = 0x00;
         CAA->StreamUpdate = &null_update;
+        CAA->MonoOut = false;
         CAA->Paired = NULL;
       }
-      CAA = CA_Paired[CurCSet];
+      CAA = Player->CA_Paired[CurCSet];
       for (CurChip = 0x00; CurChip < 0x03; CurChip++, CAA++) {
         CAA->SmpRate = 0x00;
         CAA->Volume = 0x00;
@@ -1604,225 +1976,248 @@ static void Chips_GeneralActions(UINT8 Mode) {
         CAA->ChipID = CurCSet;
         CAA->Resampler = 0x00;
         CAA->StreamUpdate = &null_update;
+        CAA->MonoOut = false;
         CAA->Paired = NULL;
       }
     }
 
     // Initialize Sound Chips
     AbsVol = 0x00;
-    if (VGMHead.lngHzPSG) {
+    if (Player->VGMHead.lngHzPSG) {
       // ChipVol = UseFM ? 0x00 : 0x80;
       sn764xx_set_emu_core(ChipOpts[0x00].SN76496.EmuCore);
       ChipOpts[0x01].SN76496.EmuCore = ChipOpts[0x00].SN76496.EmuCore;
 
-      ChipCnt = (VGMHead.lngHzPSG & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzPSG & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].SN76496;
+        CAA = &Player->ChipAudio[CurChip].SN76496;
         CAA->ChipType = 0x00;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
         ChipClk &= ~0x80000000;
-        ChipClk |= VGMHead.lngHzPSG & ((CurChip & 0x01) << 31);
+        ChipClk |= Player->VGMHead.lngHzPSG & ((CurChip & 0x01) << 31);
         CAA->SmpRate = device_start_sn764xx(
-            CurChip, ChipClk, VGMHead.bytPSG_SRWidth, VGMHead.shtPSG_Feedback,
-            (VGMHead.bytPSG_Flags & 0x02) >> 1,
-            (VGMHead.bytPSG_Flags & 0x04) >> 2,
-            (VGMHead.bytPSG_Flags & 0x08) >> 3,
-            (VGMHead.bytPSG_Flags & 0x01) >> 0);
+            &CAA->Info, ChipClk, Player->VGMHead.bytPSG_SRWidth,
+            Player->VGMHead.shtPSG_Feedback,
+            (Player->VGMHead.bytPSG_Flags & 0x02) >> 1,
+            (Player->VGMHead.bytPSG_Flags & 0x04) >> 2,
+            (Player->VGMHead.bytPSG_Flags & 0x08) >> 3,
+            (Player->VGMHead.bytPSG_Flags & 0x01) >> 0);
         CAA->StreamUpdate = &sn764xx_stream_update;
+        if (CurChip && (ChipClk & 0x80000000) && CAA->Info != NULL &&
+            Player->ChipAudio[0x00].SN76496.Info != NULL)
+          sn764xx_connect_ngp(Player->ChipAudio[0x00].SN76496.Info, CAA->Info);
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         if (!CurChip || !(ChipClk & 0x80000000))
           AbsVol += CAA->Volume;
       }
-      if (VGMHead.lngHzPSG & 0x80000000)
+      if (Player->VGMHead.lngHzPSG & 0x80000000)
         ChipCnt = 0x01;
     }
-    if (VGMHead.lngHzYM2413) {
+    if (Player->VGMHead.lngHzYM2413) {
       // ChipVol = UseFM ? 0x00 : 0x200/*0x155*/;
       ym2413_set_emu_core(ChipOpts[0x00].YM2413.EmuCore);
       ChipOpts[0x01].YM2413.EmuCore = ChipOpts[0x00].YM2413.EmuCore;
 
-      ChipCnt = (VGMHead.lngHzYM2413 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYM2413 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YM2413;
+        CAA = &Player->ChipAudio[CurChip].YM2413;
         CAA->ChipType = 0x01;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ym2413(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ym2413(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &ym2413_stream_update;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         // WHY has this chip such a low volume???
         // AbsVol += (CAA->Volume + 1) * 3 / 4;
         AbsVol += CAA->Volume / 2;
       }
     }
 
-    if (VGMHead.lngHzYM2151) {
+    if (Player->VGMHead.lngHzYM2151) {
       // ChipVol = 0x100;
       ym2151_set_emu_core(ChipOpts[0x00].YM2151.EmuCore);
-      ChipCnt = (VGMHead.lngHzYM2151 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYM2151 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YM2151;
+        CAA = &Player->ChipAudio[CurChip].YM2151;
         CAA->ChipType = 0x02;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ym2151(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ym2151(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &ym2151_update;
 
-        CAA->Volume = GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+        CAA->Volume = GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume;
       }
     }
 
-    if (VGMHead.lngHzYM3812) {
+    if (Player->VGMHead.lngHzYM3812) {
       // ChipVol = UseFM ? 0x00 : 0x100;
       ym3812_set_emu_core(ChipOpts[0x00].YM3812.EmuCore);
       ChipOpts[0x01].YM3812.EmuCore = ChipOpts[0x00].YM3812.EmuCore;
 
-      ChipCnt = (VGMHead.lngHzYM3812 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYM3812 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YM3812;
+        CAA = &Player->ChipAudio[CurChip].YM3812;
         CAA->ChipType = 0x03;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ym3812(CurChip, ChipClk);
-        CAA->StreamUpdate =
-            (ChipClk & 0x80000000) ? dual_opl2_stereo : ym3812_stream_update;
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ym3812(&CAA->Info, ChipClk);
+        if (!(ChipClk & 0x80000000))
+          CAA->StreamUpdate = &ym3812_stream_update;
+        else if (!CurChip)
+          CAA->StreamUpdate = &dual_opl2_left;
+        else
+          CAA->StreamUpdate = &dual_opl2_right;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         if (!CurChip || !(ChipClk & 0x80000000))
           AbsVol += CAA->Volume * 2;
       }
     }
-    if (VGMHead.lngHzYM3526) {
+    if (Player->VGMHead.lngHzYM3526) {
       // ChipVol = UseFM ? 0x00 : 0x100;
-      ChipCnt = (VGMHead.lngHzYM3526 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYM3526 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YM3526;
+        CAA = &Player->ChipAudio[CurChip].YM3526;
         CAA->ChipType = 0x04;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ym3526(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ym3526(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &ym3526_stream_update;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume * 2;
       }
     }
-    if (VGMHead.lngHzY8950) {
+    if (Player->VGMHead.lngHzY8950) {
       // ChipVol = UseFM ? 0x00 : 0x100;
-      ChipCnt = (VGMHead.lngHzY8950 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzY8950 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].Y8950;
+        CAA = &Player->ChipAudio[CurChip].Y8950;
         CAA->ChipType = 0x05;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_y8950(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_y8950(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &y8950_stream_update;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume * 2;
       }
     }
-    if (VGMHead.lngHzYMF262) {
+    if (Player->VGMHead.lngHzYMF262) {
       // ChipVol = UseFM ? 0x00 : 0x100;
       ymf262_set_emu_core(ChipOpts[0x00].YMF262.EmuCore);
       ChipOpts[0x01].YMF262.EmuCore = ChipOpts[0x00].YMF262.EmuCore;
 
-      ChipCnt = (VGMHead.lngHzYMF262 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYMF262 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YMF262;
+        CAA = &Player->ChipAudio[CurChip].YMF262;
         CAA->ChipType = 0x06;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ymf262(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ymf262(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &ymf262_stream_update;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume * 2;
       }
     }
-    if (VGMHead.lngHzYMF278B) {
+    if (Player->VGMHead.lngHzYMF278B) {
       // ChipVol = 0x100;
-      ChipCnt = (VGMHead.lngHzYMF278B & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzYMF278B & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].YMF278B;
+        CAA = &Player->ChipAudio[CurChip].YMF278B;
         CAA->ChipType = 0x07;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ymf278b(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_ymf278b(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &ymf278b_pcm_update;
 
-        CAA->Volume = GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+        CAA->Volume = GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume; // good as long as it only uses WaveTable Synth
       }
     }
 
-    if (VGMHead.lngHzAY8910) {
+    if (Player->VGMHead.lngHzAY8910) {
       // ChipVol = 0x100;
       ayxx_set_emu_core(ChipOpts[0x00].AY8910.EmuCore);
       ChipOpts[0x01].AY8910.EmuCore = ChipOpts[0x00].AY8910.EmuCore;
 
-      ChipCnt = (VGMHead.lngHzAY8910 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzAY8910 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].AY8910;
+        CAA = &Player->ChipAudio[CurChip].AY8910;
         CAA->ChipType = 0x08;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_ayxx(CurChip, ChipClk, VGMHead.bytAYType,
-                                         VGMHead.bytAYFlag);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate =
+            device_start_ayxx(&CAA->Info, ChipClk, Player->VGMHead.bytAYType,
+                              Player->VGMHead.bytAYFlag);
         CAA->StreamUpdate = &ayxx_stream_update;
 
         CAA->Volume =
-            GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+            GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume * 2;
       }
     }
 
-    if (VGMHead.lngHzK051649) {
+    if (Player->VGMHead.lngHzK051649) {
       // ChipVol = 0xA0;
-      ChipCnt = (VGMHead.lngHzK051649 & 0x40000000) ? 0x02 : 0x01;
+      ChipCnt = (Player->VGMHead.lngHzK051649 & 0x40000000) ? 0x02 : 0x01;
       for (CurChip = 0x00; CurChip < ChipCnt; CurChip++) {
-        CAA = &ChipAudio[CurChip].K051649;
+        CAA = &Player->ChipAudio[CurChip].K051649;
         CAA->ChipType = 0x09;
 
-        ChipClk = GetChipClock(&VGMHead, (CurChip << 7) | CAA->ChipType, NULL);
-        CAA->SmpRate = device_start_k051649(CurChip, ChipClk);
+        ChipClk = GetChipClock(Player, (CurChip << 7) | CAA->ChipType, NULL);
+        CAA->SmpRate = device_start_k051649(&CAA->Info, ChipClk);
         CAA->StreamUpdate = &k051649_update;
+        CAA->MonoOut = true;
 
-        CAA->Volume = GetChipVolume(&VGMHead, CAA->ChipType, CurChip, ChipCnt);
+        CAA->Volume = GetChipVolume(Player, CAA->ChipType, CurChip, ChipCnt);
         AbsVol += CAA->Volume;
       }
     }
 
+    // chips that failed to start stay silent
+    for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
+      for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
+        if (CAA->ChipType != 0xFF && CAA->Info == NULL) {
+          CAA->ChipType = 0xFF;
+          CAA->SmpRate = 0x00;
+          CAA->StreamUpdate = &null_update;
+        }
+      }
+    }
+
     // Initialize DAC Control and PCM Bank
-    DacCtrlUsed = 0x00;
+    Player->DacCtrlUsed = 0x00;
     // memset(DacCtrlUsg, 0x00, 0x01 * 0xFF);
     for (CurChip = 0x00; CurChip < 0xFF; CurChip++) {
-      DacCtrl[CurChip].Enable = false;
+      Player->DacCtrl[CurChip].Enable = false;
     }
     // memset(DacCtrl, 0x00, sizeof(DACCTRL_DATA) * 0xFF);
 
-    memset(PCMBank, 0x00, sizeof(VGM_PCM_BANK) * PCM_BANK_COUNT);
-    memset(&PCMTbl, 0x00, sizeof(PCMBANK_TBL));
+    memset(Player->PCMBank, 0x00, sizeof(VGM_PCM_BANK) * PCM_BANK_COUNT);
+    memset(&Player->PCMTbl, 0x00, sizeof(PCMBANK_TBL));
 
     // Reset chips
-    Chips_GeneralActions(0x01);
+    Chips_GeneralActions(Player, 0x01);
 
     while (AbsVol < 0x200 && AbsVol) {
       for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-        CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+        CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
         for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++)
           CAA->Volume *= 2;
-        CAA = CA_Paired[CurCSet];
+        CAA = Player->CA_Paired[CurCSet];
         for (CurChip = 0x00; CurChip < 0x03; CurChip++, CAA++)
           CAA->Volume *= 2;
       }
@@ -1830,66 +2225,71 @@ static void Chips_GeneralActions(UINT8 Mode) {
     }
     while (AbsVol > 0x300) {
       for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-        CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+        CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
         for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++)
           CAA->Volume /= 2;
-        CAA = CA_Paired[CurCSet];
+        CAA = Player->CA_Paired[CurCSet];
         for (CurChip = 0x00; CurChip < 0x03; CurChip++, CAA++)
           CAA->Volume /= 2;
       }
       AbsVol /= 2;
     }
 
+    // the worker threads stay until the player is destroyed
+    if (ChipThreads > 1 && Player->ChipWork == NULL)
+      Player->ChipWork = StartChipWorkers(ChipThreads - 1);
+
     // Initialize Resampler
+    Player->SegSmplsMax = MIX_BUFSIZE;
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++)
-        SetupResampler(CAA);
+        SetupResampler(Player, CAA);
 
-      CAA = CA_Paired[CurCSet];
+      CAA = Player->CA_Paired[CurCSet];
       for (CurChip = 0x00; CurChip < 0x03; CurChip++, CAA++)
-        SetupResampler(CAA);
+        SetupResampler(Player, CAA);
     }
 
-    GeneralChipLists();
+    GeneralChipLists(Player);
     break;
   case 0x01: // Reset chips
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
         if (CAA->ChipType == 0xFF) // chip unused
           continue;
         else if (CAA->ChipType == 0x00)
-          device_reset_sn764xx(CurCSet);
+          device_reset_sn764xx(CAA->Info);
         else if (CAA->ChipType == 0x01)
-          device_reset_ym2413(CurCSet);
+          device_reset_ym2413(CAA->Info);
         else if (CAA->ChipType == 0x02)
-          device_reset_ym2151(CurCSet);
+          device_reset_ym2151(CAA->Info);
         else if (CAA->ChipType == 0x03)
-          device_reset_ym3812(CurCSet);
+          device_reset_ym3812(CAA->Info);
         else if (CAA->ChipType == 0x04)
-          device_reset_ym3526(CurCSet);
+          device_reset_ym3526(CAA->Info);
         else if (CAA->ChipType == 0x05)
-          device_reset_y8950(CurCSet);
+          device_reset_y8950(CAA->Info);
         else if (CAA->ChipType == 0x06)
-          device_reset_ymf262(CurCSet);
+          device_reset_ymf262(CAA->Info);
         else if (CAA->ChipType == 0x07)
-          device_reset_ymf278b(CurCSet);
+          device_reset_ymf278b(CAA->Info);
         else if (CAA->ChipType == 0x08)
-          device_reset_ayxx(CurCSet);
+          device_reset_ayxx(CAA->Info);
         else if (CAA->ChipType == 0x09)
-          device_reset_k051649(CurCSet);
+          device_reset_k051649(CAA->Info);
 
       } // end for CurChip
 
     } // end for CurCSet
 
-    Chips_GeneralActions(0x10); // set muting mask
-    Chips_GeneralActions(0x20); // set panning
+    Chips_GeneralActions(Player, 0x10); // set muting mask
+    Chips_GeneralActions(Player, 0x20); // set panning
 
-    for (CurChip = 0x00; CurChip < DacCtrlUsed; CurChip++) {
-      CurCSet = DacCtrlUsg[CurChip];
-      device_reset_daccontrol(CurCSet);
+    for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+      CurCSet = Player->DacCtrlUsg[CurChip];
+      device_reset_daccontrol(Player->DacInfo[CurCSet]);
       // DacCtrl[CurCSet].Enable = false;
     }
     // DacCtrlUsed = 0x00;
@@ -1898,85 +2298,90 @@ static void Chips_GeneralActions(UINT8 Mode) {
     for (CurChip = 0x00; CurChip < PCM_BANK_COUNT; CurChip++) {
       // reset PCM Bank, but not the data
       // (this way I don't need to decompress the data again when restarting)
-      PCMBank[CurChip].DataPos = 0x00000000;
-      PCMBank[CurChip].BnkPos = 0x00000000;
+      Player->PCMBank[CurChip].DataPos = 0x00000000;
+      Player->PCMBank[CurChip].BnkPos = 0x00000000;
     }
-    PCMTbl.EntryCount = 0x00;
+    Player->PCMTbl.EntryCount = 0x00;
     break;
   case 0x02: // Stop chips
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
         if (CAA->ChipType == 0xFF) // chip unused
           continue;
         else if (CAA->ChipType == 0x00)
-          device_stop_sn764xx(CurCSet);
+          device_stop_sn764xx(CAA->Info);
         else if (CAA->ChipType == 0x01)
-          device_stop_ym2413(CurCSet);
+          device_stop_ym2413(CAA->Info);
         else if (CAA->ChipType == 0x02)
-          device_stop_ym2151(CurCSet);
+          device_stop_ym2151(CAA->Info);
         else if (CAA->ChipType == 0x03)
-          device_stop_ym3812(CurCSet);
+          device_stop_ym3812(CAA->Info);
         else if (CAA->ChipType == 0x04)
-          device_stop_ym3526(CurCSet);
+          device_stop_ym3526(CAA->Info);
         else if (CAA->ChipType == 0x05)
-          device_stop_y8950(CurCSet);
+          device_stop_y8950(CAA->Info);
         else if (CAA->ChipType == 0x06)
-          device_stop_ymf262(CurCSet);
+          device_stop_ymf262(CAA->Info);
         else if (CAA->ChipType == 0x07)
-          device_stop_ymf278b(CurCSet);
+          device_stop_ymf278b(CAA->Info);
         else if (CAA->ChipType == 0x08)
-          device_stop_ayxx(CurCSet);
+          device_stop_ayxx(CAA->Info);
         else if (CAA->ChipType == 0x09)
-          device_stop_k051649(CurCSet);
+          device_stop_k051649(CAA->Info);
 
         CAA->ChipType = 0xFF; // mark as "unused"
+        CAA->Info = NULL;
       } // end for CurChip
 
     } // end for CurCSet
 
-    for (CurChip = 0x00; CurChip < DacCtrlUsed; CurChip++) {
-      CurCSet = DacCtrlUsg[CurChip];
-      device_stop_daccontrol(CurCSet);
-      DacCtrl[CurCSet].Enable = false;
+    for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+      CurCSet = Player->DacCtrlUsg[CurChip];
+      Player->DacCtrl[CurCSet].Enable = false;
+    }
+    Player->DacCtrlUsed = 0x00;
+    // a seek may have disabled streams that still have a handle
+    for (CurChip = 0x00; CurChip < 0xFF; CurChip++) {
+      device_stop_daccontrol(Player->DacInfo[CurChip]);
+      Player->DacInfo[CurChip] = NULL;
     }
-    DacCtrlUsed = 0x00;
 
     for (CurChip = 0x00; CurChip < PCM_BANK_COUNT; CurChip++) {
-      free(PCMBank[CurChip].Bank);
-      free(PCMBank[CurChip].Data);
+      free(Player->PCMBank[CurChip].Bank);
+      free(Player->PCMBank[CurChip].Data);
     }
     // memset(PCMBank, 0x00, sizeof(VGM_PCM_BANK) * PCM_BANK_COUNT);
-    free(PCMTbl.Entries);
+    free(Player->PCMTbl.Entries);
     // memset(&PCMTbl, 0x00, sizeof(PCMBANK_TBL));
     break;
   case 0x10: // Set Muting Mask
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
         if (CAA->ChipType == 0xFF) // chip unused
           continue;
         else if (CAA->ChipType == 0x00)
-          sn764xx_set_mute_mask(CurCSet, ChipOpts[CurCSet].SN76496.ChnMute1);
+          sn764xx_set_mute_mask(CAA->Info, ChipOpts[CurCSet].SN76496.ChnMute1);
         else if (CAA->ChipType == 0x01)
-          ym2413_set_mute_mask(CurCSet, ChipOpts[CurCSet].YM2413.ChnMute1);
+          ym2413_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YM2413.ChnMute1);
         else if (CAA->ChipType == 0x02)
-          ym2151_set_mute_mask(CurCSet, ChipOpts[CurCSet].YM2151.ChnMute1);
+          ym2151_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YM2151.ChnMute1);
         else if (CAA->ChipType == 0x03)
-          ym3812_set_mute_mask(CurCSet, ChipOpts[CurCSet].YM3812.ChnMute1);
+          ym3812_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YM3812.ChnMute1);
         else if (CAA->ChipType == 0x04)
-          ym3526_set_mute_mask(CurCSet, ChipOpts[CurCSet].YM3526.ChnMute1);
+          ym3526_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YM3526.ChnMute1);
         else if (CAA->ChipType == 0x05)
-          y8950_set_mute_mask(CurCSet, ChipOpts[CurCSet].Y8950.ChnMute1);
+          y8950_set_mute_mask(CAA->Info, ChipOpts[CurCSet].Y8950.ChnMute1);
         else if (CAA->ChipType == 0x06)
-          ymf262_set_mute_mask(CurCSet, ChipOpts[CurCSet].YMF262.ChnMute1);
+          ymf262_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YMF262.ChnMute1);
         else if (CAA->ChipType == 0x07)
-          ymf278b_set_mute_mask(CurCSet, ChipOpts[CurCSet].YMF278B.ChnMute1,
+          ymf278b_set_mute_mask(CAA->Info, ChipOpts[CurCSet].YMF278B.ChnMute1,
                                 ChipOpts[CurCSet].YMF278B.ChnMute2);
         else if (CAA->ChipType == 0x08)
-          ayxx_set_mute_mask(CurCSet, ChipOpts[CurCSet].AY8910.ChnMute1);
+          ayxx_set_mute_mask(CAA->Info, ChipOpts[CurCSet].AY8910.ChnMute1);
         else if (CAA->ChipType == 0x09)
-          k051649_set_mute_mask(CurCSet, ChipOpts[CurCSet].K051649.ChnMute1);
+          k051649_set_mute_mask(CAA->Info, ChipOpts[CurCSet].K051649.ChnMute1);
 
       } // end for CurChip
 
@@ -1984,14 +2389,14 @@ static void Chips_GeneralActions(UINT8 Mode) {
     break;
   case 0x20: // Set Panning
     for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet];
+      CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet];
       for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++, CAA++) {
         if (CAA->ChipType == 0xFF) // chip unused
           continue;
         else if (CAA->ChipType == 0x00)
-          sn764xx_set_panning(CurCSet, ChipOpts[CurCSet].SN76496.Panning);
+          sn764xx_set_panning(CAA->Info, ChipOpts[CurCSet].SN76496.Panning);
         else if (CAA->ChipType == 0x01)
-          ym2413_set_panning(CurCSet, ChipOpts[CurCSet].YM2413.Panning);
+          ym2413_set_panning(CAA->Info, ChipOpts[CurCSet].YM2413.Panning);
       } // end for CurChip
 
     } // end for CurCSet
@@ -2001,24 +2406,28 @@ static void Chips_GeneralActions(UINT8 Mode) {
   return;
 }
 
-INLINE INT32 SampleVGM2Pbk_I(INT32 SampleVal) {
-  return (INT32)((INT64)SampleVal * VGMSmplRateMul / VGMSmplRateDiv);
+INLINE INT32 SampleVGM2Pbk_I(VGM_PLAYER *Player, INT32 SampleVal) {
+  return (INT32)((INT64)SampleVal * Player->VGMSmplRateMul /
+                 Player->VGMSmplRateDiv);
 }
 
-INLINE INT32 SamplePbk2VGM_I(INT32 SampleVal) {
-  return (INT32)((INT64)SampleVal * VGMSmplRateDiv / VGMSmplRateMul);
+INLINE INT32 SamplePbk2VGM_I(VGM_PLAYER *Player, INT32 SampleVal) {
+  return (INT32)((INT64)SampleVal * Player->VGMSmplRateDiv /
+                 Player->VGMSmplRateMul);
 }
 
-INT32 SampleVGM2Playback(INT32 SampleVal) {
-  return (INT32)((INT64)SampleVal * VGMSmplRateMul / VGMSmplRateDiv);
+INT32 SampleVGM2Playback(VGM_PLAYER *Player, INT32 SampleVal) {
+  return (INT32)((INT64)SampleVal * Player->VGMSmplRateMul /
+                 Player->VGMSmplRateDiv);
 }
 
-INT32 SamplePlayback2VGM(INT32 SampleVal) {
-  return (INT32)((INT64)SampleVal * VGMSmplRateDiv / VGMSmplRateMul);
+INT32 SamplePlayback2VGM(VGM_PLAYER *Player, INT32 SampleVal) {
+  return (INT32)((INT64)SampleVal * Player->VGMSmplRateDiv /
+                 Player->VGMSmplRateMul);
 }
 
 // static bool SetMuteControl(HMIXEROBJ hmixer, MIXERCONTROL* mxc, bool mute)
-static bool SetMuteControl(bool mute) {
+static bool SetMuteControl(VGM_PLAYER *Player, bool mute) {
 #ifdef MIXER_MUTING
 
   UINT16 mix_vol;
@@ -2036,60 +2445,62 @@ static bool SetMuteControl(bool mute) {
 #else // #indef MIXER_MUTING
   float TempVol;
 
-  TempVol = MasterVol;
+  TempVol = Player->MasterVol;
   if (TempVol > 0.0f)
-    VolumeBak = TempVol;
+    Player->VolumeBak = TempVol;
 
-  MasterVol = mute ? 0.0f : VolumeBak;
-  FinalVol = VolumeLevelM * MasterVol;
+  Player->MasterVol = mute ? 0.0f : Player->VolumeBak;
+  Player->FinalVol = Player->VolumeLevelM * Player->MasterVol;
   RefreshVolume();
 
   return true;
 #endif
 }
 
-static void InterpretFile(UINT32 SampleCount) {
+static void InterpretFile(VGM_PLAYER *Player, UINT32 SampleCount) {
   UINT32 TempLng;
   UINT8 CurChip;
 
-  while (Interpreting)
+  while (Player->Interpreting)
     Sleep(1);
 
-  if (DacCtrlUsed && SampleCount > 1) // handle skipping
+  if (Player->DacCtrlUsed && SampleCount > 1) // handle skipping
   {
-    for (CurChip = 0x00; CurChip < DacCtrlUsed; CurChip++) {
-      daccontrol_update(DacCtrlUsg[CurChip], SampleCount - 1);
+    for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+      daccontrol_update(Player->DacInfo[Player->DacCtrlUsg[CurChip]],
+                        SampleCount - 1);
     }
   }
 
-  Interpreting = true;
-  if (!FileMode)
-    InterpretVGM(SampleCount);
+  Player->Interpreting = true;
+  if (!Player->FileMode)
+    InterpretVGM(Player, SampleCount);
 
 
-  if (DacCtrlUsed && SampleCount) {
-    for (CurChip = 0x00; CurChip < DacCtrlUsed; CurChip++) {
-      daccontrol_update(DacCtrlUsg[CurChip], 1);
+  if (Player->DacCtrlUsed && SampleCount) {
+    for (CurChip = 0x00; CurChip < Player->DacCtrlUsed; CurChip++) {
+      daccontrol_update(Player->DacInfo[Player->DacCtrlUsg[CurChip]], 1);
     }
   }
 
-  if (AutoStopSkip && SampleCount) {
+  if (Player->AutoStopSkip && SampleCount) {
     StopSkipping();
-    AutoStopSkip = false;
+    Player->AutoStopSkip = false;
   }
 
-  if (!PausePlay || ForceVGMExec)
-    VGMSmplPlayed += SampleCount;
-  PlayingTime += SampleCount;
+  if (!Player->PausePlay || Player->ForceVGMExec)
+    Player->VGMSmplPlayed += SampleCount;
+  Player->PlayingTime += SampleCount;
 
 
 
-  Interpreting = false;
+  Player->Interpreting = false;
 
   return;
 }
 
-static void AddPCMData(UINT8 Type, UINT32 DataSize, const UINT8 *Data) {
+static void AddPCMData(VGM_PLAYER *Player, UINT8 Type, UINT32 DataSize,
+                       const UINT8 *Data) {
   UINT32 CurBnk;
   VGM_PCM_BANK *TempPCM;
   VGM_PCM_DATA *TempBnk;
@@ -2099,15 +2510,15 @@ static void AddPCMData(UINT8 Type, UINT32 DataSize, const UINT8 *Data) {
   UINT8 CurDAC;
 
   BnkType = Type & 0x3F;
-  if (BnkType >= PCM_BANK_COUNT || VGMCurLoop)
+  if (BnkType >= PCM_BANK_COUNT || Player->VGMCurLoop)
     return;
 
   if (Type == 0x7F) {
-    ReadPCMTable(DataSize, Data);
+    ReadPCMTable(Player, DataSize, Data);
     return;
   }
 
-  TempPCM = &PCMBank[BnkType];
+  TempPCM = &Player->PCMBank[BnkType];
   TempPCM->BnkPos++;
   if (TempPCM->BnkPos <= TempPCM->BankCount)
     return;
@@ -2129,14 +2540,14 @@ static void AddPCMData(UINT8 Type, UINT32 DataSize, const UINT8 *Data) {
     memcpy(TempBnk->Data, Data, DataSize);
   } else {
     TempBnk->Data = TempPCM->Data + TempBnk->DataStart;
-    RetVal = DecompressDataBlk(TempBnk, DataSize, Data);
+    RetVal = DecompressDataBlk(Player, TempBnk, DataSize, Data);
     if (!RetVal) {
       TempBnk->Data = NULL;
       TempBnk->DataSize = 0x00;
-      for (CurDAC = 0x00; CurDAC < DacCtrlUsed; CurDAC++) {
-        if (DacCtrl[DacCtrlUsg[CurDAC]].Bank == BnkType)
-          daccontrol_refresh_data(DacCtrlUsg[CurDAC], TempPCM->Data,
-                                  TempPCM->DataSize);
+      for (CurDAC = 0x00; CurDAC < Player->DacCtrlUsed; CurDAC++) {
+        if (Player->DacCtrl[Player->DacCtrlUsg[CurDAC]].Bank == BnkType)
+          daccontrol_refresh_data(Player->DacInfo[Player->DacCtrlUsg[CurDAC]],
+                                  TempPCM->Data, TempPCM->DataSize);
       }
       return;
     }
@@ -2145,17 +2556,17 @@ static void AddPCMData(UINT8 Type, UINT32 DataSize, const UINT8 *Data) {
     fprintf(stderr, "Error reading Data Block! Data Size conflict!\n");
   TempPCM->DataSize += BankSize;
 
-  for (CurDAC = 0x00; CurDAC < DacCtrlUsed; CurDAC++) {
-    if (DacCtrl[DacCtrlUsg[CurDAC]].Bank == BnkType)
-      daccontrol_refresh_data(DacCtrlUsg[CurDAC], TempPCM->Data,
-                              TempPCM->DataSize);
+  for (CurDAC = 0x00; CurDAC < Player->DacCtrlUsed; CurDAC++) {
+    if (Player->DacCtrl[Player->DacCtrlUsg[CurDAC]].Bank == BnkType)
+      daccontrol_refresh_data(Player->DacInfo[Player->DacCtrlUsg[CurDAC]],
+                              TempPCM->Data, TempPCM->DataSize);
   }
 
   return;
 }
 
-static bool DecompressDataBlk(VGM_PCM_DATA *Bank, UINT32 DataSize,
-                              const UINT8 *Data) {
+static bool DecompressDataBlk(VGM_PLAYER *Player, VGM_PCM_DATA *Bank,
+                              UINT32 DataSize, const UINT8 *Data) {
   UINT8 ComprType;
   UINT8 BitDec;
   FUINT8 BitCmp;
@@ -2194,15 +2605,16 @@ static bool DecompressDataBlk(VGM_PCM_DATA *Bank, UINT32 DataSize,
     Ent2B = NULL;
 
     if (CmpSubType == 0x02) {
-      Ent1B = (UINT8 *)PCMTbl.Entries;
-      Ent2B = (UINT16 *)PCMTbl.Entries;
-      if (!PCMTbl.EntryCount) {
+      Ent1B = (UINT8 *)Player->PCMTbl.Entries;
+      Ent2B = (UINT16 *)Player->PCMTbl.Entries;
+      if (!Player->PCMTbl.EntryCount) {
         Bank->DataSize = 0x00;
         fprintf(
             stderr,
             "Error loading table-compressed data block! No table loaded!\n");
         return false;
-      } else if (BitDec != PCMTbl.BitDec || BitCmp != PCMTbl.BitCmp) {
+      } else if (BitDec != Player->PCMTbl.BitDec ||
+                 BitCmp != Player->PCMTbl.BitCmp) {
         Bank->DataSize = 0x00;
         fprintf(stderr,
                 "Warning! Data block and loaded value table incompatible!\n");
@@ -2286,14 +2698,15 @@ static bool DecompressDataBlk(VGM_PCM_DATA *Bank, UINT32 DataSize,
     BitCmp = Data[0x06];
     OutVal = ReadLE16(&Data[0x08]);
 
-    Ent1B = (UINT8 *)PCMTbl.Entries;
-    Ent2B = (UINT16 *)PCMTbl.Entries;
-    if (!PCMTbl.EntryCount) {
+    Ent1B = (UINT8 *)Player->PCMTbl.Entries;
+    Ent2B = (UINT16 *)Player->PCMTbl.Entries;
+    if (!Player->PCMTbl.EntryCount) {
       Bank->DataSize = 0x00;
       fprintf(stderr,
               "Error loading table-compressed data block! No table loaded!\n");
       return false;
-    } else if (BitDec != PCMTbl.BitDec || BitCmp != PCMTbl.BitCmp) {
+    } else if (BitDec != Player->PCMTbl.BitDec ||
+               BitCmp != Player->PCMTbl.BitCmp) {
       Bank->DataSize = 0x00;
       fprintf(stderr,
               "Warning! Data block and loaded value table incompatible!\n");
@@ -2364,44 +2777,33 @@ static bool DecompressDataBlk(VGM_PCM_DATA *Bank, UINT32 DataSize,
   return true;
 }
 
-static UINT8 GetDACFromPCMBank(void) {
-
-  UINT32 DataPos;
-
-
-  DataPos = PCMBank[0x00].DataPos;
-  if (DataPos >= PCMBank[0x00].DataSize)
-    return 0x80;
-
-  PCMBank[0x00].DataPos++;
-  return PCMBank[0x00].Data[DataPos];
-}
-
-static UINT8 *GetPointerFromPCMBank(UINT8 Type, UINT32 DataPos) {
+static UINT8 *GetPointerFromPCMBank(VGM_PLAYER *Player, UINT8 Type,
+                                    UINT32 DataPos) {
   if (Type >= PCM_BANK_COUNT)
     return NULL;
 
-  if (DataPos >= PCMBank[Type].DataSize)
+  if (DataPos >= Player->PCMBank[Type].DataSize)
     return NULL;
 
-  return &PCMBank[Type].Data[DataPos];
+  return &Player->PCMBank[Type].Data[DataPos];
 }
 
-static void ReadPCMTable(UINT32 DataSize, const UINT8 *Data) {
+static void ReadPCMTable(VGM_PLAYER *Player, UINT32 DataSize,
+                         const UINT8 *Data) {
   UINT8 ValSize;
   UINT32 TblSize;
 
-  PCMTbl.ComprType = Data[0x00];
-  PCMTbl.CmpSubType = Data[0x01];
-  PCMTbl.BitDec = Data[0x02];
-  PCMTbl.BitCmp = Data[0x03];
-  PCMTbl.EntryCount = ReadLE16(&Data[0x04]);
+  Player->PCMTbl.ComprType = Data[0x00];
+  Player->PCMTbl.CmpSubType = Data[0x01];
+  Player->PCMTbl.BitDec = Data[0x02];
+  Player->PCMTbl.BitCmp = Data[0x03];
+  Player->PCMTbl.EntryCount = ReadLE16(&Data[0x04]);
 
-  ValSize = (PCMTbl.BitDec + 7) / 8;
-  TblSize = PCMTbl.EntryCount * ValSize;
+  ValSize = (Player->PCMTbl.BitDec + 7) / 8;
+  TblSize = Player->PCMTbl.EntryCount * ValSize;
 
-  PCMTbl.Entries = realloc(PCMTbl.Entries, TblSize);
-  memcpy(PCMTbl.Entries, &Data[0x06], TblSize);
+  Player->PCMTbl.Entries = realloc(Player->PCMTbl.Entries, TblSize);
+  memcpy(Player->PCMTbl.Entries, &Data[0x06], TblSize);
 
   if (DataSize < 0x06 + TblSize)
     fprintf(stderr, "Warning! Bad PCM Table Length!\n");
@@ -2409,9 +2811,282 @@ static void ReadPCMTable(UINT32 DataSize, const UINT8 *Data) {
   return;
 }
 
-#define CHIP_CHECK(name) (ChipAudio[CurChip].name.ChipType != 0xFF)
-static void InterpretVGM(UINT32 SampleCount) {
-  INT32 SmplPlayed;
+static UINT32 AddVGMEvent(VGM_PLAYER *Player, UINT32 Smpl, UINT32 Pos,
+                          UINT8 Type, UINT8 ChipID, UINT8 Port, UINT8 Reg,
+                          UINT8 Data) {
+  VGM_EVENT *TempEvt;
+
+  if (Player->VGMEvtCount >= Player->VGMEvtAlloc) {
+    Player->VGMEvtAlloc =
+        Player->VGMEvtAlloc ? Player->VGMEvtAlloc * 2 : 0x1000;
+    Player->VGMEvts = (VGM_EVENT *)realloc(
+        Player->VGMEvts, Player->VGMEvtAlloc * sizeof(VGM_EVENT));
+  }
+  TempEvt = &Player->VGMEvts[Player->VGMEvtCount];
+  TempEvt->Smpl = Smpl;
+  TempEvt->Pos = Pos;
+  TempEvt->Type = Type;
+  TempEvt->ChipID = ChipID;
+  TempEvt->Port = Port;
+  TempEvt->Reg = Reg;
+  TempEvt->Data = Data;
+
+  return Player->VGMEvtCount++;
+}
+
+static void CompileVGMEvents(VGM_PLAYER *Player) {
+  UINT32 VGMPnt;
+  UINT32 CmdLen;
+  UINT32 Smpl;
+  UINT32 LastSmpl;
+  UINT8 Command;
+  UINT8 CurChip;
+  UINT8 ChipType;
+  UINT8 ChipUsed[0x02][CHIP_COUNT];
+  bool LoopFound;
+
+  for (CurChip = 0x00; CurChip < 0x02; CurChip++) {
+    for (ChipType = 0x00; ChipType < CHIP_COUNT; ChipType++)
+      ChipUsed[CurChip][ChipType] =
+          GetChipClock(Player, (CurChip << 7) | ChipType, NULL) ? 0x01 : 0x00;
+  }
+
+  Player->VGMEvts = NULL;
+  Player->VGMEvtCount = 0x00;
+  Player->VGMEvtAlloc = 0x00;
+  Player->VGMEvtLoop = 0x00;
+  Player->VGMLoopSmpl = 0x00;
+  LoopFound = !Player->VGMHead.lngLoopOffset;
+
+  VGMPnt = Player->VGMHead.lngDataOffset;
+  Smpl = 0x00;
+  LastSmpl = 0x00;
+  while (VGMPnt < Player->VGMHead.lngEOFOffset) {
+    if (!LoopFound && VGMPnt >= Player->VGMHead.lngLoopOffset) {
+      Player->VGMEvtLoop = Player->VGMEvtCount;
+      Player->VGMLoopSmpl = Smpl;
+      LoopFound = true;
+    }
+    LastSmpl = Smpl;
+
+    Command = Player->VGMData[VGMPnt + 0x00];
+    if (Command >= 0x70 && Command <= 0x8F) {
+      if (Command < 0x80)
+        Smpl += (Command & 0x0F) + 0x01;
+      else // the YM2612 DAC write is never played back, only the wait counts
+        Smpl += (Command & 0x0F);
+      VGMPnt += 0x01;
+      continue;
+    }
+
+    switch (Command & 0xF0) {
+    case 0x30:
+      CmdLen = 0x02;
+      break;
+    case 0x40:
+    case 0x50:
+    case 0xA0:
+    case 0xB0:
+      CmdLen = 0x03;
+      break;
+    case 0xC0:
+    case 0xD0:
+      CmdLen = 0x04;
+      break;
+    case 0xE0:
+    case 0xF0:
+      CmdLen = 0x05;
+      break;
+    default:
+      CmdLen = 0x01;
+      break;
+    }
+    switch (Command) {
+    case 0x4F:
+    case 0x50:
+      CmdLen = 0x02;
+      break;
+    case 0x61:
+      CmdLen = 0x03;
+      break;
+    case 0x67:
+      CmdLen = 0x07;
+      break;
+    case 0x90:
+    case 0x91:
+    case 0x95:
+      CmdLen = 0x05;
+      break;
+    case 0x92:
+      CmdLen = 0x06;
+      break;
+    case 0x93:
+      CmdLen = 0x0B;
+      break;
+    case 0x94:
+      CmdLen = 0x02;
+      break;
+    }
+    if (VGMPnt + CmdLen > Player->VGMHead.lngEOFOffset)
+      break;
+    if (Command == 0x67) {
+      CmdLen += ReadLE32(&Player->VGMData[VGMPnt + 0x03]) & 0x7FFFFFFF;
+      if (VGMPnt + CmdLen > Player->VGMHead.lngEOFOffset)
+        break;
+    }
+
+    // resolve the second chip of dual-chip VGMs
+    CurChip = 0x00;
+    switch (Command) {
+    case 0x30:
+      if (Player->VGMHead.lngHzPSG & 0x40000000) {
+        Command += 0x20;
+        CurChip = 0x01;
+      }
+      break;
+    case 0x3F:
+      if (Player->VGMHead.lngHzPSG & 0x40000000) {
+        Command += 0x10;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xA1:
+      if (Player->VGMHead.lngHzYM2413 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xA4:
+      if (Player->VGMHead.lngHzYM2151 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xAA:
+      if (Player->VGMHead.lngHzYM3812 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xAB:
+      if (Player->VGMHead.lngHzYM3526 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xAC:
+      if (Player->VGMHead.lngHzY8950 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    case 0xAE:
+    case 0xAF:
+      if (Player->VGMHead.lngHzYMF262 & 0x40000000) {
+        Command -= 0x50;
+        CurChip = 0x01;
+      }
+      break;
+    }
+
+#define ADD_CHIP_EVENT(type, id, port, reg, data)                              \
+  if (ChipUsed[id][type])                                                      \
+  AddVGMEvent(Player, Smpl, VGMPnt, type, id, port, reg, data)
+    switch (Command) {
+    case 0x66: // End of Sound Data / Loop
+      AddVGMEvent(Player, Smpl, VGMPnt, VGMEVT_END, 0x00, 0x00, 0x00, 0x00);
+      // the data behind the end command is never played
+      VGMPnt = Player->VGMHead.lngEOFOffset;
+      break;
+    case 0x62: // 1/60s delay
+      Smpl += 735;
+      break;
+    case 0x63: // 1/50s delay
+      Smpl += 882;
+      break;
+    case 0x61: // xx Sample Delay
+      Smpl += ReadLE16(&Player->VGMData[VGMPnt + 0x01]);
+      break;
+    case 0x50: // SN76496 write
+      ADD_CHIP_EVENT(0x00, CurChip, 0x00, 0x00, Player->VGMData[VGMPnt + 0x01]);
+      break;
+    case 0x4F: // GG Stereo
+      ADD_CHIP_EVENT(0x00, CurChip, 0x01, 0x00, Player->VGMData[VGMPnt + 0x01]);
+      break;
+    case 0x51: // YM2413 write
+    case 0x54: // YM2151 write
+    case 0x5A: // YM3812 write
+    case 0x5B: // YM3526 write
+    case 0x5C: // Y8950 write
+      ChipType = (Command == 0x51)   ? 0x01
+                 : (Command == 0x54) ? 0x02
+                                     : Command - 0x57;
+      ADD_CHIP_EVENT(ChipType, CurChip, 0x00, Player->VGMData[VGMPnt + 0x01],
+                     Player->VGMData[VGMPnt + 0x02]);
+      break;
+    case 0x5E: // YMF262 write port 0
+    case 0x5F: // YMF262 write port 1
+      ADD_CHIP_EVENT(0x06, CurChip, Command & 0x01,
+                     Player->VGMData[VGMPnt + 0x01],
+                     Player->VGMData[VGMPnt + 0x02]);
+      break;
+    case 0xD0: // YMF278B write
+      CurChip = (Player->VGMData[VGMPnt + 0x01] & 0x80) >> 7;
+      ADD_CHIP_EVENT(0x07, CurChip, Player->VGMData[VGMPnt + 0x01] & 0x7F,
+                     Player->VGMData[VGMPnt + 0x02],
+                     Player->VGMData[VGMPnt + 0x03]);
+      break;
+    case 0xA0: // AY8910 write
+      CurChip = (Player->VGMData[VGMPnt + 0x01] & 0x80) >> 7;
+      ADD_CHIP_EVENT(0x08, CurChip, 0x00, Player->VGMData[VGMPnt + 0x01] & 0x7F,
+                     Player->VGMData[VGMPnt + 0x02]);
+      break;
+    case 0xD2: // SCC1 write
+      CurChip = (Player->VGMData[VGMPnt + 0x01] & 0x80) >> 7;
+      ADD_CHIP_EVENT(0x09, CurChip, Player->VGMData[VGMPnt + 0x01] & 0x7F,
+                     Player->VGMData[VGMPnt + 0x02],
+                     Player->VGMData[VGMPnt + 0x03]);
+      break;
+    case 0x67: // PCM Data Stream
+    case 0xE0: // Seek to PCM Data Bank Pos
+    case 0x31: // Set AY8910 stereo mask
+    case 0x90: // DAC Ctrl: Setup Chip
+    case 0x91: // DAC Ctrl: Set Data
+    case 0x92: // DAC Ctrl: Set Freq
+    case 0x93: // DAC Ctrl: Play from Start Pos
+    case 0x94: // DAC Ctrl: Stop immediately
+    case 0x95: // DAC Ctrl: Play Block (small)
+      AddVGMEvent(Player, Smpl, VGMPnt, VGMEVT_CMD, 0x00, 0x00, 0x00, 0x00);
+      break;
+    default:
+      switch (Command & 0xF0) {
+      case 0x60:
+      case 0x90:
+        // unknown command without a known length - stop playback here
+        AddVGMEvent(Player, Smpl, VGMPnt, VGMEVT_STOP, 0x00, 0x00, 0x00, 0x00);
+        VGMPnt = Player->VGMHead.lngEOFOffset;
+        break;
+      }
+      break;
+    }
+#undef ADD_CHIP_EVENT
+    VGMPnt += CmdLen;
+  }
+
+  // The stream is always terminated with an EOF event, so that the player
+  // never runs past the end of the array.
+  if (!LoopFound) {
+    Player->VGMEvtLoop = Player->VGMEvtCount;
+    Player->VGMLoopSmpl = LastSmpl;
+  }
+  AddVGMEvent(Player, LastSmpl, Player->VGMHead.lngEOFOffset, VGMEVT_EOF, 0x00,
+              0x00, 0x00, 0x00);
+
+  return;
+}
+
+#define CHIP_CHECK(name) (Player->ChipAudio[CurChip].name.ChipType != 0xFF)
+static void InterpretVGMCmd(VGM_PLAYER *Player, UINT32 CmdPos) {
   UINT8 Command;
   UINT8 TempByt;
   UINT16 TempSht;
@@ -2423,470 +3098,335 @@ static void InterpretVGM(UINT32 SampleCount) {
   UINT32 DataLen;
   const UINT8 *ROMData;
   UINT8 CurChip;
+  void *DstChip;
   const UINT8 *VGMPnt;
 
-  if (VGMEnd)
-    return;
-  if (PausePlay && !ForceVGMExec)
-    return;
+  VGMPnt = &Player->VGMData[CmdPos];
+  Command = VGMPnt[0x00];
+  CurChip = 0x00;
+  switch (Command) {
+  case 0x67: // PCM Data Stream
+    TempByt = VGMPnt[0x02];
+    TempLng = ReadLE32(&VGMPnt[0x03]);
+    if (TempLng & 0x80000000) {
+      TempLng &= 0x7FFFFFFF;
+      CurChip = 0x01;
+    }
 
-  SmplPlayed = SamplePbk2VGM_I(VGMSmplPlayed + SampleCount);
-  while (VGMSmplPos <= SmplPlayed) {
-    Command = VGMData[VGMPos + 0x00];
-    if (Command >= 0x70 && Command <= 0x8F) {
-      switch (Command & 0xF0) {
-      case 0x70:
-        VGMSmplPos += (Command & 0x0F) + 0x01;
+    switch (TempByt & 0xC0) {
+    case 0x00: // Database Block
+    case 0x40:
+      AddPCMData(Player, TempByt, TempLng, &VGMPnt[0x07]);
+      break;
+    case 0x80: // ROM/RAM Dump
+      if (Player->VGMCurLoop)
         break;
-      case 0x80:
-        GetDACFromPCMBank();
-        VGMSmplPos += (Command & 0x0F);
+
+      ROMSize = ReadLE32(&VGMPnt[0x07]);
+      DataStart = ReadLE32(&VGMPnt[0x0B]);
+      DataLen = TempLng - 0x08;
+      ROMData = &VGMPnt[0x0F];
+      switch (TempByt) {
+      case 0x84: // YMF278B ROM Image
+        if (!CHIP_CHECK(YMF278B))
+          break;
+        ymf278b_write_rom(Player->ChipAudio[CurChip].YMF278B.Info, ROMSize,
+                          DataStart, DataLen, ROMData);
         break;
-      }
-      VGMPos += 0x01;
-    } else {
-      VGMPnt = &VGMData[VGMPos];
-
-      CurChip = 0x00;
-      switch (Command) {
-      case 0x30:
-        if (VGMHead.lngHzPSG & 0x40000000) {
-          Command += 0x20;
-          CurChip = 0x01;
-        }
+      case 0x87: // YMF278B RAM Image
+        if (!CHIP_CHECK(YMF278B))
+          break;
+        ymf278b_write_ram(Player->ChipAudio[CurChip].YMF278B.Info, DataStart,
+                          DataLen, ROMData);
         break;
-      case 0x3F:
-        if (VGMHead.lngHzPSG & 0x40000000) {
-          Command += 0x10;
-          CurChip = 0x01;
-        }
+      case 0x88: // Y8950 DELTA-T ROM Image
+        if (!CHIP_CHECK(Y8950))
+          break;
+        y8950_write_data_pcmrom(Player->ChipAudio[CurChip].Y8950.Info, ROMSize,
+                                DataStart, DataLen, ROMData);
         break;
-      case 0xA1:
-        if (VGMHead.lngHzYM2413 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
-        break;
-      case 0xA4:
-        if (VGMHead.lngHzYM2151 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
-        break;
-      case 0xAA:
-        if (VGMHead.lngHzYM3812 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
-        break;
-      case 0xAB:
-        if (VGMHead.lngHzYM3526 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
-        break;
-      case 0xAC:
-        if (VGMHead.lngHzY8950 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
+      }
+      break;
+    case 0xC0: // RAM Write
+      break;
+    }
+    break;
+  case 0xE0: // Seek to PCM Data Bank Pos
+    Player->PCMBank[0x00].DataPos = ReadLE32(&VGMPnt[0x01]);
+    break;
+  case 0x31: // Set AY8910 stereo mask
+    TempByt = VGMPnt[0x01];
+    CurChip = (TempByt & 0x80) >> 7;
+    if (CHIP_CHECK(AY8910)) {
+      ayxx_set_stereo_mask(Player->ChipAudio[CurChip].AY8910.Info,
+                           TempByt & 0x3F);
+    }
+    break;
+  case 0x90: // DAC Ctrl: Setup Chip
+    CurChip = VGMPnt[0x01];
+    if (CurChip == 0xFF)
+      break;
+    if (!Player->DacCtrl[CurChip].Enable) {
+      // the handle survives seeking back before the setup
+      if (Player->DacInfo[CurChip] == NULL &&
+          !device_start_daccontrol(&Player->DacInfo[CurChip]))
         break;
-      case 0xAE:
-      case 0xAF:
-        if (VGMHead.lngHzYMF262 & 0x40000000) {
-          Command -= 0x50;
-          CurChip = 0x01;
-        }
+      device_reset_daccontrol(Player->DacInfo[CurChip]);
+      Player->DacCtrl[CurChip].Enable = true;
+      Player->DacCtrlUsg[Player->DacCtrlUsed] = CurChip;
+      Player->DacCtrlUsed++;
+    }
+    TempByt = VGMPnt[0x02]; // Chip Type
+    TempSht = ReadBE16(&VGMPnt[0x03]);
+    DstChip = NULL;
+    if ((TempByt & 0x7F) < CHIP_COUNT)
+      DstChip = ((CAUD_ATTR *)&Player->ChipAudio[(TempByt & 0x80) >> 7] +
+                 (TempByt & 0x7F))->Info;
+    daccontrol_setup_chip(Player->DacInfo[CurChip], TempByt & 0x7F, DstChip,
+                          TempSht);
+    break;
+  case 0x91: // DAC Ctrl: Set Data
+    CurChip = VGMPnt[0x01];
+    if (CurChip == 0xFF || !Player->DacCtrl[CurChip].Enable)
+      break;
+    Player->DacCtrl[CurChip].Bank = VGMPnt[0x02];
+    if (Player->DacCtrl[CurChip].Bank >= PCM_BANK_COUNT)
+      Player->DacCtrl[CurChip].Bank = 0x00;
+
+    TempPCM = &Player->PCMBank[Player->DacCtrl[CurChip].Bank];
+    daccontrol_set_data(Player->DacInfo[CurChip], TempPCM->Data,
+                        TempPCM->DataSize, VGMPnt[0x03], VGMPnt[0x04]);
+    break;
+  case 0x92: // DAC Ctrl: Set Freq
+    CurChip = VGMPnt[0x01];
+    if (CurChip == 0xFF || !Player->DacCtrl[CurChip].Enable)
+      break;
+    TempLng = ReadLE32(&VGMPnt[0x02]);
+    daccontrol_set_frequency(Player->DacInfo[CurChip], TempLng);
+    break;
+  case 0x93: // DAC Ctrl: Play from Start Pos
+    CurChip = VGMPnt[0x01];
+    if (CurChip == 0xFF || !Player->DacCtrl[CurChip].Enable ||
+        !Player->PCMBank[Player->DacCtrl[CurChip].Bank].BankCount)
+      break;
+    DataStart = ReadLE32(&VGMPnt[0x02]);
+    TempByt = VGMPnt[0x06];
+    DataLen = ReadLE32(&VGMPnt[0x07]);
+    daccontrol_start(Player->DacInfo[CurChip], DataStart, TempByt, DataLen);
+    break;
+  case 0x94: // DAC Ctrl: Stop immediately
+    CurChip = VGMPnt[0x01];
+    if (CurChip < 0xFF) {
+      if (!Player->DacCtrl[CurChip].Enable)
         break;
+      daccontrol_stop(Player->DacInfo[CurChip]);
+    } else {
+      for (CurChip = 0x00; CurChip < 0xFF; CurChip++) {
+        if (Player->DacInfo[CurChip] != NULL)
+          daccontrol_stop(Player->DacInfo[CurChip]);
       }
+    }
+    break;
+  case 0x95: // DAC Ctrl: Play Block (small)
+    CurChip = VGMPnt[0x01];
+    if (CurChip == 0xFF || !Player->DacCtrl[CurChip].Enable ||
+        !Player->PCMBank[Player->DacCtrl[CurChip].Bank].BankCount)
+      break;
+    TempPCM = &Player->PCMBank[Player->DacCtrl[CurChip].Bank];
+    TempSht = ReadLE16(&VGMPnt[0x02]);
+    if (TempSht >= TempPCM->BankCount)
+      TempSht = 0x00;
+    TempBnk = &TempPCM->Bank[TempSht];
+
+    TempByt = DCTRL_LMODE_BYTES | (VGMPnt[0x04] & 0x10) | // Reverse Mode
+              ((VGMPnt[0x04] & 0x01) << 7);               // Looping
+    daccontrol_start(Player->DacInfo[CurChip], TempBnk->DataStart, TempByt,
+                     TempBnk->DataSize);
+    break;
+  }
 
-      switch (Command) {
-      case 0x66:
-        if (VGMHead.lngLoopOffset) {
-          VGMPos = VGMHead.lngLoopOffset;
-          VGMSmplPos -= VGMHead.lngLoopSamples;
-          VGMSmplPlayed -= SampleVGM2Pbk_I(VGMHead.lngLoopSamples);
-          SmplPlayed = SamplePbk2VGM_I(VGMSmplPlayed + SampleCount);
-          VGMCurLoop++;
+  return;
+}
 
-          if (VGMMaxLoopM && VGMCurLoop >= VGMMaxLoopM) {
-#ifndef CONSOLE_MODE
-            if (FadePlay) {
-              FadeStart =
-                  SampleVGM2Pbk_I(VGMHead.lngTotalSamples +
-                                  (VGMCurLoop - 1) * VGMHead.lngLoopSamples);
-            }
-#endif
-            FadePlay = true;
-          }
-          if (FadePlay && !FadeTime)
-            VGMEnd = true;
-        } else {
-          if (VGMHead.lngTotalSamples != (UINT32)VGMSmplPos) {
+static void InterpretVGM(VGM_PLAYER *Player, UINT32 SampleCount) {
+  INT32 SmplPlayed;
+  const VGM_EVENT *Evt;
 
-            VGMHead.lngTotalSamples = VGMSmplPos;
-          }
+  if (Player->VGMEnd)
+    return;
+  if (Player->PausePlay && !Player->ForceVGMExec)
+    return;
 
-          if (HardStopOldVGMs) {
-            if (VGMHead.lngVersion < 0x150 ||
-                (VGMHead.lngVersion == 0x150 && HardStopOldVGMs == 0x02))
-              Chips_GeneralActions(
-                  0x01); // reset all chips, for instant silence
-          }
-          VGMEnd = true;
-          break;
-        }
-        break;
-      case 0x62: // 1/60s delay
-        VGMSmplPos += 735;
-        VGMPos += 0x01;
-        break;
-      case 0x63: // 1/50s delay
-        VGMSmplPos += 882;
-        VGMPos += 0x01;
-        break;
-      case 0x61: // xx Sample Delay
-        TempSht = ReadLE16(&VGMPnt[0x01]);
-        VGMSmplPos += TempSht;
-        VGMPos += 0x03;
-        break;
-      case 0x50: // SN76496 write
-        if (CHIP_CHECK(SN76496)) {
-          chip_reg_write(0x00, CurChip, 0x00, 0x00, VGMPnt[0x01]);
-        }
-        VGMPos += 0x02;
-        break;
-      case 0x51: // YM2413 write
-        if (CHIP_CHECK(YM2413)) {
-          chip_reg_write(0x01, CurChip, 0x00, VGMPnt[0x01], VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
+  SmplPlayed = SamplePbk2VGM_I(Player, Player->VGMSmplPlayed + SampleCount);
+  Evt = &Player->VGMEvts[Player->VGMEvtPos];
+  while (Player->VGMSmplPos <= SmplPlayed) {
+    if (Evt->Type < CHIP_COUNT) {
+      if (Player->QueueWrites)
+        QueueChipWrite(Player, Evt);
+      else
+        chip_reg_write(
+            Evt->Type,
+            ((CAUD_ATTR *)&Player->ChipAudio[Evt->ChipID])[Evt->Type].Info,
+            Evt->Port, Evt->Reg, Evt->Data);
+      Evt++;
+    } else {
+      switch (Evt->Type) {
+      case VGMEVT_CMD:
+        // the other commands access the chips directly
+        DrainChipQueues(Player);
+        InterpretVGMCmd(Player, Evt->Pos);
+        Evt++;
         break;
-      case 0x67: // PCM Data Stream
-        TempByt = VGMPnt[0x02];
-        TempLng = ReadLE32(&VGMPnt[0x03]);
-        if (TempLng & 0x80000000) {
-          TempLng &= 0x7FFFFFFF;
-          CurChip = 0x01;
-        }
+      case VGMEVT_END:
+        if (Player->VGMHead.lngLoopOffset) {
+          Player->VGMSmplOfs += (INT32)(Evt->Smpl - Player->VGMLoopSmpl) -
+                                (INT32)Player->VGMHead.lngLoopSamples;
+          Evt = &Player->VGMEvts[Player->VGMEvtLoop];
+          Player->VGMSmplPlayed -=
+              SampleVGM2Pbk_I(Player, Player->VGMHead.lngLoopSamples);
+          SmplPlayed =
+              SamplePbk2VGM_I(Player, Player->VGMSmplPlayed + SampleCount);
+          Player->VGMCurLoop++;
+
+          // The fade starts once. Restarting it at every loop would never
+          // end songs whose loop is shorter than the fade time.
+          if (Player->VGMMaxLoopM && Player->VGMCurLoop >= Player->VGMMaxLoopM)
+            Player->FadePlay = true;
+          if (Player->FadePlay && !Player->FadeTime)
+            Player->VGMEnd = true;
+        } else {
+          if (Player->VGMHead.lngTotalSamples != (UINT32)Player->VGMSmplPos) {
 
-        switch (TempByt & 0xC0) {
-        case 0x00: // Database Block
-        case 0x40:
-          AddPCMData(TempByt, TempLng, &VGMPnt[0x07]);
-          break;
-        case 0x80: // ROM/RAM Dump
-          if (VGMCurLoop)
-            break;
-
-          ROMSize = ReadLE32(&VGMPnt[0x07]);
-          DataStart = ReadLE32(&VGMPnt[0x0B]);
-          DataLen = TempLng - 0x08;
-          ROMData = &VGMPnt[0x0F];
-          switch (TempByt) {
-          case 0x84: // YMF278B ROM Image
-            if (!CHIP_CHECK(YMF278B))
-              break;
-            ymf278b_write_rom(CurChip, ROMSize, DataStart, DataLen, ROMData);
-            break;
-          case 0x87: // YMF278B RAM Image
-            if (!CHIP_CHECK(YMF278B))
-              break;
-            ymf278b_write_ram(CurChip, DataStart, DataLen, ROMData);
-            break;
-          case 0x88: // Y8950 DELTA-T ROM Image
-            if (!CHIP_CHECK(Y8950))
-              break;
-            y8950_write_data_pcmrom(CurChip, ROMSize, DataStart, DataLen,
-                                    ROMData);
-            break;
+            Player->VGMHead.lngTotalSamples = Player->VGMSmplPos;
           }
-          break;
-        case 0xC0: // RAM Write
-          if (!(TempByt & 0x20)) {
-            DataStart = ReadLE16(&VGMPnt[0x07]);
-            DataLen = TempLng - 0x02;
-            ROMData = &VGMPnt[0x09];
-          } else {
-            DataStart = ReadLE32(&VGMPnt[0x07]);
-            DataLen = TempLng - 0x04;
-            ROMData = &VGMPnt[0x0B];
+
+          if (HardStopOldVGMs) {
+            if (Player->VGMHead.lngVersion < 0x150 ||
+                (Player->VGMHead.lngVersion == 0x150 &&
+                 HardStopOldVGMs == 0x02)) {
+              DrainChipQueues(Player);
+              Chips_GeneralActions(Player, 0x01); // reset all chips, for
+                                                  // instant silence
+            }
           }
-          break;
-        }
-        VGMPos += 0x07 + TempLng;
-        break;
-      case 0xE0: // Seek to PCM Data Bank Pos
-        PCMBank[0x00].DataPos = ReadLE32(&VGMPnt[0x01]);
-        VGMPos += 0x05;
-        break;
-      case 0x31: // Set AY8910 stereo mask
-        TempByt = VGMPnt[0x01];
-        CurChip = (TempByt & 0x80) >> 7;
-        if (CHIP_CHECK(AY8910)) {
-          ayxx_set_stereo_mask(CurChip, TempByt & 0x3F);
-        }
-        VGMPos += 0x02;
-        break;
-      case 0x4F: // GG Stereo
-        if (CHIP_CHECK(SN76496)) {
-          chip_reg_write(0x00, CurChip, 0x01, 0x00, VGMPnt[0x01]);
-        }
-        VGMPos += 0x02;
-        break;
-      case 0x54: // YM2151 write
-        if (CHIP_CHECK(YM2151)) {
-          chip_reg_write(0x03, CurChip, 0x01, VGMPnt[0x01], VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0x5A: // YM3812 write
-        if (CHIP_CHECK(YM3812)) {
-          chip_reg_write(0x09, CurChip, 0x00, VGMPnt[0x01], VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0x5B: // YM3526 write
-        if (CHIP_CHECK(YM3526)) {
-          chip_reg_write(0x04, CurChip, 0x00, VGMPnt[0x01], VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0x5C: // Y8950 write
-        if (CHIP_CHECK(Y8950)) {
-          chip_reg_write(0x05, CurChip, 0x00, VGMPnt[0x01], VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0x5E: // YMF262 write port 0
-      case 0x5F: // YMF262 write port 1
-        if (CHIP_CHECK(YMF262)) {
-          chip_reg_write(0x06, CurChip, Command & 0x01, VGMPnt[0x01],
-                         VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0xD0: // YMF278B write
-        if (CHIP_CHECK(YMF278B)) {
-          CurChip = (VGMPnt[0x01] & 0x80) >> 7;
-          chip_reg_write(0x07, CurChip, VGMPnt[0x01] & 0x7F, VGMPnt[0x02],
-                         VGMPnt[0x03]);
-        }
-        VGMPos += 0x04;
-        break;
-      case 0xA0: // AY8910 write
-        CurChip = (VGMPnt[0x01] & 0x80) >> 7;
-        if (CHIP_CHECK(AY8910)) {
-          chip_reg_write(0x08, CurChip, 0x00, VGMPnt[0x01] & 0x7F,
-                         VGMPnt[0x02]);
-        }
-        VGMPos += 0x03;
-        break;
-      case 0xD2: // SCC1 write
-        CurChip = (VGMPnt[0x01] & 0x80) >> 7;
-        if (CHIP_CHECK(K051649)) {
-          chip_reg_write(0x09, CurChip, VGMPnt[0x01] & 0x7F, VGMPnt[0x02],
-                         VGMPnt[0x03]);
-        }
-        VGMPos += 0x04;
-        break;
-      case 0x90: // DAC Ctrl: Setup Chip
-        CurChip = VGMPnt[0x01];
-        if (CurChip == 0xFF) {
-          VGMPos += 0x05;
-          break;
-        }
-        if (!DacCtrl[CurChip].Enable) {
-          device_start_daccontrol(CurChip);
-          device_reset_daccontrol(CurChip);
-          DacCtrl[CurChip].Enable = true;
-          DacCtrlUsg[DacCtrlUsed] = CurChip;
-          DacCtrlUsed++;
-        }
-        TempByt = VGMPnt[0x02]; // Chip Type
-        TempSht = ReadBE16(&VGMPnt[0x03]);
-        daccontrol_setup_chip(CurChip, TempByt & 0x7F, (TempByt & 0x80) >> 7,
-                              TempSht);
-        VGMPos += 0x05;
-        break;
-      case 0x91: // DAC Ctrl: Set Data
-        CurChip = VGMPnt[0x01];
-        if (CurChip == 0xFF || !DacCtrl[CurChip].Enable) {
-          VGMPos += 0x05;
-          break;
+          Player->VGMEnd = true;
         }
-        DacCtrl[CurChip].Bank = VGMPnt[0x02];
-        if (DacCtrl[CurChip].Bank >= PCM_BANK_COUNT)
-          DacCtrl[CurChip].Bank = 0x00;
-
-        TempPCM = &PCMBank[DacCtrl[CurChip].Bank];
-        daccontrol_set_data(CurChip, TempPCM->Data, TempPCM->DataSize,
-                            VGMPnt[0x03], VGMPnt[0x04]);
-        VGMPos += 0x05;
         break;
-      case 0x92: // DAC Ctrl: Set Freq
-        CurChip = VGMPnt[0x01];
-        if (CurChip == 0xFF || !DacCtrl[CurChip].Enable) {
-          VGMPos += 0x06;
-          break;
-        }
-        TempLng = ReadLE32(&VGMPnt[0x02]);
-        daccontrol_set_frequency(CurChip, TempLng);
-        VGMPos += 0x06;
+      case VGMEVT_EOF:
+        Player->VGMEnd = true;
         break;
-      case 0x93: // DAC Ctrl: Play from Start Pos
-        CurChip = VGMPnt[0x01];
-        if (CurChip == 0xFF || !DacCtrl[CurChip].Enable ||
-            !PCMBank[DacCtrl[CurChip].Bank].BankCount) {
-          VGMPos += 0x0B;
-          break;
-        }
-        DataStart = ReadLE32(&VGMPnt[0x02]);
-        TempByt = VGMPnt[0x06];
-        DataLen = ReadLE32(&VGMPnt[0x07]);
-        daccontrol_start(CurChip, DataStart, TempByt, DataLen);
-        VGMPos += 0x0B;
-        break;
-      case 0x94: // DAC Ctrl: Stop immediately
-        CurChip = VGMPnt[0x01];
-        if (!DacCtrl[CurChip].Enable) {
-          VGMPos += 0x02;
-          break;
-        }
-        if (CurChip < 0xFF) {
-          daccontrol_stop(CurChip);
-        } else {
-          for (CurChip = 0x00; CurChip < 0xFF; CurChip++)
-            daccontrol_stop(CurChip);
-        }
-        VGMPos += 0x02;
-        break;
-      case 0x95: // DAC Ctrl: Play Block (small)
-        CurChip = VGMPnt[0x01];
-        if (CurChip == 0xFF || !DacCtrl[CurChip].Enable ||
-            !PCMBank[DacCtrl[CurChip].Bank].BankCount) {
-          VGMPos += 0x05;
-          break;
-        }
-        TempPCM = &PCMBank[DacCtrl[CurChip].Bank];
-        TempSht = ReadLE16(&VGMPnt[0x02]);
-        if (TempSht >= TempPCM->BankCount)
-          TempSht = 0x00;
-        TempBnk = &TempPCM->Bank[TempSht];
-
-        TempByt = DCTRL_LMODE_BYTES | (VGMPnt[0x04] & 0x10) | // Reverse Mode
-                  ((VGMPnt[0x04] & 0x01) << 7);               // Looping
-        daccontrol_start(CurChip, TempBnk->DataStart, TempByt,
-                         TempBnk->DataSize);
-        VGMPos += 0x05;
-        break;
-      default:
-#ifdef CONSOLE_MODE
-        if (!CmdList[Command]) {
-          fprintf(stderr, "Unknown command: %02hhX\n", Command);
-          CmdList[Command] = true;
-        }
-#endif
-
-        switch (Command & 0xF0) {
-        case 0x00:
-        case 0x10:
-        case 0x20:
-          VGMPos += 0x01;
-          break;
-        case 0x30:
-          VGMPos += 0x02;
-          break;
-        case 0x40:
-        case 0x50:
-        case 0xA0:
-        case 0xB0:
-          VGMPos += 0x03;
-          break;
-        case 0xC0:
-        case 0xD0:
-          VGMPos += 0x04;
-          break;
-        case 0xE0:
-        case 0xF0:
-          VGMPos += 0x05;
-          break;
-        default:
-          VGMEnd = true;
-          EndPlay = true;
-          break;
-        }
+      case VGMEVT_STOP:
+        Player->VGMEnd = true;
+        Player->EndPlay = true;
         break;
       }
     }
 
-    if (VGMPos >= VGMHead.lngEOFOffset)
-      VGMEnd = true;
-
-    if (VGMEnd)
+    Player->VGMPos = Evt->Pos;
+    Player->VGMSmplPos = (INT32)Evt->Smpl + Player->VGMSmplOfs;
+    if (Player->VGMEnd)
       break;
   }
+  Player->VGMEvtPos = Evt - Player->VGMEvts;
 
   return;
 }
 
-static void GeneralChipLists(void) {
+static void GeneralChipLists(VGM_PLAYER *Player) {
   UINT16 CurBufIdx;
-  CA_LIST *CLstOld;
   CA_LIST *CLst;
   CA_LIST *CurLst;
+  CA_LIST *GrpLst;
+  CA_LIST **LastGrp;
+  CA_LIST **LastLst;
+  UINT8 CurPass;
   UINT8 CurChip;
   UINT8 CurCSet;
   CAUD_ATTR *CAA;
+  bool PauseChip;
 
-  ChipListAll = NULL;
-  ChipListPause = NULL;
+  Player->ChipListAll = NULL;
+  Player->ChipListPause = NULL;
 
+  // Chips that keep playing while paused are added first, so that a group
+  // starts with the same chip (and resampler state) in both lists.
   CurBufIdx = 0x00;
-  CLstOld = NULL;
-  for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++) {
-    for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
-      CAA = (CAUD_ATTR *)&ChipAudio[CurCSet] + CurChip;
-      if (CAA->ChipType != 0xFF) {
-        CLst = &ChipListBuffer[CurBufIdx];
-        CurBufIdx++;
-        if (CLstOld == NULL)
-          ChipListAll = CLst;
-        else
-          CLstOld->next = CLst;
-
-        CLst->CAud = CAA;
-        CLst->COpts = (CHIP_OPTS *)&ChipOpts[CurCSet] + CurChip;
-        CLstOld = CLst;
+  for (CurPass = 0x00; CurPass < 0x02; CurPass++) {
+    for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++) {
+      for (CurCSet = 0x00; CurCSet < 0x02; CurCSet++) {
+        CAA = (CAUD_ATTR *)&Player->ChipAudio[CurCSet] + CurChip;
+        if (CAA->ChipType == 0xFF)
+          continue;
+        for (; CAA != NULL; CAA = CAA->Paired) {
+          PauseChip = (CAA->ChipType != 0x05 && CAA->ChipType != 0x10);
+          if (PauseChip == (CurPass != 0x00))
+            continue;
+          CLst = &Player->ChipListBuffer[CurBufIdx];
+          CurBufIdx++;
+          CLst->CAud = CAA;
+          CLst->COpts = (CHIP_OPTS *)&ChipOpts[CurCSet] + CurChip;
+          CLst->Mixed = false;
+          CLst->SameRate = NULL;
+          CLst->next = NULL;
+
+          LastGrp = &Player->ChipListAll;
+          while (*LastGrp != NULL &&
+                 ((*LastGrp)->CAud->SmpRate != CAA->SmpRate ||
+                  (*LastGrp)->CAud->Resampler != CAA->Resampler))
+            LastGrp = &(*LastGrp)->next;
+          if (*LastGrp == NULL) {
+            *LastGrp = CLst; // new group
+            continue;
+          }
+          (*LastGrp)->Mixed = true;
+          LastLst = &(*LastGrp)->SameRate;
+          while (*LastLst != NULL)
+            LastLst = &(*LastLst)->SameRate;
+          *LastLst = CLst;
+        }
       }
     }
   }
-  if (CLstOld != NULL)
-    CLstOld->next = NULL;
 
-  CLstOld = NULL;
-  CurLst = ChipListAll;
-  while (CurLst != NULL) {
-    if (CurLst->CAud->ChipType != 0x05 && CurLst->CAud->ChipType != 0x10) {
-      CLst = &ChipListBuffer[CurBufIdx];
-      CurBufIdx++;
-      if (CLstOld == NULL)
-        ChipListPause = CLst;
-      else
-        CLstOld->next = CLst;
+  // The upsampler has already rendered the first sample of every chip.
+  // Mixed groups keep it with the volume applied.
+  for (GrpLst = Player->ChipListAll; GrpLst != NULL; GrpLst = GrpLst->next) {
+    if (!GrpLst->Mixed || GrpLst->CAud->Resampler != 0x01)
+      continue;
+    CAA = GrpLst->CAud;
+    CAA->NSmpl.Left *= CAA->Volume;
+    CAA->NSmpl.Right *= CAA->Volume;
+    for (CurLst = GrpLst->SameRate; CurLst != NULL; CurLst = CurLst->SameRate) {
+      CAA->NSmpl.Left += CurLst->CAud->NSmpl.Left * CurLst->CAud->Volume;
+      CAA->NSmpl.Right += CurLst->CAud->NSmpl.Right * CurLst->CAud->Volume;
+    }
+  }
 
+  LastGrp = &Player->ChipListPause;
+  for (GrpLst = Player->ChipListAll; GrpLst != NULL; GrpLst = GrpLst->next) {
+    LastLst = LastGrp;
+    for (CurLst = GrpLst; CurLst != NULL; CurLst = CurLst->SameRate) {
+      CAA = CurLst->CAud;
+      if (CAA->ChipType == 0x05 || CAA->ChipType == 0x10)
+        continue;
+      CLst = &Player->ChipListBuffer[CurBufIdx];
+      CurBufIdx++;
       *CLst = *CurLst;
-      CLstOld = CLst;
+      CLst->SameRate = NULL;
+      CLst->next = NULL;
+      *LastLst = CLst;
+      if (LastLst == LastGrp)
+        LastGrp = &CLst->next;
+      LastLst = &CLst->SameRate;
     }
-    CurLst = CurLst->next;
   }
-  if (CLstOld != NULL)
-    CLstOld->next = NULL;
 
   return;
 }
 
-static void SetupResampler(CAUD_ATTR *CAA) {
+static void SetupResampler(VGM_PLAYER *Player, CAUD_ATTR *CAA) {
+  UINT32 TempLng;
+
   if (!CAA->SmpRate) {
     CAA->Resampler = 0xFF;
     return;
@@ -2902,6 +3442,37 @@ static void SetupResampler(CAUD_ATTR *CAA) {
     if (ResampleMode == 0x02 ||
         (ResampleMode == 0x01 && CAA->Resampler == 0x03))
       CAA->Resampler = 0x00;
+    else if (ResampleMode == 0x03)
+      CAA->Resampler = 0x04;
+  }
+  if (CAA->Resampler == 0x04) {
+    CAA->SincFlt = GetSincFilter(CAA->SmpRate, SampleRate);
+    if (CAA->SincHist == NULL)
+      CAA->SincHist = (float *)malloc(SINC_TAPS_MAX * 0x02 * sizeof(float));
+    if (CAA->SincFlt == NULL || CAA->SincHist == NULL) {
+      CAA->Resampler = (CAA->SmpRate < SampleRate) ? 0x01 : 0x03;
+    } else {
+      memset(CAA->SincHist, 0x00, SINC_TAPS_MAX * 0x02 * sizeof(float));
+    }
+  }
+
+  // a render segment must fit into the stream buffers at the chip's rate
+  TempLng = (UINT32)((UINT64)(SMPL_BUFSIZE - 0x04) * SampleRate / CAA->SmpRate);
+  if (!TempLng)
+    TempLng = 0x01;
+  if (Player->SegSmplsMax > TempLng)
+    Player->SegSmplsMax = TempLng;
+
+  if (Player->ChipWork != NULL) {
+    if (CAA->RenderBufs[0x00] == NULL)
+      CAA->RenderBufs[0x00] = (INT32 *)malloc(RENDER_BUFSIZE * sizeof(INT32));
+    if (CAA->RenderBufs[0x01] == NULL)
+      CAA->RenderBufs[0x01] = (INT32 *)malloc(RENDER_BUFSIZE * sizeof(INT32));
+    if (CAA->RenderBufs[0x00] == NULL || CAA->RenderBufs[0x01] == NULL) {
+      // not enough memory - render serially
+      StopChipWorkers(Player->ChipWork);
+      Player->ChipWork = NULL;
+    }
   }
 
   CAA->SmpP = 0x00;
@@ -2910,9 +3481,9 @@ static void SetupResampler(CAUD_ATTR *CAA) {
   CAA->LSmpl.Left = 0x00;
   CAA->LSmpl.Right = 0x00;
   if (CAA->Resampler == 0x01) {
-    CAA->StreamUpdate(CAA->ChipID, StreamBufs, 1);
-    CAA->NSmpl.Left = StreamBufs[0x00][0x00];
-    CAA->NSmpl.Right = StreamBufs[0x01][0x00];
+    CAA->StreamUpdate(CAA->Info, Player->StreamBufs, 1);
+    CAA->NSmpl.Left = Player->StreamBufs[0x00][0x00];
+    CAA->NSmpl.Right = Player->StreamBufs[0x01][0x00];
   } else {
     CAA->NSmpl.Left = 0x00;
     CAA->NSmpl.Right = 0x00;
@@ -2922,26 +3493,469 @@ static void SetupResampler(CAUD_ATTR *CAA) {
 }
 
 
+static double SincSin(double x) {
+  // minilibm's sin() is only precise enough for the chip tables
+  double x2;
+  double Sign;
+  double Result;
+  UINT8 CurTerm;
+
+  x -= 2.0 * M_PI * floor(x / (2.0 * M_PI) + 0.5); // -> [-pi, pi]
+  Sign = 1.0;
+  if (x < 0.0) {
+    x = -x;
+    Sign = -1.0;
+  }
+  if (x > M_PI / 2)
+    x = M_PI - x; // -> [0, pi/2]
+  // Taylor series up to x^13, evaluated from the highest term down
+  x2 = x * x;
+  Result = 1.0;
+  for (CurTerm = 13; CurTerm > 1; CurTerm -= 2)
+    Result = 1.0 - x2 / (CurTerm * (CurTerm - 1)) * Result;
+  return Sign * x * Result;
+}
+
+static SINC_FILTER *GetSincFilter(UINT32 InRate, UINT32 OutRate) {
+  // returns the (cached) filter bank for a rate ratio, callable from any
+  // player thread
+  SINC_FILTER *Flt;
+  UINT32 CurFlt;
+  UINT32 CurPhase;
+  UINT32 CurTap;
+  double Ratio;
+  double Cutoff;
+  double HalfLen;
+  double Dist;
+  double Sinc;
+  double Window;
+  double Sum;
+  float *Coefs;
+
+  pthread_mutex_lock(&SincFltMutex);
+  for (CurFlt = 0x00; CurFlt < SincFltCount; CurFlt++) {
+    Flt = &SincFilters[CurFlt];
+    if (Flt->InRate == InRate && Flt->OutRate == OutRate) {
+      pthread_mutex_unlock(&SincFltMutex);
+      return Flt;
+    }
+  }
+  if (SincFltCount >= SINC_FLT_COUNT) {
+    pthread_mutex_unlock(&SincFltMutex);
+    return NULL;
+  }
+
+  // When downsampling, the cutoff moves down to the output rate and the
+  // filter gets longer to keep the same transition band.
+  Ratio = (double)InRate / OutRate;
+  Cutoff = SINC_CUTOFF;
+  Flt = &SincFilters[SincFltCount];
+  Flt->Taps = SINC_TAPS;
+  if (Ratio > 1.0) {
+    Cutoff /= Ratio;
+    Flt->Taps = (UINT32)ceil(SINC_TAPS * Ratio);
+    Flt->Taps = (Flt->Taps + 0x03) & ~0x03;
+    if (Flt->Taps > SINC_TAPS_MAX)
+      Flt->Taps = SINC_TAPS_MAX;
+  }
+  Flt->Coefs = (float *)malloc(SINC_PHASES * Flt->Taps * sizeof(float));
+  if (Flt->Coefs == NULL) {
+    pthread_mutex_unlock(&SincFltMutex);
+    return NULL;
+  }
+  Flt->InRate = InRate;
+  Flt->OutRate = OutRate;
+  HalfLen = Flt->Taps / 2;
+
+  // Tap 0 is the oldest input sample. The output lies (Taps / 2) samples
+  // behind the newest one, so the filter spans both sides of it.
+  for (CurPhase = 0x00; CurPhase < SINC_PHASES; CurPhase++) {
+    Coefs = &Flt->Coefs[CurPhase * Flt->Taps];
+    Sum = 0.0;
+    for (CurTap = 0x00; CurTap < Flt->Taps; CurTap++) {
+      Dist = (double)CurPhase / SINC_PHASES + HalfLen - 1 - CurTap;
+      if (Dist == 0.0)
+        Sinc = 2.0 * Cutoff;
+      else
+        Sinc = SincSin(2.0 * M_PI * Cutoff * Dist) / (M_PI * Dist);
+      // Blackman window
+      Window = 0.42 + 0.5 * SincSin(M_PI * Dist / HalfLen + M_PI / 2) +
+               0.08 * SincSin(2.0 * M_PI * Dist / HalfLen + M_PI / 2);
+      if (Dist <= -HalfLen || Dist >= HalfLen)
+        Window = 0.0;
+      Coefs[CurTap] = (float)(Sinc * Window);
+      Sum += Coefs[CurTap];
+    }
+    for (CurTap = 0x00; CurTap < Flt->Taps; CurTap++)
+      Coefs[CurTap] = (float)(Coefs[CurTap] / Sum); // unity gain at DC
+  }
+  SincFltCount++;
+  pthread_mutex_unlock(&SincFltMutex);
+
+  return Flt;
+}
+
 INLINE INT16 Limit2Short(INT32 Value) {
   return (Value > 32767) ? 32767 : ((Value < -32768) ? -32768 : (INT16)Value);
 }
 
-static void null_update(UINT8 ChipID, stream_sample_t **outputs, int samples) {
+static void null_update(void *param, stream_sample_t **outputs, int samples) {
   memset(outputs[0x00], 0x00, sizeof(stream_sample_t) * samples);
   memset(outputs[0x01], 0x00, sizeof(stream_sample_t) * samples);
 
   return;
 }
 
-static void dual_opl2_stereo(UINT8 ChipID, stream_sample_t **outputs,
-                             int samples) {
-  ym3812_stream_update(ChipID, outputs, samples);
-  if (ChipID & 0x01)
-    memset(outputs[0x00], 0x00,
-           sizeof(stream_sample_t) * samples); 
-  else
-    memset(outputs[0x01], 0x00,
-           sizeof(stream_sample_t) * samples); 
+// Dual OPL2: the 1st chip is panned to the left, the 2nd one to the right
+static void dual_opl2_left(void *param, stream_sample_t **outputs,
+                           int samples) {
+  ym3812_stream_update(param, outputs, samples);
+  memset(outputs[0x01], 0x00, sizeof(stream_sample_t) * samples);
+
+  return;
+}
+
+static void dual_opl2_right(void *param, stream_sample_t **outputs,
+                            int samples) {
+  ym3812_stream_update(param, outputs, samples);
+  memset(outputs[0x00], 0x00, sizeof(stream_sample_t) * samples);
+
+  return;
+}
+
+// Mix Bus kernels
+// The mix bus is planar (one INT32 buffer per channel), so that chip gain,
+// master gain, surround inversion and the 32 -> 16 bit conversion can run
+// over whole segments. All variants give the same results as the scalar
+// code, except for the float rounding of the sinc filter.
+static void MixGainAdd_C(INT32 *Dst, const INT32 *Src, INT32 Gain,
+                         UINT32 Len) {
+  UINT32 CurSmpl;
+
+  for (CurSmpl = 0x00; CurSmpl < Len; CurSmpl++)
+    Dst[CurSmpl] += Src[CurSmpl] * Gain;
+
+  return;
+}
+
+static void MixToOutput_C(WAVE_16BS *Dst, INT32 **Mix, UINT32 Len, INT32 Gain,
+                          bool Invert) {
+  // applies the master volume, then clips and interleaves the samples
+  const INT32 *MixL = Mix[0x00];
+  const INT32 *MixR = Mix[0x01];
+  UINT32 CurSmpl;
+  INT32 SmplL;
+  INT32 SmplR;
+
+  for (CurSmpl = 0x00; CurSmpl < Len; CurSmpl++) {
+    SmplL = ((MixL[CurSmpl] >> 5) * Gain) >> 11;
+    SmplR = ((MixR[CurSmpl] >> 5) * Gain) >> 11;
+    if (Invert)
+      SmplR *= -1;
+    Dst[CurSmpl].Left = Limit2Short(SmplL);
+    Dst[CurSmpl].Right = Limit2Short(SmplR);
+  }
+
+  return;
+}
+
+static void SincConvolve_C(const float *SrcL, const float *SrcR,
+                           const float *Coefs, UINT32 Taps, float *RetL,
+                           float *RetR) {
+  // inner product of one filter phase with both channels
+  UINT32 CurTap;
+  float SumL;
+  float SumR;
+
+  SumL = SumR = 0.0f;
+  for (CurTap = 0x00; CurTap < Taps; CurTap++) {
+    SumL += SrcL[CurTap] * Coefs[CurTap];
+    SumR += SrcR[CurTap] * Coefs[CurTap];
+  }
+  *RetL = SumL;
+  *RetR = SumR;
+
+  return;
+}
+
+#ifdef __SSE2__
+INLINE __m128i mm_mullo_epi32(__m128i a, __m128i b) {
+  // SSE2 has no 32-bit multiply - multiply even/odd lanes and merge them
+  __m128i MulEven = _mm_mul_epu32(a, b);
+  __m128i MulOdd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(MulEven, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(MulOdd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// The SSE2 and SSE4.1 kernels only differ in the 32-bit multiply.
+#define MIX_GAIN_ADD_128(MULLO)                                                \
+  {                                                                            \
+    __m128i VecGain = _mm_set1_epi32(Gain);                                    \
+    __m128i VecSmpl;                                                           \
+                                                                               \
+    for (; CurSmpl + 4 <= Len; CurSmpl += 4) {                                 \
+      VecSmpl = MULLO(_mm_loadu_si128((const __m128i *)&Src[CurSmpl]),         \
+                      VecGain);                                                \
+      VecSmpl = _mm_add_epi32(_mm_loadu_si128((const __m128i *)&Dst[CurSmpl]), \
+                              VecSmpl);                                        \
+      _mm_storeu_si128((__m128i *)&Dst[CurSmpl], VecSmpl);                     \
+    }                                                                          \
+  }
+
+#define MIX_TO_OUTPUT_128(MULLO)                                               \
+  {                                                                            \
+    __m128i VecGain = _mm_set1_epi32(Gain);                                    \
+    __m128i VecL;                                                              \
+    __m128i VecR;                                                              \
+                                                                               \
+    for (; CurSmpl + 4 <= Len; CurSmpl += 4) {                                 \
+      VecL = _mm_loadu_si128((const __m128i *)&Mix[0x00][CurSmpl]);           \
+      VecR = _mm_loadu_si128((const __m128i *)&Mix[0x01][CurSmpl]);           \
+      VecL = _mm_srai_epi32(VecL, 5);                                          \
+      VecR = _mm_srai_epi32(VecR, 5);                                          \
+      VecL = _mm_srai_epi32(MULLO(VecL, VecGain), 11);                         \
+      VecR = _mm_srai_epi32(MULLO(VecR, VecGain), 11);                         \
+      if (Invert)                                                              \
+        VecR = _mm_sub_epi32(_mm_setzero_si128(), VecR);                       \
+      /* saturate to 16 bit and interleave L/R */                              \
+      VecL = _mm_packs_epi32(VecL, VecL);                                      \
+      VecR = _mm_packs_epi32(VecR, VecR);                                      \
+      _mm_storeu_si128((__m128i *)&Dst[CurSmpl],                               \
+                       _mm_unpacklo_epi16(VecL, VecR));                        \
+    }                                                                          \
+  }
+
+static void MixGainAdd_SSE2(INT32 *Dst, const INT32 *Src, INT32 Gain,
+                            UINT32 Len) {
+  UINT32 CurSmpl;
+
+  CurSmpl = 0x00;
+  MIX_GAIN_ADD_128(mm_mullo_epi32)
+  MixGainAdd_C(&Dst[CurSmpl], &Src[CurSmpl], Gain, Len - CurSmpl);
+
+  return;
+}
+
+static void MixToOutput_SSE2(WAVE_16BS *Dst, INT32 **Mix, UINT32 Len,
+                             INT32 Gain, bool Invert) {
+  INT32 *MixRest[0x02];
+  UINT32 CurSmpl;
+
+  CurSmpl = 0x00;
+  MIX_TO_OUTPUT_128(mm_mullo_epi32)
+  MixRest[0x00] = &Mix[0x00][CurSmpl];
+  MixRest[0x01] = &Mix[0x01][CurSmpl];
+  MixToOutput_C(&Dst[CurSmpl], MixRest, Len - CurSmpl, Gain, Invert);
+
+  return;
+}
+
+static void SincConvolve_SSE2(const float *SrcL, const float *SrcR,
+                              const float *Coefs, UINT32 Taps, float *RetL,
+                              float *RetR) {
+  // Taps is a multiple of 4
+  __m128 VecSumL = _mm_setzero_ps();
+  __m128 VecSumR = _mm_setzero_ps();
+  __m128 VecCoef;
+  UINT32 CurTap;
+
+  for (CurTap = 0x00; CurTap < Taps; CurTap += 4) {
+    VecCoef = _mm_loadu_ps(&Coefs[CurTap]);
+    VecSumL =
+        _mm_add_ps(VecSumL, _mm_mul_ps(_mm_loadu_ps(&SrcL[CurTap]), VecCoef));
+    VecSumR =
+        _mm_add_ps(VecSumR, _mm_mul_ps(_mm_loadu_ps(&SrcR[CurTap]), VecCoef));
+  }
+  // horizontal sum
+  VecSumL = _mm_add_ps(VecSumL, _mm_movehl_ps(VecSumL, VecSumL));
+  VecSumR = _mm_add_ps(VecSumR, _mm_movehl_ps(VecSumR, VecSumR));
+  VecSumL = _mm_add_ss(VecSumL, _mm_shuffle_ps(VecSumL, VecSumL, 0x55));
+  VecSumR = _mm_add_ss(VecSumR, _mm_shuffle_ps(VecSumR, VecSumR, 0x55));
+  *RetL = _mm_cvtss_f32(VecSumL);
+  *RetR = _mm_cvtss_f32(VecSumR);
+
+  return;
+}
+#endif
+
+#ifdef SIMD_DISPATCH
+__attribute__((target("sse4.1"))) static void
+MixGainAdd_SSE41(INT32 *Dst, const INT32 *Src, INT32 Gain, UINT32 Len) {
+  UINT32 CurSmpl;
+
+  CurSmpl = 0x00;
+  MIX_GAIN_ADD_128(_mm_mullo_epi32)
+  MixGainAdd_C(&Dst[CurSmpl], &Src[CurSmpl], Gain, Len - CurSmpl);
+
+  return;
+}
+
+__attribute__((target("sse4.1"))) static void
+MixToOutput_SSE41(WAVE_16BS *Dst, INT32 **Mix, UINT32 Len, INT32 Gain,
+                  bool Invert) {
+  INT32 *MixRest[0x02];
+  UINT32 CurSmpl;
+
+  CurSmpl = 0x00;
+  MIX_TO_OUTPUT_128(_mm_mullo_epi32)
+  MixRest[0x00] = &Mix[0x00][CurSmpl];
+  MixRest[0x01] = &Mix[0x01][CurSmpl];
+  MixToOutput_C(&Dst[CurSmpl], MixRest, Len - CurSmpl, Gain, Invert);
+
+  return;
+}
+
+__attribute__((target("avx2"))) static void
+MixGainAdd_AVX2(INT32 *Dst, const INT32 *Src, INT32 Gain, UINT32 Len) {
+  __m256i VecGain = _mm256_set1_epi32(Gain);
+  __m256i VecSmpl;
+  UINT32 CurSmpl;
+
+  for (CurSmpl = 0x00; CurSmpl + 8 <= Len; CurSmpl += 8) {
+    VecSmpl = _mm256_mullo_epi32(
+        _mm256_loadu_si256((const __m256i *)&Src[CurSmpl]), VecGain);
+    VecSmpl = _mm256_add_epi32(
+        _mm256_loadu_si256((const __m256i *)&Dst[CurSmpl]), VecSmpl);
+    _mm256_storeu_si256((__m256i *)&Dst[CurSmpl], VecSmpl);
+  }
+  _mm256_zeroupper(); // avoid AVX -> SSE transition stalls in the caller
+  MixGainAdd_C(&Dst[CurSmpl], &Src[CurSmpl], Gain, Len - CurSmpl);
+
+  return;
+}
+
+__attribute__((target("avx2"))) static void
+MixToOutput_AVX2(WAVE_16BS *Dst, INT32 **Mix, UINT32 Len, INT32 Gain,
+                 bool Invert) {
+  __m256i VecGain = _mm256_set1_epi32(Gain);
+  __m256i VecL;
+  __m256i VecR;
+  __m256i VecLR;
+  INT32 *MixRest[0x02];
+  UINT32 CurSmpl;
+
+  for (CurSmpl = 0x00; CurSmpl + 8 <= Len; CurSmpl += 8) {
+    VecL = _mm256_loadu_si256((const __m256i *)&Mix[0x00][CurSmpl]);
+    VecR = _mm256_loadu_si256((const __m256i *)&Mix[0x01][CurSmpl]);
+    VecL = _mm256_srai_epi32(VecL, 5);
+    VecR = _mm256_srai_epi32(VecR, 5);
+    VecL = _mm256_srai_epi32(_mm256_mullo_epi32(VecL, VecGain), 11);
+    VecR = _mm256_srai_epi32(_mm256_mullo_epi32(VecR, VecGain), 11);
+    if (Invert)
+      VecR = _mm256_sub_epi32(_mm256_setzero_si256(), VecR);
+    // The packs/unpack instructions work per 128-bit lane, which yields
+    // L0-3 R0-3 | L4-7 R4-7 - already interleaved in lane order.
+    VecLR = _mm256_packs_epi32(VecL, VecR);
+    VecLR = _mm256_shuffle_epi8(
+        VecLR, _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7,
+                                14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13,
+                                6, 7, 14, 15));
+    _mm256_storeu_si256((__m256i *)&Dst[CurSmpl], VecLR);
+  }
+  _mm256_zeroupper();
+  MixRest[0x00] = &Mix[0x00][CurSmpl];
+  MixRest[0x01] = &Mix[0x01][CurSmpl];
+  MixToOutput_C(&Dst[CurSmpl], MixRest, Len - CurSmpl, Gain, Invert);
+
+  return;
+}
+
+__attribute__((target("avx2"))) static void
+SincConvolve_AVX2(const float *SrcL, const float *SrcR, const float *Coefs,
+                  UINT32 Taps, float *RetL, float *RetR) {
+  // Taps is a multiple of 4
+  __m256 VecSumL = _mm256_setzero_ps();
+  __m256 VecSumR = _mm256_setzero_ps();
+  __m256 VecCoef;
+  __m128 SumL;
+  __m128 SumR;
+  __m128 Coef4;
+  UINT32 CurTap;
+
+  for (CurTap = 0x00; CurTap + 8 <= Taps; CurTap += 8) {
+    VecCoef = _mm256_loadu_ps(&Coefs[CurTap]);
+    VecSumL = _mm256_add_ps(
+        VecSumL, _mm256_mul_ps(_mm256_loadu_ps(&SrcL[CurTap]), VecCoef));
+    VecSumR = _mm256_add_ps(
+        VecSumR, _mm256_mul_ps(_mm256_loadu_ps(&SrcR[CurTap]), VecCoef));
+  }
+  SumL = _mm_add_ps(_mm256_castps256_ps128(VecSumL),
+                    _mm256_extractf128_ps(VecSumL, 1));
+  SumR = _mm_add_ps(_mm256_castps256_ps128(VecSumR),
+                    _mm256_extractf128_ps(VecSumR, 1));
+  _mm256_zeroupper();
+  if (CurTap < Taps) {
+    Coef4 = _mm_loadu_ps(&Coefs[CurTap]);
+    SumL = _mm_add_ps(SumL, _mm_mul_ps(_mm_loadu_ps(&SrcL[CurTap]), Coef4));
+    SumR = _mm_add_ps(SumR, _mm_mul_ps(_mm_loadu_ps(&SrcR[CurTap]), Coef4));
+  }
+  // horizontal sum
+  SumL = _mm_add_ps(SumL, _mm_movehl_ps(SumL, SumL));
+  SumR = _mm_add_ps(SumR, _mm_movehl_ps(SumR, SumR));
+  SumL = _mm_add_ss(SumL, _mm_shuffle_ps(SumL, SumL, 0x55));
+  SumR = _mm_add_ss(SumR, _mm_shuffle_ps(SumR, SumR, 0x55));
+  *RetL = _mm_cvtss_f32(SumL);
+  *RetR = _mm_cvtss_f32(SumR);
+
+  return;
+}
+#endif
+
+static void (*MixGainAdd)(INT32 *Dst, const INT32 *Src, INT32 Gain,
+                          UINT32 Len) = MixGainAdd_C;
+static void (*MixToOutput)(WAVE_16BS *Dst, INT32 **Mix, UINT32 Len,
+                           INT32 Gain, bool Invert) = MixToOutput_C;
+static void (*SincConvolve)(const float *SrcL, const float *SrcR,
+                            const float *Coefs, UINT32 Taps, float *RetL,
+                            float *RetR) = SincConvolve_C;
+
+static UINT8 GetCPUSimdLevel(void) {
+#ifdef SIMD_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SIMD_AVX2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return SIMD_SSE41;
+#endif
+#ifdef __SSE2__
+  return SIMD_SSE2;
+#else
+  return SIMD_SCALAR;
+#endif
+}
+
+static void SetupSimdKernels(void) {
+  // SimdLevel may force a lower level than the CPU supports (for testing).
+  // This runs before the first chip starts, so afterwards SimdLevel never
+  // exceeds the CPU's level and the chip cores pick their kernels from it
+  // without checking the CPU themselves.
+  UINT8 CPULevel;
+
+  CPULevel = GetCPUSimdLevel();
+  if (SimdLevel > CPULevel)
+    SimdLevel = CPULevel;
+
+  MixGainAdd = MixGainAdd_C;
+  MixToOutput = MixToOutput_C;
+  SincConvolve = SincConvolve_C;
+#ifdef __SSE2__
+  if (SimdLevel >= SIMD_SSE2) {
+    MixGainAdd = MixGainAdd_SSE2;
+    MixToOutput = MixToOutput_SSE2;
+    SincConvolve = SincConvolve_SSE2;
+  }
+#endif
+#ifdef SIMD_DISPATCH
+  if (SimdLevel >= SIMD_SSE41) {
+    MixGainAdd = MixGainAdd_SSE41;
+    MixToOutput = MixToOutput_SSE41;
+  }
+  if (SimdLevel >= SIMD_AVX2) {
+    MixGainAdd = MixGainAdd_AVX2;
+    MixToOutput = MixToOutput_AVX2;
+    SincConvolve = SincConvolve_AVX2;
+  }
+#endif
 
   return;
 }
@@ -2962,9 +3976,67 @@ typedef UINT64 SLINT;
 #define fp2i_floor(x) ((x) / FIXPNT_FACT)
 #define fp2i_ceil(x) ((x + FIXPNT_MASK) / FIXPNT_FACT)
 
-static void ResampleChipStream(CA_LIST *CLst, WAVE_32BS *RetSample,
-                               UINT32 Length) {
+static void UpdateChipGroup(VGM_PLAYER *Player, CA_LIST *CLst,
+                            stream_sample_t **Outputs, UINT32 Length) {
+  // renders a same-rate group and mixes its chips at their native rate
+  // (or takes the chips' output from the chip workers)
+  CAUD_ATTR *CAA;
+  stream_sample_t *MonoBufs[0x02];
+  INT32 *ChipBufs[0x02];
+  UINT64 TimeStart;
+
+  TimeStart = ProfileRender ? GetProfileTime() : 0;
+  if (!CLst->Mixed) {
+    CAA = CLst->CAud;
+    if (Player->ChipsRendered) {
+      memcpy(Outputs[0x00], CAA->RenderBufs[0x00] + CAA->RenderPos,
+             sizeof(stream_sample_t) * Length);
+      memcpy(Outputs[0x01],
+             CAA->RenderBufs[CAA->MonoOut ? 0x00 : 0x01] + CAA->RenderPos,
+             sizeof(stream_sample_t) * Length);
+      CAA->RenderPos += Length;
+    } else if (CAA->MonoOut) {
+      MonoBufs[0x00] = Outputs[0x00];
+      MonoBufs[0x01] = NULL;
+      CAA->StreamUpdate(CAA->Info, MonoBufs, Length);
+      memcpy(Outputs[0x01], Outputs[0x00], sizeof(stream_sample_t) * Length);
+    } else {
+      CAA->StreamUpdate(CAA->Info, Outputs, Length);
+    }
+  } else {
+    memset(Outputs[0x00], 0x00, sizeof(stream_sample_t) * Length);
+    memset(Outputs[0x01], 0x00, sizeof(stream_sample_t) * Length);
+    for (; CLst != NULL; CLst = CLst->SameRate) {
+      if (CLst->COpts->Disabled)
+        continue;
+      CAA = CLst->CAud;
+      if (Player->ChipsRendered) {
+        ChipBufs[0x00] = CAA->RenderBufs[0x00] + CAA->RenderPos;
+        ChipBufs[0x01] = CAA->RenderBufs[0x01] + CAA->RenderPos;
+        CAA->RenderPos += Length;
+      } else {
+        ChipBufs[0x00] = Player->GroupBufs[0x00];
+        ChipBufs[0x01] = CAA->MonoOut ? NULL : Player->GroupBufs[0x01];
+        CAA->StreamUpdate(CAA->Info, ChipBufs, Length);
+      }
+      // a mono render is added to both sides
+      MixGainAdd(Outputs[0x00], ChipBufs[0x00], CAA->Volume, Length);
+      MixGainAdd(Outputs[0x01], ChipBufs[CAA->MonoOut ? 0x00 : 0x01],
+                 CAA->Volume, Length);
+    }
+  }
+  if (ProfileRender)
+    Player->ProfileTime[PROF_CHIPS] += GetProfileTime() - TimeStart;
+
+  return;
+}
+
+static void ResampleChipStream(VGM_PLAYER *Player, CA_LIST *CLst,
+                               INT32 **RetSample, UINT32 Length) {
+  // resamples a group of chips - the first chip holds the resampler state
   CAUD_ATTR *CAA;
+  INT32 *RetL;
+  INT32 *RetR;
   INT32 *CurBufL;
   INT32 *CurBufR;
   INT32 *StreamPnt[0x02];
@@ -2983,316 +4055,921 @@ static void ResampleChipStream(CA_LIST *CLst, WAVE_32BS *RetSample,
   INT32 SmpCnt;
   INT32 CurSmpl;
   UINT64 ChipSmpRate;
+  SINC_FILTER *Flt;
+  UINT32 HistLen;
+  UINT64 InPosL64;
+  float *SincL;
+  float *SincR;
+  float SincOutL;
+  float SincOutR;
+  INT32 Volume;
 
   CAA = CLst->CAud;
-  CurBufL = StreamBufs[0x00];
-  CurBufR = StreamBufs[0x01];
-
-  do {
-    switch (CAA->Resampler) {
-    case 0x00: // old, but very fast resampler
+  Volume = CLst->Mixed ? 0x01 : CAA->Volume;
+  CurBufL = Player->StreamBufs[0x00];
+  CurBufR = Player->StreamBufs[0x01];
+  RetL = RetSample[0x00];
+  RetR = RetSample[0x01];
+
+  switch (CAA->Resampler) {
+  case 0x00: // old, but very fast resampler
+    // render the whole block at once, then split it per output sample
+    InBase = CAA->SmpNext;
+    InNow = (UINT32)((UINT64)(CAA->SmpP + Length) * CAA->SmpRate / SampleRate);
+    if (InNow > InBase)
+      UpdateChipGroup(Player, CLst, Player->StreamBufs, InNow - InBase);
+    for (OutPos = 0x00; OutPos < Length; OutPos++) {
       CAA->SmpLast = CAA->SmpNext;
-      CAA->SmpP += Length;
+      CAA->SmpP++;
       CAA->SmpNext = (UINT32)((UINT64)CAA->SmpP * CAA->SmpRate / SampleRate);
       if (CAA->SmpLast >= CAA->SmpNext) {
-        for (OutPos = 0x00; OutPos < Length; OutPos++) {
-          RetSample[OutPos].Left += CAA->LSmpl.Left * CAA->Volume;
-          RetSample[OutPos].Right += CAA->LSmpl.Right * CAA->Volume;
-        }
-      } else {
-        SmpCnt = CAA->SmpNext - CAA->SmpLast;
-        CAA->StreamUpdate(CAA->ChipID, StreamBufs, SmpCnt);
+        RetL[OutPos] += CAA->LSmpl.Left * Volume;
+        RetR[OutPos] += CAA->LSmpl.Right * Volume;
+        continue;
+      }
 
-        if (SmpCnt == 1) {
-          for (OutPos = 0x00; OutPos < Length; OutPos++) {
-            RetSample[OutPos].Left += CurBufL[0x00] * CAA->Volume;
-            RetSample[OutPos].Right += CurBufR[0x00] * CAA->Volume;
-          }
-          CAA->LSmpl.Left = CurBufL[0x00];
-          CAA->LSmpl.Right = CurBufR[0x00];
-        } else {
-          TempS32L = CurBufL[0x00];
-          TempS32R = CurBufR[0x00];
-          for (CurSmpl = 0x01; CurSmpl < SmpCnt; CurSmpl++) {
-            TempS32L += CurBufL[CurSmpl];
-            TempS32R += CurBufR[CurSmpl];
-          }
-          for (OutPos = 0x00; OutPos < Length; OutPos++) {
-            RetSample[OutPos].Left += (TempS32L * CAA->Volume / SmpCnt);
-            RetSample[OutPos].Right += (TempS32R * CAA->Volume / SmpCnt);
-          }
-          CAA->LSmpl.Left = CurBufL[SmpCnt - 1];
-          CAA->LSmpl.Right = CurBufR[SmpCnt - 1];
+      SmpCnt = CAA->SmpNext - CAA->SmpLast;
+      InPre = CAA->SmpLast - InBase;
+      if (SmpCnt == 1) {
+        RetL[OutPos] += CurBufL[InPre] * Volume;
+        RetR[OutPos] += CurBufR[InPre] * Volume;
+        CAA->LSmpl.Left = CurBufL[InPre];
+        CAA->LSmpl.Right = CurBufR[InPre];
+      } else {
+        TempS32L = CurBufL[InPre];
+        TempS32R = CurBufR[InPre];
+        for (CurSmpl = 0x01; CurSmpl < SmpCnt; CurSmpl++) {
+          TempS32L += CurBufL[InPre + CurSmpl];
+          TempS32R += CurBufR[InPre + CurSmpl];
         }
+        RetL[OutPos] += (TempS32L * Volume / SmpCnt);
+        RetR[OutPos] += (TempS32R * Volume / SmpCnt);
+        CAA->LSmpl.Left = CurBufL[InPre + SmpCnt - 1];
+        CAA->LSmpl.Right = CurBufR[InPre + SmpCnt - 1];
       }
-      break;
-    case 0x01: // Upsampling
-      ChipSmpRate = CAA->SmpRate;
-      InPosL = (SLINT)(FIXPNT_FACT * CAA->SmpP * ChipSmpRate / SampleRate);
-      InPre = (UINT32)fp2i_floor(InPosL);
-      InNow = (UINT32)fp2i_ceil(InPosL);
-
-      CurBufL[0x00] = CAA->LSmpl.Left;
-      CurBufR[0x00] = CAA->LSmpl.Right;
-      CurBufL[0x01] = CAA->NSmpl.Left;
-      CurBufR[0x01] = CAA->NSmpl.Right;
-      StreamPnt[0x00] = &CurBufL[0x02];
-      StreamPnt[0x01] = &CurBufR[0x02];
-      CAA->StreamUpdate(CAA->ChipID, StreamPnt, InNow - CAA->SmpNext);
-
-      InBase =
-          FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->SmpNext * FIXPNT_FACT);
-      SmpCnt = FIXPNT_FACT;
-      CAA->SmpLast = InPre;
-      CAA->SmpNext = InNow;
-      for (OutPos = 0x00; OutPos < Length; OutPos++) {
-        InPos =
-            InBase + (UINT32)(FIXPNT_FACT * OutPos * ChipSmpRate / SampleRate);
+    }
+    break;
+  case 0x01: // Upsampling
+    // Note: Positions are calculated from the absolute sample number, so
+    //       rendering a block gives the same result as single samples.
+    ChipSmpRate = CAA->SmpRate;
+    InPosL = (SLINT)(FIXPNT_FACT * (CAA->SmpP + Length - 1) * ChipSmpRate /
+                     SampleRate);
+    InPre = (UINT32)fp2i_floor(InPosL);
+    InNow = (UINT32)fp2i_ceil(InPosL);
+
+    CurBufL[0x00] = CAA->LSmpl.Left;
+    CurBufR[0x00] = CAA->LSmpl.Right;
+    CurBufL[0x01] = CAA->NSmpl.Left;
+    CurBufR[0x01] = CAA->NSmpl.Right;
+    StreamPnt[0x00] = &CurBufL[0x02];
+    StreamPnt[0x01] = &CurBufR[0x02];
+    UpdateChipGroup(Player, CLst, StreamPnt, InNow - CAA->SmpNext);
+
+    InBase = CAA->SmpNext;
+    SmpCnt = FIXPNT_FACT;
+    CAA->SmpLast = InPre;
+    CAA->SmpNext = InNow;
+    for (OutPos = 0x00; OutPos < Length; OutPos++) {
+      InPosL = (SLINT)(FIXPNT_FACT * (CAA->SmpP + OutPos) * ChipSmpRate /
+                       SampleRate);
+      InPos = FIXPNT_FACT + (UINT32)(InPosL - (SLINT)InBase * FIXPNT_FACT);
+
+      InPre = fp2i_floor(InPos);
+      InNow = fp2i_ceil(InPos);
+      SmpFrc = getfriction(InPos);
+
+      // Linear interpolation
+      TempSmpL = ((INT64)CurBufL[InPre] * (FIXPNT_FACT - SmpFrc)) +
+                 ((INT64)CurBufL[InNow] * SmpFrc);
+      TempSmpR = ((INT64)CurBufR[InPre] * (FIXPNT_FACT - SmpFrc)) +
+                 ((INT64)CurBufR[InNow] * SmpFrc);
+      RetL[OutPos] += (INT32)(TempSmpL * Volume / SmpCnt);
+      RetR[OutPos] += (INT32)(TempSmpR * Volume / SmpCnt);
+    }
+    CAA->LSmpl.Left = CurBufL[InPre];
+    CAA->LSmpl.Right = CurBufR[InPre];
+    CAA->NSmpl.Left = CurBufL[InNow];
+    CAA->NSmpl.Right = CurBufR[InNow];
+    CAA->SmpP += Length;
+    break;
+  case 0x02: // Copying
+    CAA->SmpNext = CAA->SmpP * CAA->SmpRate / SampleRate;
+    UpdateChipGroup(Player, CLst, Player->StreamBufs, Length);
+
+    MixGainAdd(RetL, CurBufL, Volume, Length);
+    MixGainAdd(RetR, CurBufR, Volume, Length);
+    CAA->SmpP += Length;
+    CAA->SmpLast = CAA->SmpNext;
+    break;
+  case 0x03: // Downsampling
+    ChipSmpRate = CAA->SmpRate;
+    InPosL = (SLINT)(FIXPNT_FACT * (CAA->SmpP + Length) * ChipSmpRate /
+                     SampleRate);
+    CAA->SmpNext = (UINT32)fp2i_ceil(InPosL);
+
+    CurBufL[0x00] = CAA->LSmpl.Left;
+    CurBufR[0x00] = CAA->LSmpl.Right;
+    StreamPnt[0x00] = &CurBufL[0x01];
+    StreamPnt[0x01] = &CurBufR[0x01];
+    UpdateChipGroup(Player, CLst, StreamPnt, CAA->SmpNext - CAA->SmpLast);
+
+    // every output sample spans the same amount of input samples
+    InBase = (UINT32)(FIXPNT_FACT * ChipSmpRate / SampleRate);
+    for (OutPos = 0x00; OutPos < Length; OutPos++) {
+      InPosL = (SLINT)(FIXPNT_FACT * (CAA->SmpP + OutPos) * ChipSmpRate /
+                       SampleRate);
+      InPos =
+          FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->SmpLast * FIXPNT_FACT);
+      InPosNext = InPos + InBase;
 
+      SmpFrc = getnfriction(InPos);
+      if (SmpFrc) {
         InPre = fp2i_floor(InPos);
-        InNow = fp2i_ceil(InPos);
-        SmpFrc = getfriction(InPos);
-
-        // Linear interpolation
-        TempSmpL = ((INT64)CurBufL[InPre] * (FIXPNT_FACT - SmpFrc)) +
-                   ((INT64)CurBufL[InNow] * SmpFrc);
-        TempSmpR = ((INT64)CurBufR[InPre] * (FIXPNT_FACT - SmpFrc)) +
-                   ((INT64)CurBufR[InNow] * SmpFrc);
-        RetSample[OutPos].Left += (INT32)(TempSmpL * CAA->Volume / SmpCnt);
-        RetSample[OutPos].Right += (INT32)(TempSmpR * CAA->Volume / SmpCnt);
+        TempSmpL = (INT64)CurBufL[InPre] * SmpFrc;
+        TempSmpR = (INT64)CurBufR[InPre] * SmpFrc;
+      } else {
+        TempSmpL = TempSmpR = 0x00;
       }
-      CAA->LSmpl.Left = CurBufL[InPre];
-      CAA->LSmpl.Right = CurBufR[InPre];
-      CAA->NSmpl.Left = CurBufL[InNow];
-      CAA->NSmpl.Right = CurBufR[InNow];
-      CAA->SmpP += Length;
-      break;
-    case 0x02: // Copying
-      CAA->SmpNext = CAA->SmpP * CAA->SmpRate / SampleRate;
-      CAA->StreamUpdate(CAA->ChipID, StreamBufs, Length);
-
-      for (OutPos = 0x00; OutPos < Length; OutPos++) {
-        RetSample[OutPos].Left += CurBufL[OutPos] * CAA->Volume;
-        RetSample[OutPos].Right += CurBufR[OutPos] * CAA->Volume;
+      SmpCnt = SmpFrc;
+
+      SmpFrc = getfriction(InPosNext);
+      InPre = fp2i_floor(InPosNext);
+      if (SmpFrc) {
+        TempSmpL += (INT64)CurBufL[InPre] * SmpFrc;
+        TempSmpR += (INT64)CurBufR[InPre] * SmpFrc;
+        SmpCnt += SmpFrc;
       }
-      CAA->SmpP += Length;
-      CAA->SmpLast = CAA->SmpNext;
-      break;
-    case 0x03: // Downsampling
-      ChipSmpRate = CAA->SmpRate;
-      InPosL = (SLINT)(FIXPNT_FACT * (CAA->SmpP + Length) * ChipSmpRate /
-                       SampleRate);
-      CAA->SmpNext = (UINT32)fp2i_ceil(InPosL);
 
-      CurBufL[0x00] = CAA->LSmpl.Left;
-      CurBufR[0x00] = CAA->LSmpl.Right;
-      StreamPnt[0x00] = &CurBufL[0x01];
-      StreamPnt[0x01] = &CurBufR[0x01];
-      CAA->StreamUpdate(CAA->ChipID, StreamPnt, CAA->SmpNext - CAA->SmpLast);
+      InNow = fp2i_ceil(InPos);
+      SmpCnt += (InPre - InNow) * FIXPNT_FACT;
+      while (InNow < InPre) {
+        TempSmpL += (INT64)CurBufL[InNow] * FIXPNT_FACT;
+        TempSmpR += (INT64)CurBufR[InNow] * FIXPNT_FACT;
+        InNow++;
+      }
 
-      InPosL = (SLINT)(FIXPNT_FACT * CAA->SmpP * ChipSmpRate / SampleRate);
-      InBase =
-          FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->SmpLast * FIXPNT_FACT);
-      InPosNext = InBase;
-      for (OutPos = 0x00; OutPos < Length; OutPos++) {
-        InPos = InPosNext;
-        InPosNext = InBase + (UINT32)(FIXPNT_FACT * (OutPos + 1) * ChipSmpRate /
-                                      SampleRate);
-
-
-        SmpFrc = getnfriction(InPos);
-        if (SmpFrc) {
-          InPre = fp2i_floor(InPos);
-          TempSmpL = (INT64)CurBufL[InPre] * SmpFrc;
-          TempSmpR = (INT64)CurBufR[InPre] * SmpFrc;
-        } else {
-          TempSmpL = TempSmpR = 0x00;
-        }
-        SmpCnt = SmpFrc;
-
-        SmpFrc = getfriction(InPosNext);
-        InPre = fp2i_floor(InPosNext);
-        if (SmpFrc) {
-          TempSmpL += (INT64)CurBufL[InPre] * SmpFrc;
-          TempSmpR += (INT64)CurBufR[InPre] * SmpFrc;
-          SmpCnt += SmpFrc;
-        }
+      RetL[OutPos] += (INT32)(TempSmpL * Volume / SmpCnt);
+      RetR[OutPos] += (INT32)(TempSmpR * Volume / SmpCnt);
+    }
 
-        InNow = fp2i_ceil(InPos);
-        SmpCnt += (InPre - InNow) * FIXPNT_FACT;
-        while (InNow < InPre) {
-          TempSmpL += (INT64)CurBufL[InNow] * FIXPNT_FACT;
-          TempSmpR += (INT64)CurBufR[InNow] * FIXPNT_FACT;
-          InNow++;
-        }
+    CAA->LSmpl.Left = CurBufL[InPre];
+    CAA->LSmpl.Right = CurBufR[InPre];
+    CAA->SmpP += Length;
+    CAA->SmpLast = CAA->SmpNext;
+    break;
+  case 0x04: // Windowed Sinc
+    // SmpLast is the number of rendered input samples. The work buffers
+    // start with the last Taps samples of the previous call.
+    Flt = CAA->SincFlt;
+    HistLen = Flt->Taps;
+    InPosL64 = (UINT64)(CAA->SmpP + Length - 1) * CAA->SmpRate;
+    InNow = (UINT32)(InPosL64 / SampleRate);
+    if ((InPosL64 % SampleRate) * SINC_PHASES + SampleRate / 2 >=
+        (UINT64)SINC_PHASES * SampleRate)
+      InNow++; // the phase rounds up to the next sample
+    CAA->SmpNext = InNow + 1;
+    InBase = CAA->SmpLast;
+    if (CAA->SmpNext > InBase)
+      UpdateChipGroup(Player, CLst, Player->StreamBufs, CAA->SmpNext - InBase);
+    else
+      CAA->SmpNext = InBase;
+
+    SincL = Player->SincBufs[0x00];
+    SincR = Player->SincBufs[0x01];
+    memcpy(SincL, &CAA->SincHist[0x00], HistLen * sizeof(float));
+    memcpy(SincR, &CAA->SincHist[SINC_TAPS_MAX], HistLen * sizeof(float));
+    for (InPos = 0x00; InPos < CAA->SmpNext - InBase; InPos++) {
+      SincL[HistLen + InPos] = (float)CurBufL[InPos];
+      SincR[HistLen + InPos] = (float)CurBufR[InPos];
+    }
 
-        RetSample[OutPos].Left += (INT32)(TempSmpL * CAA->Volume / SmpCnt);
-        RetSample[OutPos].Right += (INT32)(TempSmpR * CAA->Volume / SmpCnt);
+    for (OutPos = 0x00; OutPos < Length; OutPos++) {
+      InPosL64 = (UINT64)(CAA->SmpP + OutPos) * CAA->SmpRate;
+      InPre = (UINT32)(InPosL64 / SampleRate);
+      SmpFrc = (UINT32)(((InPosL64 % SampleRate) * SINC_PHASES +
+                         SampleRate / 2) / SampleRate);
+      if (SmpFrc >= SINC_PHASES) {
+        SmpFrc -= SINC_PHASES;
+        InPre++;
       }
-
-      CAA->LSmpl.Left = CurBufL[InPre];
-      CAA->LSmpl.Right = CurBufR[InPre];
-      CAA->SmpP += Length;
-      CAA->SmpLast = CAA->SmpNext;
-      break;
-    default:
-      CAA->SmpP += SampleRate;
-      break;
+      // filter over the input samples (InPre - Taps + 1) .. InPre
+      InPos = InPre + 1 - InBase;
+      SincConvolve(&SincL[InPos], &SincR[InPos],
+                   &Flt->Coefs[SmpFrc * Flt->Taps], Flt->Taps, &SincOutL,
+                   &SincOutR);
+      RetL[OutPos] += (INT32)(SincOutL * Volume);
+      RetR[OutPos] += (INT32)(SincOutR * Volume);
     }
 
-    if (CAA->SmpLast >= CAA->SmpRate) {
-      CAA->SmpLast -= CAA->SmpRate;
-      CAA->SmpNext -= CAA->SmpRate;
-      CAA->SmpP -= SampleRate;
-    }
+    InPos = CAA->SmpNext - InBase;
+    memcpy(&CAA->SincHist[0x00], &SincL[InPos], HistLen * sizeof(float));
+    memcpy(&CAA->SincHist[SINC_TAPS_MAX], &SincR[InPos],
+           HistLen * sizeof(float));
+    CAA->SmpP += Length;
+    CAA->SmpLast = CAA->SmpNext;
+    break;
+  default:
+    CAA->SmpP += SampleRate;
+    break;
+  }
 
-    CAA = CAA->Paired;
-  } while (CAA != NULL);
+  if (CAA->SmpLast >= CAA->SmpRate) {
+    CAA->SmpLast -= CAA->SmpRate;
+    CAA->SmpNext -= CAA->SmpRate;
+    CAA->SmpP -= SampleRate;
+  }
 
   return;
 }
 
-static INT32 RecalcFadeVolume(void) {
-  if (FadePlay) {
-    if (!FadeStart)
-      FadeStart = PlayingTime;
+static INT32 RecalcFadeVolume(VGM_PLAYER *Player) {
+  if (Player->FadePlay) {
+    if (!Player->FadeStart)
+      Player->FadeStart = Player->PlayingTime;
 
-    UINT64 SamplesElapsed = (UINT64)(PlayingTime - FadeStart);
-    UINT64 FadeSamples = (UINT64)FadeTime * SampleRate / 1000;
+    UINT64 SamplesElapsed = (UINT64)(Player->PlayingTime - Player->FadeStart);
+    UINT64 FadeSamples = (UINT64)Player->FadeTime * SampleRate / 1000;
 
     if (FadeSamples == 0 || SamplesElapsed >= FadeSamples) {
-      MasterVol = 0.0f;
-      FinalVol = 0.0f;
-      VGMEnd = true;
+      Player->MasterVol = 0.0f;
+      Player->FinalVol = 0.0f;
+      Player->VGMEnd = true;
       return 0;
     }
 
     UINT32 VolFactorQ16 = (UINT32)(((FadeSamples - SamplesElapsed) << 16) / FadeSamples);
     
-    MasterVol = (float)VolFactorQ16 / 65536.0f;
-    FinalVol = VolumeLevelM * MasterVol;
+    Player->MasterVol = (float)VolFactorQ16 / 65536.0f;
+    Player->FinalVol = Player->VolumeLevelM * Player->MasterVol;
+  }
+
+  return (INT32)(0x100 * Player->FinalVol + 0.5f);
+}
+
+static UINT32 GetEventDelay(VGM_PLAYER *Player) {
+  // returns the number of samples that can be rendered after the current one
+  // before the next VGM command has to be executed
+  INT64 EvtSmpl;
+
+  if (Player->DacCtrlUsed) // DAC streams write to the chips every sample
+    return 0;
+  if (Player->FileMode || Player->VGMEnd ||
+      (Player->PausePlay && !Player->ForceVGMExec))
+    return 0xFFFFFFFF;
+  if (Player->VGMSmplPos <= 0)
+    return 0;
+
+  // first playback sample that reaches the position of the next command
+  EvtSmpl = ((INT64)Player->VGMSmplPos * Player->VGMSmplRateMul +
+             Player->VGMSmplRateDiv - 1) /
+            Player->VGMSmplRateDiv;
+  EvtSmpl -= (INT64)Player->VGMSmplPlayed + 1;
+  if (EvtSmpl <= 0)
+    return 0;
+  return (EvtSmpl < 0xFFFFFFFF) ? (UINT32)EvtSmpl : 0xFFFFFFFF;
+}
+
+// Chip Workers (--chip-threads)
+// The chips render on worker threads while the interpreter runs ahead:
+// 1. FillBuffer interprets the song segment by segment as usual, but the
+//    register writes are queued per chip, tagged with the buffer position of
+//    their segment, and the segments are collected in a render window.
+// 2. The workers replay the queue of every chip, the writes as well as the
+//    StreamUpdate call of each segment, into the chip's RenderBufs.
+// 3. The calling thread resamples and mixes the segments from the RenderBufs.
+// While a window is in stage 2, FillBuffer fills the other one. The chips get
+// the same writes and StreamUpdate calls in the same order as with serial
+// rendering and the mixing doesn't change, so the output is identical.
+// Commands other than register writes drain the pipeline and run directly.
+#define CHIPWORK_TASKS 0x20  // 2 * (CHIP_COUNT + 3) chips per player
+#define CHIPWORK_MINLEN 0x40 // shorter windows render on the calling thread
+#define CHIPQ_SEGS 0x100     // render segments per window
+#define CHIPQ_SLOTS (0x02 * CHIP_COUNT)
+#define CHIPQ_NORENDER 0xFFFFFFFF
+
+typedef struct chip_write {
+  UINT32 Smpl; // buffer position of the segment
+  UINT8 Port;
+  UINT8 Reg;
+  UINT8 Data;
+} CHIP_WRITE;
+
+struct render_window {
+  WAVE_16BS *Buffer;
+  UINT32 SegCount;
+  UINT32 SmplCount;
+  UINT32 SegSmpl[CHIPQ_SEGS]; // buffer position
+  UINT32 SegLen[CHIPQ_SEGS];
+  INT32 SegVol[CHIPQ_SEGS]; // master volume
+  // chip samples of every segment, per group of CurChipList
+  UINT32 GrpLens[CHIPWORK_TASKS][CHIPQ_SEGS];
+  UINT32 GrpTotal[CHIPWORK_TASKS];
+  // register writes per chip (ChipID * CHIP_COUNT + chip type)
+  CHIP_WRITE *Writes[CHIPQ_SLOTS];
+  UINT32 WriteCount[CHIPQ_SLOTS];
+  UINT32 WriteAlloc[CHIPQ_SLOTS];
+  UINT32 WriteTotal;
+};
+
+struct chip_task {
+  CAUD_ATTR *CAA;
+  UINT8 ChipType;
+  const UINT32 *Lens; // render length per segment, NULL - writes only
+  const CHIP_WRITE *Writes;
+  UINT32 WriteCount;
+};
+
+struct resampler_pos {
+  UINT32 SmpP;
+  UINT32 SmpLast;
+  UINT32 SmpNext;
+};
+
+struct chip_workers {
+  pthread_mutex_t Mutex;
+  pthread_cond_t WorkCond; // new tasks or Quit
+  pthread_cond_t DoneCond; // all tasks done
+  pthread_t Threads[CHIPWORK_TASKS];
+  UINT32 ThreadCount;
+  bool Quit;
+  UINT32 Generation; // counts the task lists handed to the threads
+  CHIP_TASK Tasks[CHIPWORK_TASKS];
+  const RENDER_WINDOW *TaskWin;
+  UINT32 TaskCount;
+  UINT32 TaskNext;
+  UINT32 TaskDone;
+
+  RENDER_WINDOW Win[0x02];
+  UINT8 FillWin; // window of stage 1
+  bool Busy;     // the other window is in stage 2
+  // resampler positions of the groups after the queued segments
+  RESMPL_POS GrpPos[CHIPWORK_TASKS];
+};
+
+static CHIP_WORKERS *StartChipWorkers(UINT32 ThreadCount) {
+  // the calling thread renders as well, so it needs one thread less
+  CHIP_WORKERS *CW;
+
+  CW = (CHIP_WORKERS *)calloc(1, sizeof(CHIP_WORKERS));
+  if (CW == NULL)
+    return NULL;
+  pthread_mutex_init(&CW->Mutex, NULL);
+  pthread_cond_init(&CW->WorkCond, NULL);
+  pthread_cond_init(&CW->DoneCond, NULL);
+  if (ThreadCount > CHIPWORK_TASKS)
+    ThreadCount = CHIPWORK_TASKS;
+  for (CW->ThreadCount = 0x00; CW->ThreadCount < ThreadCount;
+       CW->ThreadCount++) {
+    if (pthread_create(&CW->Threads[CW->ThreadCount], NULL, ChipWorkerThread,
+                       CW))
+      break;
+  }
+  if (!CW->ThreadCount) {
+    StopChipWorkers(CW);
+    return NULL;
+  }
+
+  return CW;
+}
+
+static void StopChipWorkers(CHIP_WORKERS *CW) {
+  UINT32 CurThr;
+  UINT8 CurWin;
+  UINT8 CurSlot;
+
+  pthread_mutex_lock(&CW->Mutex);
+  CW->Quit = true;
+  pthread_cond_broadcast(&CW->WorkCond);
+  pthread_mutex_unlock(&CW->Mutex);
+  for (CurThr = 0x00; CurThr < CW->ThreadCount; CurThr++)
+    pthread_join(CW->Threads[CurThr], NULL);
+
+  for (CurWin = 0x00; CurWin < 0x02; CurWin++) {
+    for (CurSlot = 0x00; CurSlot < CHIPQ_SLOTS; CurSlot++)
+      free(CW->Win[CurWin].Writes[CurSlot]);
+  }
+  pthread_cond_destroy(&CW->DoneCond);
+  pthread_cond_destroy(&CW->WorkCond);
+  pthread_mutex_destroy(&CW->Mutex);
+  free(CW);
+
+  return;
+}
+
+static void *ChipWorkerThread(void *Arg) {
+  CHIP_WORKERS *CW = (CHIP_WORKERS *)Arg;
+  UINT32 Generation;
+
+  pthread_mutex_lock(&CW->Mutex);
+  Generation = CW->Generation;
+  while (true) {
+    while (!CW->Quit && CW->Generation == Generation)
+      pthread_cond_wait(&CW->WorkCond, &CW->Mutex);
+    if (CW->Quit)
+      break;
+    Generation = CW->Generation;
+    RunChipTasks(CW);
+  }
+  pthread_mutex_unlock(&CW->Mutex);
+
+  return NULL;
+}
+
+static void RunChipTasks(CHIP_WORKERS *CW) {
+  // takes tasks until the list is empty, called with the mutex locked
+  const RENDER_WINDOW *Win;
+  const CHIP_TASK *Task;
+
+  while (CW->TaskNext < CW->TaskCount) {
+    Win = CW->TaskWin;
+    Task = &CW->Tasks[CW->TaskNext];
+    CW->TaskNext++;
+    pthread_mutex_unlock(&CW->Mutex);
+
+    RunChipTask(Win, Task);
+
+    pthread_mutex_lock(&CW->Mutex);
+    CW->TaskDone++;
+    if (CW->TaskDone == CW->TaskCount)
+      pthread_cond_signal(&CW->DoneCond);
+  }
+
+  return;
+}
+
+static void RunChipTask(const RENDER_WINDOW *Win, const CHIP_TASK *Task) {
+  // replays the writes and renders of one chip (stage 2)
+  CAUD_ATTR *CAA = Task->CAA;
+  stream_sample_t *Outputs[0x02];
+  const CHIP_WRITE *Wrt;
+  const CHIP_WRITE *WrtEnd;
+  UINT32 CurSeg;
+  UINT32 RenderPos;
+
+  Wrt = Task->Writes;
+  WrtEnd = Wrt + Task->WriteCount;
+  RenderPos = 0x00;
+  for (CurSeg = 0x00; CurSeg < Win->SegCount; CurSeg++) {
+    for (; Wrt < WrtEnd && Wrt->Smpl <= Win->SegSmpl[CurSeg]; Wrt++)
+      chip_reg_write(Task->ChipType, CAA->Info, Wrt->Port, Wrt->Reg,
+                     Wrt->Data);
+    if (Task->Lens == NULL || Task->Lens[CurSeg] == CHIPQ_NORENDER)
+      continue;
+    Outputs[0x00] = CAA->RenderBufs[0x00] + RenderPos;
+    Outputs[0x01] = CAA->MonoOut ? NULL : CAA->RenderBufs[0x01] + RenderPos;
+    CAA->StreamUpdate(CAA->Info, Outputs, Task->Lens[CurSeg]);
+    RenderPos += Task->Lens[CurSeg];
+  }
+  // writes of the segment that was interrupted by DrainChipQueues
+  for (; Wrt < WrtEnd; Wrt++)
+    chip_reg_write(Task->ChipType, CAA->Info, Wrt->Port, Wrt->Reg, Wrt->Data);
+
+  return;
+}
+
+static UINT32 AdvanceGroupPos(const CAUD_ATTR *CAA, RESMPL_POS *Pos,
+                              UINT32 Length) {
+  // moves Pos like ResampleChipStream moves the resampler of CAA's group and
+  // returns the length of its UpdateChipGroup call (or CHIPQ_NORENDER)
+  UINT32 RenderLen;
+  UINT32 InNow;
+  SLINT InPosL;
+  UINT64 ChipSmpRate;
+  UINT64 InPosL64;
+
+  ChipSmpRate = CAA->SmpRate;
+  switch (CAA->Resampler) {
+  case 0x00:
+    InNow = (UINT32)((UINT64)(Pos->SmpP + Length) * CAA->SmpRate / SampleRate);
+    RenderLen = (InNow > Pos->SmpNext) ? InNow - Pos->SmpNext : CHIPQ_NORENDER;
+    if (Length > 1)
+      Pos->SmpLast = (UINT32)((UINT64)(Pos->SmpP + Length - 1) *
+                              CAA->SmpRate / SampleRate);
+    else
+      Pos->SmpLast = Pos->SmpNext;
+    Pos->SmpNext = InNow;
+    Pos->SmpP += Length;
+    break;
+  case 0x01:
+    InPosL = (SLINT)(FIXPNT_FACT * (Pos->SmpP + Length - 1) * ChipSmpRate /
+                     SampleRate);
+    InNow = (UINT32)fp2i_ceil(InPosL);
+    RenderLen = InNow - Pos->SmpNext;
+    Pos->SmpLast = (UINT32)fp2i_floor(InPosL);
+    Pos->SmpNext = InNow;
+    Pos->SmpP += Length;
+    break;
+  case 0x02:
+    Pos->SmpNext = Pos->SmpP * CAA->SmpRate / SampleRate;
+    RenderLen = Length;
+    Pos->SmpP += Length;
+    Pos->SmpLast = Pos->SmpNext;
+    break;
+  case 0x03:
+    InPosL = (SLINT)(FIXPNT_FACT * (Pos->SmpP + Length) * ChipSmpRate /
+                     SampleRate);
+    Pos->SmpNext = (UINT32)fp2i_ceil(InPosL);
+    RenderLen = Pos->SmpNext - Pos->SmpLast;
+    Pos->SmpP += Length;
+    Pos->SmpLast = Pos->SmpNext;
+    break;
+  case 0x04:
+    InPosL64 = (UINT64)(Pos->SmpP + Length - 1) * CAA->SmpRate;
+    InNow = (UINT32)(InPosL64 / SampleRate);
+    if ((InPosL64 % SampleRate) * SINC_PHASES + SampleRate / 2 >=
+        (UINT64)SINC_PHASES * SampleRate)
+      InNow++;
+    Pos->SmpNext = InNow + 1;
+    if (Pos->SmpNext > Pos->SmpLast) {
+      RenderLen = Pos->SmpNext - Pos->SmpLast;
+    } else {
+      RenderLen = CHIPQ_NORENDER;
+      Pos->SmpNext = Pos->SmpLast;
+    }
+    Pos->SmpP += Length;
+    Pos->SmpLast = Pos->SmpNext;
+    break;
+  default:
+    RenderLen = CHIPQ_NORENDER;
+    Pos->SmpP += SampleRate;
+    break;
+  }
+
+  if (Pos->SmpLast >= CAA->SmpRate) {
+    Pos->SmpLast -= CAA->SmpRate;
+    Pos->SmpNext -= CAA->SmpRate;
+    Pos->SmpP -= SampleRate;
+  }
+
+  return RenderLen;
+}
+
+static void QueueChipWrite(VGM_PLAYER *Player, const VGM_EVENT *Evt) {
+  CHIP_WORKERS *CW = Player->ChipWork;
+  RENDER_WINDOW *Win = &CW->Win[CW->FillWin];
+  CHIP_WRITE *Wrt;
+  UINT32 NewAlloc;
+  UINT8 Slot;
+
+  Slot = Evt->ChipID * CHIP_COUNT + Evt->Type;
+  if (Win->WriteCount[Slot] >= Win->WriteAlloc[Slot]) {
+    NewAlloc = Win->WriteAlloc[Slot] ? Win->WriteAlloc[Slot] * 2 : 0x100;
+    Wrt = (CHIP_WRITE *)realloc(Win->Writes[Slot],
+                                NewAlloc * sizeof(CHIP_WRITE));
+    if (Wrt == NULL) {
+      // not enough memory - write directly
+      DrainChipQueues(Player);
+      chip_reg_write(
+          Evt->Type,
+          ((CAUD_ATTR *)&Player->ChipAudio[Evt->ChipID])[Evt->Type].Info,
+          Evt->Port, Evt->Reg, Evt->Data);
+      return;
+    }
+    Win->Writes[Slot] = Wrt;
+    Win->WriteAlloc[Slot] = NewAlloc;
+  }
+
+  Wrt = &Win->Writes[Slot][Win->WriteCount[Slot]];
+  Wrt->Smpl = Player->QueueSmpl;
+  Wrt->Port = Evt->Port;
+  Wrt->Reg = Evt->Reg;
+  Wrt->Data = Evt->Data;
+  Win->WriteCount[Slot]++;
+  Win->WriteTotal++;
+
+  return;
+}
+
+static void QueueSegment(VGM_PLAYER *Player, WAVE_16BS *Buffer, UINT32 BufPos,
+                         UINT32 Length, INT32 MstVol) {
+  // adds a segment to the render window, instead of RenderSegment
+  CHIP_WORKERS *CW = Player->ChipWork;
+  RENDER_WINDOW *Win = &CW->Win[CW->FillWin];
+  CA_LIST *CurCLst;
+  UINT32 CurGrp;
+  UINT32 CurSeg;
+  UINT32 RenderLen;
+  bool WinFull;
+
+  if (!Win->SegCount && !CW->Busy) {
+    // nothing is queued - the resamplers are up to date
+    CurGrp = 0x00;
+    for (CurCLst = Player->CurChipList; CurCLst != NULL;
+         CurCLst = CurCLst->next, CurGrp++) {
+      CW->GrpPos[CurGrp].SmpP = CurCLst->CAud->SmpP;
+      CW->GrpPos[CurGrp].SmpLast = CurCLst->CAud->SmpLast;
+      CW->GrpPos[CurGrp].SmpNext = CurCLst->CAud->SmpNext;
+    }
+  }
+
+  CurSeg = Win->SegCount;
+  Win->Buffer = Buffer;
+  Win->SegSmpl[CurSeg] = BufPos;
+  Win->SegLen[CurSeg] = Length;
+  Win->SegVol[CurSeg] = MstVol;
+  Win->SegCount++;
+  Win->SmplCount += Length;
+  WinFull = (Win->SegCount >= CHIPQ_SEGS);
+
+  // the same groups as in RenderSegment
+  CurGrp = 0x00;
+  for (CurCLst = Player->CurChipList; CurCLst != NULL;
+       CurCLst = CurCLst->next, CurGrp++) {
+    if (CurCLst->Mixed || !CurCLst->COpts->Disabled)
+      RenderLen = AdvanceGroupPos(CurCLst->CAud, &CW->GrpPos[CurGrp], Length);
+    else
+      RenderLen = CHIPQ_NORENDER;
+    Win->GrpLens[CurGrp][CurSeg] = RenderLen;
+    if (RenderLen == CHIPQ_NORENDER)
+      continue;
+    // a segment renders less than SMPL_BUFSIZE samples
+    Win->GrpTotal[CurGrp] += RenderLen;
+    if (Win->GrpTotal[CurGrp] >= RENDER_BUFSIZE - SMPL_BUFSIZE)
+      WinFull = true;
+  }
+  if (WinFull)
+    SubmitWindow(Player);
+
+  return;
+}
+
+static void SubmitWindow(VGM_PLAYER *Player) {
+  // hands the filled window to stage 2 and starts a new one
+  CHIP_WORKERS *CW = Player->ChipWork;
+  RENDER_WINDOW *Win;
+  CHIP_TASK *Task;
+  CA_LIST *CurCLst;
+  CA_LIST *ChipCLst;
+  UINT32 CurGrp;
+  UINT8 CurSlot;
+  bool SlotUsed[CHIPQ_SLOTS];
+
+  if (CW->Busy)
+    FinishWindow(Player); // frees the RenderBufs
+
+  Win = &CW->Win[CW->FillWin];
+  memset(SlotUsed, 0x00, sizeof(SlotUsed));
+  pthread_mutex_lock(&CW->Mutex);
+  CW->TaskWin = Win;
+  CW->TaskCount = 0x00;
+  CurGrp = 0x00;
+  for (CurCLst = Player->CurChipList; CurCLst != NULL;
+       CurCLst = CurCLst->next, CurGrp++) {
+    if (!CurCLst->Mixed && CurCLst->COpts->Disabled)
+      continue;
+    for (ChipCLst = CurCLst; ChipCLst != NULL; ChipCLst = ChipCLst->SameRate) {
+      if (ChipCLst->COpts->Disabled)
+        continue;
+      Task = &CW->Tasks[CW->TaskCount];
+      CW->TaskCount++;
+      Task->CAA = ChipCLst->CAud;
+      Task->ChipType = 0x00;
+      Task->Lens = Win->GrpLens[CurGrp];
+      Task->Writes = NULL;
+      Task->WriteCount = 0x00;
+      for (CurSlot = 0x00; CurSlot < CHIPQ_SLOTS; CurSlot++) {
+        if (Task->CAA == (CAUD_ATTR *)&Player->ChipAudio[CurSlot / CHIP_COUNT] +
+                             CurSlot % CHIP_COUNT) {
+          Task->ChipType = CurSlot % CHIP_COUNT;
+          Task->Writes = Win->Writes[CurSlot];
+          Task->WriteCount = Win->WriteCount[CurSlot];
+          SlotUsed[CurSlot] = true;
+          break;
+        }
+      }
+      if (!CurCLst->Mixed)
+        break;
+    }
+  }
+  // disabled chips still get their writes
+  for (CurSlot = 0x00; CurSlot < CHIPQ_SLOTS; CurSlot++) {
+    if (SlotUsed[CurSlot] || !Win->WriteCount[CurSlot])
+      continue;
+    Task = &CW->Tasks[CW->TaskCount];
+    CW->TaskCount++;
+    Task->CAA = (CAUD_ATTR *)&Player->ChipAudio[CurSlot / CHIP_COUNT] +
+                CurSlot % CHIP_COUNT;
+    Task->ChipType = CurSlot % CHIP_COUNT;
+    Task->Lens = NULL;
+    Task->Writes = Win->Writes[CurSlot];
+    Task->WriteCount = Win->WriteCount[CurSlot];
   }
+  CW->TaskNext = 0x00;
+  CW->TaskDone = 0x00;
+  // FinishWindow renders short windows on the calling thread
+  if (Win->SmplCount >= CHIPWORK_MINLEN) {
+    CW->Generation++;
+    pthread_cond_broadcast(&CW->WorkCond);
+  }
+  pthread_mutex_unlock(&CW->Mutex);
+
+  CW->Busy = true;
+  CW->FillWin ^= 0x01;
+  Win = &CW->Win[CW->FillWin];
+  Win->SegCount = 0x00;
+  Win->SmplCount = 0x00;
+  memset(Win->GrpTotal, 0x00, sizeof(Win->GrpTotal));
+  memset(Win->WriteCount, 0x00, sizeof(Win->WriteCount));
+  Win->WriteTotal = 0x00;
 
-  return (INT32)(0x100 * FinalVol + 0.5f);
+  return;
+}
+
+static void FinishWindow(VGM_PLAYER *Player) {
+  // waits for stage 2 of the busy window and mixes it (stage 3)
+  CHIP_WORKERS *CW = Player->ChipWork;
+  const RENDER_WINDOW *Win = CW->TaskWin;
+  UINT32 CurTask;
+  UINT32 CurSeg;
+  UINT64 TimeStart;
+
+  TimeStart = ProfileRender ? GetProfileTime() : 0;
+  pthread_mutex_lock(&CW->Mutex);
+  RunChipTasks(CW);
+  while (CW->TaskDone < CW->TaskCount)
+    pthread_cond_wait(&CW->DoneCond, &CW->Mutex);
+  pthread_mutex_unlock(&CW->Mutex);
+  if (ProfileRender)
+    Player->ProfileTime[PROF_CHIPS] += GetProfileTime() - TimeStart;
+
+  for (CurTask = 0x00; CurTask < CW->TaskCount; CurTask++)
+    CW->Tasks[CurTask].CAA->RenderPos = 0x00;
+  Player->ChipsRendered = true;
+  for (CurSeg = 0x00; CurSeg < Win->SegCount; CurSeg++)
+    RenderSegment(Player, &Win->Buffer[Win->SegSmpl[CurSeg]],
+                  Win->SegLen[CurSeg], Win->SegVol[CurSeg]);
+  Player->ChipsRendered = false;
+  CW->Busy = false;
+
+  return;
+}
+
+static void DrainChipQueues(VGM_PLAYER *Player) {
+  // renders the queued segments and applies all queued writes, so that the
+  // chips can be accessed directly
+  CHIP_WORKERS *CW = Player->ChipWork;
+  RENDER_WINDOW *Win;
+
+  Player->QueueWrites = false;
+  if (CW == NULL)
+    return;
+  Win = &CW->Win[CW->FillWin];
+  if (Win->SegCount || Win->WriteTotal)
+    SubmitWindow(Player);
+  if (CW->Busy)
+    FinishWindow(Player);
+
+  return;
+}
+
+static void RenderSegment(VGM_PLAYER *Player, WAVE_16BS *Buffer,
+                          UINT32 Length, INT32 MstVol) {
+  // renders the chips of the current list and mixes them into Buffer
+  CA_LIST *CurCLst;
+  UINT64 TimeStart;
+  UINT64 ChipTime;
+
+  TimeStart = ProfileRender ? GetProfileTime() : 0;
+  ChipTime = Player->ProfileTime[PROF_CHIPS];
+  memset(Player->MixBufs[0x00], 0x00, sizeof(INT32) * Length);
+  memset(Player->MixBufs[0x01], 0x00, sizeof(INT32) * Length);
+  CurCLst = Player->CurChipList;
+  while (CurCLst != NULL) {
+    if (CurCLst->Mixed || !CurCLst->COpts->Disabled) {
+      ResampleChipStream(Player, CurCLst, Player->MixBufs, Length);
+    }
+    CurCLst = CurCLst->next;
+  }
+  MixToOutput(Buffer, Player->MixBufs, Length, MstVol, SurroundSound);
+  if (ProfileRender) {
+    // chip rendering is timed separately in UpdateChipGroup
+    ChipTime = Player->ProfileTime[PROF_CHIPS] - ChipTime;
+    Player->ProfileTime[PROF_MIX] += GetProfileTime() - TimeStart - ChipTime;
+  }
+
+  return;
 }
 
-UINT32 FillBuffer(WAVE_16BS *Buffer, UINT32 BufferSize) {
+UINT32 FillBuffer(VGM_PLAYER *Player, WAVE_16BS *Buffer, UINT32 BufferSize) {
   UINT32 CurSmpl;
-  WAVE_32BS TempBuf;
+  UINT32 SegLen;
+  UINT32 TempLng;
   INT32 CurMstVol;
   UINT32 RecalcStep;
-  CA_LIST *CurCLst;
+  UINT64 TimeStart;
 
-
-  RecalcStep = FadePlay ? SampleRate / 44100 : 0;
-  CurMstVol = RecalcFadeVolume();
+  RecalcStep = Player->FadePlay ? SampleRate / 44100 : 0;
+  CurMstVol = RecalcFadeVolume(Player);
 
   if (Buffer == NULL) {
 
-    InterpretFile(BufferSize);
+    InterpretFile(Player, BufferSize);
 
-    if (FadePlay && !FadeStart) {
-      FadeStart = PlayingTime;
-      RecalcStep = FadePlay ? SampleRate / 100 : 0;
+    if (Player->FadePlay && !Player->FadeStart) {
+      Player->FadeStart = Player->PlayingTime;
+      RecalcStep = Player->FadePlay ? SampleRate / 100 : 0;
     }
     if (RecalcStep)
-      CurMstVol = RecalcFadeVolume();
+      CurMstVol = RecalcFadeVolume(Player);
 
-    if (VGMEnd) {
-      if (PauseSmpls <= BufferSize) {
-        PauseSmpls = 0;
-        EndPlay = true;
+    if (Player->VGMEnd) {
+      if (Player->PauseSmpls <= BufferSize) {
+        Player->PauseSmpls = 0;
+        Player->EndPlay = true;
       } else {
-        PauseSmpls -= BufferSize;
+        Player->PauseSmpls -= BufferSize;
       }
     }
 
     return BufferSize;
   }
 
-  CurChipList = (VGMEnd || PausePlay) ? ChipListPause : ChipListAll;
-
-  for (CurSmpl = 0x00; CurSmpl < BufferSize; CurSmpl++) {
-    InterpretFile(1);
-
-    // Sample Structures
-    //	00 - SN76496
-    //	01 - YM2413
-    //	02 - YM2612
-    //	03 - YM2151
-    //	04 - SegaPCM
-    //	05 - RF5C68
-    //	06 - YM2203
-    //	07 - YM2608
-    //	08 - YM2610/YM2610B
-    //	09 - YM3812
-    //	0A - YM3526
-    //	0B - Y8950
-    //	0C - YMF262
-    //	0D - YMF278B
-    //	0E - YMF271
-    //	0F - YMZ280B
-    //	10 - RF5C164
-    //	11 - PWM
-    //	12 - AY8910
-    //	13 - GameBoy
-    //	14 - NES APU
-    //	15 - MultiPCM
-    //	16 - UPD7759
-    //	17 - OKIM6258
-    //	18 - OKIM6295
-    //	19 - K051649
-    //	1A - K054539
-    //	1B - HuC6280
-    //	1C - C140
-    //	1D - K053260
-    //	1E - Pokey
-    //	1F - QSound
-    //	20 - YMF292/SCSP
-    //	21 - WonderSwan
-    //	22 - VSU
-    //	23 - SAA1099
-    //	24 - ES5503
-    //	25 - ES5506
-    //	26 - X1-010
-    //	27 - C352
-    //	28 - GA20
-    TempBuf.Left = 0x00;
-    TempBuf.Right = 0x00;
-    CurCLst = CurChipList;
-    while (CurCLst != NULL) {
-      if (!CurCLst->COpts->Disabled) {
-        ResampleChipStream(CurCLst, &TempBuf, 1);
+  Player->CurChipList = (Player->VGMEnd || Player->PausePlay)
+                            ? Player->ChipListPause
+                            : Player->ChipListAll;
+
+  // The buffer is rendered in segments that end before the next VGM command,
+  // so every chip is updated once per segment instead of once per sample.
+  CurSmpl = 0x00;
+  while (CurSmpl < BufferSize) {
+    TimeStart = ProfileRender ? GetProfileTime() : 0;
+    if (!Player->VGMEnd && !Player->PausePlay) {
+      TempLng = Player->VGMCurLoop *
+                    SampleVGM2Pbk_I(Player, Player->VGMHead.lngLoopSamples) +
+                Player->VGMSmplPlayed;
+      if (TempLng >= Player->SeekKeyNext) {
+        DrainChipQueues(Player); // the snapshot needs the current chip states
+        SaveSeekKey(Player, TempLng);
       }
-      CurCLst = CurCLst->next;
     }
+    // With chip workers, the register writes of the segment are queued.
+    // DAC streams write to the chips directly, every sample.
+    if (Player->ChipWork != NULL && !Player->DacCtrlUsed) {
+      Player->QueueWrites = true;
+      Player->QueueSmpl = CurSmpl;
+    } else {
+      DrainChipQueues(Player);
+    }
+    InterpretFile(Player, 1);
 
-    TempBuf.Left = ((TempBuf.Left >> 5) * CurMstVol) >> 11;
-    TempBuf.Right = ((TempBuf.Right >> 5) * CurMstVol) >> 11;
-    if (SurroundSound)
-      TempBuf.Right *= -1;
-    Buffer[CurSmpl].Left = Limit2Short(TempBuf.Left);
-    Buffer[CurSmpl].Right = Limit2Short(TempBuf.Right);
+    if (Player->FadePlay && !Player->FadeStart) {
+      Player->FadeStart = Player->PlayingTime;
+      RecalcStep = Player->FadePlay ? SampleRate / 100 : 0;
+    }
 
-    if (FadePlay && !FadeStart) {
-      FadeStart = PlayingTime;
-      RecalcStep = FadePlay ? SampleRate / 100 : 0;
+    SegLen = BufferSize - CurSmpl;
+    if (SegLen > Player->SegSmplsMax)
+      SegLen = Player->SegSmplsMax;
+    TempLng = GetEventDelay(Player);
+    if (SegLen - 1 > TempLng)
+      SegLen = TempLng + 1;
+    if (RecalcStep) {
+      // the fade volume is refreshed after the last sample of a segment
+      TempLng = (RecalcStep - CurSmpl % RecalcStep) % RecalcStep;
+      if (SegLen - 1 > TempLng)
+        SegLen = TempLng + 1;
     }
-    if (RecalcStep && !(CurSmpl % RecalcStep))
-      CurMstVol = RecalcFadeVolume();
+    if (Player->VGMEnd && !Player->EndPlay && SegLen - 1 > Player->PauseSmpls)
+      SegLen = Player->PauseSmpls + 1;
+    if (SegLen > 1)
+      InterpretFile(Player, SegLen - 1);
+
+    if (ProfileRender)
+      Player->ProfileTime[PROF_INTERP] += GetProfileTime() - TimeStart;
+    // a command that accesses the chips directly stops the queueing
+    if (Player->QueueWrites)
+      QueueSegment(Player, Buffer, CurSmpl, SegLen, CurMstVol);
+    else
+      RenderSegment(Player, &Buffer[CurSmpl], SegLen, CurMstVol);
+
+    // The segment ends before the next fade step and can't run past the
+    // pause after the song's end, so only its last sample needs the checks.
+    if (Player->VGMEnd && SegLen > 1) {
+      TempLng = SegLen - 1;
+      Player->PauseSmpls -=
+          (Player->PauseSmpls < TempLng) ? Player->PauseSmpls : TempLng;
+    }
+    CurSmpl += SegLen - 1;
 
-    if (VGMEnd) {
-      if (!PauseSmpls) {
-        if (!EndPlay) {
-          EndPlay = true;
-          break;
+    if (RecalcStep && !(CurSmpl % RecalcStep))
+      CurMstVol = RecalcFadeVolume(Player);
+
+    if (Player->VGMEnd) {
+      if (!Player->PauseSmpls) {
+        if (!Player->EndPlay) {
+          Player->EndPlay = true;
+          DrainChipQueues(Player);
+          return CurSmpl;
         }
       } else
       {
-        PauseSmpls--;
+        Player->PauseSmpls--;
       }
     }
+    CurSmpl++;
   }
+  DrainChipQueues(Player);
 
   return CurSmpl;
 }
@@ -3300,6 +4977,13 @@ UINT32 FillBuffer(WAVE_16BS *Buffer, UINT32 BufferSize) {
 UINT64 TimeSpec2Int64(const struct timespec *ts) {
   return (UINT64)ts->tv_sec * 1000000000 + ts->tv_nsec;
 }
+
+INLINE UINT64 GetProfileTime(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return TimeSpec2Int64(&ts);
+}
 // --- Merged from Stream.c ---
 
 typedef struct {
@@ -3312,6 +4996,8 @@ typedef struct {
   UINT16 cbSize;
 } WAVEFORMATEX;
 
+#define ALSA_LATENCY 20000 // device buffer length in usec
+
 static snd_pcm_t *hAlsaOut = NULL;
 static volatile bool WaveOutOpen = false;
 static pthread_t hThread;
@@ -3327,23 +5013,55 @@ bool SoundLog = false;
 char SoundLogFile[PATH_MAX] = {0};
 
 
+// The render thread fills a ring of RingBlocks blocks (SMPL_P_BUFFER samples
+// each) and the output thread drains it into ALSA, so render jitter doesn't
+// turn into underruns. BlocksSent/BlocksPlayed are the write/read positions
+// of the ring and each one is only modified by its own thread.
+static WAVE_16BS *RingBuf = NULL;
+static UINT32 RingBlocks;
+static pthread_t hRenderThread;
+
 void WaveOutLinuxCallBack(UINT32 WrtSmpls) {
+  // write the oldest rendered block to the device
+  UINT32 RdBlk;
+
   if (!hAlsaOut)
     return;
-  static WAVE_16BS TempBuf[8192];
-  FillBuffer(TempBuf, WrtSmpls);
-  if (snd_pcm_writei(hAlsaOut, TempBuf, WrtSmpls) < 0)
+  RdBlk = BlocksPlayed;
+  if (RdBlk == __atomic_load_n(&BlocksSent, __ATOMIC_ACQUIRE))
+    return; // ring empty
+  if (snd_pcm_writei(hAlsaOut, &RingBuf[(RdBlk % RingBlocks) * SMPL_P_BUFFER],
+                     WrtSmpls) < 0)
     snd_pcm_prepare(hAlsaOut);
-  BlocksSent++;
-  BlocksPlayed++;
+  __atomic_store_n(&BlocksPlayed, RdBlk + 1, __ATOMIC_RELEASE);
+}
+
+static void *RenderThread(void *arg) {
+  UINT32 WrtBlk;
+
+  while (WaveOutOpen) {
+    WrtBlk = BlocksSent;
+    if (StreamPause ||
+        WrtBlk - __atomic_load_n(&BlocksPlayed, __ATOMIC_ACQUIRE) >=
+            RingBlocks) {
+      usleep(1000); // ring full
+      continue;
+    }
+    FillBuffer(StreamPlayer, &RingBuf[(WrtBlk % RingBlocks) * SMPL_P_BUFFER],
+               SMPL_P_BUFFER);
+    __atomic_store_n(&BlocksSent, WrtBlk + 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
 }
 
 static void *PlaybackThread(void *arg) {
   while (WaveOutOpen) {
-    if (!StreamPause && hAlsaOut)
-      WaveOutLinuxCallBack(SMPL_P_BUFFER);
-    else
+    if (StreamPause || !hAlsaOut)
       usleep(10000);
+    else if (BlocksPlayed == __atomic_load_n(&BlocksSent, __ATOMIC_ACQUIRE))
+      usleep(1000); // wait for the renderer
+    else
+      WaveOutLinuxCallBack(SMPL_P_BUFFER);
   }
   return NULL;
 }
@@ -3378,7 +5096,7 @@ void StartAudioWarmup(void) {
   }
 }
 
-UINT8 StartStream(UINT8 DeviceID) {
+UINT8 StartStream(VGM_PLAYER *Player, UINT8 DeviceID) {
   if (WaveOutOpen)
     return 0x01;
     
@@ -3403,9 +5121,20 @@ UINT8 StartStream(UINT8 DeviceID) {
     }
   }
 
+  // the ring buffer absorbs render jitter, so the device buffer can be small
+  RingBlocks = (AUDIOBUFFERU >= 0x02) ? AUDIOBUFFERU : 0x02;
+  RingBuf = (WAVE_16BS *)malloc(RingBlocks * SMPL_P_BUFFER * SAMPLESIZE);
+  if (RingBuf == NULL)
+    return 0xC0;
+  BlocksSent = 0;
+  BlocksPlayed = 0;
+
   snd_pcm_set_params(hAlsaOut, SND_PCM_FORMAT_S16_LE,
-                     SND_PCM_ACCESS_RW_INTERLEAVED, 2, SampleRate, 1, 50000);
+                     SND_PCM_ACCESS_RW_INTERLEAVED, 2, SampleRate, 1,
+                     ALSA_LATENCY);
+  StreamPlayer = Player;
   WaveOutOpen = true;
+  pthread_create(&hRenderThread, NULL, RenderThread, NULL);
   pthread_create(&hThread, NULL, PlaybackThread, NULL);
   return 0x00;
 }
@@ -3414,9 +5143,13 @@ UINT8 StopStream(void) {
   if (!WaveOutOpen)
     return 0xD8;
   WaveOutOpen = false;
+  pthread_join(hRenderThread, NULL);
   pthread_join(hThread, NULL);
+  StreamPlayer = NULL;
   snd_pcm_close(hAlsaOut);
   hAlsaOut = NULL;
+  free(RingBuf);
+  RingBuf = NULL;
   return 0x00;
 }
 
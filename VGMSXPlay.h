@@ -75,6 +75,20 @@ typedef unsigned char bool;
 #define VGM_VER_NUM 0x170
 
 #define CHIP_COUNT 0x0A
+
+// SIMD kernel levels (SimdLevel), SIMD_AUTO uses the best one the CPU has
+#define SIMD_SCALAR 0x00
+#define SIMD_SSE2 0x01
+#define SIMD_SSE41 0x02
+#define SIMD_AVX2 0x03
+#define SIMD_AUTO 0xFF
+
+// render stages for ProfileTime
+#define PROF_INTERP 0x00 // VGM command interpreter
+#define PROF_CHIPS 0x01  // chip synthesis
+#define PROF_MIX 0x02    // resampling and mixing
+#define PROF_COUNT 0x03
+
 typedef struct chip_options {
   bool Disabled;
   UINT8 EmuCore;
@@ -133,39 +147,202 @@ typedef struct waveform_32bit_stereo {
   INT32 Right;
 } WAVE_32BS;
 
+typedef void (*strm_func)(void *param, stream_sample_t **outputs, int samples);
+
+// polyphase windowed-sinc filter bank for one input -> output rate ratio
+typedef struct sinc_filter {
+  UINT32 InRate;
+  UINT32 OutRate;
+  UINT32 Taps;  // coefficients per phase (multiple of 4)
+  float *Coefs; // SINC_PHASES * Taps coefficients
+} SINC_FILTER;
+
+typedef struct chip_audio_attributes CAUD_ATTR;
+struct chip_audio_attributes {
+  void *Info; // chip handle from device_start, NULL if not running
+  UINT32 SmpRate;
+  UINT16 Volume;
+  UINT8 ChipType;
+  UINT8 ChipID; // 0 - 1st chip, 1 - 2nd chip, etc.
+  // Resampler Type:
+  //	00 - Old
+  //	01 - Upsampling
+  //	02 - Copy
+  //	03 - Downsampling
+  //	04 - Windowed Sinc
+  UINT8 Resampler;
+  strm_func StreamUpdate;
+  bool MonoOut; // StreamUpdate can render mono (outputs[1] == NULL)
+  UINT32 SmpP;     // Current Sample (Playback Rate)
+  UINT32 SmpLast;  // Sample Number Last
+  UINT32 SmpNext;  // Sample Number Next
+  WAVE_32BS LSmpl; // Last Sample
+  WAVE_32BS NSmpl; // Next Sample
+  SINC_FILTER *SincFlt;
+  float *SincHist; // last Taps input samples, SINC_TAPS_MAX per channel
+  INT32 *RenderBufs[0x02]; // chip output of a render window (chip workers)
+  UINT32 RenderPos;        // next sample in RenderBufs
+  CAUD_ATTR *Paired;
+};
+
+typedef struct chip_audio_struct {
+  CAUD_ATTR SN76496;
+  CAUD_ATTR YM2413;
+  CAUD_ATTR YM2151;
+  CAUD_ATTR YM3812;
+  CAUD_ATTR YM3526;
+  CAUD_ATTR Y8950;
+  CAUD_ATTR YMF262;
+  CAUD_ATTR YMF278B;
+  CAUD_ATTR AY8910;
+  CAUD_ATTR K051649;
+} CHIP_AUDIO;
+
+// Chips with the same sample rate form a group that is mixed at that rate
+// and resampled once. The first chip of a group holds the resampler state.
+typedef struct chip_aud_list CA_LIST;
+struct chip_aud_list {
+  CAUD_ATTR *CAud;
+  CHIP_OPTS *COpts;
+  bool Mixed;        // several chips - volume is applied before resampling
+  CA_LIST *SameRate; // further chips of the group
+  CA_LIST *next;     // next group
+};
+
+typedef struct daccontrol_data {
+  bool Enable;
+  UINT8 Bank;
+} DACCTRL_DATA;
+
+typedef struct pcmbank_table {
+  UINT8 ComprType;
+  UINT8 CmpSubType;
+  UINT8 BitDec;
+  UINT8 BitCmp;
+  UINT16 EntryCount;
+  void *Entries;
+} PCMBANK_TBL;
+
+#define PCM_BANK_COUNT 0x40
+typedef struct vgm_event VGM_EVENT;
+typedef struct seek_keyframe SEEK_KEY;
+typedef struct chip_workers CHIP_WORKERS;
+
+// Everything that belongs to one song. Players are independent of each
+// other and can render on different threads at the same time, the options
+// above (SampleRate, ChipOpts, ...) are shared and must not change while
+// a player renders.
+typedef struct vgm_player {
+  bool AutoStopSkip;
+  UINT8 FileMode;
+  VGM_HEADER VGMHead;
+  VGM_HDR_EXTRA VGMHeadX;
+  VGM_EXTRA VGMH_Extra;
+  UINT32 VGMDataLen;
+  UINT8 *VGMData;
+  GD3_TAG VGMTag;
+
+  VGM_PCM_BANK PCMBank[PCM_BANK_COUNT];
+  PCMBANK_TBL PCMTbl;
+  UINT8 DacCtrlUsed;
+  UINT8 DacCtrlUsg[0xFF];
+  DACCTRL_DATA DacCtrl[0xFF];
+  void *DacInfo[0xFF]; // DAC Control handles, kept until the chips stop
+
+  CHIP_AUDIO ChipAudio[0x02];
+  CAUD_ATTR CA_Paired[0x02][0x03];
+  float MasterVol;
+  CA_LIST ChipListBuffer[0x200];
+  CA_LIST *ChipListAll;
+  CA_LIST *ChipListPause;
+  CA_LIST *CurChipList;
+
+  INT32 *StreamBufs[0x02];
+  INT32 *GroupBufs[0x02]; // single chip output of a same-rate group
+  INT32 *MixBufs[0x02];   // planar mix bus (left/right)
+  float *SincBufs[0x02];
+  UINT32 SegSmplsMax;
+  CHIP_WORKERS *ChipWork; // NULL if the chips render on the caller's thread
+  bool QueueWrites;       // register writes go to the chip workers' queues
+  UINT32 QueueSmpl;       // buffer position of the queued writes
+  bool ChipsRendered;     // the chips' output is already in RenderBufs
+  float VolumeBak;
+
+  UINT32 VGMPos;
+  INT32 VGMSmplPos;
+  VGM_EVENT *VGMEvts;
+  UINT32 VGMEvtCount;
+  UINT32 VGMEvtAlloc;
+  UINT32 VGMEvtPos;
+  UINT32 VGMEvtLoop;  // first event of the loop
+  UINT32 VGMLoopSmpl; // timestamp of the loop offset
+  INT32 VGMSmplOfs;   // event timestamp -> VGMSmplPos
+  INT32 VGMSmplPlayed;
+  INT32 VGMSampleRate;
+  UINT32 VGMPbRateMul;
+  UINT32 VGMPbRateDiv;
+  UINT32 VGMSmplRateMul;
+  UINT32 VGMSmplRateDiv;
+  UINT32 FadeTime;  // fade-out length in ms
+  UINT32 PauseTime; // silence after the song in ms
+  UINT32 PauseSmpls;
+  bool VGMEnd;
+  bool EndPlay;
+  bool PausePlay;
+  bool FadePlay;
+  bool ForceVGMExec;
+  UINT32 PlayingTime;
+  UINT32 FadeStart;
+  UINT32 VGMMaxLoopM;
+  UINT32 VGMCurLoop;
+  float VolumeLevelM;
+  float FinalVol;
+  bool Interpreting;
+
+  SEEK_KEY *SeekKeys;
+  UINT32 SeekKeyCount;
+  UINT32 SeekKeyAlloc;
+  UINT32 SeekKeyNext; // playback sample of the next snapshot
+
+  UINT8 IsVGMInit;
+  UINT64 ProfileTime[PROF_COUNT]; // render time per stage in ns
+} VGM_PLAYER;
+
 void VGMPlay_Init(void);
 void VGMPlay_Init2(void);
 void VGMPlay_Deinit(void);
+VGM_PLAYER *VGMPlayer_Create(void);
+void VGMPlayer_Destroy(VGM_PLAYER *Player);
 char *FindFile(const char *FileName);
 
 UINT32 GetGZFileLength(const char *FileName);
-bool OpenVGMFile(const char *FileName);
-void CloseVGMFile(void);
+bool OpenVGMFile(VGM_PLAYER *Player, const char *FileName);
+void CloseVGMFile(VGM_PLAYER *Player);
 
 void FreeGD3Tag(GD3_TAG *TagData);
 UINT32 GetVGMFileInfo(const char *FileName, VGM_HEADER *RetVGMHead,
                       GD3_TAG *RetGD3Tag);
-UINT32 CalcSampleMSec(UINT64 Value, UINT8 Mode);
+UINT32 CalcSampleMSec(VGM_PLAYER *Player, UINT64 Value, UINT8 Mode);
 UINT32 CalcSampleMSecExt(UINT64 Value, UINT8 Mode, VGM_HEADER *FileHead);
 const char *GetChipName(UINT8 ChipID);
 const char *GetAccurateChipName(UINT8 ChipID, UINT8 SubType);
-UINT32 GetChipClock(VGM_HEADER *FileHead, UINT8 ChipID, UINT8 *RetSubType);
+UINT32 GetChipClock(VGM_PLAYER *Player, UINT8 ChipID, UINT8 *RetSubType);
 
-INT32 SampleVGM2Playback(INT32 SampleVal);
-INT32 SamplePlayback2VGM(INT32 SampleVal);
+INT32 SampleVGM2Playback(VGM_PLAYER *Player, INT32 SampleVal);
+INT32 SamplePlayback2VGM(VGM_PLAYER *Player, INT32 SampleVal);
 
-void PlayVGM(void);
-void StopVGM(void);
-void RestartVGM(void);
-void PauseVGM(bool Pause);
-void SeekVGM(bool Relative, INT32 PlayBkSamples);
-void RefreshMuting(void);
-void RefreshPanning(void);
-void RefreshPlaybackOptions(void);
+void PlayVGM(VGM_PLAYER *Player);
+void StopVGM(VGM_PLAYER *Player);
+void RestartVGM(VGM_PLAYER *Player);
+void PauseVGM(VGM_PLAYER *Player, bool Pause);
+void SeekVGM(VGM_PLAYER *Player, bool Relative, INT32 PlayBkSamples);
+void RefreshMuting(VGM_PLAYER *Player);
+void RefreshPanning(VGM_PLAYER *Player);
+void RefreshPlaybackOptions(VGM_PLAYER *Player);
 
 extern UINT32 PLFileCount;
 
-UINT32 FillBuffer(WAVE_16BS *Buffer, UINT32 BufferSize);
+UINT32 FillBuffer(VGM_PLAYER *Player, WAVE_16BS *Buffer, UINT32 BufferSize);
 
 // --- Merged from Stream.h ---
 #define MAX_PATH PATH_MAX
@@ -175,7 +352,7 @@ UINT32 FillBuffer(WAVE_16BS *Buffer, UINT32 BufferSize);
 #define BUFSIZELD 11       // Buffer Size
 #define AUDIOBUFFERS 200   // Maximum Buffer Count
 
-UINT8 StartStream(UINT8 DeviceID);
+UINT8 StartStream(VGM_PLAYER *Player, UINT8 DeviceID);
 UINT8 StopStream(void);
 void StartAudioWarmup(void); // Pre-init audio in background
 void PauseStream(bool PauseOn);
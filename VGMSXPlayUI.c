@@ -4,6 +4,8 @@
 // #define _GNU_SOURCE
 #include <ctype.h> // for toupper
 #include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
 #include <locale.h> // for setlocale
 #include <stdarg.h>
 #include <stdio.h>
@@ -20,6 +22,7 @@
 #include <sys/types.h>  // Added
 #include <sys/wait.h>   // Added
 #include <termios.h>
+#include <time.h>   // for clock_gettime()
 #include <unistd.h> // for STDIN_FILENO and usleep()
 
 #define Sleep(msec) usleep(msec * 1000)
@@ -623,6 +626,23 @@ static void ShowHelp(void) {
   printf("   <file>       Play a single .vgm/.vgz file\n");
   printf("   <directory>  Play all .vmg/.vgz files in directory\n");
   printf("   <archive>    play files from archive\n\n");
+  printf("   --sinc       use the windowed-sinc resampler (higher quality)\n");
+  printf("   --simd=<x>   force the DSP kernels: scalar, sse2, sse4.1 or avx2\n");
+  printf("   --no-blep    run the PSG cores at their native rate and resample\n");
+  printf("   --opl-fixed  use the integer variant of the OPL2/OPL3 core\n");
+  printf("   --chip-threads=<n> render the chips of a song on <n> threads\n");
+  printf("   --bench      render the inputs without sound output and print\n");
+  printf("                the render speed as CSV (accepts several inputs)\n");
+  printf("   --batch=<dir> render the inputs to WAV files in <dir>, directory\n");
+  printf("                trees and archives are mirrored below it\n");
+  printf("   --jobs=<n>   batch render threads (default: one per CPU)\n");
+  printf("   --render=<file> render the inputs one after another into <file>\n");
+  printf("                as fast as possible, without sound output\n");
+  printf("   --split      render one file per track: <name>-01.wav, ...\n");
+  printf("   --direct-io  write the render with O_DIRECT (bypasses the cache)\n");
+  printf("   --raw        batch/render to raw 16-bit stereo PCM\n");
+  printf("   --loops=<n>  number of loops to play (default: 2)\n");
+  printf("   --fade=<ms>  fade-out time after the last loop (default: 5000)\n\n");
   printf(" *Playing from archive requires the appropriate system decompressor.\n\n");
 }
 
@@ -676,7 +696,7 @@ static bool FindVGMDir(char *path) {
 
 static bool OpenDirectoryAsPlaylist(const char *DirPath);
 static bool OpenMusicFile(const char *FileName);
-extern bool OpenVGMFile(const char *FileName);
+extern UINT64 TimeSpec2Int64(const struct timespec *ts);
 static void wprintc(const wchar_t *format, ...);
 static void PrintChipStr(UINT8 ChipID, UINT8 SubType, UINT32 Clock);
 const wchar_t *GetTagStrEJ(const wchar_t *EngTag, const wchar_t *JapTag);
@@ -685,6 +705,10 @@ static void PlayVGM_UI(void);
 INLINE INT8 sign(double Value);
 INLINE long int Round(double Value);
 static void PrintMinSec(UINT32 SamplePos, UINT32 SmplRate);
+static void BenchFile(const char *FileName, UINT64 *Totals);
+static int RunBenchmark(int argc, char *argv[]);
+static int RunBatchRender(int argc, char *argv[]);
+static int RunRender(int argc, char *argv[]);
 
 extern UINT32 SampleRate; 
 extern UINT32 VGMPbRate;
@@ -692,10 +716,8 @@ extern UINT32 VGMMaxLoop;
 extern UINT32 CMFMaxLoop;
 UINT32 FadeTimeN;  // normal fade time
 UINT32 FadeTimePL; // in-playlist fade time
-extern UINT32 FadeTime;
 UINT32 PauseTimeJ; // Pause Time for Jingles
 UINT32 PauseTimeL; // Pause Time for Looping Songs
-extern UINT32 PauseTime;
 extern float VolumeLevel;
 extern bool SurroundSound;
 extern UINT8 HardStopOldVGMs;
@@ -704,7 +726,18 @@ extern bool PauseEmulate;
 extern bool DoubleSSGVol;
 static UINT16 ForceAudioBuf;
 static UINT8 OutputDevID;
-extern UINT8 ResampleMode; // 00 - HQ both, 01 - LQ downsampling, 02 - LQ both
+extern UINT8 ResampleMode; // 00 - HQ both, 01 - LQ downsampling, 02 - LQ both,
+                           // 03 - windowed sinc
+extern UINT8 SimdLevel;
+extern bool PSGBlep;
+extern bool ProfileRender;
+extern UINT32 ChipThreads;
+static bool BenchMode;
+static const char *BatchOutDir; // --batch: output directory
+static UINT32 BatchJobs;        // worker threads, 0 = one per CPU
+static bool BatchRaw;           // headerless PCM instead of WAV
+static bool RenderSplit;        // --render: one file per track
+static bool RenderDirect;       // --render: write with O_DIRECT
 extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
 extern bool FMBreakFade;
@@ -713,6 +746,7 @@ extern bool FMOPL2Pan;
 extern CHIPS_OPTION ChipOpts[0x02];
 extern UINT16 AUDIOBUFFERU;
 extern UINT32 SMPL_P_BUFFER;
+extern bool SoundLog;
 extern char SoundLogFile[MAX_PATH];
 extern UINT8 OPL_MODE;
 extern UINT8 OPL_CHIPS;
@@ -727,37 +761,17 @@ UINT32 CurPLFile;
 static UINT8 NextPLCmd;
 UINT8 PLMode; // set to 1 to show Playlist text
 static bool FirstInit;
-extern bool AutoStopSkip;
 char VgmFileName[MAX_PATH];
 static UINT8 FileMode;
-extern VGM_HEADER VGMHead;
-extern UINT32 VGMDataLen;
-extern UINT8 *VGMData;
-extern GD3_TAG VGMTag;
 static bool PreferJapTag;
 static bool StreamStarted;
-extern float MasterVol;
-extern UINT32 VGMPos;
-extern INT32 VGMSmplPos;
-extern INT32 VGMSmplPlayed;
-extern INT32 VGMSampleRate;
 extern UINT32 BlocksSent;
 extern UINT32 BlocksPlayed;
 static bool IsRAWLog;
-extern bool EndPlay;
-extern bool PausePlay;
-extern bool FadePlay;
-extern bool ForceVGMExec;
 // extern UINT8 PlayingMode; // Removed
 
-extern UINT32 PlayingTime;
 
-extern UINT32 FadeStart;
-extern UINT32 VGMMaxLoopM;
-extern UINT32 VGMCurLoop;
-extern float VolumeLevelM;
 bool ErrorHappened; // used by VGMPlay.c and VGMPlay_AddFmts.c
-extern float FinalVol;
 extern bool ResetPBTimer;
 
 static struct termios oldterm;
@@ -767,10 +781,11 @@ static volatile bool sigint = false;
 
 UINT8 CmdList[0x100];
 
-extern UINT8 IsVGMInit;
 
 static bool PrintMSHours;
 
+static VGM_PLAYER *Player;
+
 static void signal_handler(int signal) {
   if (signal == SIGINT || signal == SIGTERM || signal == SIGHUP)
     sigint = true;
@@ -850,9 +865,70 @@ int main(int argc, char *argv[]) {
   if (CHIP_SAMPLE_RATE <= 0)
     CHIP_SAMPLE_RATE = SampleRate;
   VGMPlay_Init2();
+  Player = VGMPlayer_Create();
+  if (Player == NULL) {
+    fprintf(stderr, "Error allocating the player!\n");
+    VGMPlay_Deinit();
+    free(AppName);
+    return 1;
+  }
 
   ErrRet = 0;
   argbase = 0x01;
+  while (argbase < argc && !strncmp(argv[argbase], "--", 2)) {
+    if (!stricmp_u(argv[argbase], "--sinc"))
+      ResampleMode = 0x03;
+    else if (!stricmp_u(argv[argbase], "--simd=scalar"))
+      SimdLevel = SIMD_SCALAR;
+    else if (!stricmp_u(argv[argbase], "--simd=sse2"))
+      SimdLevel = SIMD_SSE2;
+    else if (!stricmp_u(argv[argbase], "--simd=sse4.1"))
+      SimdLevel = SIMD_SSE41;
+    else if (!stricmp_u(argv[argbase], "--simd=avx2"))
+      SimdLevel = SIMD_AVX2;
+    else if (!stricmp_u(argv[argbase], "--no-blep"))
+      PSGBlep = false;
+    else if (!stricmp_u(argv[argbase], "--opl-fixed")) {
+      // DosBox OPL core with integer envelope math (EC_DBOPL_FIXED)
+      ChipOpts[0x00].YM3812.EmuCore = 0x02;
+      ChipOpts[0x00].YMF262.EmuCore = 0x02;
+    }
+    else if (!strnicmp_u(argv[argbase], "--chip-threads=", 15))
+      ChipThreads = (UINT32)strtoul(argv[argbase] + 15, NULL, 0);
+    else if (!stricmp_u(argv[argbase], "--bench"))
+      BenchMode = true;
+    else if (!strnicmp_u(argv[argbase], "--batch=", 8))
+      BatchOutDir = argv[argbase] + 8;
+    else if (!strnicmp_u(argv[argbase], "--jobs=", 7))
+      BatchJobs = (UINT32)strtoul(argv[argbase] + 7, NULL, 0);
+    else if (!stricmp_u(argv[argbase], "--raw"))
+      BatchRaw = true;
+    else if (!strnicmp_u(argv[argbase], "--render=", 9)) {
+      SoundLog = true;
+      snprintf(SoundLogFile, MAX_PATH, "%s", argv[argbase] + 9);
+    } else if (!stricmp_u(argv[argbase], "--split"))
+      RenderSplit = true;
+    else if (!stricmp_u(argv[argbase], "--direct-io"))
+      RenderDirect = true;
+    else if (!strnicmp_u(argv[argbase], "--loops=", 8))
+      VGMMaxLoop = (UINT32)strtoul(argv[argbase] + 8, NULL, 0);
+    else if (!strnicmp_u(argv[argbase], "--fade=", 7))
+      FadeTimeN = (UINT32)strtoul(argv[argbase] + 7, NULL, 0);
+    argbase++;
+  }
+
+  if ((BenchMode || BatchOutDir != NULL || SoundLog) && argc > argbase) {
+    if (BatchOutDir != NULL)
+      ErrRet = RunBatchRender(argc - argbase, &argv[argbase]);
+    else if (SoundLog)
+      ErrRet = RunRender(argc - argbase, &argv[argbase]);
+    else
+      ErrRet = RunBenchmark(argc - argbase, &argv[argbase]);
+    VGMPlayer_Destroy(Player);
+    VGMPlay_Deinit();
+    free(AppName);
+    return ErrRet;
+  }
 
   if (argc <= argbase) {
     if (termmode)
@@ -942,14 +1018,14 @@ int main(int argc, char *argv[]) {
     }
 
     ErrorHappened = false;
-    FadeTime = FadeTimeN;
-    PauseTime = PauseTimeL;
+    Player->FadeTime = FadeTimeN;
+    Player->PauseTime = PauseTimeL;
     PrintMSHours =
-        (VGMHead.lngTotalSamples >= 158760000); 
+        (Player->VGMHead.lngTotalSamples >= 158760000); 
     NextPLCmd = 0x80;
     PlayVGM_UI();
 
-    CloseVGMFile();
+    CloseVGMFile(Player);
   } else {
 
     CurPLFile = 0x00;
@@ -992,15 +1068,16 @@ int main(int argc, char *argv[]) {
 
       ErrorHappened = false;
       if (CurPLFile < PLFileCount - 1)
-        FadeTime = FadeTimePL;
+        Player->FadeTime = FadeTimePL;
       else
-        FadeTime = FadeTimeN;
-      PauseTime = VGMHead.lngLoopOffset ? PauseTimeL : PauseTimeJ;
-      PrintMSHours = (VGMHead.lngTotalSamples >= 158760000);
+        Player->FadeTime = FadeTimeN;
+      Player->PauseTime =
+          Player->VGMHead.lngLoopOffset ? PauseTimeL : PauseTimeJ;
+      PrintMSHours = (Player->VGMHead.lngTotalSamples >= 158760000);
       NextPLCmd = 0x00;
       PlayVGM_UI();
 
-      CloseVGMFile();
+      CloseVGMFile(Player);
 
       if (NextPLCmd == 0x01) { // Previous Track
         if (CurPLFile > 0)
@@ -1017,7 +1094,7 @@ int main(int argc, char *argv[]) {
     printf("\x1B[?25h"); // Show Cursor
     StopStream();
     StreamStarted = false;
-    StopVGM();
+    StopVGM(Player);
     if (IsTempExtraction && TempExtractDir) {
         CleanupTempDirectory(TempExtractDir);
         free(TempExtractDir);
@@ -1050,6 +1127,7 @@ ExitProgram:
 
   printf("\x1B[?25h"); // Show Cursor
   changemode(false);
+  VGMPlayer_Destroy(Player);
   VGMPlay_Deinit();
   free(AppName);
   return ErrRet;
@@ -1319,7 +1397,7 @@ static bool OpenDirectoryAsPlaylist(const char *DirPath) {
 }
 
 static bool OpenMusicFile(const char *FileName) {
-  if (OpenVGMFile(FileName))
+  if (OpenVGMFile(Player, FileName))
     return true;
   return false;
 }
@@ -1451,10 +1529,14 @@ static void ShowVGMTag(void) {
   UINT32 StrLen;
 #endif
 
-  TitleTag = GetTagStrEJ(VGMTag.strTrackNameE, VGMTag.strTrackNameJ);
-  GameTag = GetTagStrEJ(VGMTag.strGameNameE, VGMTag.strGameNameJ);
-  AuthorTag = GetTagStrEJ(VGMTag.strAuthorNameE, VGMTag.strAuthorNameJ);
-  SystemTag = GetTagStrEJ(VGMTag.strSystemNameE, VGMTag.strSystemNameJ);
+  TitleTag = GetTagStrEJ(Player->VGMTag.strTrackNameE,
+                         Player->VGMTag.strTrackNameJ);
+  GameTag = GetTagStrEJ(Player->VGMTag.strGameNameE,
+                        Player->VGMTag.strGameNameJ);
+  AuthorTag = GetTagStrEJ(Player->VGMTag.strAuthorNameE,
+                          Player->VGMTag.strAuthorNameJ);
+  SystemTag = GetTagStrEJ(Player->VGMTag.strSystemNameE,
+                          Player->VGMTag.strSystemNameJ);
 
 
   UI_GoToLine(10);
@@ -1481,17 +1563,17 @@ static void ShowVGMTag(void) {
     }
     PrintBoxLineW(L"\"%ls\"", TitleTag);
   }
-  PrintBoxLineW(L"Game: %ls (%ls)", GameTag, VGMTag.strReleaseDate);
+  PrintBoxLineW(L"Game: %ls (%ls)", GameTag, Player->VGMTag.strReleaseDate);
   PrintBoxLineW(L"Composer: %ls", AuthorTag);
-  PrintBoxLine("Loop: %s", VGMHead.lngLoopOffset ? "Yes" : "No");
+  PrintBoxLine("Loop: %s", Player->VGMHead.lngLoopOffset ? "Yes" : "No");
 
   {
     char chips_buf[512] = "Used chips: ";
     char chip_name[64];
     bool first = true;
     for (CurChip = 0x00; CurChip < CHIP_COUNT; CurChip++) {
-      ChpClk = GetChipClock(&VGMHead, CurChip, &ChpType);
-      if (ChpClk && GetChipClock(&VGMHead, 0x80 | CurChip, NULL))
+      ChpClk = GetChipClock(Player, CurChip, &ChpType);
+      if (ChpClk && GetChipClock(Player, 0x80 | CurChip, NULL))
         ChpClk |= 0x40000000;
 
       if (ChpClk) {
@@ -1571,7 +1653,7 @@ static void PlayVGM_UI(void) {
   printf("\x1B[?25l");
   fflush(stdout);
 
-  PlayVGM();
+  PlayVGM(Player);
   DBus_EmitSignal(SIGNAL_SEEK | SIGNAL_METADATA | SIGNAL_PLAYSTATUS |
                   SIGNAL_CONTROLS);
 
@@ -1583,8 +1665,9 @@ static void PlayVGM_UI(void) {
 
   switch (FileMode) {
   case 0x00: // VGM
-    IsRAWLog = (!VGMHead.lngLoopOffset && (wcslen(VGMTag.strSystemNameE) ||
-                                           wcslen(VGMTag.strSystemNameJ)));
+    IsRAWLog = (!Player->VGMHead.lngLoopOffset &&
+                (wcslen(Player->VGMTag.strSystemNameE) ||
+                 wcslen(Player->VGMTag.strSystemNameJ)));
     break;
   case 0x01: // CMF
     IsRAWLog = false;
@@ -1593,7 +1676,7 @@ static void PlayVGM_UI(void) {
     IsRAWLog = true;
     break;
   }
-  if (!VGMHead.lngTotalSamples)
+  if (!Player->VGMHead.lngTotalSamples)
     IsRAWLog = false;
 
     if (FirstInit || !StreamStarted) {
@@ -1602,7 +1685,7 @@ static void PlayVGM_UI(void) {
       UINT8 RetVal;
       
       while (attempts < 3) {
-          RetVal = StartStream(OutputDevID);
+          RetVal = StartStream(Player, OutputDevID);
           
           if (!RetVal) break;
           
@@ -1681,14 +1764,14 @@ static void PlayVGM_UI(void) {
         ShowVGMTag();
     }
 
-    PauseStream(PausePlay);
+    PauseStream(Player->PausePlay);
   FirstInit = false;
 
-  VGMPlaySt = VGMPos;
-  if (VGMHead.lngGD3Offset)
-    VGMPlayEnd = VGMHead.lngGD3Offset;
+  VGMPlaySt = Player->VGMPos;
+  if (Player->VGMHead.lngGD3Offset)
+    VGMPlayEnd = Player->VGMHead.lngGD3Offset;
   else
-    VGMPlayEnd = VGMHead.lngEOFOffset;
+    VGMPlayEnd = Player->VGMHead.lngEOFOffset;
   VGMPlayEnd -= VGMPlaySt;
   if (!FileMode)
     VGMPlayEnd--; 
@@ -1703,19 +1786,21 @@ static void PlayVGM_UI(void) {
       NextPLCmd = 0xFF;
     }
 
-    if (!PausePlay || PosPrint) {
+    if (!Player->PausePlay || PosPrint) {
       UINT32 CurSec;
       static UINT32 LastSec = 0xFFFFFFFF;
 
       PlaySmpl = (BlocksSent - BlocksPlayed) * SMPL_P_BUFFER;
-      PlaySmpl = VGMSmplPlayed - PlaySmpl;
-      if (!VGMCurLoop) {
+      PlaySmpl = Player->VGMSmplPlayed - PlaySmpl;
+      if (!Player->VGMCurLoop) {
         if (PlaySmpl < 0)
           PlaySmpl = 0;
       } else {
-        while (PlaySmpl < SampleVGM2Playback(VGMHead.lngTotalSamples -
-                                             VGMHead.lngLoopSamples))
-          PlaySmpl += SampleVGM2Playback(VGMHead.lngLoopSamples);
+        while (PlaySmpl <
+               SampleVGM2Playback(Player, Player->VGMHead.lngTotalSamples -
+                                              Player->VGMHead.lngLoopSamples))
+          PlaySmpl +=
+              SampleVGM2Playback(Player, Player->VGMHead.lngLoopSamples);
       }
 
       CurSec = PlaySmpl / SampleRate;
@@ -1723,7 +1808,8 @@ static void PlayVGM_UI(void) {
         PosPrint = false;
         LastSec = CurSec;
 
-        VGMPbSmplCount = SampleVGM2Playback(VGMHead.lngTotalSamples);
+        VGMPbSmplCount =
+            SampleVGM2Playback(Player, Player->VGMHead.lngTotalSamples);
 
         char status_buf[512]; 
         char time_cur[32];
@@ -1789,9 +1875,9 @@ static void PlayVGM_UI(void) {
     } else {
     }
 
-    if (EndPlay) {
+    if (Player->EndPlay) {
       if (!PlayTimeEnd) {
-        PlayTimeEnd = PlayingTime;
+        PlayTimeEnd = Player->PlayingTime;
         if (!PLFileCount || CurPLFile >= PLFileCount - 0x01) {
           if (FileMode == 0x01)
             PlayTimeEnd += SampleRate << 1; 
@@ -1799,7 +1885,7 @@ static void PlayVGM_UI(void) {
         }
       }
 
-      if (PlayingTime >= PlayTimeEnd)
+      if (Player->PlayingTime >= PlayTimeEnd)
         QuitPlay = true;
     }
 #define KEY_UP 0x1000
@@ -1889,7 +1975,7 @@ static void PlayVGM_UI(void) {
           SeekOffset = 0;
           break;
         case ' ': // Space
-          PauseVGM(!PausePlay);
+          PauseVGM(Player, !Player->PausePlay);
           PosPrint = true;
           DBus_EmitSignal(SIGNAL_PLAYSTATUS);
           break;
@@ -1898,19 +1984,20 @@ static void PlayVGM_UI(void) {
         }
 
         if (SeekOffset) {
-          SeekVGM(true, SeekOffset * SampleRate);
+          SeekVGM(Player, true, SeekOffset * SampleRate);
           PosPrint = true;
           DBus_EmitSignal(SIGNAL_SEEK);
         }
       }
     }
 
-    if (FadeRAWLog && IsRAWLog && !PausePlay && !FadePlay && FadeTimeN) {
-      PlaySmpl =
-          (INT32)VGMHead.lngTotalSamples - FadeTimeN * VGMSampleRate / 1500;
-      if (VGMSmplPos >= PlaySmpl) {
-        FadeTime = FadeTimeN;
-        FadePlay = true; 
+    if (FadeRAWLog && IsRAWLog && !Player->PausePlay && !Player->FadePlay &&
+        FadeTimeN) {
+      PlaySmpl = (INT32)Player->VGMHead.lngTotalSamples -
+                 FadeTimeN * Player->VGMSampleRate / 1500;
+      if (Player->VGMSmplPos >= PlaySmpl) {
+        Player->FadeTime = FadeTimeN;
+        Player->FadePlay = true; 
       }
     }
     usleep(20000);
@@ -1943,7 +2030,7 @@ static void PlayVGM_UI(void) {
 
   StopStream();
   StreamStarted = false;
-  StopVGM();
+  StopVGM(Player);
   printf("\x1B[?25h"); 
 
 
@@ -1984,6 +2071,722 @@ static void PrintMinSec(UINT32 SamplePos, UINT32 SmplRate) {
   return;
 }
 
+// --- Benchmark Mode ---
+#define BENCH_BUFSIZE 0x400
+
+static void BenchFile(const char *FileName, UINT64 *Totals) {
+  // renders a file as fast as possible and prints one CSV line
+  // Totals: samples, render time, interpreter/chip/mix time (ns)
+  static WAVE_16BS BenchBuf[BENCH_BUFSIZE];
+  struct timespec TimeStart;
+  struct timespec TimeEnd;
+  const char *FileTitle;
+  UINT64 RenderTime;
+  UINT64 SmplCount;
+  UINT8 CurStage;
+
+  if (!OpenMusicFile(FileName)) {
+    fprintf(stderr, "Error opening the file: %s\n", FileName);
+    return;
+  }
+  Player->FadeTime = FadeTimeN;
+  Player->PauseTime = Player->VGMHead.lngLoopOffset ? PauseTimeL : PauseTimeJ;
+
+  PlayVGM(Player);
+  for (CurStage = 0x00; CurStage < PROF_COUNT; CurStage++)
+    Player->ProfileTime[CurStage] = 0;
+  ProfileRender = true;
+  SmplCount = 0;
+  clock_gettime(CLOCK_MONOTONIC, &TimeStart);
+  while (!Player->EndPlay && !sigint)
+    SmplCount += FillBuffer(Player, BenchBuf, BENCH_BUFSIZE);
+  clock_gettime(CLOCK_MONOTONIC, &TimeEnd);
+  ProfileRender = false;
+  StopVGM(Player);
+  CloseVGMFile(Player);
+
+  RenderTime = TimeSpec2Int64(&TimeEnd) - TimeSpec2Int64(&TimeStart);
+  if (!RenderTime)
+    RenderTime = 1;
+  Totals[0] += SmplCount;
+  Totals[1] += RenderTime;
+  for (CurStage = 0x00; CurStage < PROF_COUNT; CurStage++)
+    Totals[2 + CurStage] += Player->ProfileTime[CurStage];
+
+  FileTitle = strrchr(FileName, DIR_CHR);
+  FileTitle = FileTitle ? FileTitle + 1 : FileName;
+  putchar('"');
+  for (; *FileTitle; FileTitle++) {
+    if (*FileTitle == '"')
+      putchar('"');
+    putchar(*FileTitle);
+  }
+  printf("\",%llu,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+         (unsigned long long)SmplCount, RenderTime / 1e9,
+         SmplCount * 1e9 / SampleRate / RenderTime,
+         SmplCount ? (double)RenderTime / SmplCount : 0.0,
+         Player->ProfileTime[PROF_INTERP] * 100.0 / RenderTime,
+         Player->ProfileTime[PROF_CHIPS] * 100.0 / RenderTime,
+         Player->ProfileTime[PROF_MIX] * 100.0 / RenderTime);
+  fflush(stdout);
+
+  return;
+}
+
+static int RunBenchmark(int argc, char *argv[]) {
+  // --bench: renders files, directories and archives without sound output
+  struct stat statbuf;
+  char TempDir[MAX_PATH];
+  UINT64 Totals[2 + PROF_COUNT];
+  UINT32 CurFile;
+  int CurArg;
+  int ErrRet;
+
+  memset(Totals, 0x00, sizeof(Totals));
+  ErrRet = 0;
+  printf("file,samples,seconds,x_realtime,ns_per_sample,"
+         "interp_pct,chips_pct,mix_pct\n");
+  for (CurArg = 0; CurArg < argc && !sigint; CurArg++) {
+    strcpy(VgmFileName, argv[CurArg]);
+    TempDir[0] = '\0';
+    if (IsArchiveFile(VgmFileName) && stat(VgmFileName, &statbuf) == 0 &&
+        S_ISREG(statbuf.st_mode)) {
+      if (ExtractArchiveToTemp(VgmFileName, TempDir)) {
+        fprintf(stderr, "Error extracting the archive: %s\n", VgmFileName);
+        ErrRet = 1;
+        continue;
+      }
+      strcpy(VgmFileName, TempDir);
+      FindVGMDir(VgmFileName);
+    }
+
+    if (stat(VgmFileName, &statbuf) == 0 && S_ISDIR(statbuf.st_mode)) {
+      if (!OpenDirectoryAsPlaylist(VgmFileName)) {
+        fprintf(stderr, "No VGM files found in: %s\n", argv[CurArg]);
+        ErrRet = 1;
+      } else {
+        for (CurFile = 0x00; CurFile < PLFileCount; CurFile++) {
+          strcpy(VgmFileName, PLFileBase);
+          strcat(VgmFileName, PlayListFile[CurFile]);
+          if (!sigint)
+            BenchFile(VgmFileName, Totals);
+          free(PlayListFile[CurFile]);
+        }
+        free(PlayListFile);
+        PlayListFile = NULL;
+        PLFileCount = 0x00;
+      }
+    } else {
+      BenchFile(VgmFileName, Totals);
+    }
+
+    if (TempDir[0] != '\0')
+      CleanupTempDirectory(TempDir);
+  }
+
+  if (Totals[1]) {
+    printf("\"TOTAL\",%llu,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+           (unsigned long long)Totals[0], Totals[1] / 1e9,
+           Totals[0] * 1e9 / SampleRate / Totals[1],
+           Totals[0] ? (double)Totals[1] / Totals[0] : 0.0,
+           Totals[2 + PROF_INTERP] * 100.0 / Totals[1],
+           Totals[2 + PROF_CHIPS] * 100.0 / Totals[1],
+           Totals[2 + PROF_MIX] * 100.0 / Totals[1]);
+  }
+
+  return ErrRet;
+}
+
+// --- Batch Render Mode ---
+#define BATCH_BUFSIZE 0x1000
+#define WAVE_HDRSIZE 0x2C
+
+typedef struct batch_job {
+  char *InFile;  // .vgm/.vgz file
+  char *OutFile; // output path without extension
+} BATCH_JOB;
+
+static BATCH_JOB *BatchList;
+static UINT32 BatchCount;
+static UINT32 BatchAlloc;
+// guarded by BatchMutex
+static pthread_mutex_t BatchMutex = PTHREAD_MUTEX_INITIALIZER;
+static UINT32 BatchNext;
+static UINT32 BatchDone;
+static UINT32 BatchErrors;
+static UINT64 BatchSmplTotal;
+
+static void AddBatchJob(const char *InFile, const char *OutFile) {
+  if (BatchCount >= BatchAlloc) {
+    BatchAlloc += 0x0100;
+    BatchList =
+        (BATCH_JOB *)realloc(BatchList, BatchAlloc * sizeof(BATCH_JOB));
+  }
+  BatchList[BatchCount].InFile = strdup(InFile);
+  BatchList[BatchCount].OutFile = strdup(OutFile);
+  BatchCount++;
+
+  return;
+}
+
+static bool IsVGMFileName(const char *FileName) {
+  const char *FileExt;
+
+  FileExt = strrchr(FileName, '.');
+  if (FileExt == NULL)
+    return false;
+  return !stricmp_u(FileExt, ".vgm") || !stricmp_u(FileExt, ".vgz");
+}
+
+static void AddBatchDir(const char *DirPath, const char *OutPath) {
+  // adds all .vgm/.vgz files of a directory tree, the output mirrors the tree
+  DIR *d;
+  struct dirent *dir;
+  struct stat statbuf;
+  char InName[MAX_PATH];
+  char OutName[MAX_PATH];
+  int NameLen;
+
+  d = opendir(DirPath);
+  if (!d)
+    return;
+
+  while ((dir = readdir(d)) != NULL) {
+    if (dir->d_name[0] == '.')
+      continue;
+    snprintf(InName, MAX_PATH, "%s" DIR_STR "%s", DirPath, dir->d_name);
+    if (stat(InName, &statbuf))
+      continue;
+
+    if (S_ISDIR(statbuf.st_mode)) {
+      snprintf(OutName, MAX_PATH, "%s" DIR_STR "%s", OutPath, dir->d_name);
+      AddBatchDir(InName, OutName);
+    } else if (S_ISREG(statbuf.st_mode) && IsVGMFileName(dir->d_name)) {
+      NameLen = (int)(strrchr(dir->d_name, '.') - dir->d_name);
+      snprintf(OutName, MAX_PATH, "%s" DIR_STR "%.*s", OutPath, NameLen,
+               dir->d_name);
+      AddBatchJob(InName, OutName);
+    }
+  }
+  closedir(d);
+
+  return;
+}
+
+static void CreateParentDirs(const char *FilePath) {
+  char DirPath[MAX_PATH];
+  char *SepPtr;
+
+  strcpy(DirPath, FilePath);
+  SepPtr = DirPath;
+  while ((SepPtr = strchr(SepPtr + 1, DIR_CHR)) != NULL) {
+    *SepPtr = '\0';
+    mkdir(DirPath, 0755); // fails harmlessly for existing directories
+    *SepPtr = DIR_CHR;
+  }
+
+  return;
+}
+
+static void MakeWaveHeader(UINT32 *Header, UINT32 DataLen) {
+  // 16-bit stereo PCM at SampleRate, WAVE_HDRSIZE bytes
+  memcpy(&Header[0x00], "RIFF", 0x04);
+  Header[0x01] = 0x24 + DataLen;
+  memcpy(&Header[0x02], "WAVE", 0x04);
+  memcpy(&Header[0x03], "fmt ", 0x04);
+  Header[0x04] = 0x10;       // fmt chunk size
+  Header[0x05] = 0x00020001; // PCM, 2 channels
+  Header[0x06] = SampleRate;
+  Header[0x07] = SampleRate * sizeof(WAVE_16BS);
+  Header[0x08] = 0x00100000 | sizeof(WAVE_16BS); // block align, 16 bits
+  memcpy(&Header[0x09], "data", 0x04);
+  Header[0x0A] = DataLen;
+
+  return;
+}
+
+static void WriteWaveHeader(FILE *hFile, UINT32 DataLen) {
+  UINT32 Header[WAVE_HDRSIZE / 4];
+
+  MakeWaveHeader(Header, DataLen);
+  fwrite(Header, 0x01, WAVE_HDRSIZE, hFile);
+
+  return;
+}
+
+static bool RenderBatchJob(VGM_PLAYER *BPlayer, const BATCH_JOB *Job,
+                           WAVE_16BS *Buffer, UINT64 *RetSmplCount) {
+  char OutName[MAX_PATH];
+  FILE *hFile;
+  UINT64 SmplCount;
+  UINT32 RetSmpls;
+  bool WriteErr;
+
+  *RetSmplCount = 0;
+  if (!OpenVGMFile(BPlayer, Job->InFile)) {
+    fprintf(stderr, "Error opening the file: %s\n", Job->InFile);
+    return false;
+  }
+  snprintf(OutName, MAX_PATH, "%s%s", Job->OutFile,
+           BatchRaw ? ".raw" : ".wav");
+  CreateParentDirs(OutName);
+  hFile = fopen(OutName, "wb");
+  if (hFile == NULL) {
+    fprintf(stderr, "Error creating the file: %s\n", OutName);
+    CloseVGMFile(BPlayer);
+    return false;
+  }
+  if (!BatchRaw)
+    WriteWaveHeader(hFile, 0);
+
+  BPlayer->FadeTime = FadeTimeN;
+  BPlayer->PauseTime =
+      BPlayer->VGMHead.lngLoopOffset ? PauseTimeL : PauseTimeJ;
+  PlayVGM(BPlayer);
+  SmplCount = 0;
+  WriteErr = false;
+  while (!BPlayer->EndPlay && !sigint && !WriteErr) {
+    RetSmpls = FillBuffer(BPlayer, Buffer, BATCH_BUFSIZE);
+    if (fwrite(Buffer, sizeof(WAVE_16BS), RetSmpls, hFile) != RetSmpls)
+      WriteErr = true;
+    SmplCount += RetSmpls;
+  }
+  StopVGM(BPlayer);
+  CloseVGMFile(BPlayer);
+
+  if (!BatchRaw && !WriteErr) {
+    // the RIFF sizes are known only now
+    fseek(hFile, 0, SEEK_SET);
+    WriteWaveHeader(hFile, (UINT32)(SmplCount * sizeof(WAVE_16BS)));
+  }
+  if (fclose(hFile))
+    WriteErr = true;
+  if (WriteErr || sigint) {
+    if (WriteErr)
+      fprintf(stderr, "Error writing the file: %s\n", OutName);
+    remove(OutName); // don't leave truncated files behind
+    return false;
+  }
+
+  *RetSmplCount = SmplCount;
+  return true;
+}
+
+static void *BatchWorker(void *Arg) {
+  // renders jobs until the list is done, every worker has its own player
+  VGM_PLAYER *BPlayer;
+  WAVE_16BS *Buffer;
+  UINT32 CurJob;
+  UINT64 SmplCount;
+  bool RetVal;
+
+  BPlayer = VGMPlayer_Create();
+  Buffer = (WAVE_16BS *)malloc(BATCH_BUFSIZE * sizeof(WAVE_16BS));
+  if (BPlayer == NULL || Buffer == NULL) {
+    fprintf(stderr, "Error allocating the player!\n");
+    free(Buffer);
+    if (BPlayer != NULL)
+      VGMPlayer_Destroy(BPlayer);
+    return NULL;
+  }
+
+  while (!sigint) {
+    pthread_mutex_lock(&BatchMutex);
+    CurJob = BatchNext;
+    if (BatchNext < BatchCount)
+      BatchNext++;
+    pthread_mutex_unlock(&BatchMutex);
+    if (CurJob >= BatchCount)
+      break;
+
+    RetVal = RenderBatchJob(BPlayer, &BatchList[CurJob], Buffer, &SmplCount);
+
+    pthread_mutex_lock(&BatchMutex);
+    BatchDone++;
+    if (RetVal) {
+      BatchSmplTotal += SmplCount;
+      printf("[%u/%u] %s\n", BatchDone, BatchCount,
+             BatchList[CurJob].OutFile);
+    } else {
+      BatchErrors++;
+    }
+    pthread_mutex_unlock(&BatchMutex);
+  }
+
+  free(Buffer);
+  VGMPlayer_Destroy(BPlayer);
+
+  return NULL;
+}
+
+static int CompareBatchJobs(const void *a, const void *b) {
+  return strcmp(((const BATCH_JOB *)a)->InFile,
+                ((const BATCH_JOB *)b)->InFile);
+}
+
+static int AddBatchInputs(int argc, char *argv[], const char *OutDir,
+                          char **TempDirs) {
+  // adds the files, directory trees and archives given on the command line,
+  // sorted by name within every argument, extracted archives go to TempDirs
+  struct stat statbuf;
+  char TempDir[MAX_PATH];
+  char InPath[MAX_PATH];
+  char OutName[MAX_PATH];
+  const char *FileTitle;
+  const char *FileExt;
+  UINT32 FirstJob;
+  int CurArg;
+  int ErrRet;
+
+  ErrRet = 0;
+  for (CurArg = 0; CurArg < argc; CurArg++) {
+    strcpy(InPath, argv[CurArg]);
+    if (InPath[0] != '\0' && InPath[strlen(InPath) - 1] == DIR_CHR)
+      InPath[strlen(InPath) - 1] = '\0';
+    FileTitle = strrchr(InPath, DIR_CHR);
+    FileTitle = FileTitle ? FileTitle + 1 : InPath;
+    FileExt = strrchr(FileTitle, '.');
+    if (FileExt == NULL)
+      FileExt = FileTitle + strlen(FileTitle);
+    if (stat(InPath, &statbuf)) {
+      fprintf(stderr, "File not found: %s\n", argv[CurArg]);
+      ErrRet = 1;
+      continue;
+    }
+
+    FirstJob = BatchCount;
+    if (S_ISDIR(statbuf.st_mode)) {
+      AddBatchDir(InPath, OutDir);
+    } else if (IsArchiveFile(InPath)) {
+      // the tracks of an archive go to a directory named after it
+      if (ExtractArchiveToTemp(InPath, TempDir)) {
+        fprintf(stderr, "Error extracting the archive: %s\n", argv[CurArg]);
+        ErrRet = 1;
+        continue;
+      }
+      TempDirs[CurArg] = strdup(TempDir);
+      snprintf(OutName, MAX_PATH, "%s" DIR_STR "%.*s", OutDir,
+               (int)(FileExt - FileTitle), FileTitle);
+      AddBatchDir(TempDir, OutName);
+    } else {
+      snprintf(OutName, MAX_PATH, "%s" DIR_STR "%.*s", OutDir,
+               (int)(FileExt - FileTitle), FileTitle);
+      AddBatchJob(InPath, OutName);
+    }
+    qsort(&BatchList[FirstJob], BatchCount - FirstJob, sizeof(BATCH_JOB),
+          CompareBatchJobs);
+  }
+
+  return ErrRet;
+}
+
+static void FreeBatchInputs(int argc, char **TempDirs) {
+  UINT32 CurJob;
+  int CurArg;
+
+  for (CurArg = 0; CurArg < argc; CurArg++) {
+    if (TempDirs[CurArg] != NULL) {
+      CleanupTempDirectory(TempDirs[CurArg]);
+      free(TempDirs[CurArg]);
+    }
+  }
+  free(TempDirs);
+  for (CurJob = 0; CurJob < BatchCount; CurJob++) {
+    free(BatchList[CurJob].InFile);
+    free(BatchList[CurJob].OutFile);
+  }
+  free(BatchList);
+  BatchList = NULL;
+  BatchCount = BatchAlloc = 0x00;
+
+  return;
+}
+
+static int RunBatchRender(int argc, char *argv[]) {
+  // --batch: renders files, directory trees and archives to BatchOutDir
+  struct timespec TimeStart;
+  struct timespec TimeEnd;
+  char **TempDirs;
+  pthread_t *Workers;
+  UINT32 WorkerCount;
+  UINT32 CurWrk;
+  UINT64 RenderTime;
+  int ErrRet;
+
+  TempDirs = (char **)calloc(argc, sizeof(char *));
+  ErrRet = AddBatchInputs(argc, argv, BatchOutDir, TempDirs);
+
+  WorkerCount = BatchJobs;
+  if (!WorkerCount)
+    WorkerCount = (UINT32)sysconf(_SC_NPROCESSORS_ONLN);
+  if (WorkerCount > BatchCount)
+    WorkerCount = BatchCount;
+  if (!WorkerCount)
+    WorkerCount = 1;
+  Workers = (pthread_t *)malloc(WorkerCount * sizeof(pthread_t));
+
+  if (BatchCount) {
+    mkdir(BatchOutDir, 0755);
+    clock_gettime(CLOCK_MONOTONIC, &TimeStart);
+    for (CurWrk = 0; CurWrk < WorkerCount; CurWrk++)
+      pthread_create(&Workers[CurWrk], NULL, &BatchWorker, NULL);
+    for (CurWrk = 0; CurWrk < WorkerCount; CurWrk++)
+      pthread_join(Workers[CurWrk], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &TimeEnd);
+
+    RenderTime = TimeSpec2Int64(&TimeEnd) - TimeSpec2Int64(&TimeStart);
+    if (!RenderTime)
+      RenderTime = 1;
+    printf("%u of %u tracks rendered with %u threads: %.1f s of audio in "
+           "%.3f s (%.1fx realtime)\n",
+           BatchDone - BatchErrors, BatchCount, WorkerCount,
+           (double)BatchSmplTotal / SampleRate, RenderTime / 1e9,
+           BatchSmplTotal * 1e9 / SampleRate / RenderTime);
+  } else if (!ErrRet) {
+    fprintf(stderr, "No VGM files found.\n");
+  }
+  if (BatchErrors || BatchDone < BatchCount)
+    ErrRet = 1;
+
+  free(Workers);
+  FreeBatchInputs(argc, TempDirs);
+
+  return ErrRet;
+}
+
+// --- Offline Render Mode ---
+// --render plays the tracks one after another like the playlist, without
+// ALSA and the playback thread. FillBuffer renders straight into a large I/O
+// buffer that is written out whenever it is full, so the render runs as fast
+// as the CPU allows. The fade steps of FillBuffer count from the start of a
+// block, so the blocks always have the same size and the output doesn't
+// depend on the file layout.
+#define RENDER_IOSIZE 0x100000 // bytes per write, a multiple of RENDER_ALIGN
+#define RENDER_ALIGN 0x1000    // O_DIRECT buffer, size and offset alignment
+#define RENDER_BLOCK 0x4000    // samples per FillBuffer call
+
+typedef struct render_file {
+  int hFile;
+  bool Direct;  // opened with O_DIRECT
+  bool WriteErr;
+  UINT8 *IOBuf; // RENDER_IOSIZE + one block, aligned to RENDER_ALIGN
+  UINT32 IOPos;
+  UINT64 DataLen; // PCM bytes rendered so far
+  char FileName[MAX_PATH];
+} RENDER_FILE;
+
+static bool OpenRenderFile(RENDER_FILE *RFile, const char *FileName) {
+  int Flags;
+
+  snprintf(RFile->FileName, MAX_PATH, "%s", FileName);
+  CreateParentDirs(FileName);
+  Flags = O_WRONLY | O_CREAT | O_TRUNC;
+  RFile->hFile = -1;
+  RFile->Direct = false;
+  if (RenderDirect) {
+    RFile->hFile = open(FileName, Flags | O_DIRECT, 0644);
+    RFile->Direct = (RFile->hFile >= 0);
+  }
+  if (RFile->hFile < 0) // some file systems (e.g. tmpfs) refuse O_DIRECT
+    RFile->hFile = open(FileName, Flags, 0644);
+  if (RFile->hFile < 0) {
+    fprintf(stderr, "Error creating the file: %s\n", FileName);
+    return false;
+  }
+  if (RenderDirect && !RFile->Direct)
+    fprintf(stderr, "No direct I/O for %s, using buffered writes.\n",
+            FileName);
+
+  RFile->WriteErr = false;
+  RFile->DataLen = 0;
+  RFile->IOPos = 0;
+  if (!BatchRaw) {
+    // placeholder, the RIFF sizes are known only at the end
+    memset(RFile->IOBuf, 0x00, WAVE_HDRSIZE);
+    RFile->IOPos = WAVE_HDRSIZE;
+  }
+
+  return true;
+}
+
+static void WriteRenderBuf(RENDER_FILE *RFile, UINT32 Length) {
+  // writes the first Length bytes of the I/O buffer
+  UINT32 Written;
+  ssize_t RetVal;
+
+  Written = 0;
+  while (Written < Length && !RFile->WriteErr) {
+    RetVal = write(RFile->hFile, RFile->IOBuf + Written, Length - Written);
+    if (RetVal > 0)
+      Written += (UINT32)RetVal;
+    else if (RetVal == 0 || errno != EINTR)
+      RFile->WriteErr = true;
+  }
+
+  return;
+}
+
+static bool CloseRenderFile(RENDER_FILE *RFile, bool Discard) {
+  UINT32 Header[WAVE_HDRSIZE / 4];
+  UINT64 DataLen;
+  int Flags;
+
+  if (!Discard && !RFile->WriteErr) {
+    if (RFile->Direct) {
+      // the tail isn't a multiple of RENDER_ALIGN
+      Flags = fcntl(RFile->hFile, F_GETFL);
+      fcntl(RFile->hFile, F_SETFL, Flags & ~O_DIRECT);
+    }
+    WriteRenderBuf(RFile, RFile->IOPos);
+    if (!BatchRaw && !RFile->WriteErr) {
+      // RIFF can't describe more than 4 GB, players read on to the end
+      DataLen = RFile->DataLen;
+      if (DataLen > 0xFFFFFFFF - 0x24)
+        DataLen = (0xFFFFFFFF - 0x24) & ~0x03;
+      MakeWaveHeader(Header, (UINT32)DataLen);
+      if (pwrite(RFile->hFile, Header, WAVE_HDRSIZE, 0) != WAVE_HDRSIZE)
+        RFile->WriteErr = true;
+    }
+  }
+  if (close(RFile->hFile))
+    RFile->WriteErr = true;
+  if (Discard || RFile->WriteErr) {
+    if (RFile->WriteErr)
+      fprintf(stderr, "Error writing the file: %s\n", RFile->FileName);
+    remove(RFile->FileName); // don't leave truncated files behind
+    return false;
+  }
+
+  return true;
+}
+
+static UINT64 RenderTrack(RENDER_FILE *RFile) {
+  // renders the opened file to its end (loops, fade and pause included)
+  UINT64 SmplCount;
+  UINT32 RetSmpls;
+
+  PlayVGM(Player);
+  SmplCount = 0;
+  while (!Player->EndPlay && !sigint && !RFile->WriteErr) {
+    RetSmpls = FillBuffer(Player, (WAVE_16BS *)&RFile->IOBuf[RFile->IOPos],
+                          RENDER_BLOCK);
+    RFile->IOPos += RetSmpls * sizeof(WAVE_16BS);
+    RFile->DataLen += RetSmpls * sizeof(WAVE_16BS);
+    SmplCount += RetSmpls;
+    if (RFile->IOPos >= RENDER_IOSIZE) {
+      // the rest of the block moves to the start of the buffer
+      WriteRenderBuf(RFile, RENDER_IOSIZE);
+      RFile->IOPos -= RENDER_IOSIZE;
+      memcpy(RFile->IOBuf, RFile->IOBuf + RENDER_IOSIZE, RFile->IOPos);
+    }
+  }
+  StopVGM(Player);
+
+  return SmplCount;
+}
+
+static int RunRender(int argc, char *argv[]) {
+  // --render: renders the inputs into SoundLogFile, or into one file per
+  // track (<name>-01.wav, <name>-02.wav, ...) with --split
+  RENDER_FILE RFile;
+  struct timespec TimeStart;
+  struct timespec TimeEnd;
+  char **TempDirs;
+  char OutName[MAX_PATH];
+  const char *FileExt;
+  UINT64 SmplTotal;
+  UINT64 RenderTime;
+  UINT32 CurJob;
+  UINT32 DoneCount;
+  bool FileOpen;
+  int ErrRet;
+
+  TempDirs = (char **)calloc(argc, sizeof(char *));
+  ErrRet = AddBatchInputs(argc, argv, ".", TempDirs);
+  if (!BatchCount) {
+    if (!ErrRet)
+      fprintf(stderr, "No VGM files found.\n");
+    FreeBatchInputs(argc, TempDirs);
+    return 1;
+  }
+  if (posix_memalign((void **)&RFile.IOBuf, RENDER_ALIGN,
+                     RENDER_IOSIZE + RENDER_BLOCK * sizeof(WAVE_16BS))) {
+    fprintf(stderr, "Error allocating the render buffer!\n");
+    FreeBatchInputs(argc, TempDirs);
+    return 1;
+  }
+
+  FileExt = strrchr(SoundLogFile, '.');
+  if (FileExt == NULL || strchr(FileExt, DIR_CHR) != NULL)
+    FileExt = SoundLogFile + strlen(SoundLogFile);
+  FileOpen = false;
+  SmplTotal = 0;
+  DoneCount = 0;
+  clock_gettime(CLOCK_MONOTONIC, &TimeStart);
+  for (CurJob = 0; CurJob < BatchCount && !sigint; CurJob++) {
+    if (!OpenVGMFile(Player, BatchList[CurJob].InFile)) {
+      fprintf(stderr, "Error opening the file: %s\n",
+              BatchList[CurJob].InFile);
+      ErrRet = 1;
+      continue;
+    }
+    if (!FileOpen) {
+      if (RenderSplit)
+        snprintf(OutName, MAX_PATH, "%.*s-%02u%s",
+                 (int)(FileExt - SoundLogFile), SoundLogFile, CurJob + 1,
+                 FileExt);
+      else
+        snprintf(OutName, MAX_PATH, "%s", SoundLogFile);
+      if (!OpenRenderFile(&RFile, OutName)) {
+        CloseVGMFile(Player);
+        ErrRet = 1;
+        break;
+      }
+      FileOpen = true;
+    }
+
+    // like the playlist, the tracks of one file get the short fade
+    if (RenderSplit || CurJob == BatchCount - 1)
+      Player->FadeTime = FadeTimeN;
+    else
+      Player->FadeTime = FadeTimePL;
+    Player->PauseTime =
+        Player->VGMHead.lngLoopOffset ? PauseTimeL : PauseTimeJ;
+    SmplTotal += RenderTrack(&RFile);
+    CloseVGMFile(Player);
+    if (sigint || RFile.WriteErr) {
+      CloseRenderFile(&RFile, true);
+      FileOpen = false;
+      ErrRet = 1;
+      break;
+    }
+    DoneCount++;
+    printf("[%u/%u] %s\n", CurJob + 1, BatchCount, BatchList[CurJob].InFile);
+
+    if (RenderSplit) {
+      if (!CloseRenderFile(&RFile, false))
+        ErrRet = 1;
+      FileOpen = false;
+    }
+  }
+  if (FileOpen && !CloseRenderFile(&RFile, false))
+    ErrRet = 1;
+  clock_gettime(CLOCK_MONOTONIC, &TimeEnd);
+
+  RenderTime = TimeSpec2Int64(&TimeEnd) - TimeSpec2Int64(&TimeStart);
+  if (!RenderTime)
+    RenderTime = 1;
+  printf("%u of %u tracks rendered: %.1f s of audio in %.3f s (%.1fx "
+         "realtime)\n",
+         DoneCount, BatchCount, (double)SmplTotal / SampleRate,
+         RenderTime / 1e9, SmplTotal * 1e9 / SampleRate / RenderTime);
+
+  free(RFile.IOBuf);
+  FreeBatchInputs(argc, TempDirs);
+
+  return ErrRet;
+}
+
 // --- DBus Stubs ---
 void DBus_ReadWriteDispatch(void) {}
 void DBus_EmitSignal(UINT8 type) {}
@@ -32,8 +32,6 @@ struct _ym2151_state {
 extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
 static UINT8 EMU_CORE = 0x00;
-#define MAX_CHIPS 0x02
-static ym2151_state YM2151Data[MAX_CHIPS];
 
 /*INLINE ym2151_state *get_safe_token(const device_config *device)
 {
@@ -45,9 +43,8 @@ static ym2151_state YM2151Data[MAX_CHIPS];
 }*/
 
 // static STREAM_UPDATE( ym2151_update )
-void ym2151_update(UINT8 ChipID, stream_sample_t **outputs, int samples) {
-  // ym2151_state *info = (ym2151_state *)param;
-  ym2151_state *info = &YM2151Data[ChipID];
+void ym2151_update(void *param, stream_sample_t **outputs, int samples) {
+  ym2151_state *info = (ym2151_state *)param;
 
   switch (EMU_CORE) {
   case EC_MAME:
@@ -63,25 +60,24 @@ void ym2151_update(UINT8 ChipID, stream_sample_t **outputs, int samples) {
 }
 
 // static STATE_POSTLOAD( ym2151intf_postload )
-/*static void ym2151intf_postload(UINT8 ChipID)
+/*static void ym2151intf_postload(void *param)
 {
-        //ym2151_state *info = (ym2151_state *)param;
-        ym2151_state *info = &YM2151Data[ChipID];
+        ym2151_state *info = (ym2151_state *)param;
         ym2151_postload(info->chip);
 }*/
 
 // static DEVICE_START( ym2151 )
-int device_start_ym2151(UINT8 ChipID, int clock) {
+int device_start_ym2151(void **param, int clock) {
   // static const ym2151_interface dummy = { 0 };
 
   // ym2151_state *info = get_safe_token(device);
   ym2151_state *info;
   int rate;
 
-  if (ChipID >= MAX_CHIPS)
+  info = (ym2151_state *)calloc(1, sizeof(ym2151_state));
+  if (info == NULL)
     return 0;
-
-  info = &YM2151Data[ChipID];
+  *param = info;
   rate = clock / 64;
   if ((CHIP_SAMPLING_MODE == 0x01 && rate < CHIP_SAMPLE_RATE) ||
       CHIP_SAMPLING_MODE == 0x02)
@@ -114,9 +110,9 @@ int device_start_ym2151(UINT8 ChipID, int clock) {
 }
 
 // static DEVICE_STOP( ym2151 )
-void device_stop_ym2151(UINT8 ChipID) {
+void device_stop_ym2151(void *param) {
   // ym2151_state *info = get_safe_token(device);
-  ym2151_state *info = &YM2151Data[ChipID];
+  ym2151_state *info = (ym2151_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     ym2151_shutdown(info->chip);
@@ -128,12 +124,13 @@ void device_stop_ym2151(UINT8 ChipID) {
 #endif
   }
   // YM2151Shutdown();
+  free(info);
 }
 
 // static DEVICE_RESET( ym2151 )
-void device_reset_ym2151(UINT8 ChipID) {
+void device_reset_ym2151(void *param) {
   // ym2151_state *info = get_safe_token(device);
-  ym2151_state *info = &YM2151Data[ChipID];
+  ym2151_state *info = (ym2151_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     ym2151_reset_chip(info->chip);
@@ -147,10 +144,30 @@ void device_reset_ym2151(UINT8 ChipID) {
   // YM2151ResetChip(0x00);
 }
 
+UINT32 device_save_state_ym2151(void *param, void *Data) {
+  ym2151_state *info = (ym2151_state *)param;
+  switch (EMU_CORE) {
+  case EC_MAME:
+    return ym2151_save_state(info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
+UINT32 device_load_state_ym2151(void *param, const void *Data) {
+  ym2151_state *info = (ym2151_state *)param;
+  switch (EMU_CORE) {
+  case EC_MAME:
+    return ym2151_load_state(info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
 // READ8_DEVICE_HANDLER( ym2151_r )
-UINT8 ym2151_r(UINT8 ChipID, offs_t offset) {
+UINT8 ym2151_r(void *param, offs_t offset) {
   // ym2151_state *token = get_safe_token(device);
-  ym2151_state *token = &YM2151Data[ChipID];
+  ym2151_state *token = (ym2151_state *)param;
 
   switch (EMU_CORE) {
   case EC_MAME:
@@ -165,9 +182,9 @@ UINT8 ym2151_r(UINT8 ChipID, offs_t offset) {
 }
 
 // WRITE8_DEVICE_HANDLER( ym2151_w )
-void ym2151_w(UINT8 ChipID, offs_t offset, UINT8 data) {
+void ym2151_w(void *param, offs_t offset, UINT8 data) {
   // ym2151_state *token = get_safe_token(device);
-  ym2151_state *token = &YM2151Data[ChipID];
+  ym2151_state *token = (ym2151_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     if (offset & 1) {
@@ -189,15 +206,15 @@ void ym2151_w(UINT8 ChipID, offs_t offset, UINT8 data) {
 
 WRITE8_DEVICE_HANDLER( ym2151_register_port_w ) { ym2151_w(device, 0, data); }
 WRITE8_DEVICE_HANDLER( ym2151_data_port_w ) { ym2151_w(device, 1, data); }*/
-UINT8 ym2151_status_port_r(UINT8 ChipID, offs_t offset) {
-  return ym2151_r(ChipID, 1);
+UINT8 ym2151_status_port_r(void *param, offs_t offset) {
+  return ym2151_r(param, 1);
 }
 
-void ym2151_register_port_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  ym2151_w(ChipID, 0, data);
+void ym2151_register_port_w(void *param, offs_t offset, UINT8 data) {
+  ym2151_w(param, 0, data);
 }
-void ym2151_data_port_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  ym2151_w(ChipID, 1, data);
+void ym2151_data_port_w(void *param, offs_t offset, UINT8 data) {
+  ym2151_w(param, 1, data);
 }
 
 void ym2151_set_emu_core(UINT8 Emulator) {
@@ -210,8 +227,8 @@ void ym2151_set_emu_core(UINT8 Emulator) {
   return;
 }
 
-void ym2151_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
-  ym2151_state *info = &YM2151Data[ChipID];
+void ym2151_set_mute_mask(void *param, UINT32 MuteMask) {
+  ym2151_state *info = (ym2151_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     ym2151_set_mutemask(info->chip, MuteMask);
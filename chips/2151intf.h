@@ -17,18 +17,20 @@ WRITE8_DEVICE_HANDLER( ym2151_data_port_w );
 
 DEVICE_GET_INFO( ym2151 );
 #define SOUND_YM2151 DEVICE_GET_INFO_NAME( ym2151 )*/
-void ym2151_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
+void ym2151_update(void *param, stream_sample_t **outputs, int samples);
 
-int device_start_ym2151(UINT8 ChipID, int clock);
-void device_stop_ym2151(UINT8 ChipID);
-void device_reset_ym2151(UINT8 ChipID);
+int device_start_ym2151(void **param, int clock);
+void device_stop_ym2151(void *param);
+void device_reset_ym2151(void *param);
+UINT32 device_save_state_ym2151(void *param, void *Data);
+UINT32 device_load_state_ym2151(void *param, const void *Data);
 
-UINT8 ym2151_r(UINT8 ChipID, offs_t offset);
-void ym2151_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ym2151_r(void *param, offs_t offset);
+void ym2151_w(void *param, offs_t offset, UINT8 data);
 
-UINT8 ym2151_status_port_r(UINT8 ChipID, offs_t offset);
-void ym2151_register_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ym2151_data_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ym2151_status_port_r(void *param, offs_t offset);
+void ym2151_register_port_w(void *param, offs_t offset, UINT8 data);
+void ym2151_data_port_w(void *param, offs_t offset, UINT8 data);
 
 void ym2151_set_emu_core(UINT8 Emulator);
-void ym2151_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
+void ym2151_set_mute_mask(void *param, UINT32 MuteMask);
@@ -35,9 +35,6 @@ extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
 static UINT8 EMU_CORE = 0x00;
 
-#define MAX_CHIPS 0x02
-static ym2413_state YM2413Data[MAX_CHIPS];
-
 /*INLINE ym2413_state *get_safe_token(const device_config *device)
 {
         assert(device != NULL);
@@ -113,9 +110,9 @@ static void _emu2413_set_mute_mask(OPLL *opll, UINT32 MuteMask) {
 }
 
 // static STREAM_UPDATE( ym2413_stream_update )
-void ym2413_stream_update(UINT8 ChipID, stream_sample_t **outputs,
+void ym2413_stream_update(void *param, stream_sample_t **outputs,
                           int samples) {
-  ym2413_state *info = &YM2413Data[ChipID];
+  ym2413_state *info = (ym2413_state *)param;
   _emu2413_calc_stereo(info->chip, outputs, samples);
 }
 
@@ -125,15 +122,15 @@ static void _stream_update(void *param, int interval) {
 }
 
 // static DEVICE_START( ym2413 )
-int device_start_ym2413(UINT8 ChipID, int clock) {
+int device_start_ym2413(void **param, int clock) {
   // ym2413_state *info = get_safe_token(device);
   ym2413_state *info;
   int rate;
 
-  if (ChipID >= MAX_CHIPS)
+  info = (ym2413_state *)calloc(1, sizeof(ym2413_state));
+  if (info == NULL)
     return 0;
-
-  info = &YM2413Data[ChipID];
+  *param = info;
   info->Mode = (clock & 0x80000000) >> 31;
   clock &= 0x7FFFFFFF;
 
@@ -156,33 +153,44 @@ int device_start_ym2413(UINT8 ChipID, int clock) {
 }
 
 // static DEVICE_STOP( ym2413 )
-void device_stop_ym2413(UINT8 ChipID) {
+void device_stop_ym2413(void *param) {
   // ym2413_state *info = get_safe_token(device);
-  ym2413_state *info = &YM2413Data[ChipID];
+  ym2413_state *info = (ym2413_state *)param;
   OPLL_delete(info->chip);
+  free(info);
 }
 
 // static DEVICE_RESET( ym2413 )
-void device_reset_ym2413(UINT8 ChipID) {
+void device_reset_ym2413(void *param) {
   // ym2413_state *info = get_safe_token(device);
-  ym2413_state *info = &YM2413Data[ChipID];
+  ym2413_state *info = (ym2413_state *)param;
   OPLL_reset(info->chip);
 }
 
+UINT32 device_save_state_ym2413(void *param, void *Data) {
+  ym2413_state *info = (ym2413_state *)param;
+  return OPLL_saveState(info->chip, Data);
+}
+
+UINT32 device_load_state_ym2413(void *param, const void *Data) {
+  ym2413_state *info = (ym2413_state *)param;
+  return OPLL_loadState(info->chip, Data);
+}
+
 // WRITE8_DEVICE_HANDLER( ym2413_w )
-void ym2413_w(UINT8 ChipID, offs_t offset, UINT8 data) {
+void ym2413_w(void *param, offs_t offset, UINT8 data) {
   // ym2413_state *info = get_safe_token(device);
-  ym2413_state *info = &YM2413Data[ChipID];
+  ym2413_state *info = (ym2413_state *)param;
   OPLL_writeIO(info->chip, offset & 1, data);
 }
 
 // WRITE8_DEVICE_HANDLER( ym2413_register_port_w )
-void ym2413_register_port_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  ym2413_w(ChipID, 0, data);
+void ym2413_register_port_w(void *param, offs_t offset, UINT8 data) {
+  ym2413_w(param, 0, data);
 }
 // WRITE8_DEVICE_HANDLER( ym2413_data_port_w )
-void ym2413_data_port_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  ym2413_w(ChipID, 1, data);
+void ym2413_data_port_w(void *param, offs_t offset, UINT8 data) {
+  ym2413_w(param, 1, data);
 }
 
 void ym2413_set_emu_core(UINT8 Emulator) {
@@ -190,14 +198,14 @@ void ym2413_set_emu_core(UINT8 Emulator) {
   return;
 }
 
-void ym2413_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
-  ym2413_state *info = &YM2413Data[ChipID];
+void ym2413_set_mute_mask(void *param, UINT32 MuteMask) {
+  ym2413_state *info = (ym2413_state *)param;
   _emu2413_set_mute_mask(info->chip, MuteMask);
   return;
 }
 
-void ym2413_set_panning(UINT8 ChipID, INT16 *PanVals) {
-  ym2413_state *info = &YM2413Data[ChipID];
+void ym2413_set_panning(void *param, INT16 *PanVals) {
+  ym2413_state *info = (ym2413_state *)param;
   UINT8 CurChn;
   UINT8 EmuChn;
 
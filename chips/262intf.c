@@ -5,6 +5,7 @@
   MAME interface for YMF262 (OPL3) emulator
 
 ***************************************************************************/
+#include <stdlib.h>	// for calloc/free
 #include "../VGMSXPlay.h"
 //#include "attotime.h"
 //#include "sndintrf.h"
@@ -16,12 +17,15 @@
 
 #define OPLTYPE_IS_OPL3
 #include "adlibemu.h"
+#define OPL_FIXEDPT
+#include "adlibemu.h"
 
 
 #define EC_DBOPL	0x00	// DosBox OPL (AdLibEmu)
 #ifdef ENABLE_ALL_CORES
 #define EC_MAME		0x01	// YMF262 core from MAME
 #endif
+#define EC_DBOPL_FIXED	0x02	// DosBox OPL with integer envelope/volume math
 
 typedef struct _ymf262_state ymf262_state;
 struct _ymf262_state
@@ -38,9 +42,6 @@ extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
 static UINT8 EMU_CORE = 0x00;
 
-#define MAX_CHIPS	0x02
-static ymf262_state YMF262Data[MAX_CHIPS];
-
 /*INLINE ymf262_state *get_safe_token(const device_config *device)
 {
 	assert(device != NULL);
@@ -86,10 +87,9 @@ static void timer_handler_262(void *param,int timer, int period)
 }
 
 //static STREAM_UPDATE( ymf262_stream_update )
-void ymf262_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
+void ymf262_stream_update(void *param, stream_sample_t **outputs, int samples)
 {
-	//ymf262_state *info = (ymf262_state *)param;
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -100,6 +100,9 @@ void ymf262_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
 	case EC_DBOPL:
 		adlib_OPL3_getsample(info->chip, outputs, samples);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_getsample(info->chip, outputs, samples);
+		break;
 	}
 }
 
@@ -118,22 +121,25 @@ static void _stream_update(void *param/*, int interval*/)
 	case EC_DBOPL:
 		adlib_OPL3_getsample(info->chip, DUMMYBUF, 0);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_getsample(info->chip, DUMMYBUF, 0);
+		break;
 	}
 }
 
 
 //static DEVICE_START( ymf262 )
-int device_start_ymf262(UINT8 ChipID, int clock)
+int device_start_ymf262(void **param, int clock)
 {
 	//static const ymf262_interface dummy = { 0 };
 	//ymf262_state *info = get_safe_token(device);
 	ymf262_state *info;
 	int rate;
 	
-	if (ChipID >= MAX_CHIPS)
+	info = (ymf262_state *)calloc(1, sizeof(ymf262_state));
+	if (info == NULL)
 		return 0;
-	
-	info = &YMF262Data[ChipID];
+	*param = info;
 	rate = clock/288;
 	if ((CHIP_SAMPLING_MODE == 0x01 && rate < CHIP_SAMPLE_RATE) ||
 		CHIP_SAMPLING_MODE == 0x02)
@@ -165,16 +171,19 @@ int device_start_ymf262(UINT8 ChipID, int clock)
 	case EC_DBOPL:
 		info->chip = adlib_OPL3_init(clock, rate, _stream_update, info);
 		break;
+	case EC_DBOPL_FIXED:
+		info->chip = adlib_OPL3I_init(clock, rate, _stream_update, info);
+		break;
 	}
 	
 	return rate;
 }
 
 //static DEVICE_STOP( ymf262 )
-void device_stop_ymf262(UINT8 ChipID)
+void device_stop_ymf262(void *param)
 {
 	//ymf262_state *info = get_safe_token(device);
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -185,15 +194,19 @@ void device_stop_ymf262(UINT8 ChipID)
 	case EC_DBOPL:
 		adlib_OPL3_stop(info->chip);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_stop(info->chip);
+		break;
 	}
+	free(info);
 }
 
 /* reset */
 //static DEVICE_RESET( ymf262 )
-void device_reset_ymf262(UINT8 ChipID)
+void device_reset_ymf262(void *param)
 {
 	//ymf262_state *info = get_safe_token(device);
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -204,15 +217,54 @@ void device_reset_ymf262(UINT8 ChipID)
 	case EC_DBOPL:
 		adlib_OPL3_reset(info->chip);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_reset(info->chip);
+		break;
+	}
+}
+
+UINT32 device_save_state_ymf262(void *param, void *Data)
+{
+	ymf262_state *info = (ymf262_state *)param;
+	switch(EMU_CORE)
+	{
+#ifdef ENABLE_ALL_CORES
+	case EC_MAME:
+		return ymf262_save_state(info->chip, Data);
+#endif
+	case EC_DBOPL:
+		return adlib_OPL3_save_state(info->chip, Data);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL3I_save_state(info->chip, Data);
+	default:
+		return 0;
+	}
+}
+
+UINT32 device_load_state_ymf262(void *param, const void *Data)
+{
+	ymf262_state *info = (ymf262_state *)param;
+	switch(EMU_CORE)
+	{
+#ifdef ENABLE_ALL_CORES
+	case EC_MAME:
+		return ymf262_load_state(info->chip, Data);
+#endif
+	case EC_DBOPL:
+		return adlib_OPL3_load_state(info->chip, Data);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL3I_load_state(info->chip, Data);
+	default:
+		return 0;
 	}
 }
 
 
 //READ8_DEVICE_HANDLER( ymf262_r )
-UINT8 ymf262_r(UINT8 ChipID, offs_t offset)
+UINT8 ymf262_r(void *param, offs_t offset)
 {
 	//ymf262_state *info = get_safe_token(device);
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -221,16 +273,18 @@ UINT8 ymf262_r(UINT8 ChipID, offs_t offset)
 #endif
 	case EC_DBOPL:
 		return adlib_OPL3_reg_read(info->chip, offset & 0x03);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL3I_reg_read(info->chip, offset & 0x03);
 	default:
 		return 0x00;
 	}
 }
 
 //WRITE8_DEVICE_HANDLER( ymf262_w )
-void ymf262_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf262_w(void *param, offs_t offset, UINT8 data)
 {
 	//ymf262_state *info = get_safe_token(device);
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -241,50 +295,53 @@ void ymf262_w(UINT8 ChipID, offs_t offset, UINT8 data)
 	case EC_DBOPL:
 		adlib_OPL3_writeIO(info->chip, offset & 3, data);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_writeIO(info->chip, offset & 3, data);
+		break;
 	}
 }
 
 //READ8_DEVICE_HANDLER ( ymf262_status_r )
-UINT8 ymf262_status_r(UINT8 ChipID, offs_t offset)
+UINT8 ymf262_status_r(void *param, offs_t offset)
 {
-	return ymf262_r(ChipID, 0);
+	return ymf262_r(param, 0);
 }
 //WRITE8_DEVICE_HANDLER( ymf262_register_a_w )
-void ymf262_register_a_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf262_register_a_w(void *param, offs_t offset, UINT8 data)
 {
-	ymf262_w(ChipID, 0, data);
+	ymf262_w(param, 0, data);
 }
 //WRITE8_DEVICE_HANDLER( ymf262_register_b_w )
-void ymf262_register_b_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf262_register_b_w(void *param, offs_t offset, UINT8 data)
 {
-	ymf262_w(ChipID, 2, data);
+	ymf262_w(param, 2, data);
 }
 //WRITE8_DEVICE_HANDLER( ymf262_data_a_w )
-void ymf262_data_a_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf262_data_a_w(void *param, offs_t offset, UINT8 data)
 {
-	ymf262_w(ChipID, 1, data);
+	ymf262_w(param, 1, data);
 }
 //WRITE8_DEVICE_HANDLER( ymf262_data_b_w )
-void ymf262_data_b_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf262_data_b_w(void *param, offs_t offset, UINT8 data)
 {
-	ymf262_w(ChipID, 3, data);
+	ymf262_w(param, 3, data);
 }
 
 
 void ymf262_set_emu_core(UINT8 Emulator)
 {
 #ifdef ENABLE_ALL_CORES
-	EMU_CORE = (Emulator < 0x02) ? Emulator : 0x00;
+	EMU_CORE = (Emulator < 0x03) ? Emulator : 0x00;
 #else
-	EMU_CORE = EC_DBOPL;
+	EMU_CORE = (Emulator == EC_DBOPL_FIXED) ? EC_DBOPL_FIXED : EC_DBOPL;
 #endif
 	
 	return;
 }
 
-void ymf262_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
+void ymf262_set_mute_mask(void *param, UINT32 MuteMask)
 {
-	ymf262_state *info = &YMF262Data[ChipID];
+	ymf262_state *info = (ymf262_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -295,6 +352,9 @@ void ymf262_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
 	case EC_DBOPL:
 		adlib_OPL3_set_mute_mask(info->chip, MuteMask);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL3I_set_mute_mask(info->chip, MuteMask);
+		break;
 	}
 	
 	return;
@@ -22,21 +22,23 @@ WRITE8_DEVICE_HANDLER( ymf262_data_b_w );
 DEVICE_GET_INFO( ymf262 );
 #define SOUND_YMF262 DEVICE_GET_INFO_NAME( ymf262 )*/
 
-void ymf262_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
+void ymf262_stream_update(void *param, stream_sample_t **outputs, int samples);
 
-int device_start_ymf262(UINT8 ChipID, int clock);
-void device_stop_ymf262(UINT8 ChipID);
-void device_reset_ymf262(UINT8 ChipID);
+int device_start_ymf262(void **param, int clock);
+void device_stop_ymf262(void *param);
+void device_reset_ymf262(void *param);
+UINT32 device_save_state_ymf262(void *param, void *Data);
+UINT32 device_load_state_ymf262(void *param, const void *Data);
 
-UINT8 ymf262_r(UINT8 ChipID, offs_t offset);
-void ymf262_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ymf262_r(void *param, offs_t offset);
+void ymf262_w(void *param, offs_t offset, UINT8 data);
 
-UINT8 ymf262_status_r(UINT8 ChipID, offs_t offset);
-void ymf262_register_a_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ymf262_register_b_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ymf262_data_a_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ymf262_data_b_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ymf262_status_r(void *param, offs_t offset);
+void ymf262_register_a_w(void *param, offs_t offset, UINT8 data);
+void ymf262_register_b_w(void *param, offs_t offset, UINT8 data);
+void ymf262_data_a_w(void *param, offs_t offset, UINT8 data);
+void ymf262_data_b_w(void *param, offs_t offset, UINT8 data);
 
 void ymf262_set_emu_core(UINT8 Emulator);
-void ymf262_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
+void ymf262_set_mute_mask(void *param, UINT32 MuteMask);
 
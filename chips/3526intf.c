@@ -16,6 +16,7 @@
 * NOTES
 *
 ******************************************************************************/
+#include <stdlib.h>	// for calloc/free
 #include "../VGMSXPlay.h"
 //#include "attotime.h"
 //#include "sndintrf.h"
@@ -37,8 +38,6 @@ struct _ym3526_state
 
 extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
-#define MAX_CHIPS	0x02
-static ym3526_state YM3526Data[MAX_CHIPS];
 
 /*INLINE ym3526_state *get_safe_token(const device_config *device)
 {
@@ -86,10 +85,9 @@ static void TimerHandler(void *param,int c,int period)
 
 
 //static STREAM_UPDATE( ym3526_stream_update )
-void ym3526_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
+void ym3526_stream_update(void *param, stream_sample_t **outputs, int samples)
 {
-	//ym3526_state *info = (ym3526_state *)param;
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	ym3526_update_one(info->chip, outputs, samples);
 }
 
@@ -103,17 +101,17 @@ static void _stream_update(void *param/*, int interval*/)
 
 
 //static DEVICE_START( ym3526 )
-int device_start_ym3526(UINT8 ChipID, int clock)
+int device_start_ym3526(void **param, int clock)
 {
 	//static const ym3526_interface dummy = { 0 };
 	//ym3526_state *info = get_safe_token(device);
 	ym3526_state *info;
 	int rate;
 	
-	if (ChipID >= MAX_CHIPS)
+	info = (ym3526_state *)calloc(1, sizeof(ym3526_state));
+	if (info == NULL)
 		return 0;
-	
-	info = &YM3526Data[ChipID];
+	*param = info;
 	rate = clock/72;
 	if ((CHIP_SAMPLING_MODE == 0x01 && rate < CHIP_SAMPLE_RATE) ||
 		CHIP_SAMPLING_MODE == 0x02)
@@ -139,63 +137,76 @@ int device_start_ym3526(UINT8 ChipID, int clock)
 }
 
 //static DEVICE_STOP( ym3526 )
-void device_stop_ym3526(UINT8 ChipID)
+void device_stop_ym3526(void *param)
 {
 	//ym3526_state *info = get_safe_token(device);
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	ym3526_shutdown(info->chip);
+	free(info);
 }
 
 //static DEVICE_RESET( ym3526 )
-void device_reset_ym3526(UINT8 ChipID)
+void device_reset_ym3526(void *param)
 {
 	//ym3526_state *info = get_safe_token(device);
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	ym3526_reset_chip(info->chip);
 }
 
+UINT32 device_save_state_ym3526(void *param, void *Data)
+{
+	ym3526_state *info = (ym3526_state *)param;
+	return opl_save_state(info->chip, Data);
+}
+
+UINT32 device_load_state_ym3526(void *param, const void *Data)
+{
+	ym3526_state *info = (ym3526_state *)param;
+	return opl_load_state(info->chip, Data);
+}
+
 
 //READ8_DEVICE_HANDLER( ym3526_r )
-UINT8 ym3526_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3526_r(void *param, offs_t offset)
 {
 	//ym3526_state *info = get_safe_token(device);
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	return ym3526_read(info->chip, offset & 1);
 }
 
 //WRITE8_DEVICE_HANDLER( ym3526_w )
-void ym3526_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3526_w(void *param, offs_t offset, UINT8 data)
 {
 	//ym3526_state *info = get_safe_token(device);
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	ym3526_write(info->chip, offset & 1, data);
 }
 
 //READ8_DEVICE_HANDLER( ym3526_status_port_r )
-UINT8 ym3526_status_port_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3526_status_port_r(void *param, offs_t offset)
 {
-	return ym3526_r(ChipID, 0);
+	return ym3526_r(param, 0);
 }
 //READ8_DEVICE_HANDLER( ym3526_read_port_r )
-UINT8 ym3526_read_port_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3526_read_port_r(void *param, offs_t offset)
 {
-	return ym3526_r(ChipID, 1);
+	return ym3526_r(param, 1);
 }
 //WRITE8_DEVICE_HANDLER( ym3526_control_port_w )
-void ym3526_control_port_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3526_control_port_w(void *param, offs_t offset, UINT8 data)
 {
-	ym3526_w(ChipID, 0, data);
+	ym3526_w(param, 0, data);
 }
 //WRITE8_DEVICE_HANDLER( ym3526_write_port_w )
-void ym3526_write_port_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3526_write_port_w(void *param, offs_t offset, UINT8 data)
 {
-	ym3526_w(ChipID, 1, data);
+	ym3526_w(param, 1, data);
 }
 
 
-void ym3526_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
+void ym3526_set_mute_mask(void *param, UINT32 MuteMask)
 {
-	ym3526_state *info = &YM3526Data[ChipID];
+	ym3526_state *info = (ym3526_state *)param;
 	opl_set_mute_mask(info->chip, MuteMask);
 }
 
@@ -17,6 +17,7 @@
 *
 ******************************************************************************/
 #include <stddef.h>	// for NULL
+#include <stdlib.h>	// for calloc/free
 #include "../VGMSXPlay.h"
 //#include "attotime.h"
 //#include "sndintrf.h"
@@ -29,12 +30,15 @@
 
 #define OPLTYPE_IS_OPL2
 #include "adlibemu.h"
+#define OPL_FIXEDPT
+#include "adlibemu.h"
 
 
 #define EC_DBOPL	0x00	// DosBox OPL (AdLibEmu)
 #ifdef ENABLE_ALL_CORES
 #define EC_MAME		0x01	// YM3826 core from MAME
 #endif
+#define EC_DBOPL_FIXED	0x02	// DosBox OPL with integer envelope/volume math
 
 typedef struct _ym3812_state ym3812_state;
 struct _ym3812_state
@@ -51,9 +55,6 @@ extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
 static UINT8 EMU_CORE = 0x00;
 
-#define MAX_CHIPS	0x02
-static ym3812_state YM3812Data[MAX_CHIPS];
-
 /*INLINE ym3812_state *get_safe_token(const device_config *device)
 {
 	assert(device != NULL);
@@ -100,10 +101,9 @@ static void TimerHandler(void *param,int c,int period)
 
 
 //static STREAM_UPDATE( ym3812_stream_update )
-void ym3812_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
+void ym3812_stream_update(void *param, stream_sample_t **outputs, int samples)
 {
-	//ym3812_state *info = (ym3812_state *)param;
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -114,6 +114,9 @@ void ym3812_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
 	case EC_DBOPL:
 		adlib_OPL2_getsample(info->chip, outputs, samples);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_getsample(info->chip, outputs, samples);
+		break;
 	}
 }
 
@@ -132,22 +135,25 @@ static void _stream_update(void * param/*, int interval*/)
 	case EC_DBOPL:
 		adlib_OPL2_getsample(info->chip, DUMMYBUF, 0);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_getsample(info->chip, DUMMYBUF, 0);
+		break;
 	}
 }
 
 
 //static DEVICE_START( ym3812 )
-int device_start_ym3812(UINT8 ChipID, int clock)
+int device_start_ym3812(void **param, int clock)
 {
 	//static const ym3812_interface dummy = { 0 };
 	//ym3812_state *info = get_safe_token(device);
 	ym3812_state *info;
 	int rate;
 	
-	if (ChipID >= MAX_CHIPS)
+	info = (ym3812_state *)calloc(1, sizeof(ym3812_state));
+	if (info == NULL)
 		return 0;
-	
-	info = &YM3812Data[ChipID];
+	*param = info;
 	rate = (clock & 0x7FFFFFFF)/72;
 	if ((CHIP_SAMPLING_MODE == 0x01 && rate < CHIP_SAMPLE_RATE) ||
 		CHIP_SAMPLING_MODE == 0x02)
@@ -178,16 +184,19 @@ int device_start_ym3812(UINT8 ChipID, int clock)
 	case EC_DBOPL:
 		info->chip = adlib_OPL2_init(clock & 0x7FFFFFFF, rate, _stream_update, info);
 		break;
+	case EC_DBOPL_FIXED:
+		info->chip = adlib_OPL2I_init(clock & 0x7FFFFFFF, rate, _stream_update, info);
+		break;
 	}
 	
 	return rate;
 }
 
 //static DEVICE_STOP( ym3812 )
-void device_stop_ym3812(UINT8 ChipID)
+void device_stop_ym3812(void *param)
 {
 	//ym3812_state *info = get_safe_token(device);
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -198,14 +207,18 @@ void device_stop_ym3812(UINT8 ChipID)
 	case EC_DBOPL:
 		adlib_OPL2_stop(info->chip);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_stop(info->chip);
+		break;
 	}
+	free(info);
 }
 
 //static DEVICE_RESET( ym3812 )
-void device_reset_ym3812(UINT8 ChipID)
+void device_reset_ym3812(void *param)
 {
 	//ym3812_state *info = get_safe_token(device);
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -216,15 +229,54 @@ void device_reset_ym3812(UINT8 ChipID)
 	case EC_DBOPL:
 		adlib_OPL2_reset(info->chip);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_reset(info->chip);
+		break;
+	}
+}
+
+UINT32 device_save_state_ym3812(void *param, void *Data)
+{
+	ym3812_state *info = (ym3812_state *)param;
+	switch(EMU_CORE)
+	{
+#ifdef ENABLE_ALL_CORES
+	case EC_MAME:
+		return opl_save_state(info->chip, Data);
+#endif
+	case EC_DBOPL:
+		return adlib_OPL2_save_state(info->chip, Data);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL2I_save_state(info->chip, Data);
+	default:
+		return 0;
+	}
+}
+
+UINT32 device_load_state_ym3812(void *param, const void *Data)
+{
+	ym3812_state *info = (ym3812_state *)param;
+	switch(EMU_CORE)
+	{
+#ifdef ENABLE_ALL_CORES
+	case EC_MAME:
+		return opl_load_state(info->chip, Data);
+#endif
+	case EC_DBOPL:
+		return adlib_OPL2_load_state(info->chip, Data);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL2I_load_state(info->chip, Data);
+	default:
+		return 0;
 	}
 }
 
 
 //READ8_DEVICE_HANDLER( ym3812_r )
-UINT8 ym3812_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3812_r(void *param, offs_t offset)
 {
 	//ym3812_state *info = get_safe_token(device);
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -233,16 +285,18 @@ UINT8 ym3812_r(UINT8 ChipID, offs_t offset)
 #endif
 	case EC_DBOPL:
 		return adlib_OPL2_reg_read(info->chip, offset & 0x01);
+	case EC_DBOPL_FIXED:
+		return adlib_OPL2I_reg_read(info->chip, offset & 0x01);
 	default:
 		return 0x00;
 	}
 }
 
 //WRITE8_DEVICE_HANDLER( ym3812_w )
-void ym3812_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3812_w(void *param, offs_t offset, UINT8 data)
 {
 	//ym3812_state *info = get_safe_token(device);
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -253,45 +307,48 @@ void ym3812_w(UINT8 ChipID, offs_t offset, UINT8 data)
 	case EC_DBOPL:
 		adlib_OPL2_writeIO(info->chip, offset & 1, data);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_writeIO(info->chip, offset & 1, data);
+		break;
 	}
 }
 
 //READ8_DEVICE_HANDLER( ym3812_status_port_r )
-UINT8 ym3812_status_port_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3812_status_port_r(void *param, offs_t offset)
 {
-	return ym3812_r(ChipID, 0);
+	return ym3812_r(param, 0);
 }
 //READ8_DEVICE_HANDLER( ym3812_read_port_r )
-UINT8 ym3812_read_port_r(UINT8 ChipID, offs_t offset)
+UINT8 ym3812_read_port_r(void *param, offs_t offset)
 {
-	return ym3812_r(ChipID, 1);
+	return ym3812_r(param, 1);
 }
 //WRITE8_DEVICE_HANDLER( ym3812_control_port_w )
-void ym3812_control_port_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3812_control_port_w(void *param, offs_t offset, UINT8 data)
 {
-	ym3812_w(ChipID, 0, data);
+	ym3812_w(param, 0, data);
 }
 //WRITE8_DEVICE_HANDLER( ym3812_write_port_w )
-void ym3812_write_port_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym3812_write_port_w(void *param, offs_t offset, UINT8 data)
 {
-	ym3812_w(ChipID, 1, data);
+	ym3812_w(param, 1, data);
 }
 
 
 void ym3812_set_emu_core(UINT8 Emulator)
 {
 #ifdef ENABLE_ALL_CORES
-	EMU_CORE = (Emulator < 0x02) ? Emulator : 0x00;
+	EMU_CORE = (Emulator < 0x03) ? Emulator : 0x00;
 #else
-	EMU_CORE = EC_DBOPL;
+	EMU_CORE = (Emulator == EC_DBOPL_FIXED) ? EC_DBOPL_FIXED : EC_DBOPL;
 #endif
 	
 	return;
 }
 
-void ym3812_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
+void ym3812_set_mute_mask(void *param, UINT32 MuteMask)
 {
-	ym3812_state *info = &YM3812Data[ChipID];
+	ym3812_state *info = (ym3812_state *)param;
 	switch(EMU_CORE)
 	{
 #ifdef ENABLE_ALL_CORES
@@ -302,6 +359,9 @@ void ym3812_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
 	case EC_DBOPL:
 		adlib_OPL2_set_mute_mask(info->chip, MuteMask);
 		break;
+	case EC_DBOPL_FIXED:
+		adlib_OPL2I_set_mute_mask(info->chip, MuteMask);
+		break;
 	}
 	
 	return;
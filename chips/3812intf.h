@@ -18,18 +18,20 @@ WRITE8_DEVICE_HANDLER( ym3812_write_port_w );
 DEVICE_GET_INFO( ym3812 );
 #define SOUND_YM3812 DEVICE_GET_INFO_NAME( ym3812 )*/
 
-void ym3812_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
-int device_start_ym3812(UINT8 ChipID, int clock);
-void device_stop_ym3812(UINT8 ChipID);
-void device_reset_ym3812(UINT8 ChipID);
+void ym3812_stream_update(void *param, stream_sample_t **outputs, int samples);
+int device_start_ym3812(void **param, int clock);
+void device_stop_ym3812(void *param);
+void device_reset_ym3812(void *param);
+UINT32 device_save_state_ym3812(void *param, void *Data);
+UINT32 device_load_state_ym3812(void *param, const void *Data);
 
-UINT8 ym3812_r(UINT8 ChipID, offs_t offset);
-void ym3812_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ym3812_r(void *param, offs_t offset);
+void ym3812_w(void *param, offs_t offset, UINT8 data);
 
-UINT8 ym3812_status_port_r(UINT8 ChipID, offs_t offset);
-UINT8 ym3812_read_port_r(UINT8 ChipID, offs_t offset);
-void ym3812_control_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ym3812_write_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
+UINT8 ym3812_status_port_r(void *param, offs_t offset);
+UINT8 ym3812_read_port_r(void *param, offs_t offset);
+void ym3812_control_port_w(void *param, offs_t offset, UINT8 data);
+void ym3812_write_port_w(void *param, offs_t offset, UINT8 data);
 
 void ym3812_set_emu_core(UINT8 Emulator);
-void ym3812_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
+void ym3812_set_mute_mask(void *param, UINT32 MuteMask);
@@ -22,19 +22,21 @@ WRITE8_DEVICE_HANDLER( y8950_write_port_w );
 
 DEVICE_GET_INFO( y8950 );
 #define SOUND_Y8950 DEVICE_GET_INFO_NAME( y8950 )*/
-void y8950_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
-int device_start_y8950(UINT8 ChipID, int clock);
-void device_stop_y8950(UINT8 ChipID);
-void device_reset_y8950(UINT8 ChipID);
-
-UINT8 y8950_r(UINT8 ChipID, offs_t offset);
-void y8950_w(UINT8 ChipID, offs_t offset, UINT8 data);
-
-UINT8 y8950_status_port_r(UINT8 ChipID, offs_t offset);
-UINT8 y8950_read_port_r(UINT8 ChipID, offs_t offset);
-void y8950_control_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void y8950_write_port_w(UINT8 ChipID, offs_t offset, UINT8 data);
-
-void y8950_write_data_pcmrom(UINT8 ChipID, offs_t ROMSize, offs_t DataStart,
+void y8950_stream_update(void *param, stream_sample_t **outputs, int samples);
+int device_start_y8950(void **param, int clock);
+void device_stop_y8950(void *param);
+void device_reset_y8950(void *param);
+UINT32 device_save_state_y8950(void *param, void *Data);
+UINT32 device_load_state_y8950(void *param, const void *Data);
+
+UINT8 y8950_r(void *param, offs_t offset);
+void y8950_w(void *param, offs_t offset, UINT8 data);
+
+UINT8 y8950_status_port_r(void *param, offs_t offset);
+UINT8 y8950_read_port_r(void *param, offs_t offset);
+void y8950_control_port_w(void *param, offs_t offset, UINT8 data);
+void y8950_write_port_w(void *param, offs_t offset, UINT8 data);
+
+void y8950_write_data_pcmrom(void *param, offs_t ROMSize, offs_t DataStart,
 							  offs_t DataLength, const UINT8* ROMData);
-void y8950_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
+void y8950_set_mute_mask(void *param, UINT32 MuteMask);
@@ -1,10 +1,20 @@
-#if defined(OPLTYPE_IS_OPL2)
+// This header can be included once more with OPL_FIXEDPT defined to get the
+// prototypes of the integer variant of the core.
+#undef ADLIBEMU
+#if defined(OPLTYPE_IS_OPL2) && defined(OPL_FIXEDPT)
+#define ADLIBEMU(name)			adlib_OPL2I_##name
+#elif defined(OPLTYPE_IS_OPL2)
 #define ADLIBEMU(name)			adlib_OPL2_##name
+#elif defined(OPLTYPE_IS_OPL3) && defined(OPL_FIXEDPT)
+#define ADLIBEMU(name)			adlib_OPL3I_##name
 #elif defined(OPLTYPE_IS_OPL3)
 #define ADLIBEMU(name)			adlib_OPL3_##name
 #endif
 
+#ifndef ADL_UPDATEHANDLER_DEFINED
+#define ADL_UPDATEHANDLER_DEFINED
 typedef void (*ADL_UPDATEHANDLER)(void *param);
+#endif
 
 void* ADLIBEMU(init)(UINT32 clock, UINT32 samplerate,
 					 ADL_UPDATEHANDLER UpdateHandler, void* param);
@@ -18,3 +28,5 @@ UINT32 ADLIBEMU(reg_read)(void *chip, UINT32 port);
 void ADLIBEMU(write_index)(void *chip, UINT32 port, UINT8 val);
 
 void ADLIBEMU(set_mute_mask)(void *chip, UINT32 MuteMask);
+UINT32 ADLIBEMU(save_state)(void *chip, void *Data);
+UINT32 ADLIBEMU(load_state)(void *chip, const void *Data);
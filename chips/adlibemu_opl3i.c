@@ -0,0 +1,6 @@
+#include "../VGMSXPlay.h"
+
+#define OPLTYPE_IS_OPL3
+#define OPL_FIXEDPT
+#include "adlibemu.h"
+#include "opl.c"
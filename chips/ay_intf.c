@@ -27,14 +27,13 @@ struct _ayxx_state {
 
 extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
+extern bool PSGBlep;
 static UINT8 EMU_CORE = 0x00;
 
 extern UINT32 SampleRate;
-#define MAX_CHIPS 0x02
-static ayxx_state AYxxData[MAX_CHIPS];
 
-void ayxx_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples) {
-  ayxx_state *info = &AYxxData[ChipID];
+void ayxx_stream_update(void *param, stream_sample_t **outputs, int samples) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -47,14 +46,15 @@ void ayxx_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples) {
   }
 }
 
-int device_start_ayxx(UINT8 ChipID, int clock, UINT8 chip_type, UINT8 Flags) {
+int device_start_ayxx(void **param, int clock, UINT8 chip_type, UINT8 Flags) {
   ayxx_state *info;
   int rate;
+  bool blep;
 
-  if (ChipID >= MAX_CHIPS)
+  info = (ayxx_state *)calloc(1, sizeof(ayxx_state));
+  if (info == NULL)
     return 0;
-
-  info = &AYxxData[ChipID];
+  *param = info;
   if (Flags & YM2149_PIN26_LOW)
     rate = clock / 16;
   else
@@ -62,6 +62,8 @@ int device_start_ayxx(UINT8 ChipID, int clock, UINT8 chip_type, UINT8 Flags) {
   if (((CHIP_SAMPLING_MODE & 0x01) && rate < CHIP_SAMPLE_RATE) ||
       CHIP_SAMPLING_MODE == 0x02)
     rate = CHIP_SAMPLE_RATE;
+  // with band-limited steps the chip renders at the output rate directly
+  blep = PSGBlep && CHIP_SAMPLING_MODE != 0x02 && rate > (int)SampleRate;
 
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
@@ -72,9 +74,16 @@ int device_start_ayxx(UINT8 ChipID, int clock, UINT8 chip_type, UINT8 Flags) {
   case EC_EMU2149:
     if (Flags & YM2149_PIN26_LOW)
       clock /= 2;
+    if (blep)
+      rate = SampleRate;
     info->chip = PSG_new(clock, rate);
-    if (info->chip == NULL)
+    if (info->chip == NULL) {
+      free(info);
+      *param = NULL;
       return 0;
+    }
+    if (blep)
+      PSG_set_quality((PSG *)info->chip, EMU2149_QUALITY_BLEP);
     PSG_setVolumeMode((PSG *)info->chip, (chip_type & 0x10) ? 1 : 2);
     PSG_setFlags((PSG *)info->chip, Flags & ~YM2149_PIN26_LOW);
     break;
@@ -83,8 +92,8 @@ int device_start_ayxx(UINT8 ChipID, int clock, UINT8 chip_type, UINT8 Flags) {
   return rate;
 }
 
-void device_stop_ayxx(UINT8 ChipID) {
-  ayxx_state *info = &AYxxData[ChipID];
+void device_stop_ayxx(void *param) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -95,11 +104,11 @@ void device_stop_ayxx(UINT8 ChipID) {
     PSG_delete((PSG *)info->chip);
     break;
   }
-  info->chip = NULL;
+  free(info);
 }
 
-void device_reset_ayxx(UINT8 ChipID) {
-  ayxx_state *info = &AYxxData[ChipID];
+void device_reset_ayxx(void *param) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -112,8 +121,28 @@ void device_reset_ayxx(UINT8 ChipID) {
   }
 }
 
-void ayxx_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  ayxx_state *info = &AYxxData[ChipID];
+UINT32 device_save_state_ayxx(void *param, void *Data) {
+  ayxx_state *info = (ayxx_state *)param;
+  switch (EMU_CORE) {
+  case EC_EMU2149:
+    return PSG_saveState((PSG *)info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
+UINT32 device_load_state_ayxx(void *param, const void *Data) {
+  ayxx_state *info = (ayxx_state *)param;
+  switch (EMU_CORE) {
+  case EC_EMU2149:
+    return PSG_loadState((PSG *)info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
+void ayxx_w(void *param, offs_t offset, UINT8 data) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -136,8 +165,8 @@ void ayxx_set_emu_core(UINT8 Emulator) {
   return;
 }
 
-void ayxx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
-  ayxx_state *info = &AYxxData[ChipID];
+void ayxx_set_mute_mask(void *param, UINT32 MuteMask) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -152,8 +181,8 @@ void ayxx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
   return;
 }
 
-void ayxx_set_stereo_mask(UINT8 ChipID, UINT32 StereoMask) {
-  ayxx_state *info = &AYxxData[ChipID];
+void ayxx_set_stereo_mask(void *param, UINT32 StereoMask) {
+  ayxx_state *info = (ayxx_state *)param;
   switch (EMU_CORE) {
 #ifdef ENABLE_ALL_CORES
   case EC_MAME:
@@ -1,13 +1,15 @@
 #pragma once
 
-void ayxx_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
+void ayxx_stream_update(void *param, stream_sample_t **outputs, int samples);
 
-int device_start_ayxx(UINT8 ChipID, int clock, UINT8 chip_type, UINT8 Flags);
-void device_stop_ayxx(UINT8 ChipID);
-void device_reset_ayxx(UINT8 ChipID);
+int device_start_ayxx(void **param, int clock, UINT8 chip_type, UINT8 Flags);
+void device_stop_ayxx(void *param);
+void device_reset_ayxx(void *param);
+UINT32 device_save_state_ayxx(void *param, void *Data);
+UINT32 device_load_state_ayxx(void *param, const void *Data);
 
-void ayxx_w(UINT8 ChipID, offs_t offset, UINT8 data);
+void ayxx_w(void *param, offs_t offset, UINT8 data);
 
 void ayxx_set_emu_core(UINT8 Emulator);
-void ayxx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
-void ayxx_set_stereo_mask(UINT8 ChipID, UINT32 StereoMask);
+void ayxx_set_mute_mask(void *param, UINT32 MuteMask);
+void ayxx_set_stereo_mask(void *param, UINT32 StereoMask);
@@ -0,0 +1,160 @@
+/****************************************************************************
+
+  blep.c -- band-limited step kernel shared by emu2149 and sn76496
+
+  Row p holds the impulse for an edge (p + 0.5) / BLEP_PHASES samples before
+  the sample point, delayed by BLEP_TAPS / 2 samples: a sinc with its cutoff
+  at 0.44 * the output rate, Kaiser window (beta = 6), rounded so that every
+  row sums to exactly 1 << BLEP_SHIFT. Because of that, integrating the
+  impulses restores the exact step height and the output never drifts.
+
+*****************************************************************************/
+#include "blep.h"
+
+const e_int16 blep_kernel[BLEP_PHASES][BLEP_TAPS] = {
+  { 0, -2, 5, -11, 18, -23, 24, -15, -8, 50, -111, 188, -275, 362, -439, 505,
+    3605, 445, -416, 352, -272, 190, -114, 54, -12, -13, 23, -23, 17, -11, 5,
+    -2},
+  { 0, -2, 5, -11, 18, -24, 26, -18, -5, 46, -107, 186, -276, 371, -462, 565,
+    3603, 387, -392, 342, -270, 191, -117, 57, -15, -10, 21, -22, 17, -11, 5,
+    -2},
+  { 0, -2, 5, -11, 18, -25, 27, -20, -1, 42, -103, 183, -277, 379, -484, 626,
+    3597, 330, -368, 332, -267, 192, -120, 61, -18, -8, 20, -21, 17, -11, 5,
+    -2},
+  { 0, -2, 5, -11, 18, -25, 29, -23, 2, 38, -99, 180, -278, 387, -506, 689,
+    3591, 274, -344, 321, -263, 192, -123, 64, -21, -6, 18, -20, 16, -11, 6,
+    -2},
+  { 0, -1, 5, -11, 18, -26, 30, -25, 6, 33, -94, 177, -278, 394, -528, 751,
+    3581, 219, -319, 309, -259, 193, -126, 68, -24, -3, 16, -19, 16, -11, 6,
+    -2},
+  { 0, -1, 5, -10, 18, -27, 31, -27, 9, 29, -90, 174, -278, 400, -549, 814,
+    3570, 165, -295, 297, -254, 193, -128, 71, -27, -1, 15, -18, 16, -10, 6,
+    -2},
+  { 0, -1, 4, -10, 19, -27, 33, -30, 13, 24, -85, 170, -277, 406, -569, 879,
+    3556, 112, -270, 285, -249, 192, -130, 74, -30, 2, 13, -17, 15, -10, 6, -2},
+  { 0, -1, 4, -10, 19, -28, 34, -32, 16, 20, -80, 165, -276, 411, -587, 945,
+    3541, 61, -245, 272, -244, 191, -131, 76, -33, 4, 11, -16, 15, -10, 6, -2},
+  { 0, -1, 4, -10, 19, -28, 35, -34, 20, 15, -75, 161, -274, 415, -606, 1010,
+    3524, 11, -220, 259, -238, 190, -133, 79, -36, 6, 10, -15, 14, -10, 6, -2},
+  { 0, -1, 4, -10, 19, -28, 36, -37, 23, 10, -69, 156, -271, 419, -625, 1076,
+    3503, -37, -195, 246, -232, 189, -134, 81, -38, 9, 8, -14, 14, -10, 6, -2},
+  { 0, -1, 4, -10, 18, -29, 37, -39, 27, 6, -63, 150, -268, 422, -640, 1142,
+    3481, -84, -170, 232, -226, 187, -135, 84, -41, 11, 7, -13, 13, -10, 6, -2},
+  { 0, 0, 3, -9, 18, -29, 38, -41, 30, 1, -58, 145, -264, 424, -657, 1209,
+    3457, -130, -145, 218, -219, 185, -136, 86, -43, 13, 5, -12, 13, -10, 6,
+    -2},
+  { 0, 0, 3, -9, 18, -29, 39, -43, 34, -4, -52, 139, -260, 425, -672, 1276,
+    3430, -174, -120, 204, -211, 182, -136, 88, -46, 15, 3, -11, 12, -9, 6, -2},
+  { -1, 0, 3, -9, 18, -30, 40, -45, 37, -9, -45, 132, -256, 426, -685, 1345,
+    3403, -217, -95, 189, -204, 179, -136, 89, -48, 17, 2, -10, 12, -9, 5, -2},
+  { -1, 0, 3, -8, 18, -30, 41, -47, 41, -14, -39, 126, -250, 425, -698, 1412,
+    3371, -258, -71, 175, -196, 176, -136, 91, -50, 19, 0, -9, 11, -9, 5, -2},
+  { -1, 0, 2, -8, 18, -30, 42, -49, 44, -19, -33, 119, -245, 424, -710, 1481,
+    3341, -298, -46, 160, -188, 173, -136, 92, -52, 21, -2, -8, 10, -9, 5, -2},
+  { -1, 0, 2, -8, 17, -30, 43, -51, 47, -24, -26, 111, -238, 422, -721, 1550,
+    3306, -336, -23, 145, -180, 169, -135, 93, -54, 23, -3, -7, 10, -8, 5, -2},
+  { -1, 0, 2, -7, 17, -30, 43, -53, 51, -29, -20, 104, -232, 420, -730, 1616,
+    3270, -372, 1, 130, -171, 165, -134, 94, -56, 25, -5, -6, 9, -8, 5, -2},
+  { -1, 1, 2, -7, 17, -30, 44, -54, 54, -34, -13, 96, -224, 416, -739, 1683,
+    3230, -407, 24, 115, -162, 160, -133, 95, -57, 27, -6, -5, 9, -8, 5, -2},
+  { -1, 1, 1, -7, 16, -30, 44, -56, 57, -39, -6, 88, -217, 412, -746, 1753,
+    3192, -440, 47, 100, -153, 156, -132, 95, -59, 28, -8, -4, 8, -7, 5, -2},
+  { -1, 1, 1, -6, 16, -29, 45, -57, 60, -44, 1, 80, -208, 406, -752, 1818,
+    3148, -472, 70, 85, -144, 151, -130, 96, -60, 30, -9, -3, 7, -7, 5, -2},
+  { -1, 1, 1, -6, 15, -29, 45, -59, 63, -49, 8, 71, -199, 400, -756, 1885,
+    3104, -502, 92, 70, -134, 146, -128, 96, -61, 32, -10, -2, 7, -7, 5, -2},
+  { -1, 1, 0, -5, 15, -29, 45, -60, 66, -54, 15, 62, -190, 393, -759, 1953,
+    3060, -530, 113, 55, -125, 141, -126, 96, -63, 33, -12, -1, 6, -6, 5, -2},
+  { -1, 2, 0, -5, 14, -28, 45, -61, 69, -59, 22, 53, -180, 386, -761, 2019,
+    3013, -557, 134, 40, -115, 135, -124, 96, -64, 35, -13, 0, 5, -6, 4, -2},
+  { -1, 2, 0, -4, 14, -28, 45, -62, 71, -64, 29, 44, -170, 377, -761, 2084,
+    2963, -582, 154, 25, -105, 130, -121, 96, -64, 36, -14, 1, 5, -6, 4, -2},
+  { -1, 2, -1, -4, 13, -27, 45, -63, 74, -69, 36, 35, -160, 368, -760, 2150,
+    2915, -605, 174, 10, -95, 124, -119, 95, -65, 37, -16, 2, 4, -5, 4, -2},
+  { -1, 2, -1, -3, 12, -27, 45, -64, 76, -73, 43, 25, -149, 357, -757, 2216,
+    2864, -626, 193, -5, -85, 118, -116, 94, -66, 38, -17, 3, 3, -5, 4, -2},
+  { -2, 2, -1, -3, 12, -26, 45, -65, 79, -78, 50, 16, -137, 346, -754, 2279,
+    2810, -647, 212, -19, -75, 112, -113, 94, -66, 39, -18, 4, 3, -5, 4, -2},
+  { -2, 2, -2, -2, 11, -25, 45, -66, 81, -82, 58, 6, -125, 335, -748, 2341,
+    2754, -665, 230, -33, -65, 105, -109, 93, -67, 40, -19, 5, 2, -4, 4, -2},
+  { -2, 3, -2, -1, 10, -25, 44, -66, 83, -86, 65, -4, -113, 322, -741, 2403,
+    2699, -682, 247, -47, -55, 99, -106, 91, -67, 41, -20, 6, 2, -4, 4, -2},
+  { -2, 3, -3, -1, 9, -24, 44, -66, 85, -91, 72, -14, -101, 308, -733, 2466,
+    2644, -697, 263, -61, -44, 92, -102, 90, -67, 42, -21, 7, 1, -4, 3, -2},
+  { -2, 3, -3, 0, 9, -23, 43, -67, 87, -95, 78, -24, -88, 294, -722, 2526,
+    2586, -710, 279, -75, -34, 85, -99, 88, -67, 43, -22, 8, 0, -3, 3, -2},
+  { -2, 3, -3, 0, 8, -22, 43, -67, 88, -99, 85, -34, -75, 279, -710, 2586,
+    2526, -722, 294, -88, -24, 78, -95, 87, -67, 43, -23, 9, 0, -3, 3, -2},
+  { -2, 3, -4, 1, 7, -21, 42, -67, 90, -102, 92, -44, -61, 263, -697, 2644,
+    2466, -733, 308, -101, -14, 72, -91, 85, -66, 44, -24, 9, -1, -3, 3, -2},
+  { -2, 4, -4, 2, 6, -20, 41, -67, 91, -106, 99, -55, -47, 247, -682, 2699,
+    2403, -741, 322, -113, -4, 65, -86, 83, -66, 44, -25, 10, -1, -2, 3, -2},
+  { -2, 4, -4, 2, 5, -19, 40, -67, 93, -109, 105, -65, -33, 230, -665, 2754,
+    2341, -748, 335, -125, 6, 58, -82, 81, -66, 45, -25, 11, -2, -2, 2, -2},
+  { -2, 4, -5, 3, 4, -18, 39, -66, 94, -113, 112, -75, -19, 212, -647, 2810,
+    2279, -754, 346, -137, 16, 50, -78, 79, -65, 45, -26, 12, -3, -1, 2, -2},
+  { -2, 4, -5, 3, 3, -17, 38, -66, 94, -116, 118, -85, -5, 193, -626, 2864,
+    2216, -757, 357, -149, 25, 43, -73, 76, -64, 45, -27, 12, -3, -1, 2, -1},
+  { -2, 4, -5, 4, 2, -16, 37, -65, 95, -119, 124, -95, 10, 174, -605, 2915,
+    2150, -760, 368, -160, 35, 36, -69, 74, -63, 45, -27, 13, -4, -1, 2, -1},
+  { -2, 4, -6, 5, 1, -14, 36, -64, 96, -121, 130, -105, 25, 154, -582, 2963,
+    2084, -761, 377, -170, 44, 29, -64, 71, -62, 45, -28, 14, -4, 0, 2, -1},
+  { -2, 4, -6, 5, 0, -13, 35, -64, 96, -124, 135, -115, 40, 134, -557, 3013,
+    2019, -761, 386, -180, 53, 22, -59, 69, -61, 45, -28, 14, -5, 0, 2, -1},
+  { -2, 5, -6, 6, -1, -12, 33, -63, 96, -126, 141, -125, 55, 113, -530, 3060,
+    1953, -759, 393, -190, 62, 15, -54, 66, -60, 45, -29, 15, -5, 0, 1, -1},
+  { -2, 5, -7, 7, -2, -10, 32, -61, 96, -128, 146, -134, 70, 92, -502, 3104,
+    1885, -756, 400, -199, 71, 8, -49, 63, -59, 45, -29, 15, -6, 1, 1, -1},
+  { -2, 5, -7, 7, -3, -9, 30, -60, 96, -130, 151, -144, 85, 70, -472, 3148,
+    1818, -752, 406, -208, 80, 1, -44, 60, -57, 45, -29, 16, -6, 1, 1, -1},
+  { -2, 5, -7, 8, -4, -8, 28, -59, 95, -132, 156, -153, 100, 47, -440, 3192,
+    1753, -746, 412, -217, 88, -6, -39, 57, -56, 44, -30, 16, -7, 1, 1, -1},
+  { -2, 5, -8, 9, -5, -6, 27, -57, 95, -133, 160, -162, 115, 24, -407, 3230,
+    1683, -739, 416, -224, 96, -13, -34, 54, -54, 44, -30, 17, -7, 2, 1, -1},
+  { -2, 5, -8, 9, -6, -5, 25, -56, 94, -134, 165, -171, 130, 1, -372, 3270,
+    1616, -730, 420, -232, 104, -20, -29, 51, -53, 43, -30, 17, -7, 2, 0, -1},
+  { -2, 5, -8, 10, -7, -3, 23, -54, 93, -135, 169, -180, 145, -23, -336, 3306,
+    1550, -721, 422, -238, 111, -26, -24, 47, -51, 43, -30, 17, -8, 2, 0, -1},
+  { -2, 5, -9, 10, -8, -2, 21, -52, 92, -136, 173, -188, 160, -46, -298, 3341,
+    1481, -710, 424, -245, 119, -33, -19, 44, -49, 42, -30, 18, -8, 2, 0, -1},
+  { -2, 5, -9, 11, -9, 0, 19, -50, 91, -136, 176, -196, 175, -71, -258, 3371,
+    1412, -698, 425, -250, 126, -39, -14, 41, -47, 41, -30, 18, -8, 3, 0, -1},
+  { -2, 5, -9, 12, -10, 2, 17, -48, 89, -136, 179, -204, 189, -95, -217, 3403,
+    1345, -685, 426, -256, 132, -45, -9, 37, -45, 40, -30, 18, -9, 3, 0, -1},
+  { -2, 6, -9, 12, -11, 3, 15, -46, 88, -136, 182, -211, 204, -120, -174,
+    3430, 1276, -672, 425, -260, 139, -52, -4, 34, -43, 39, -29, 18, -9, 3, 0,
+    0},
+  { -2, 6, -10, 13, -12, 5, 13, -43, 86, -136, 185, -219, 218, -145, -130,
+    3457, 1209, -657, 424, -264, 145, -58, 1, 30, -41, 38, -29, 18, -9, 3, 0,
+    0},
+  { -2, 6, -10, 13, -13, 7, 11, -41, 84, -135, 187, -226, 232, -170, -84,
+    3481, 1142, -640, 422, -268, 150, -63, 6, 27, -39, 37, -29, 18, -10, 4,
+    -1, 0},
+  { -2, 6, -10, 14, -14, 8, 9, -38, 81, -134, 189, -232, 246, -195, -37, 3503,
+    1076, -625, 419, -271, 156, -69, 10, 23, -37, 36, -28, 19, -10, 4, -1, 0},
+  { -2, 6, -10, 14, -15, 10, 6, -36, 79, -133, 190, -238, 259, -220, 11, 3524,
+    1010, -606, 415, -274, 161, -75, 15, 20, -34, 35, -28, 19, -10, 4, -1, 0},
+  { -2, 6, -10, 15, -16, 11, 4, -33, 76, -131, 191, -244, 272, -245, 61, 3541,
+    945, -587, 411, -276, 165, -80, 20, 16, -32, 34, -28, 19, -10, 4, -1, 0},
+  { -2, 6, -10, 15, -17, 13, 2, -30, 74, -130, 192, -249, 285, -270, 112,
+    3556, 879, -569, 406, -277, 170, -85, 24, 13, -30, 33, -27, 19, -10, 4,
+    -1, 0},
+  { -2, 6, -10, 16, -18, 15, -1, -27, 71, -128, 193, -254, 297, -295, 165,
+    3570, 814, -549, 400, -278, 174, -90, 29, 9, -27, 31, -27, 18, -10, 5, -1,
+    0},
+  { -2, 6, -11, 16, -19, 16, -3, -24, 68, -126, 193, -259, 309, -319, 219,
+    3581, 751, -528, 394, -278, 177, -94, 33, 6, -25, 30, -26, 18, -11, 5, -1,
+    0},
+  { -2, 6, -11, 16, -20, 18, -6, -21, 64, -123, 192, -263, 321, -344, 274,
+    3591, 689, -506, 387, -278, 180, -99, 38, 2, -23, 29, -25, 18, -11, 5, -2,
+    0},
+  { -2, 5, -11, 17, -21, 20, -8, -18, 61, -120, 192, -267, 332, -368, 330,
+    3597, 626, -484, 379, -277, 183, -103, 42, -1, -20, 27, -25, 18, -11, 5,
+    -2, 0},
+  { -2, 5, -11, 17, -22, 21, -10, -15, 57, -117, 191, -270, 342, -392, 387,
+    3603, 565, -462, 371, -276, 186, -107, 46, -5, -18, 26, -24, 18, -11, 5,
+    -2, 0},
+  { -2, 5, -11, 17, -23, 23, -13, -12, 54, -114, 190, -272, 352, -416, 445,
+    3605, 505, -439, 362, -275, 188, -111, 50, -8, -15, 24, -23, 18, -11, 5,
+    -2, 0}
+};
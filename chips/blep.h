@@ -0,0 +1,87 @@
+/* blep.h -- band-limited step synthesis for the square-wave PSG cores */
+#ifndef _BLEP_H_
+#define _BLEP_H_
+#include "emutypes.h"
+
+/*
+  The PSG cores emit one BLEP (band-limited step) per edge of their output:
+  a level change at a fractional position inside an output sample is spread
+  over BLEP_TAPS samples with a windowed-sinc impulse and integrated back.
+  That keeps the output alias-free while the chip is only stepped from one
+  edge to the next, instead of once per internal clock tick.
+
+  The step lands BLEP_TAPS / 2 output samples late.
+*/
+#define BLEP_TAPS 32
+#define BLEP_PHASE_BITS 6
+#define BLEP_PHASES (1 << BLEP_PHASE_BITS)
+#define BLEP_SHIFT 12 /* each kernel phase sums to 1 << BLEP_SHIFT */
+
+/* INLINE is "static inline" when VGMSXPlay.h came first, plain otherwise */
+#if defined(_MSC_VER)
+#define BLEP_INLINE static __inline
+#else
+#define BLEP_INLINE static __inline__
+#endif
+
+typedef struct __BLEP
+{
+  e_int32 ring[2][BLEP_TAPS]; /* pending impulses for the next samples */
+  e_int32 sum[2];             /* integrated output << BLEP_SHIFT */
+  e_int32 level[2];           /* current (unfiltered) chip output */
+  e_uint32 pos;
+}
+BLEP;
+
+extern const e_int16 blep_kernel[BLEP_PHASES][BLEP_TAPS];
+
+/* Returns the kernel phase of an edge at time num / den of the current
+   sample (0 < num <= den); recip is (BLEP_PHASES << 32) / den. */
+BLEP_INLINE e_uint32
+blep_phase (e_uint32 num, uint64_t recip)
+{
+  e_uint32 ph = (e_uint32) (((uint64_t) num * recip) >> 32);
+
+  return (ph < BLEP_PHASES) ? (BLEP_PHASES - 1 - ph) : 0;
+}
+
+BLEP_INLINE int
+blep_changed (const BLEP * b, e_int32 l, e_int32 r)
+{
+  return (l != b->level[0]) || (r != b->level[1]);
+}
+
+/* Moves the output to the levels l/r at the given kernel phase. */
+BLEP_INLINE void
+blep_step (BLEP * b, e_uint32 phase, e_int32 l, e_int32 r)
+{
+  const e_int16 *k = blep_kernel[phase];
+  e_int32 dl = l - b->level[0];
+  e_int32 dr = r - b->level[1];
+  e_uint32 i, p;
+
+  b->level[0] = l;
+  b->level[1] = r;
+  for (i = 0; i < BLEP_TAPS; i++)
+  {
+    p = (b->pos + i) & (BLEP_TAPS - 1);
+    b->ring[0][p] += dl * k[i];
+    b->ring[1][p] += dr * k[i];
+  }
+}
+
+/* Reads the current output sample and moves on to the next one. */
+BLEP_INLINE void
+blep_read (BLEP * b, e_int32 out[2])
+{
+  b->sum[0] += b->ring[0][b->pos];
+  b->sum[1] += b->ring[1][b->pos];
+  b->ring[0][b->pos] = 0;
+  b->ring[1][b->pos] = 0;
+  b->pos = (b->pos + 1) & (BLEP_TAPS - 1);
+
+  out[0] = b->sum[0] >> BLEP_SHIFT;
+  out[1] = b->sum[1] >> BLEP_SHIFT;
+}
+
+#endif
@@ -11,8 +11,10 @@
 #include "dac_control.h"
 #include "../VGMSXPlay.h"
 #include <stddef.h> // for NULL
+#include <stdlib.h> // for calloc/free
+#include <string.h> // for memcpy
 
-void chip_reg_write(UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT8 Offset,
+void chip_reg_write(UINT8 ChipType, void *ChipInf, UINT8 Port, UINT8 Offset,
                     UINT8 Data);
 
 extern UINT32 SampleRate;
@@ -21,7 +23,7 @@ extern UINT32 SampleRate;
 typedef struct _dac_control {
   // Commands sent to dest-chip
   UINT8 DstChipType;
-  UINT8 DstChipID;
+  void *DstChip; // handle of the chip, NULL if it isn't running
   UINT16 DstCommand;
   UINT8 CmdSize;
 
@@ -42,9 +44,6 @@ typedef struct _dac_control {
   UINT8 DataStep; // always StepSize * CmdSize
 } dac_control;
 
-#define MAX_CHIPS 0xFF
-static dac_control DACData[MAX_CHIPS];
-
 INLINE void daccontrol_SendCommand(dac_control *chip) {
   UINT8 Port;
   UINT8 Command;
@@ -62,13 +61,13 @@ INLINE void daccontrol_SendCommand(dac_control *chip) {
     Command = (chip->DstCommand & 0x00F0) >> 0;
     Data = ChipData[0x00] & 0x0F;
     if (Command & 0x10) {
-      chip_reg_write(chip->DstChipType, chip->DstChipID, 0x00, 0x00,
+      chip_reg_write(chip->DstChipType, chip->DstChip, 0x00, 0x00,
                      Command | Data);
     } else {
       Port = ((ChipData[0x01] & 0x03) << 4) | ((ChipData[0x00] & 0xF0) >> 4);
-      chip_reg_write(chip->DstChipType, chip->DstChipID, 0x00, 0x00,
+      chip_reg_write(chip->DstChipType, chip->DstChip, 0x00, 0x00,
                      Command | Data);
-      chip_reg_write(chip->DstChipType, chip->DstChipID, 0x00, 0x00, Port);
+      chip_reg_write(chip->DstChipType, chip->DstChip, 0x00, 0x00, Port);
     }
     break;
   case 0x01: // YM2413 (1)
@@ -79,7 +78,7 @@ INLINE void daccontrol_SendCommand(dac_control *chip) {
   case 0x08: // AY8910 (8)
     Command = (chip->DstCommand & 0x00FF) >> 0;
     Data = ChipData[0x00];
-    chip_reg_write(chip->DstChipType, chip->DstChipID, 0x00, Command, Data);
+    chip_reg_write(chip->DstChipType, chip->DstChip, 0x00, Command, Data);
     break;
   case 0x06: // YMF262 (6)
   case 0x07: // YMF278B (7)
@@ -87,7 +86,7 @@ INLINE void daccontrol_SendCommand(dac_control *chip) {
     Port = (chip->DstCommand & 0xFF00) >> 8;
     Command = (chip->DstCommand & 0x00FF) >> 0;
     Data = ChipData[0x00];
-    chip_reg_write(chip->DstChipType, chip->DstChipID, Port, Command, Data);
+    chip_reg_write(chip->DstChipType, chip->DstChip, Port, Command, Data);
     break;
   }
   chip->Running |= 0x10;
@@ -100,8 +99,8 @@ INLINE UINT32 muldiv64round(UINT32 Multiplicand, UINT32 Multiplier,
   return (UINT32)(((UINT64)Multiplicand * Multiplier + Divisor / 2) / Divisor);
 }
 
-void daccontrol_update(UINT8 ChipID, UINT32 samples) {
-  dac_control *chip = &DACData[ChipID];
+void daccontrol_update(void *param, UINT32 samples) {
+  dac_control *chip = (dac_control *)param;
   UINT32 NewPos;
   INT16 RealDataStp;
 
@@ -155,27 +154,27 @@ void daccontrol_update(UINT8 ChipID, UINT32 samples) {
   return;
 }
 
-UINT8 device_start_daccontrol(UINT8 ChipID) {
+UINT8 device_start_daccontrol(void **param) {
   dac_control *chip;
-  if (ChipID >= MAX_CHIPS)
+  chip = (dac_control *)calloc(1, sizeof(dac_control));
+  if (chip == NULL)
     return 0;
-  chip = &DACData[ChipID];
+  *param = chip;
   chip->DstChipType = 0xFF;
-  chip->DstChipID = 0x00;
+  chip->DstChip = NULL;
   chip->DstCommand = 0x0000;
   chip->Running = 0xFF;
   return 1;
 }
 
-void device_stop_daccontrol(UINT8 ChipID) {
-  dac_control *chip = &DACData[ChipID];
-  chip->Running = 0xFF;
+void device_stop_daccontrol(void *param) {
+  free(param);
 }
 
-void device_reset_daccontrol(UINT8 ChipID) {
-  dac_control *chip = &DACData[ChipID];
+void device_reset_daccontrol(void *param) {
+  dac_control *chip = (dac_control *)param;
   chip->DstChipType = 0x00;
-  chip->DstChipID = 0x00;
+  chip->DstChip = NULL;
   chip->DstCommand = 0x00;
   chip->CmdSize = 0x00;
   chip->Frequency = 0;
@@ -193,11 +192,27 @@ void device_reset_daccontrol(UINT8 ChipID) {
   chip->DataStep = 0x00;
 }
 
-void daccontrol_setup_chip(UINT8 ChipID, UINT8 ChType, UINT8 ChNum,
+UINT32 device_save_state_daccontrol(void *param, void *Data) {
+  dac_control *chip = (dac_control *)param;
+  if (Data != NULL)
+    memcpy(Data, chip, sizeof(dac_control));
+  return sizeof(dac_control);
+}
+
+// Note: The data pointer is restored as well and must be refreshed by the
+//       caller if the PCM bank was reallocated in the meantime.
+//       The destination chip must still be the one the state was saved with.
+UINT32 device_load_state_daccontrol(void *param, const void *Data) {
+  dac_control *chip = (dac_control *)param;
+  memcpy(chip, Data, sizeof(dac_control));
+  return sizeof(dac_control);
+}
+
+void daccontrol_setup_chip(void *param, UINT8 ChType, void *DstChip,
                            UINT16 Command) {
-  dac_control *chip = &DACData[ChipID];
+  dac_control *chip = (dac_control *)param;
   chip->DstChipType = ChType;
-  chip->DstChipID = ChNum;
+  chip->DstChip = DstChip;
   chip->DstCommand = Command;
   switch (chip->DstChipType) {
   case 0x00: // SN76496
@@ -213,9 +228,9 @@ void daccontrol_setup_chip(UINT8 ChipID, UINT8 ChType, UINT8 ChNum,
   chip->DataStep = chip->CmdSize * chip->StepSize;
 }
 
-void daccontrol_set_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen,
+void daccontrol_set_data(void *param, UINT8 *Data, UINT32 DataLen,
                          UINT8 StepSize, UINT8 StepBase) {
-  dac_control *chip = &DACData[ChipID];
+  dac_control *chip = (dac_control *)param;
   if (chip->Running & 0x80)
     return;
   if (DataLen && Data != NULL) {
@@ -230,8 +245,8 @@ void daccontrol_set_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen,
   chip->DataStep = chip->CmdSize * chip->StepSize;
 }
 
-void daccontrol_refresh_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen) {
-  dac_control *chip = &DACData[ChipID];
+void daccontrol_refresh_data(void *param, UINT8 *Data, UINT32 DataLen) {
+  dac_control *chip = (dac_control *)param;
   if (chip->Running & 0x80)
     return;
   if (DataLen && Data != NULL) {
@@ -243,8 +258,8 @@ void daccontrol_refresh_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen) {
   }
 }
 
-void daccontrol_set_frequency(UINT8 ChipID, UINT32 Frequency) {
-  dac_control *chip = &DACData[ChipID];
+void daccontrol_set_frequency(void *param, UINT32 Frequency) {
+  dac_control *chip = (dac_control *)param;
   if (chip->Running & 0x80)
     return;
   if (Frequency)
@@ -252,9 +267,9 @@ void daccontrol_set_frequency(UINT8 ChipID, UINT32 Frequency) {
   chip->Frequency = Frequency;
 }
 
-void daccontrol_start(UINT8 ChipID, UINT32 DataPos, UINT8 LenMode,
+void daccontrol_start(void *param, UINT32 DataPos, UINT8 LenMode,
                       UINT32 Length) {
-  dac_control *chip = &DACData[ChipID];
+  dac_control *chip = (dac_control *)param;
   UINT16 CmdStepBase;
   if (chip->Running & 0x80)
     return;
@@ -293,8 +308,8 @@ void daccontrol_start(UINT8 ChipID, UINT32 DataPos, UINT8 LenMode,
   chip->Running &= ~0x10;
 }
 
-void daccontrol_stop(UINT8 ChipID) {
-  dac_control *chip = &DACData[ChipID];
+void daccontrol_stop(void *param) {
+  dac_control *chip = (dac_control *)param;
   if (chip->Running & 0x80)
     return;
   chip->Running &= ~0x01;
@@ -3,19 +3,21 @@
 
 #include "../VGMSXPlay.h"
 
-void daccontrol_update(UINT8 ChipID, UINT32 samples);
-UINT8 device_start_daccontrol(UINT8 ChipID);
-void device_stop_daccontrol(UINT8 ChipID);
-void device_reset_daccontrol(UINT8 ChipID);
-void daccontrol_setup_chip(UINT8 ChipID, UINT8 ChType, UINT8 ChNum,
+void daccontrol_update(void *param, UINT32 samples);
+UINT8 device_start_daccontrol(void **param);
+void device_stop_daccontrol(void *param);
+void device_reset_daccontrol(void *param);
+UINT32 device_save_state_daccontrol(void *param, void *Data);
+UINT32 device_load_state_daccontrol(void *param, const void *Data);
+void daccontrol_setup_chip(void *param, UINT8 ChType, void *DstChip,
                            UINT16 Command);
-void daccontrol_set_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen,
+void daccontrol_set_data(void *param, UINT8 *Data, UINT32 DataLen,
                          UINT8 StepSize, UINT8 StepBase);
-void daccontrol_refresh_data(UINT8 ChipID, UINT8 *Data, UINT32 DataLen);
-void daccontrol_set_frequency(UINT8 ChipID, UINT32 Frequency);
-void daccontrol_start(UINT8 ChipID, UINT32 DataPos, UINT8 LenMode,
+void daccontrol_refresh_data(void *param, UINT8 *Data, UINT32 DataLen);
+void daccontrol_set_frequency(void *param, UINT32 Frequency);
+void daccontrol_start(void *param, UINT32 DataPos, UINT8 LenMode,
                       UINT32 Length);
-void daccontrol_stop(UINT8 ChipID);
+void daccontrol_stop(void *param);
 
 #define DCTRL_LMODE_IGNORE 0x00
 #define DCTRL_LMODE_CMDS 0x01
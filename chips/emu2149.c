@@ -40,7 +40,7 @@ static e_uint32 voltbl[2][32] = {
 static void
 internal_refresh (PSG * psg)
 {
-  if (psg->quality)
+  if (psg->quality == 1)
   {
     psg->base_incr = 1 << GETA_BITS;
     psg->realstep = (e_uint32) ((1ULL << 31) / psg->rate);
@@ -51,6 +51,8 @@ internal_refresh (PSG * psg)
   {
     psg->base_incr =
       (e_uint32) ((uint64_t) psg->clk * (1 << GETA_BITS) / (8 * psg->rate));
+    if (psg->base_incr)
+      psg->blep_recip = ((uint64_t) BLEP_PHASES << 32) / psg->base_incr;
   }
 }
 
@@ -157,6 +159,21 @@ PSG_setStereoMask (PSG *psg, e_uint32 mask)
   }  
 }
 
+EMU2149_API e_uint32
+PSG_saveState (PSG *psg, void *data)
+{
+  if (data != NULL)
+    memcpy (data, psg, sizeof (PSG));
+  return sizeof (PSG);
+}
+
+EMU2149_API e_uint32
+PSG_loadState (PSG *psg, const void *data)
+{
+  memcpy (psg, data, sizeof (PSG));
+  return sizeof (PSG);
+}
+
 EMU2149_API e_uint32
 PSG_toggleMask (PSG *psg, e_uint32 mask)
 {
@@ -324,7 +341,7 @@ calc (PSG * psg)
 EMU2149_API e_int16
 PSG_calc (PSG * psg)
 {
-  if (!psg->quality)
+  if (psg->quality != 1)
     return (e_int16) (calc (psg) << 4);
 
   /* Simple rate converter */
@@ -341,17 +358,8 @@ PSG_calc (PSG * psg)
 }
 
 INLINE static void
-calc_stereo (PSG * psg, e_int32 out[2])
+step_envelope (PSG * psg, e_uint32 incr)
 {
-  int i, noise;
-  e_uint32 incr;
-  e_int32 l = 0, r = 0;
-
-  psg->base_count += psg->base_incr;
-  incr = (psg->base_count >> GETA_BITS);
-  psg->base_count &= (1 << GETA_BITS) - 1;
-
-  /* Envelope */
   psg->env_count += incr;
   while (psg->env_count>=0x10000 && psg->env_freq!=0)
   {
@@ -380,17 +388,67 @@ calc_stereo (PSG * psg, e_int32 out[2])
 
     psg->env_count -= psg->env_freq;
   }
+}
+
+INLINE static void
+step_noise (PSG * psg)
+{
+  if (psg->noise_seed & 1)
+    psg->noise_seed ^= 0x24000;
+  psg->noise_seed >>= 1;
+  psg->noise_count -= psg->noise_freq;
+}
+
+INLINE static void
+mix_stereo (PSG * psg, e_int32 out[2])
+{
+  int i, noise;
+  e_int32 l = 0, r = 0;
+
+  noise = psg->noise_seed & 1;
+
+  for (i = 0; i < 3; i++)
+  {
+    psg->cout[i] = 0; // BS maintaining cout for stereo mix
+
+    if (psg->mask&PSG_MASK_CH(i))
+      continue;
+
+    if ((psg->tmask[i] || psg->edge[i]) && (psg->nmask[i] || noise))
+    {
+      if (!(psg->volume[i] & 32))
+        psg->cout[i] = psg->voltbl[psg->volume[i] & 31];
+      else
+        psg->cout[i] = psg->voltbl[psg->env_ptr];
+
+      if (psg->stereo_mask[i] & 0x01)
+        l += psg->cout[i];
+      if (psg->stereo_mask[i] & 0x02)
+        r += psg->cout[i];
+    }
+  }
+
+  out[0] = l << 5;
+  out[1] = r << 5;
+}
+
+INLINE static void
+calc_stereo (PSG * psg, e_int32 out[2])
+{
+  int i;
+  e_uint32 incr;
+
+  psg->base_count += psg->base_incr;
+  incr = (psg->base_count >> GETA_BITS);
+  psg->base_count &= (1 << GETA_BITS) - 1;
+
+  /* Envelope */
+  step_envelope (psg, incr);
 
   /* Noise */
   psg->noise_count += incr;
   if (psg->noise_count & 0x40)
-  {
-    if (psg->noise_seed & 1)
-      psg->noise_seed ^= 0x24000;
-    psg->noise_seed >>= 1;
-    psg->noise_count -= psg->noise_freq;
-  }
-  noise = psg->noise_seed & 1;
+    step_noise (psg);
 
   /* Tone */
   for (i = 0; i < 3; i++)
@@ -408,30 +466,125 @@ calc_stereo (PSG * psg, e_int32 out[2])
         psg->edge[i] = 1;
       }
     }
+  }
 
-    psg->cout[i] = 0; // BS maintaining cout for stereo mix
+  mix_stereo (psg, out);
+}
 
-    if (psg->mask&PSG_MASK_CH(i))
-      continue;
+/* Ticks until a counter that fires when 'bit' gets set fires again. */
+INLINE static e_uint32
+ticks_to_bit (e_uint32 count, e_uint32 bit)
+{
+  e_uint32 m = (count + 1) & (2 * bit - 1);
 
-    if ((psg->tmask[i] || psg->edge[i]) && (psg->nmask[i] || noise))
-    {
-      if (!(psg->volume[i] & 32))
-        psg->cout[i] = psg->voltbl[psg->volume[i] & 31];
-      else
-        psg->cout[i] = psg->voltbl[psg->env_ptr];
+  return (m & bit) ? 1 : bit + 1 - m;
+}
 
-      if (psg->stereo_mask[i] & 0x01)
-        l += psg->cout[i];
-      if (psg->stereo_mask[i] & 0x02)
-        r += psg->cout[i];
+/* Advances the chip by incr ticks, exactly as incr calls of calc_stereo()
+   at the chip rate would. Nothing is mixed on the way. */
+INLINE static void
+skip_ticks (PSG * psg, e_uint32 incr)
+{
+  e_uint32 i, t, k;
+
+  /* the envelope counter only piles up steps, so one call catches up */
+  step_envelope (psg, incr);
+
+  for (t = incr; t >= (k = ticks_to_bit (psg->noise_count, 0x40)); t -= k)
+  {
+    psg->noise_count += k;
+    step_noise (psg);
+  }
+  psg->noise_count += t;
+
+  for (i = 0; i < 3; i++)
+  {
+    if (psg->freq[i] <= 1)
+    {
+      /* the edge goes to 1 at the first hit and stays there */
+      if (incr >= ticks_to_bit (psg->count[i], 0x1000))
+        psg->edge[i] = 1;
+      psg->count[i] += incr;
+      continue;
+    }
+    for (t = incr; t >= (k = ticks_to_bit (psg->count[i], 0x1000)); t -= k)
+    {
+      psg->count[i] += k;
+      psg->edge[i] = !psg->edge[i];
+      psg->count[i] -= psg->freq[i];
     }
+    psg->count[i] += t;
+  }
+}
+
+/* Number of ticks until the next one that can change the mixed output.
+   Tone, noise and envelope only count when some channel can hear them. */
+INLINE static e_uint32
+next_edge (PSG * psg)
+{
+  e_uint32 i, k, next = 0xFFFFFFFF;
+  int noise = 0, env = 0;
+
+  for (i = 0; i < 3; i++)
+  {
+    if ((psg->mask & PSG_MASK_CH(i)) || !(psg->volume[i] & 0x3f))
+      continue;
+    if (!psg->nmask[i])
+      noise = 1;
+    if (psg->volume[i] & 32)
+      env = 1;
+    if (psg->tmask[i] || (psg->freq[i] <= 1 && psg->edge[i]))
+      continue;
+    k = ticks_to_bit (psg->count[i], 0x1000);
+    if (k < next)
+      next = k;
   }
 
-  out[0] = l << 5;
-  out[1] = r << 5;
+  if (noise)
+  {
+    k = ticks_to_bit (psg->noise_count, 0x40);
+    if (k < next)
+      next = k;
+  }
 
-  return;
+  /* a paused envelope steps without moving env_ptr */
+  if (env && psg->env_freq && !psg->env_pause)
+  {
+    k = (psg->env_count >= 0x10000) ? 1 : 0x10000 - psg->env_count;
+    if (k < next)
+      next = k;
+  }
+
+  return next;
+}
+
+/* One output sample in BLEP mode: run the chip from edge to edge and put a
+   band-limited step wherever the output level changes. */
+INLINE static void
+calc_stereo_blep (PSG * psg, e_int32 out[2])
+{
+  e_uint32 start = psg->base_count;
+  e_uint32 incr, t, k;
+  e_int32 lr[2];
+
+  psg->base_count += psg->base_incr;
+  incr = (psg->base_count >> GETA_BITS);
+  psg->base_count &= (1 << GETA_BITS) - 1;
+
+  for (t = 0; t < incr; t += k)
+  {
+    k = next_edge (psg);
+    if (k > incr - t)
+      k = incr - t;
+    skip_ticks (psg, k);
+    mix_stereo (psg, lr);
+    if (blep_changed (&psg->blep, lr[0], lr[1]))
+      blep_step (&psg->blep,
+                 blep_phase (((t + k) << GETA_BITS) - start, psg->blep_recip),
+                 lr[0], lr[1]);
+  }
+
+  blep_read (&psg->blep, out);
 }
 
 EMU2149_API void
@@ -443,6 +596,17 @@ PSG_calc_stereo (PSG * psg, e_int32 **out, e_int32 samples)
 
   int i;
 
+  if (psg->quality == EMU2149_QUALITY_BLEP)
+  {
+    for (i = 0; i < samples; i ++)
+    {
+      calc_stereo_blep (psg, buffers);
+      bufMO[i] = buffers[0];
+      bufRO[i] = buffers[1];
+    }
+    return;
+  }
+
   for (i = 0; i < samples; i ++)
   {
     if (!psg->quality)
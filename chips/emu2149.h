@@ -2,6 +2,7 @@
 #ifndef _EMU2149_H_
 #define _EMU2149_H_
 #include "emutypes.h"
+#include "blep.h"
 
 /*#ifdef EMU2149_DLL_EXPORTS
 #define EMU2149_API __declspec(dllexport)
@@ -17,6 +18,10 @@
 
 #define EMU2149_ZX_STEREO			0x80
 
+/* PSG_set_quality: 0 - one step per sample, 1 - step at the chip rate and
+   interpolate, 2 - band-limited steps at the output rate (stereo only) */
+#define EMU2149_QUALITY_BLEP 2
+
 #define PSG_MASK_CH(x) (1<<(x))
 
 /*#ifdef __cplusplus
@@ -71,6 +76,8 @@ extern "C"
     e_uint32 psgstep;
     e_int32 prev, next;
     e_int32 sprev[2], snext[2];
+    uint64_t blep_recip;
+    BLEP blep;
 
     /* I/O Ctrl */
     e_uint32 adr;
@@ -95,6 +102,8 @@ extern "C"
   EMU2149_API e_uint32 PSG_setMask (PSG *, e_uint32 mask);
   EMU2149_API e_uint32 PSG_toggleMask (PSG *, e_uint32 mask);
   EMU2149_API void PSG_setStereoMask (PSG *psg, e_uint32 mask);
+  EMU2149_API e_uint32 PSG_saveState (PSG *psg, void *data);
+  EMU2149_API e_uint32 PSG_loadState (PSG *psg, const void *data);
     
 /*#ifdef __cplusplus
 }
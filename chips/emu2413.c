@@ -15,6 +15,7 @@
 #include "emu2413.h"
 #include "panning.h" // Maxim
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -146,29 +147,13 @@ static uint16_t exp_table[256] = {
 854,  859,  864,  869,  874,  880,  885,  890,  895,  900,  906,  911,  916,  921,  927,  932,
 937,  942,  948,  953,  959,  964,  969,  975,  980,  986,  991,  996, 1002, 1007, 1013, 1018
 };
-/* fullsin_table[x] = round(-log2(sin((x + 0.5) * PI / (PG_WIDTH / 4) / 2)) * 256) */
-static uint16_t fullsin_table[PG_WIDTH] = {
-2137, 1731, 1543, 1419, 1326, 1252, 1190, 1137, 1091, 1050, 1013, 979,  949,  920,  894,  869, 
-846,  825,  804,  785,  767,  749,  732,  717,  701,  687,  672,  659,  646,  633,  621,  609, 
-598,  587,  576,  566,  556,  546,  536,  527,  518,  509,  501,  492,  484,  476,  468,  461,
-453,  446,  439,  432,  425,  418,  411,  405,  399,  392,  386,  380,  375,  369,  363,  358,  
-352,  347,  341,  336,  331,  326,  321,  316,  311,  307,  302,  297,  293,  289,  284,  280,
-276,  271,  267,  263,  259,  255,  251,  248,  244,  240,  236,  233,  229,  226,  222,  219, 
-215,  212,  209,  205,  202,  199,  196,  193,  190,  187,  184,  181,  178,  175,  172,  169, 
-167,  164,  161,  159,  156,  153,  151,  148,  146,  143,  141,  138,  136,  134,  131,  129,  
-127,  125,  122,  120,  118,  116,  114,  112,  110,  108,  106,  104,  102,  100,  98,   96,   
-94,   92,   91,   89,   87,   85,   83,   82,   80,   78,   77,   75,   74,   72,   70,   69,
-67,   66,   64,   63,   62,   60,   59,   57,   56,   55,   53,   52,   51,   49,   48,   47,  
-46,   45,   43,   42,   41,   40,   39,   38,   37,   36,   35,   34,   33,   32,   31,   30,  
-29,   28,   27,   26,   25,   24,   23,   23,   22,   21,   20,   20,   19,   18,   17,   17,   
-16,   15,   15,   14,   13,   13,   12,   12,   11,   10,   10,   9,    9,    8,    8,    7,    
-7,    7,    6,    6,    5,    5,    5,    4,    4,    4,    3,    3,    3,    2,    2,    2,
-2,    1,    1,    1,    1,    1,    1,    1,    0,    0,    0,    0,    0,    0,    0,    0,
-};
 /* clang-format on */
 
-static uint16_t halfsin_table[PG_WIDTH];
-static uint16_t *wave_table_map[2] = {fullsin_table, halfsin_table};
+/* fullsin_table[x] = round(-log2(sin((x + 0.5) * PI / (PG_WIDTH / 4) / 2)) * 256),
+   halfsin_table, tll_table[8 * 16][1 << TL_BITS][4] and rks_table[8 * 2][2]
+   are generated at build time by gentables.c */
+#include "emu2413_tables.h"
+static const uint16_t *wave_table_map[2] = {fullsin_table, halfsin_table};
 
 /* pitch modulator */
 /* offset to fnum, rough approximation of 14 cents depth. */
@@ -218,16 +203,6 @@ static uint32_t ml_table[16] = {1,      1 * 2,  2 * 2,  3 * 2, 4 * 2,  5 * 2,
                                 6 * 2,  7 * 2,  8 * 2,  9 * 2, 10 * 2, 10 * 2,
                                 12 * 2, 12 * 2, 15 * 2, 15 * 2};
 
-#define dB2(x) ((x) * 2)
-static double kl_table[16] = {
-    dB2(0.000),  dB2(9.000),  dB2(12.000), dB2(13.875),
-    dB2(15.000), dB2(16.125), dB2(16.875), dB2(17.625),
-    dB2(18.000), dB2(18.750), dB2(19.125), dB2(19.500),
-    dB2(19.875), dB2(20.250), dB2(20.625), dB2(21.000)};
-
-static uint32_t tll_table[8 * 16][1 << TL_BITS][4];
-static int32_t rks_table[8 * 2][2];
-
 static OPLL_PATCH null_patch = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 static OPLL_PATCH default_patch[OPLL_TONE_NUM][(16 + 3) * 2];
 
@@ -356,58 +331,6 @@ void OPLL_RateConv_delete(OPLL_RateConv *conv) {
 
 ****************************************************/
 
-static void makeSinTable(void) {
-  int x;
-
-  for (x = 0; x < PG_WIDTH / 4; x++) {
-    fullsin_table[PG_WIDTH / 4 + x] = fullsin_table[PG_WIDTH / 4 - x - 1];
-  }
-
-  for (x = 0; x < PG_WIDTH / 2; x++) {
-    fullsin_table[PG_WIDTH / 2 + x] = 0x8000 | fullsin_table[x];
-  }
-
-  for (x = 0; x < PG_WIDTH / 2; x++)
-    halfsin_table[x] = fullsin_table[x];
-
-  for (x = PG_WIDTH / 2; x < PG_WIDTH; x++)
-    halfsin_table[x] = 0xfff;
-}
-
-static void makeTllTable(void) {
-
-  int32_t tmp;
-  int32_t fnum, block, TL, KL;
-
-  for (fnum = 0; fnum < 16; fnum++) {
-    for (block = 0; block < 8; block++) {
-      for (TL = 0; TL < 64; TL++) {
-        for (KL = 0; KL < 4; KL++) {
-          if (KL == 0) {
-            tll_table[(block << 4) | fnum][TL][KL] = TL2EG(TL);
-          } else {
-            tmp = (int32_t)(kl_table[fnum] - dB2(3.000) * (7 - block));
-            if (tmp <= 0)
-              tll_table[(block << 4) | fnum][TL][KL] = TL2EG(TL);
-            else
-              tll_table[(block << 4) | fnum][TL][KL] =
-                  (uint32_t)((tmp >> (3 - KL)) / EG_STEP) + TL2EG(TL);
-          }
-        }
-      }
-    }
-  }
-}
-
-static void makeRksTable(void) {
-  int fnum8, block;
-  for (fnum8 = 0; fnum8 < 2; fnum8++)
-    for (block = 0; block < 8; block++) {
-      rks_table[(block << 1) | fnum8][1] = (block << 1) + fnum8;
-      rks_table[(block << 1) | fnum8][0] = block >> 1;
-    }
-}
-
 static void makeDefaultPatch() {
   int i, j;
   for (i = 0; i < OPLL_TONE_NUM; i++)
@@ -415,14 +338,11 @@ static void makeDefaultPatch() {
       OPLL_getDefaultPatch(i, j, &default_patch[i][j * 2]);
 }
 
-static uint8_t table_initialized = 0;
+// the tables are shared by all chips and created once
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
 
 static void initializeTables() {
-  makeTllTable();
-  makeRksTable();
-  makeSinTable();
   makeDefaultPatch();
-  table_initialized = 1;
 }
 
 /*********************************************************
@@ -1014,6 +934,26 @@ static INLINE int16_t calc_slot_hat(OPLL *opll) {
   return to_linear(slot->wave_table[phase], slot, 0);
 }
 
+/* Calculate a melody channel. The carrier output is 0 while its envelope
+ * is below the audible floor (see to_linear()), so only the operator
+ * history is kept up to date then; the modulator is skipped as well when
+ * it is silent and has no feedback history left. */
+static INLINE int16_t calc_channel(OPLL *opll, int ch) {
+  OPLL_SLOT *mod = MOD(opll, ch);
+  OPLL_SLOT *car = CAR(opll, ch);
+  int16_t fm = 0;
+
+  if (mod->eg_out < EG_MAX || (mod->output[0] | mod->output[1]))
+    fm = calc_slot_mod(opll, ch);
+
+  if (car->eg_out >= EG_MAX) {
+    car->output[1] = car->output[0];
+    car->output[0] = 0;
+    return 0;
+  }
+  return calc_slot_car(opll, ch, fm);
+}
+
 #define _MO(x) (-(x) >> 1)
 #define _RO(x) (x)
 
@@ -1030,18 +970,18 @@ static void update_output(OPLL *opll) {
   /* CH1-6 */
   for (i = 0; i < 6; i++) {
     if (!(opll->mask & OPLL_MASK_CH(i))) {
-      out[i] = _MO(calc_slot_car(opll, i, calc_slot_mod(opll, i)));
+      out[i] = _MO(calc_channel(opll, i));
     }
   }
 
   /* CH7 */
   if (!opll->rhythm_mode) {
     if (!(opll->mask & OPLL_MASK_CH(6))) {
-      out[6] = _MO(calc_slot_car(opll, 6, calc_slot_mod(opll, 6)));
+      out[6] = _MO(calc_channel(opll, 6));
     }
   } else {
     if (!(opll->mask & OPLL_MASK_BD)) {
-      out[9] = _RO(calc_slot_car(opll, 6, calc_slot_mod(opll, 6)));
+      out[9] = _RO(calc_channel(opll, 6));
     }
   }
   update_noise(opll, 14);
@@ -1049,7 +989,7 @@ static void update_output(OPLL *opll) {
   /* CH8 */
   if (!opll->rhythm_mode) {
     if (!(opll->mask & OPLL_MASK_CH(7))) {
-      out[7] = _MO(calc_slot_car(opll, 7, calc_slot_mod(opll, 7)));
+      out[7] = _MO(calc_channel(opll, 7));
     }
   } else {
     if (!(opll->mask & OPLL_MASK_HH)) {
@@ -1064,7 +1004,7 @@ static void update_output(OPLL *opll) {
   /* CH9 */
   if (!opll->rhythm_mode) {
     if (!(opll->mask & OPLL_MASK_CH(8))) {
-      out[8] = _MO(calc_slot_car(opll, 8, calc_slot_mod(opll, 8)));
+      out[8] = _MO(calc_channel(opll, 8));
     }
   } else {
     if (!(opll->mask & OPLL_MASK_TOM)) {
@@ -1095,6 +1035,8 @@ INLINE static void mix_output_stereo(OPLL *opll) {
   int i;
   out[0] = out[1] = 0;
   for (i = 0; i < 14; i++) {
+    if (!opll->ch_out[i])
+      continue;
     /* Maxim/Valley Bell: added stereo control (multiply each side by a float in
      * opll->pan[ch][side]) */
     if (opll->pan[i] & 2)
@@ -1118,9 +1060,7 @@ OPLL *OPLL_new(uint32_t clk, uint32_t rate) {
   OPLL *opll;
   int i;
 
-  if (!table_initialized) {
-    initializeTables();
-  }
+  pthread_once(&table_once, initializeTables);
 
   opll = (OPLL *)calloc(sizeof(OPLL), 1);
   if (opll == NULL)
@@ -1538,6 +1478,43 @@ uint32_t OPLL_setMask(OPLL *opll, uint32_t mask) {
     return 0;
 }
 
+uint32_t OPLL_saveState(OPLL *opll, void *data) {
+  uint8_t *ptr = (uint8_t *)data;
+  uint32_t size = sizeof(OPLL);
+  int i;
+
+  if (ptr != NULL)
+    memcpy(ptr, opll, sizeof(OPLL));
+  if (opll->conv) {
+    /* the rate converter keeps the last LW input samples of each channel */
+    if (ptr != NULL) {
+      memcpy(ptr + size, &opll->conv->timer, sizeof(opll->conv->timer));
+      for (i = 0; i < opll->conv->ch; i++)
+        memcpy(ptr + size + sizeof(opll->conv->timer) + i * LW * sizeof(int16_t), opll->conv->buf[i],
+               LW * sizeof(int16_t));
+    }
+    size += sizeof(opll->conv->timer) + opll->conv->ch * LW * sizeof(int16_t);
+  }
+  return size;
+}
+
+uint32_t OPLL_loadState(OPLL *opll, const void *data) {
+  const uint8_t *ptr = (const uint8_t *)data;
+  OPLL_RateConv *conv = opll->conv;
+  uint32_t size = sizeof(OPLL);
+  int i;
+
+  memcpy(opll, ptr, sizeof(OPLL));
+  opll->conv = conv;
+  if (conv) {
+    memcpy(&conv->timer, ptr + size, sizeof(conv->timer));
+    for (i = 0; i < conv->ch; i++)
+      memcpy(conv->buf[i], ptr + size + sizeof(conv->timer) + i * LW * sizeof(int16_t), LW * sizeof(int16_t));
+    size += sizeof(conv->timer) + conv->ch * LW * sizeof(int16_t);
+  }
+  return size;
+}
+
 uint32_t OPLL_toggleMask(OPLL *opll, uint32_t mask) {
   uint32_t ret;
 
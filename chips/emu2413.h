@@ -33,7 +33,7 @@ typedef struct __OPLL_SLOT {
   int32_t output[2]; /* output value, latest and previous. */
 
   /* phase generator (pg) */
-  uint16_t *wave_table; /* wave table */
+  const uint16_t *wave_table; /* wave table */
   uint32_t pg_phase;    /* pg phase */
   uint32_t pg_out;      /* pg output, as index of wave table */
   uint8_t pg_keep;      /* if 1, pg_phase is preserved when key-on */
@@ -219,6 +219,13 @@ uint32_t OPLL_setMask(OPLL *, uint32_t mask);
  */
 uint32_t OPLL_toggleMask(OPLL *, uint32_t mask);
 
+/**
+ * Chip state snapshot (including the rate converter history).
+ * Returns the size of the state; OPLL_saveState with data == NULL only returns the size.
+ */
+uint32_t OPLL_saveState(OPLL *, void *data);
+uint32_t OPLL_loadState(OPLL *, const void *data);
+
 /* for compatibility */
 #define OPLL_set_rate OPLL_setRate
 #define OPLL_set_quality OPLL_setQuality
@@ -75,12 +75,19 @@ Revision History:
 #include <stdlib.h>
 #include <string.h>	// for memset
 #include <stddef.h>	// for NULL
+#include <pthread.h>
 //#include "sndintrf.h"
 #include "fmopl.h"
 #if BUILD_Y8950
 #include "ymdeltat.h"
 #endif
 
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__clang__)
+// the AVX2 channel pass is compiled per function and selected at runtime
+#define OPL_AVX2
+#include <immintrin.h>
+#endif
+
 
 /* output final shift */
 #if (OPL_SAMPLE_BITS==16)
@@ -217,20 +224,10 @@ typedef struct
 	UINT8	ksr;		/* key scale rate: kcode>>KSR   */
 	UINT8	mul;		/* multiple: mul_tab[ML]        */
 
-	/* Phase Generator */
-	UINT32	Cnt;		/* frequency counter            */
-	UINT32	Incr;		/* frequency counter step       */
-	UINT8   FB;			/* feedback shift value         */
-	INT32   *connect1;	/* slot1 output pointer         */
-	INT32   op1_out[2];	/* slot1 output for feedback    */
-	UINT8   CON;		/* connection (algorithm) type  */
-
 	/* Envelope Generator */
 	UINT8	eg_type;	/* percussive/non-percussive mode */
 	UINT8	state;		/* phase type                   */
 	UINT32	TL;			/* total level: TL << 2         */
-	INT32	TLL;		/* adjusted now TL              */
-	INT32	volume;		/* envelope counter             */
 	UINT32	sl;			/* sustain level: sl_tab[SL]    */
 	UINT8	eg_sh_ar;	/* (attack state)               */
 	UINT8	eg_sel_ar;	/* (attack state)               */
@@ -239,13 +236,6 @@ typedef struct
 	UINT8	eg_sh_rr;	/* (release state)              */
 	UINT8	eg_sel_rr;	/* (release state)              */
 	UINT32	key;		/* 0 = KEY OFF, >0 = KEY ON     */
-
-	/* LFO */
-	UINT32	AMmask;		/* LFO Amplitude Modulation enable mask */
-	UINT8	vib;		/* LFO Phase Modulation enable flag (active high)*/
-
-	/* waveform select */
-	UINT16	wavetable;
 } OPL_SLOT;
 
 typedef struct
@@ -256,14 +246,39 @@ typedef struct
 	UINT32  fc;			/* Freq. Increment base         */
 	UINT32  ksl_base;	/* KeyScaleLevel Base step      */
 	UINT8   kcode;		/* key code (for key scaling)   */
-	UINT8   Muted;
 } OPL_CH;
 
+/* operator state used by the sample loop
+** Kept as structure of arrays, indexed [slot][channel], so that the
+** operators of all channels can be calculated side by side. */
+typedef struct
+{
+	/* Phase Generator */
+	UINT32	Cnt[2][9];		/* frequency counter            */
+	UINT32	Incr[2][9];		/* frequency counter step       */
+
+	/* Envelope Generator */
+	INT32	TLL[2][9];		/* adjusted now TL              */
+	INT32	volume[2][9];	/* envelope counter             */
+	UINT32	AMmask[2][9];	/* LFO Amplitude Modulation enable mask */
+	UINT32	wavetable[2][9];	/* waveform select: wave * SIN_LEN */
+
+	/* LFO */
+	UINT32	vib;			/* LFO Phase Modulation enable, bit ch*2+slot */
+
+	/* slot1 feedback and connection, per channel */
+	INT32	op1_out[2][9];	/* slot1 output for feedback    */
+	UINT32	FB[9];			/* feedback shift value         */
+	UINT32	CON[9];			/* connection (algorithm) type  */
+} OPL_OPS;
+
 /* OPL state */
 typedef struct fm_opl_f
 {
 	/* FM channel slots */
 	OPL_CH	P_CH[9];				/* OPL/OPL2 chips have 9 channels*/
+	OPL_OPS	op;						/* operator state of all slots  */
+	UINT32	MuteChn;				/* bit n set: channel n is muted */
 	UINT8	MuteSpc[6];				/* Mute Special: 5 Rhythm + 1 DELTA-T Channel */
 
 	UINT32	eg_cnt;					/* global envelope generator counter    */
@@ -330,7 +345,6 @@ typedef struct fm_opl_f
 	double freqbase;				/* frequency base               */
 	//attotime TimerBase;			/* Timer base time (==sampling time)*/
 
-	signed int phase_modulation;	/* phase modulation input (SLOT 2) */
 	signed int output[1];
 #if BUILD_Y8950
 	INT32 output_deltat[4];		/* for Y8950 DELTA-T, chip is mono, that 4 here is just for safety */
@@ -533,13 +547,13 @@ static const UINT8 mul_tab[16]= {
 *   TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (12*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
 
 #define ENV_QUIET		(TL_TAB_LEN>>4)
 
-/* sin waveform table in 'decibel' scale */
-/* four waveforms on OPL2 type chips */
-static unsigned int sin_tab[SIN_LEN * 4];
+/* tl_tab[TL_TAB_LEN] and the sin waveform table in 'decibel' scale,
+   sin_tab[SIN_LEN * 4] (four waveforms on OPL2 type chips), are generated
+   at build time by gentables.c */
+#include "fmopl_tables.h"
 
 
 /* LFO Amplitude Modulation table (verified on real YM3812)
@@ -649,16 +663,11 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
+/* lock level of common table (chips are created by several players) */
 static int num_lock = 0;
+static pthread_mutex_t num_lock_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-
-#define SLOT7_1 (&OPL->P_CH[7].SLOT[SLOT1])
-#define SLOT7_2 (&OPL->P_CH[7].SLOT[SLOT2])
-#define SLOT8_1 (&OPL->P_CH[8].SLOT[SLOT1])
-#define SLOT8_2 (&OPL->P_CH[8].SLOT[SLOT2])
-
-
+extern UINT8 SimdLevel;
 
 
 /*INLINE int limit( int val, int max, int min ) {
@@ -738,6 +747,7 @@ INLINE void refresh_eg(FM_OPL* OPL)
 {
 	OPL_CH *CH;
 	OPL_SLOT *op;
+	INT32 *volume;
 	int i;
 	int new_vol;
 
@@ -745,6 +755,7 @@ INLINE void refresh_eg(FM_OPL* OPL)
 	{
 		CH  = &OPL->P_CH[i/2];
 		op  = &CH->SLOT[i&1];
+		volume = &OPL->op.volume[i&1][i/2];
 
 		// Envelope Generator
 		switch(op->state)
@@ -752,12 +763,12 @@ INLINE void refresh_eg(FM_OPL* OPL)
 		case EG_ATT:		// attack phase
 			if ( !(OPL->eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
 			{
-				new_vol = op->volume + ((~op->volume *
+				new_vol = *volume + ((~*volume *
 							   (eg_inc[op->eg_sel_ar + ((OPL->eg_cnt>>op->eg_sh_ar)&7)])
 							  ) >> 3);
 				if (new_vol <= MIN_ATT_INDEX)
 				{
-					op->volume = MIN_ATT_INDEX;
+					*volume = MIN_ATT_INDEX;
 					op->state = EG_DEC;
 				}
 			}
@@ -765,7 +776,7 @@ INLINE void refresh_eg(FM_OPL* OPL)
 		/*case EG_DEC:	// decay phase
 			if ( !(OPL->eg_cnt & ((1<<op->eg_sh_dr)-1) ) )
 			{
-				new_vol = op->volume + eg_inc[op->eg_sel_dr + ((OPL->eg_cnt>>op->eg_sh_dr)&7)];
+				new_vol = *volume + eg_inc[op->eg_sel_dr + ((OPL->eg_cnt>>op->eg_sh_dr)&7)];
 
 				if ( new_vol >= op->sl )
 					op->state = EG_SUS;
@@ -774,22 +785,22 @@ INLINE void refresh_eg(FM_OPL* OPL)
 		case EG_SUS:	// sustain phase
 			if ( !op->eg_type)	percussive mode
 			{
-				new_vol = op->volume + eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
+				new_vol = *volume + eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
 
 				if ( !(OPL->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 				{
 					if ( new_vol >= MAX_ATT_INDEX )
-						op->volume = MAX_ATT_INDEX;
+						*volume = MAX_ATT_INDEX;
 				}
 			}
 			break;
 		case EG_REL:	// release phase
 			if ( !(OPL->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 			{
-				new_vol = op->volume + eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
+				new_vol = *volume + eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
 				if ( new_vol >= MAX_ATT_INDEX )
 				{
-					op->volume = MAX_ATT_INDEX;
+					*volume = MAX_ATT_INDEX;
 					op->state = EG_OFF;
 				}
 
@@ -803,11 +814,54 @@ INLINE void refresh_eg(FM_OPL* OPL)
 	return;
 }
 
+/* LFO phase modulation of a slot, applied on top of its regular step
+   ('i' is the slot number: channel i/2, slot i&1) */
+INLINE void advance_vib_phase(FM_OPL *OPL, int i)
+{
+	OPL_CH *CH = &OPL->P_CH[i/2];
+	UINT8 block;
+	unsigned int block_fnum = CH->block_fnum;
+
+	unsigned int fnum_lfo   = (block_fnum&0x0380) >> 7;
+
+	signed int lfo_fn_table_index_offset = lfo_pm_table[OPL->LFO_PM + 16*fnum_lfo ];
+
+	if (lfo_fn_table_index_offset)	/* LFO phase modulation active */
+	{
+		block_fnum += lfo_fn_table_index_offset;
+		block = (block_fnum&0x1c00) >> 10;
+		OPL->op.Cnt[i&1][i/2] += (OPL->fn_tab[block_fnum&0x03ff] >> (7-block)) * CH->SLOT[i&1].mul
+								- OPL->op.Incr[i&1][i/2];
+	}
+	/* else LFO phase modulation = zero, the regular step stays */
+}
+
+/* phase generator step of all slots */
+INLINE void advance_phase(FM_OPL *OPL)
+{
+	OPL_OPS *ops = &OPL->op;
+	UINT32 vib;
+	int i;
+
+	for (i=0; i<9; i++)
+	{
+		ops->Cnt[SLOT1][i] += ops->Incr[SLOT1][i];
+		ops->Cnt[SLOT2][i] += ops->Incr[SLOT2][i];
+	}
+	for (i=0, vib=ops->vib; vib; i++, vib>>=1)
+	{
+		if (vib & 1)
+			advance_vib_phase(OPL, i);
+	}
+}
+
 /* advance to next sample */
 INLINE void advance(FM_OPL *OPL)
 {
+	OPL_OPS *ops = &OPL->op;
 	OPL_CH *CH;
 	OPL_SLOT *op;
+	INT32 *volume;
 	int i;
 
 	OPL->eg_timer += OPL->eg_timer_add;
@@ -822,6 +876,7 @@ INLINE void advance(FM_OPL *OPL)
 		{
 			CH  = &OPL->P_CH[i/2];
 			op  = &CH->SLOT[i&1];
+			volume = &ops->volume[i&1][i/2];
 
 			/* Envelope Generator */
 			switch(op->state)
@@ -829,13 +884,13 @@ INLINE void advance(FM_OPL *OPL)
 			case EG_ATT:		/* attack phase */
 				if ( !(OPL->eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
 				{
-					op->volume += (~op->volume *
+					*volume += (~*volume *
 							   (eg_inc[op->eg_sel_ar + ((OPL->eg_cnt>>op->eg_sh_ar)&7)])
 							  ) >>3;
 
-					if (op->volume <= MIN_ATT_INDEX)
+					if (*volume <= MIN_ATT_INDEX)
 					{
-						op->volume = MIN_ATT_INDEX;
+						*volume = MIN_ATT_INDEX;
 						op->state = EG_DEC;
 					}
 
@@ -845,9 +900,9 @@ INLINE void advance(FM_OPL *OPL)
 			case EG_DEC:	/* decay phase */
 				if ( !(OPL->eg_cnt & ((1<<op->eg_sh_dr)-1) ) )
 				{
-					op->volume += eg_inc[op->eg_sel_dr + ((OPL->eg_cnt>>op->eg_sh_dr)&7)];
+					*volume += eg_inc[op->eg_sel_dr + ((OPL->eg_cnt>>op->eg_sh_dr)&7)];
 
-					if ( op->volume >= op->sl )
+					if ( *volume >= op->sl )
 						op->state = EG_SUS;
 
 				}
@@ -868,10 +923,10 @@ INLINE void advance(FM_OPL *OPL)
 					/* during sustain phase chip adds Release Rate (in percussive mode) */
 					if ( !(OPL->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 					{
-						op->volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
+						*volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
 
-						if ( op->volume >= MAX_ATT_INDEX )
-							op->volume = MAX_ATT_INDEX;
+						if ( *volume >= MAX_ATT_INDEX )
+							*volume = MAX_ATT_INDEX;
 					}
 					/* else do nothing in sustain phase */
 				}
@@ -880,11 +935,11 @@ INLINE void advance(FM_OPL *OPL)
 			case EG_REL:	/* release phase */
 				if ( !(OPL->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 				{
-					op->volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
+					*volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt>>op->eg_sh_rr)&7)];
 
-					if ( op->volume >= MAX_ATT_INDEX )
+					if ( *volume >= MAX_ATT_INDEX )
 					{
-						op->volume = MAX_ATT_INDEX;
+						*volume = MAX_ATT_INDEX;
 						op->state = EG_OFF;
 					}
 
@@ -897,37 +952,8 @@ INLINE void advance(FM_OPL *OPL)
 		}
 	}
 
-	for (i=0; i<9*2; i++)
-	{
-		CH  = &OPL->P_CH[i/2];
-		op  = &CH->SLOT[i&1];
-
-		/* Phase Generator */
-		if(op->vib)
-		{
-			UINT8 block;
-			unsigned int block_fnum = CH->block_fnum;
-
-			unsigned int fnum_lfo   = (block_fnum&0x0380) >> 7;
-
-			signed int lfo_fn_table_index_offset = lfo_pm_table[OPL->LFO_PM + 16*fnum_lfo ];
-
-			if (lfo_fn_table_index_offset)	/* LFO phase modulation active */
-			{
-				block_fnum += lfo_fn_table_index_offset;
-				block = (block_fnum&0x1c00) >> 10;
-				op->Cnt += (OPL->fn_tab[block_fnum&0x03ff] >> (7-block)) * op->mul;
-			}
-			else	/* LFO phase modulation  = zero */
-			{
-				op->Cnt += op->Incr;
-			}
-		}
-		else	/* LFO phase modulation disabled for this operator */
-		{
-			op->Cnt += op->Incr;
-		}
-	}
+	/* Phase Generator */
+	advance_phase(OPL);
 
 	/*  The Noise Generator of the YM3812 is 23-bit shift register.
     *   Period is equal to 2^23-2 samples.
@@ -967,6 +993,87 @@ INLINE void advance(FM_OPL *OPL)
 }
 
 
+/* Idle channel tracking
+** A slot in EG_OFF is silent and can only be woken up by a key-on, which is
+** a register write and never happens in the middle of an update. Channels
+** with both slots off and a drained feedback history are therefore skipped
+** for a whole update, and a chip without any active channel only advances
+** its counters. */
+
+/* bit n set: channel n can produce output during the current update */
+static UINT32 OPL_active_channels(FM_OPL *OPL)
+{
+	OPL_CH *CH;
+	UINT32 active = 0;
+	int c;
+
+	for (c=0; c<9; c++)
+	{
+		CH = &OPL->P_CH[c];
+		if (CH->SLOT[SLOT1].state != EG_OFF || CH->SLOT[SLOT2].state != EG_OFF ||
+			(OPL->op.op1_out[0][c] | OPL->op.op1_out[1][c]))
+			active |= 1 << c;
+	}
+
+	return active;
+}
+
+/* advance 'length' samples while no channel is active
+   (same result as 'length' calls of advance_lfo() and advance()) */
+static void advance_idle(FM_OPL *OPL, int length)
+{
+	UINT32 vib = OPL->op.vib;
+	UINT64 t;
+	int i, s;
+
+	/* envelope generator: all slots are off, only the counter moves */
+	t = OPL->eg_timer + (UINT64)OPL->eg_timer_add * length;
+	OPL->eg_cnt += (UINT32)(t / OPL->eg_timer_overflow);
+	OPL->eg_timer = (UINT32)(t % OPL->eg_timer_overflow);
+
+	/* phase generator (the phase of an idle slot is still used by the
+	   rhythm section) */
+	for (i=0; i<9*2; i++)
+	{
+		if (! (vib & (1 << i)))
+			OPL->op.Cnt[i&1][i/2] += OPL->op.Incr[i&1][i/2] * length;
+	}
+
+	if (vib)
+	{
+		/* LFO phase modulation follows the LFO sample by sample */
+		for (s=0; s<length; s++)
+		{
+			advance_lfo(OPL);
+			for (i=0; i<9*2; i++)
+			{
+				if (vib & (1 << i))
+				{
+					OPL->op.Cnt[i&1][i/2] += OPL->op.Incr[i&1][i/2];
+					advance_vib_phase(OPL, i);
+				}
+			}
+		}
+	}
+	else
+	{
+		t = OPL->lfo_am_cnt + (UINT64)OPL->lfo_am_inc * (length-1);
+		OPL->lfo_am_cnt = (UINT32)(t % ((UINT32)LFO_AM_TAB_ELEMENTS<<LFO_SH));
+		OPL->lfo_pm_cnt += OPL->lfo_pm_inc * (length-1);
+		advance_lfo(OPL);
+	}
+
+	/* noise generator */
+	t = OPL->noise_p + (UINT64)OPL->noise_f * length;
+	OPL->noise_p = (UINT32)t & FREQ_MASK;
+	for (t >>= FREQ_SH; t; t--)
+	{
+		if (OPL->noise_rng & 1) OPL->noise_rng ^= 0x800302;
+		OPL->noise_rng >>= 1;
+	}
+}
+
+
 INLINE signed int op_calc(UINT32 phase, unsigned int env, signed int pm, unsigned int wave_tab)
 {
 	UINT32 p;
@@ -990,41 +1097,137 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm, unsign
 }
 
 
-#define volume_calc(OP) ((OP)->TLL + ((UINT32)(OP)->volume) + (OPL->LFO_AM & (OP)->AMmask))
+#define volume_calc(s,c) (ops->TLL[s][c] + ((UINT32)ops->volume[s][c]) + (OPL->LFO_AM & ops->AMmask[s][c]))
 
 /* calculate output */
-INLINE void OPL_CALC_CH( FM_OPL *OPL, OPL_CH *CH )
+INLINE void OPL_CALC_CH( FM_OPL *OPL, int c )
 {
-	OPL_SLOT *SLOT;
+	OPL_OPS *ops = &OPL->op;
 	unsigned int env;
 	signed int out;
-
-	if (CH->Muted)
-		return;
-
-	OPL->phase_modulation = 0;
+	signed int phase_modulation;	/* phase modulation input (SLOT 2) */
 
 	/* SLOT 1 */
-	SLOT = &CH->SLOT[SLOT1];
-	env  = volume_calc(SLOT);
-	out  = SLOT->op1_out[0] + SLOT->op1_out[1];
-	SLOT->op1_out[0] = SLOT->op1_out[1];
-	*SLOT->connect1 += SLOT->op1_out[0];
-	SLOT->op1_out[1] = 0;
+	env  = volume_calc(SLOT1, c);
+	out  = ops->op1_out[0][c] + ops->op1_out[1][c];
+	ops->op1_out[0][c] = ops->op1_out[1][c];
+	phase_modulation = ops->op1_out[0][c];
+	if (ops->CON[c])
+	{
+		OPL->output[0] += phase_modulation;
+		phase_modulation = 0;
+	}
+	ops->op1_out[1][c] = 0;
 	if( env < ENV_QUIET )
 	{
-		if (!SLOT->FB)
+		if (!ops->FB[c])
 			out = 0;
-		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+		ops->op1_out[1][c] = op_calc1(ops->Cnt[SLOT1][c], env, (out<<ops->FB[c]), ops->wavetable[SLOT1][c] );
 	}
 
 	/* SLOT 2 */
-	SLOT++;
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT2, c);
 	if( env < ENV_QUIET )
-		OPL->output[0] += op_calc(SLOT->Cnt, env, OPL->phase_modulation, SLOT->wavetable);
+		OPL->output[0] += op_calc(ops->Cnt[SLOT2][c], env, phase_modulation, ops->wavetable[SLOT2][c]);
+}
+
+/* calculate the melodic channels set in 'chns' */
+typedef void (*OPL_CALC_FUNC)(FM_OPL *OPL, UINT32 chns);
+
+static void OPL_CALC_CHANNELS_C(FM_OPL *OPL, UINT32 chns)
+{
+	int c;
+
+	for (c = 0; chns; c ++, chns >>= 1)
+	{
+		if (chns & 1)
+			OPL_CALC_CH(OPL, c);
+	}
+}
+
+#ifdef OPL_AVX2
+/* op_calc/op_calc1 for 8 operators, silent ones (env >= ENV_QUIET) give 0 */
+__attribute__((target("avx2")))
+INLINE __m256i op_calc_AVX2(__m256i phase, __m256i env, __m256i pm, __m256i wave_tab)
+{
+	__m256i on, p;
+
+	on = _mm256_cmpgt_epi32(_mm256_set1_epi32(ENV_QUIET), env);
+	p = _mm256_add_epi32(_mm256_and_si256(phase, _mm256_set1_epi32(~FREQ_MASK)), pm);
+	p = _mm256_and_si256(_mm256_srli_epi32(p, FREQ_SH), _mm256_set1_epi32(SIN_MASK));
+	p = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)sin_tab,
+					_mm256_add_epi32(wave_tab, p), on, 4);
+	p = _mm256_add_epi32(_mm256_slli_epi32(env, 4), p);
+
+	on = _mm256_and_si256(on, _mm256_cmpgt_epi32(_mm256_set1_epi32(TL_TAB_LEN), p));
+	return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tl_tab, p, on, 4);
 }
 
+#define LOAD8(x) _mm256_loadu_si256((const __m256i *)(x))
+
+/* channels 0-7 in one pass with a lane per channel, channel 8 on its own
+   (the operators of a sample don't depend on each other: slot 2 is
+   modulated by the slot 1 output of the previous sample) */
+__attribute__((target("avx2")))
+static void OPL_CALC_CHANNELS_AVX2(FM_OPL *OPL, UINT32 chns)
+{
+	OPL_OPS *ops = &OPL->op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bits = _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+	const __m256i lfo_am = _mm256_set1_epi32(OPL->LFO_AM);
+	__m256i run, out0, out1, out, modul, fb, env, res1, res2, sum;
+	__m128i hsum;
+	UINT32 few;
+
+	/* with fewer than 3 channels in the vector the scalar code is faster */
+	few = chns & 0xFF;
+	few &= few - 1;
+	if (! (few & (few - 1)))
+	{
+		OPL_CALC_CHANNELS_C(OPL, chns);
+		return;
+	}
+
+	run = _mm256_and_si256(_mm256_set1_epi32(chns), bits);
+	run = _mm256_cmpeq_epi32(run, bits);
+
+	/* SLOT 1 */
+	out0 = LOAD8(ops->op1_out[0]);
+	out1 = LOAD8(ops->op1_out[1]);
+	out = _mm256_add_epi32(out0, out1);
+	fb = LOAD8(ops->FB);
+	out = _mm256_andnot_si256(_mm256_cmpeq_epi32(fb, zero), _mm256_sllv_epi32(out, fb));
+	env = _mm256_add_epi32(LOAD8(ops->TLL[SLOT1]), LOAD8(ops->volume[SLOT1]));
+	env = _mm256_add_epi32(env, _mm256_and_si256(lfo_am, LOAD8(ops->AMmask[SLOT1])));
+	res1 = op_calc_AVX2(LOAD8(ops->Cnt[SLOT1]), env, out, LOAD8(ops->wavetable[SLOT1]));
+
+	/* the previous slot 1 output modulates slot 2 or goes to the output */
+	modul = _mm256_cmpeq_epi32(LOAD8(ops->CON), zero);
+	sum = _mm256_andnot_si256(modul, out1);
+	modul = _mm256_slli_epi32(_mm256_and_si256(modul, out1), 16);
+
+	/* SLOT 2 */
+	env = _mm256_add_epi32(LOAD8(ops->TLL[SLOT2]), LOAD8(ops->volume[SLOT2]));
+	env = _mm256_add_epi32(env, _mm256_and_si256(lfo_am, LOAD8(ops->AMmask[SLOT2])));
+	res2 = op_calc_AVX2(LOAD8(ops->Cnt[SLOT2]), env, modul, LOAD8(ops->wavetable[SLOT2]));
+
+	sum = _mm256_and_si256(_mm256_add_epi32(sum, res2), run);
+	hsum = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	hsum = _mm_add_epi32(hsum, _mm_shuffle_epi32(hsum, 0x4E));
+	hsum = _mm_add_epi32(hsum, _mm_shuffle_epi32(hsum, 0xB1));
+	OPL->output[0] += _mm_cvtsi128_si32(hsum);
+
+	_mm256_storeu_si256((__m256i *)ops->op1_out[0], _mm256_blendv_epi8(out0, out1, run));
+	_mm256_storeu_si256((__m256i *)ops->op1_out[1], _mm256_blendv_epi8(out1, res1, run));
+	_mm256_zeroupper();
+
+	if (chns & 0x100)
+		OPL_CALC_CH(OPL, 8);
+}
+#endif
+
+static OPL_CALC_FUNC OPL_CALC_CHANNELS = OPL_CALC_CHANNELS_C;
+
 /*
     operators used in the rhythm sounds generation process:
 
@@ -1062,11 +1265,12 @@ number   number    BLK/FNUM2 FNUM    Drum  Hat   Drum  Tom  Cymbal
 
 /* calculate rhythm */
 
-INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
+INLINE void OPL_CALC_RH( FM_OPL *OPL, unsigned int noise )
 {
-	OPL_SLOT *SLOT;
+	OPL_OPS *ops = &OPL->op;
 	signed int out;
 	unsigned int env;
+	signed int phase_modulation;
 
 
 	/* Bass Drum (verified on real YM3812):
@@ -1076,31 +1280,29 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
       - output sample always is multiplied by 2
     */
 
-	OPL->phase_modulation = 0;
+	phase_modulation = 0;
 	/* SLOT 1 */
-	SLOT = &CH[6].SLOT[SLOT1];
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT1, 6);
 
-	out = SLOT->op1_out[0] + SLOT->op1_out[1];
-	SLOT->op1_out[0] = SLOT->op1_out[1];
+	out = ops->op1_out[0][6] + ops->op1_out[1][6];
+	ops->op1_out[0][6] = ops->op1_out[1][6];
 
-	if (!SLOT->CON)
-		OPL->phase_modulation = SLOT->op1_out[0];
+	if (!ops->CON[6])
+		phase_modulation = ops->op1_out[0][6];
 	/* else ignore output of operator 1 */
 
-	SLOT->op1_out[1] = 0;
+	ops->op1_out[1][6] = 0;
 	if( env < ENV_QUIET )
 	{
-		if (!SLOT->FB)
+		if (!ops->FB[6])
 			out = 0;
-		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+		ops->op1_out[1][6] = op_calc1(ops->Cnt[SLOT1][6], env, (out<<ops->FB[6]), ops->wavetable[SLOT1][6] );
 	}
 
 	/* SLOT 2 */
-	SLOT++;
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT2, 6);
 	if( env < ENV_QUIET && ! OPL->MuteSpc[0] )
-		OPL->output[0] += op_calc(SLOT->Cnt, env, OPL->phase_modulation, SLOT->wavetable) * 2;
+		OPL->output[0] += op_calc(ops->Cnt[SLOT2][6], env, phase_modulation, ops->wavetable[SLOT2][6]) * 2;
 
 
 	/* Phase generation is based on: */
@@ -1121,7 +1323,7 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
     */
 
 	/* High Hat (verified on real YM3812) */
-	env = volume_calc(SLOT7_1);
+	env = volume_calc(SLOT1, 7);
 	if( env < ENV_QUIET && ! OPL->MuteSpc[4] )
 	{
 
@@ -1131,9 +1333,9 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
         */
 
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit7 = ((SLOT7_1->Cnt>>FREQ_SH)>>7)&1;
-		unsigned char bit3 = ((SLOT7_1->Cnt>>FREQ_SH)>>3)&1;
-		unsigned char bit2 = ((SLOT7_1->Cnt>>FREQ_SH)>>2)&1;
+		unsigned char bit7 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>7)&1;
+		unsigned char bit3 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>3)&1;
+		unsigned char bit2 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>2)&1;
 
 		unsigned char res1 = (bit2 ^ bit7) | bit3;
 
@@ -1142,8 +1344,8 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 		UINT32 phase = res1 ? (0x200|(0xd0>>2)) : 0xd0;
 
 		/* enable gate based on frequency of operator 2 in channel 8 */
-		unsigned char bit5e= ((SLOT8_2->Cnt>>FREQ_SH)>>5)&1;
-		unsigned char bit3e= ((SLOT8_2->Cnt>>FREQ_SH)>>3)&1;
+		unsigned char bit5e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>5)&1;
+		unsigned char bit3e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>3)&1;
 
 		unsigned char res2 = (bit3e ^ bit5e);
 
@@ -1168,15 +1370,15 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 				phase = 0xd0>>2;
 		}
 
-		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, SLOT7_1->wavetable) * 2;
+		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT1][7]) * 2;
 	}
 
 	/* Snare Drum (verified on real YM3812) */
-	env = volume_calc(SLOT7_2);
+	env = volume_calc(SLOT2, 7);
 	if( env < ENV_QUIET && ! OPL->MuteSpc[1] )
 	{
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit8 = ((SLOT7_1->Cnt>>FREQ_SH)>>8)&1;
+		unsigned char bit8 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>8)&1;
 
 		/* when bit8 = 0 phase = 0x100; */
 		/* when bit8 = 1 phase = 0x200; */
@@ -1189,22 +1391,22 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 		if (noise)
 			phase ^= 0x100;
 
-		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, SLOT7_2->wavetable) * 2;
+		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT2][7]) * 2;
 	}
 
 	/* Tom Tom (verified on real YM3812) */
-	env = volume_calc(SLOT8_1);
+	env = volume_calc(SLOT1, 8);
 	if( env < ENV_QUIET && ! OPL->MuteSpc[2] )
-		OPL->output[0] += op_calc(SLOT8_1->Cnt, env, 0, SLOT8_1->wavetable) * 2;
+		OPL->output[0] += op_calc(ops->Cnt[SLOT1][8], env, 0, ops->wavetable[SLOT1][8]) * 2;
 
 	/* Top Cymbal (verified on real YM3812) */
-	env = volume_calc(SLOT8_2);
+	env = volume_calc(SLOT2, 8);
 	if( env < ENV_QUIET && ! OPL->MuteSpc[3] )
 	{
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit7 = ((SLOT7_1->Cnt>>FREQ_SH)>>7)&1;
-		unsigned char bit3 = ((SLOT7_1->Cnt>>FREQ_SH)>>3)&1;
-		unsigned char bit2 = ((SLOT7_1->Cnt>>FREQ_SH)>>2)&1;
+		unsigned char bit7 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>7)&1;
+		unsigned char bit3 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>3)&1;
+		unsigned char bit2 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>2)&1;
 
 		unsigned char res1 = (bit2 ^ bit7) | bit3;
 
@@ -1213,8 +1415,8 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 		UINT32 phase = res1 ? 0x300 : 0x100;
 
 		/* enable gate based on frequency of operator 2 in channel 8 */
-		unsigned char bit5e= ((SLOT8_2->Cnt>>FREQ_SH)>>5)&1;
-		unsigned char bit3e= ((SLOT8_2->Cnt>>FREQ_SH)>>3)&1;
+		unsigned char bit5e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>5)&1;
+		unsigned char bit3e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>3)&1;
 
 		unsigned char res2 = (bit3e ^ bit5e);
 		/* when res2 = 0 pass the phase from calculation above (res1); */
@@ -1222,118 +1424,28 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 		if (res2)
 			phase = 0x300;
 
-		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, SLOT8_2->wavetable) * 2;
+		OPL->output[0] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT2][8]) * 2;
 	}
 }
 
 
-/* generic table initialize */
-static int init_tables(void)
+/* calculate all active channels (see OPL_active_channels) */
+INLINE void OPL_CALC_ACTIVE( FM_OPL *OPL, UINT32 active, UINT8 rhythm )
 {
-	signed int i,x;
-	signed int n;
-	double o,m;
+	UINT32 chns = active & ~OPL->MuteChn;
 
+	if(rhythm)
+		chns &= 0x03F;	/* channels 6-8 play the rhythm sounds */
+	if (chns)
+		OPL_CALC_CHANNELS(OPL, chns);
 
-	for (x=0; x<TL_RES_LEN; x++)
+	if (rhythm && (active & 0x1C0))	/* Rhythm part */
 	{
-		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
-		m = floor(m);
-
-		/* we never reach (1<<16) here due to the (x+1) */
-		/* result fits within 16 bits at maximum */
-
-		n = (int)m;		/* 16 bits here */
-		n >>= 4;		/* 12 bits here */
-		if (n&1)		/* round to nearest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-						/* 11 bits here (rounded) */
-		n <<= 1;		/* 12 bits here (as in real chip) */
-		tl_tab[ x*2 + 0 ] = n;
-		tl_tab[ x*2 + 1 ] = -tl_tab[ x*2 + 0 ];
-
-		for (i=1; i<12; i++)
-		{
-			tl_tab[ x*2+0 + i*2*TL_RES_LEN ] =  tl_tab[ x*2+0 ]>>i;
-			tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = -tl_tab[ x*2+0 + i*2*TL_RES_LEN ];
-		}
-	#if 0
-			logerror("tl %04i", x*2);
-			for (i=0; i<12; i++)
-				logerror(", [%02i] %5i", i*2, tl_tab[ x*2 /*+1*/ + i*2*TL_RES_LEN ] );
-			logerror("\n");
-	#endif
+		OPL_CALC_RH(OPL, (OPL->noise_rng>>0)&1 );
 	}
-	/*logerror("FMOPL.C: TL_TAB_LEN = %i elements (%i bytes)\n",TL_TAB_LEN, (int)sizeof(tl_tab));*/
-
-
-	for (i=0; i<SIN_LEN; i++)
-	{
-		/* non-standard sinus */
-		m = sin( ((i*2)+1) * M_PI / SIN_LEN ); /* checked against the real chip */
-
-		/* we never reach zero here due to ((i*2)+1) */
-
-		if (m>0.0)
-			o = 8*log(1.0/m)/log(2.0);	/* convert to 'decibels' */
-		else
-			o = 8*log(-1.0/m)/log(2.0);	/* convert to 'decibels' */
-
-		o = o / (ENV_STEP/4);
-
-		n = (int)(2.0*o);
-		if (n&1)						/* round to nearest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-
-		sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
-
-		/*logerror("FMOPL.C: sin [%4i (hex=%03x)]= %4i (tl_tab value=%5i)\n", i, i, sin_tab[i], tl_tab[sin_tab[i]] );*/
-	}
-
-	for (i=0; i<SIN_LEN; i++)
-	{
-		/* waveform 1:  __      __     */
-		/*             /  \____/  \____*/
-		/* output only first half of the sinus waveform (positive one) */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			sin_tab[1*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[1*SIN_LEN+i] = sin_tab[i];
-
-		/* waveform 2:  __  __  __  __ */
-		/*             /  \/  \/  \/  \*/
-		/* abs(sin) */
-
-		sin_tab[2*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>1) ];
-
-		/* waveform 3:  _   _   _   _  */
-		/*             / |_/ |_/ |_/ |_*/
-		/* abs(output only first quarter of the sinus waveform) */
-
-		if (i & (1<<(SIN_BITS-2)) )
-			sin_tab[3*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[3*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>2)];
-
-		/*logerror("FMOPL.C: sin1[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[1*SIN_LEN+i], tl_tab[sin_tab[1*SIN_LEN+i]] );
-        logerror("FMOPL.C: sin2[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[2*SIN_LEN+i], tl_tab[sin_tab[2*SIN_LEN+i]] );
-        logerror("FMOPL.C: sin3[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[3*SIN_LEN+i], tl_tab[sin_tab[3*SIN_LEN+i]] );*/
-	}
-	/*logerror("FMOPL.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-
-#ifdef SAVE_SAMPLE
-	sample[0]=fopen("sampsum.pcm","wb");
-#endif
-
-	return 1;
 }
 
+
 static void OPLCloseTable( void )
 {
 #ifdef SAVE_SAMPLE
@@ -1388,8 +1500,7 @@ static void OPL_initalize(FM_OPL *OPL)
 	}
 #endif
 
-	for(i = 0; i < 9; i ++)
-		OPL->P_CH[i].Muted = 0x00;
+	OPL->MuteChn = 0x00;
 	for(i = 0; i < 6; i ++)
 		OPL->MuteSpc[i] = 0x00;
 
@@ -1412,12 +1523,14 @@ static void OPL_initalize(FM_OPL *OPL)
 
 }
 
-INLINE void FM_KEYON(OPL_SLOT *SLOT, UINT32 key_set)
+INLINE void FM_KEYON(FM_OPL *OPL, int c, int s, UINT32 key_set)
 {
+	OPL_SLOT *SLOT = &OPL->P_CH[c].SLOT[s];
+
 	if( !SLOT->key )
 	{
 		/* restart Phase Generator */
-		SLOT->Cnt = 0;
+		OPL->op.Cnt[s][c] = 0;
 		/* phase -> Attack */
 		SLOT->state = EG_ATT;
 	}
@@ -1440,12 +1553,14 @@ INLINE void FM_KEYOFF(OPL_SLOT *SLOT, UINT32 key_clr)
 }
 
 /* update phase increment counter of operator (also update the EG rates if necessary) */
-INLINE void CALC_FCSLOT(OPL_CH *CH,OPL_SLOT *SLOT)
+INLINE void CALC_FCSLOT(FM_OPL *OPL,int c,int s)
 {
+	OPL_CH   *CH   = &OPL->P_CH[c];
+	OPL_SLOT *SLOT = &CH->SLOT[s];
 	int ksr;
 
 	/* (frequency) phase increment counter */
-	SLOT->Incr = CH->fc * SLOT->mul;
+	OPL->op.Incr[s][c] = CH->fc * SLOT->mul;
 	ksr = CH->kcode >> SLOT->KSR;
 
 	if( SLOT->ksr != ksr )
@@ -1479,9 +1594,12 @@ INLINE void set_mul(FM_OPL *OPL,int slot,int v)
 	SLOT->mul     = mul_tab[v&0x0f];
 	SLOT->KSR     = (v&0x10) ? 0 : 2;
 	SLOT->eg_type = (v&0x20);
-	SLOT->vib     = (v&0x40);
-	SLOT->AMmask  = (v&0x80) ? ~0 : 0;
-	CALC_FCSLOT(CH,SLOT);
+	if (v&0x40)
+		OPL->op.vib |= 1 << slot;
+	else
+		OPL->op.vib &= ~(1 << slot);
+	OPL->op.AMmask[slot&1][slot/2] = (v&0x80) ? ~0 : 0;
+	CALC_FCSLOT(OPL,slot/2,slot&1);
 }
 
 /* set ksl & tl */
@@ -1493,7 +1611,7 @@ INLINE void set_ksl_tl(FM_OPL *OPL,int slot,int v)
 	SLOT->ksl = ksl_shift[v >> 6];
 	SLOT->TL  = (v&0x3f)<<(ENV_BITS-1-7); /* 7 bits TL (bit 6 = always 0) */
 
-	SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+	OPL->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 }
 
 /* set attack rate & decay rate  */
@@ -1702,8 +1820,8 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 				/* BD key on/off */
 				if(v&0x10)
 				{
-					FM_KEYON (&OPL->P_CH[6].SLOT[SLOT1], 2);
-					FM_KEYON (&OPL->P_CH[6].SLOT[SLOT2], 2);
+					FM_KEYON (OPL, 6, SLOT1, 2);
+					FM_KEYON (OPL, 6, SLOT2, 2);
 				}
 				else
 				{
@@ -1711,16 +1829,16 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 					FM_KEYOFF(&OPL->P_CH[6].SLOT[SLOT2],~2);
 				}
 				/* HH key on/off */
-				if(v&0x01) FM_KEYON (&OPL->P_CH[7].SLOT[SLOT1], 2);
+				if(v&0x01) FM_KEYON (OPL, 7, SLOT1, 2);
 				else       FM_KEYOFF(&OPL->P_CH[7].SLOT[SLOT1],~2);
 				/* SD key on/off */
-				if(v&0x08) FM_KEYON (&OPL->P_CH[7].SLOT[SLOT2], 2);
+				if(v&0x08) FM_KEYON (OPL, 7, SLOT2, 2);
 				else       FM_KEYOFF(&OPL->P_CH[7].SLOT[SLOT2],~2);
 				/* TOM key on/off */
-				if(v&0x04) FM_KEYON (&OPL->P_CH[8].SLOT[SLOT1], 2);
+				if(v&0x04) FM_KEYON (OPL, 8, SLOT1, 2);
 				else       FM_KEYOFF(&OPL->P_CH[8].SLOT[SLOT1],~2);
 				/* TOP-CY key on/off */
-				if(v&0x02) FM_KEYON (&OPL->P_CH[8].SLOT[SLOT2], 2);
+				if(v&0x02) FM_KEYON (OPL, 8, SLOT2, 2);
 				else       FM_KEYOFF(&OPL->P_CH[8].SLOT[SLOT2],~2);
 			}
 			else
@@ -1752,8 +1870,8 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 
 			if(v&0x20)
 			{
-				FM_KEYON (&CH->SLOT[SLOT1], 1);
-				FM_KEYON (&CH->SLOT[SLOT2], 1);
+				FM_KEYON (OPL, r&0x0f, SLOT1, 1);
+				FM_KEYON (OPL, r&0x0f, SLOT2, 1);
 			}
 			else
 			{
@@ -1783,21 +1901,19 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 				CH->kcode |= (CH->block_fnum&0x200)>>9;	/* notesel == 0 */
 
 			/* refresh Total Level in both SLOTs of this channel */
-			CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-			CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+			OPL->op.TLL[SLOT1][r&0x0f] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+			OPL->op.TLL[SLOT2][r&0x0f] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
 
 			/* refresh frequency counter in both SLOTs of this channel */
-			CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-			CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
+			CALC_FCSLOT(OPL,r&0x0f,SLOT1);
+			CALC_FCSLOT(OPL,r&0x0f,SLOT2);
 		}
 		break;
 	case 0xc0:
 		/* FB,C */
 		if( (r&0x0f) > 8) return;
-		CH = &OPL->P_CH[r&0x0f];
-		CH->SLOT[SLOT1].FB  = (v>>1)&7 ? ((v>>1)&7) + 7 : 0;
-		CH->SLOT[SLOT1].CON = v&1;
-		CH->SLOT[SLOT1].connect1 = CH->SLOT[SLOT1].CON ? &OPL->output[0] : &OPL->phase_modulation;
+		OPL->op.FB[r&0x0f]  = (v>>1)&7 ? ((v>>1)&7) + 7 : 0;
+		OPL->op.CON[r&0x0f] = v&1;
 		break;
 	case 0xe0: /* waveform select */
 		/* simply ignore write to the waveform select register if selecting not enabled in test register */
@@ -1805,9 +1921,7 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 		{
 			slot = slot_array[r&0x1f];
 			if(slot < 0) return;
-			CH = &OPL->P_CH[slot/2];
-
-			CH->SLOT[slot&1].wavetable = (v&0x03)*SIN_LEN;
+			OPL->op.wavetable[slot&1][slot/2] = (v&0x03)*SIN_LEN;
 		}
 		break;
 	}
@@ -1824,17 +1938,20 @@ static void OPLWriteReg(FM_OPL *OPL, int r, int v)
 /* lock/unlock for common table */
 static int OPL_LockTable(void)
 {
+	pthread_mutex_lock(&num_lock_mutex);
 	num_lock++;
-	if(num_lock>1) return 0;
+	if(num_lock>1)
+	{
+		pthread_mutex_unlock(&num_lock_mutex);
+		return 0;
+	}
 
 	/* first time */
 
-	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
+	/* the total level and sin tables are static const (gentables.c) */
+#ifdef SAVE_SAMPLE
+	sample[0]=fopen("sampsum.pcm","wb");
+#endif
 
 	/*if (LOG_CYM_FILE)
 	{
@@ -1845,17 +1962,24 @@ static int OPL_LockTable(void)
 			logerror("Could not create file 3812_.cym\n");
 	}*/
 
+	pthread_mutex_unlock(&num_lock_mutex);
 	return 0;
 }
 
 static void OPL_UnLockTable(void)
 {
+	pthread_mutex_lock(&num_lock_mutex);
 	if(num_lock) num_lock--;
-	if(num_lock) return;
+	if(num_lock)
+	{
+		pthread_mutex_unlock(&num_lock_mutex);
+		return;
+	}
 
 	/* last time */
 
 	OPLCloseTable();
+	pthread_mutex_unlock(&num_lock_mutex);
 
 	/*if (cymfile)
 		fclose (cymfile);
@@ -1888,9 +2012,9 @@ static void OPLResetChip(FM_OPL *OPL)
 		for(s = 0 ; s < 2 ; s++ )
 		{
 			/* wave table */
-			CH->SLOT[s].wavetable = 0;
-			CH->SLOT[s].state     = EG_OFF;
-			CH->SLOT[s].volume    = MAX_ATT_INDEX;
+			OPL->op.wavetable[s][c] = 0;
+			CH->SLOT[s].state       = EG_OFF;
+			OPL->op.volume[s][c]    = MAX_ATT_INDEX;
 		}
 	}
 #if BUILD_Y8950
@@ -1948,13 +2072,10 @@ static void OPL_postload(void* param)
 			SLOT->eg_sel_rr = eg_rate_select[SLOT->rr + SLOT->ksr ];
 
 			/* Calculate phase increment */
-			SLOT->Incr = CH->fc * SLOT->mul;
+			OPL->op.Incr[slot][ch] = CH->fc * SLOT->mul;
 
 			/* Total level */
-			SLOT->TLL = SLOT->TL + (CH->ksl_base >> SLOT->ksl);
-
-			/* Connect output */
-			SLOT->connect1 = SLOT->CON ? &OPL->output[0] : &OPL->phase_modulation;
+			OPL->op.TLL[slot][ch] = SLOT->TL + (CH->ksl_base >> SLOT->ksl);
 		}
 	}
 #if BUILD_Y8950
@@ -2002,7 +2123,6 @@ static void OPLsave_state_channel(OPL_CH *CH)
 			state_save_register_device_item(device, ch * 2 + slot, SLOT->key);
 
 			state_save_register_device_item(device, ch * 2 + slot, SLOT->AMmask);
-			state_save_register_device_item(device, ch * 2 + slot, SLOT->vib);
 
 			state_save_register_device_item(device, ch * 2 + slot, SLOT->wavetable);
 		}
@@ -2106,6 +2226,12 @@ static FM_OPL *OPLCreate(UINT32 clock, UINT32 rate, int type)
 	/* init global tables */
 	OPL_initalize(OPL);
 
+	OPL_CALC_CHANNELS = OPL_CALC_CHANNELS_C;
+#ifdef OPL_AVX2
+	if (SimdLevel >= SIMD_AVX2)
+		OPL_CALC_CHANNELS = OPL_CALC_CHANNELS_AVX2;
+#endif
+
 	return OPL;
 }
 
@@ -2221,10 +2347,12 @@ static unsigned char OPLRead(FM_OPL *OPL,int a)
 }
 
 /* CSM Key Controll */
-INLINE void CSMKeyControll(OPL_CH *CH)
+INLINE void CSMKeyControll(FM_OPL *OPL, int c)
 {
-	FM_KEYON (&CH->SLOT[SLOT1], 4);
-	FM_KEYON (&CH->SLOT[SLOT2], 4);
+	OPL_CH *CH = &OPL->P_CH[c];
+
+	FM_KEYON (OPL, c, SLOT1, 4);
+	FM_KEYON (OPL, c, SLOT2, 4);
 
 	/* The key off should happen exactly one sample later - not implemented correctly yet */
 
@@ -2248,7 +2376,7 @@ static int OPLTimerOver(FM_OPL *OPL,int c)
 			int ch;
 			if(OPL->UpdateHandler) OPL->UpdateHandler(OPL->UpdateParam/*,0*/);
 			for(ch=0; ch<9; ch++)
-				CSMKeyControll( &OPL->P_CH[ch] );
+				CSMKeyControll( OPL, ch );
 		}
 	}
 	/* reload timer */
@@ -2334,6 +2462,7 @@ void ym3812_update_one(void *chip, OPLSAMPLE **buffer, int length)
 	UINT8		rhythm = OPL->rhythm&0x20;
 	OPLSAMPLE	*bufL = buffer[0];
 	OPLSAMPLE	*bufR = buffer[1];
+	UINT32		active;
 	int i;
 
 	if (! length)
@@ -2342,6 +2471,16 @@ void ym3812_update_one(void *chip, OPLSAMPLE **buffer, int length)
 		return;
 	}
 	
+	active = OPL_active_channels(OPL);
+	if (! active)
+	{
+		/* nothing to calculate, the chip is silent */
+		memset(bufL, 0x00, length * sizeof(OPLSAMPLE));
+		memset(bufR, 0x00, length * sizeof(OPLSAMPLE));
+		advance_idle(OPL, length);
+		return;
+	}
+
 	for( i=0; i < length ; i++ )
 	{
 		int lt;
@@ -2351,23 +2490,7 @@ void ym3812_update_one(void *chip, OPLSAMPLE **buffer, int length)
 		advance_lfo(OPL);
 
 		/* FM part */
-		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[2]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[3]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[4]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[5]);
-
-		if(!rhythm)
-		{
-			OPL_CALC_CH(OPL, &OPL->P_CH[6]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[7]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[8]);
-		}
-		else		/* Rhythm part */
-		{
-			OPL_CALC_RH(OPL, &OPL->P_CH[0], (OPL->noise_rng>>0)&1 );
-		}
+		OPL_CALC_ACTIVE(OPL, active, rhythm);
 
 		lt = OPL->output[0];
 
@@ -2469,8 +2592,19 @@ void ym3526_update_one(void *chip, OPLSAMPLE **buffer, int length)
 	UINT8		rhythm = OPL->rhythm&0x20;
 	OPLSAMPLE	*bufL = buffer[0];
 	OPLSAMPLE	*bufR = buffer[1];
+	UINT32		active;
 	int i;
 
+	active = OPL_active_channels(OPL);
+	if (! active && length)
+	{
+		/* nothing to calculate, the chip is silent */
+		memset(bufL, 0x00, length * sizeof(OPLSAMPLE));
+		memset(bufR, 0x00, length * sizeof(OPLSAMPLE));
+		advance_idle(OPL, length);
+		return;
+	}
+
 	for( i=0; i < length ; i++ )
 	{
 		int lt;
@@ -2480,23 +2614,7 @@ void ym3526_update_one(void *chip, OPLSAMPLE **buffer, int length)
 		advance_lfo(OPL);
 
 		/* FM part */
-		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[2]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[3]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[4]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[5]);
-
-		if(!rhythm)
-		{
-			OPL_CALC_CH(OPL, &OPL->P_CH[6]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[7]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[8]);
-		}
-		else		/* Rhythm part */
-		{
-			OPL_CALC_RH(OPL, &OPL->P_CH[0], (OPL->noise_rng>>0)&1 );
-		}
+		OPL_CALC_ACTIVE(OPL, active, rhythm);
 
 		lt = OPL->output[0];
 
@@ -2547,6 +2665,7 @@ void *y8950_init(UINT32 clock, UINT32 rate)
 		Y8950->deltat->memory = NULL;
 		Y8950->deltat->memory_size = 0x00;
 		Y8950->deltat->memory_mask = 0x00;
+		Y8950->deltat->cache = NULL;
 
 		Y8950->deltat->status_set_handler = Y8950_deltat_status_set;
 		Y8950->deltat->status_reset_handler = Y8950_deltat_status_reset;
@@ -2569,6 +2688,7 @@ void y8950_shutdown(void *chip)
 	FM_OPL *Y8950 = (FM_OPL *)chip;
 	
 	free(Y8950->deltat->memory);	Y8950->deltat->memory = NULL;
+	YM_DELTAT_cache_free(Y8950->deltat);
 	
 	/* emulator shutdown */
 	OPLDestroy(Y8950);
@@ -2617,6 +2737,7 @@ void y8950_set_delta_t_memory(void *chip, void * deltat_mem_ptr, int deltat_mem_
 	FM_OPL		*OPL = (FM_OPL *)chip;
 	OPL->deltat->memory = (UINT8 *)(deltat_mem_ptr);
 	OPL->deltat->memory_size = deltat_mem_size;
+	YM_DELTAT_cache_invalidate(OPL->deltat);
 }
 
 void y8950_write_pcmrom(void *chip, offs_t ROMSize, offs_t DataStart,
@@ -2637,6 +2758,7 @@ void y8950_write_pcmrom(void *chip, offs_t ROMSize, offs_t DataStart,
 		DataLength = ROMSize - DataStart;
 	
 	memcpy(Y8950->deltat->memory + DataStart, ROMData, DataLength);
+	YM_DELTAT_cache_invalidate(Y8950->deltat);
 	
 	return;
 }
@@ -2656,6 +2778,17 @@ void y8950_update_one(void *chip, OPLSAMPLE **buffer, int length)
 	YM_DELTAT	*DELTAT = OPL->deltat;
 	OPLSAMPLE	*bufL = buffer[0];
 	OPLSAMPLE	*bufR = buffer[1];
+	UINT32		active;
+
+	active = OPL_active_channels(OPL);
+	if (! active && ! (DELTAT->portstate&0x80 && ! OPL->MuteSpc[5]) && length)
+	{
+		/* nothing to calculate, the chip is silent */
+		memset(bufL, 0x00, length * sizeof(OPLSAMPLE));
+		memset(bufR, 0x00, length * sizeof(OPLSAMPLE));
+		advance_idle(OPL, length);
+		return;
+	}
 
 	for( i=0; i < length ; i++ )
 	{
@@ -2671,23 +2804,7 @@ void y8950_update_one(void *chip, OPLSAMPLE **buffer, int length)
 			YM_DELTAT_ADPCM_CALC(DELTAT);
 
 		/* FM part */
-		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[2]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[3]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[4]);
-		OPL_CALC_CH(OPL, &OPL->P_CH[5]);
-
-		if(!rhythm)
-		{
-			OPL_CALC_CH(OPL, &OPL->P_CH[6]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[7]);
-			OPL_CALC_CH(OPL, &OPL->P_CH[8]);
-		}
-		else		/* Rhythm part */
-		{
-			OPL_CALC_RH(OPL, &OPL->P_CH[0], (OPL->noise_rng>>0)&1 );
-		}
+		OPL_CALC_ACTIVE(OPL, active, rhythm);
 
 		lt = OPL->output[0] + (OPL->output_deltat[0]>>11);
 
@@ -2735,10 +2852,65 @@ void opl_set_mute_mask(void *chip, UINT32 MuteMask)
 	FM_OPL *opl = (FM_OPL *)chip;
 	UINT8 CurChn;
 	
-	for (CurChn = 0; CurChn < 9; CurChn ++)
-		opl->P_CH[CurChn].Muted = (MuteMask >> CurChn) & 0x01;
+	opl->MuteChn = MuteMask & 0x1FF;
 	for (CurChn = 0; CurChn < 6; CurChn ++)
 		opl->MuteSpc[CurChn] = (MuteMask >> (9 + CurChn)) & 0x01;
 	
 	return;
 }
+
+/* Chip state snapshots (used by the seek index)
+** 'Data' == NULL returns the required buffer size.
+** The DELTA-T memory is not part of the state, it is only written by data blocks.
+** Neither is its decode cache, which is dropped on a load. */
+UINT32 opl_save_state(void *chip, void *Data)
+{
+	FM_OPL *OPL = (FM_OPL *)chip;
+	UINT32 state_size;
+
+	state_size = sizeof(FM_OPL);
+#if BUILD_Y8950
+	if (OPL->type & OPL_TYPE_ADPCM)
+		state_size += sizeof(YM_DELTAT);
+#endif
+	if (Data != NULL)
+		memcpy(Data, OPL, state_size);
+
+	return state_size;
+}
+
+UINT32 opl_load_state(void *chip, const void *Data)
+{
+	FM_OPL *OPL = (FM_OPL *)chip;
+	UINT32 state_size;
+#if BUILD_Y8950
+	UINT8 *memory = NULL;
+	UINT32 memory_size = 0;
+	UINT32 memory_mask = 0;
+	YM_DELTAT_CACHE *cache = NULL;
+
+	if (OPL->type & OPL_TYPE_ADPCM)
+	{
+		memory = OPL->deltat->memory;
+		memory_size = OPL->deltat->memory_size;
+		memory_mask = OPL->deltat->memory_mask;
+		cache = OPL->deltat->cache;
+	}
+#endif
+
+	state_size = opl_save_state(chip, NULL);
+	memcpy(OPL, Data, state_size);
+
+#if BUILD_Y8950
+	if (OPL->type & OPL_TYPE_ADPCM)
+	{
+		OPL->deltat->memory = memory;
+		OPL->deltat->memory_size = memory_size;
+		OPL->deltat->memory_mask = memory_mask;
+		OPL->deltat->cache = cache;
+		YM_DELTAT_cache_invalidate(OPL->deltat);	/* the play position changed */
+	}
+#endif
+
+	return state_size;
+}
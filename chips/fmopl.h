@@ -119,4 +119,6 @@ void y8950_set_update_handler(void *chip, OPL_UPDATEHANDLER UpdateHandler, void
 #endif /* BUILD_Y8950 */
 
 void opl_set_mute_mask(void *chip, UINT32 MuteMask);
+UINT32 opl_save_state(void *chip, void *Data);
+UINT32 opl_load_state(void *chip, const void *Data);
 
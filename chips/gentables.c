@@ -0,0 +1,393 @@
+/*
+**
+** gentables.c - build-time generator for the FM cores' lookup tables
+**
+** The total level, sinus and key scale tables of fmopl.c, ymf262.c, ym2151.c
+** and emu2413.c depend on neither the clock nor the sample rate. They used to
+** be computed at chip start; the Makefile now runs
+**
+**     gentables <core> > <core>_tables.h
+**
+** on the host and the cores include the result as static const arrays, which
+** end up in .rodata and are shared by every process using the player.
+**
+** The generator is linked against minilibm.c, the same sin/pow/log the cores
+** were linked with, so the values are exactly those computed at run time before.
+**
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI	3.14159265358979323846
+#endif
+
+/* common to the MAME cores (fmopl.c, ymf262.c, ym2151.c) */
+#define ENV_BITS		10
+#define ENV_LEN			(1<<ENV_BITS)
+#define ENV_STEP		(128.0/ENV_LEN)
+
+#define SIN_BITS		10
+#define SIN_LEN			(1<<SIN_BITS)
+#define SIN_MASK		(SIN_LEN-1)
+
+#define TL_RES_LEN		(256)	/* 8 bits addressing (real chip) */
+
+/* largest table: ymf262/ym2151 have 13 amplitude bits, fmopl 12 */
+#define TL_TAB_MAX		(13*2*TL_RES_LEN)
+
+static signed int tl_tab[TL_TAB_MAX];
+static unsigned int sin_tab[SIN_LEN * 8];
+
+
+/* prints 'len' values as rows of 16, or as nested rows of 'inner' values
+   ('inner2' of those per outer row) for the multi-dimensional emu2413 tables */
+static void print_values(const long *data, int len, int inner, int inner2)
+{
+	int i;
+
+	for (i=0; i<len; i++)
+	{
+		if (inner)
+		{
+			if (inner2 && (i % (inner*inner2)) == 0)
+				printf("\t{\n");
+			printf("%s%s%ld", (i % inner) ? "" : (inner2 ? "\t\t{" : "\t{"), (i % inner) ? ", " : "", data[i]);
+			if ((i % inner) == inner-1)
+				printf("},\n");
+			if (inner2 && (i % (inner*inner2)) == inner*inner2-1)
+				printf("\t},\n");
+		}
+		else
+			printf("%s%ld,%s", (i&15) ? " " : "\t", data[i], ((i&15)==15 || i==len-1) ? "\n" : "");
+	}
+}
+
+static void print_table(const char *decl, const char *name, const char *size,
+						const long *data, int len)
+{
+	printf("static const %s %s[%s] = {\n", decl, name, size);
+	print_values(data, len, 0, 0);
+	printf("};\n\n");
+}
+
+static void print_int_table(const char *decl, const char *name, const char *size,
+							const signed int *data, int len)
+{
+	static long buf[TL_TAB_MAX];
+	int i;
+
+	for (i=0; i<len; i++)
+		buf[i] = data[i];
+	print_table(decl, name, size, buf, len);
+}
+
+static void print_uint_table(const char *decl, const char *name, const char *size,
+							 const unsigned int *data, int len)
+{
+	static long buf[SIN_LEN * 8];
+	int i;
+
+	for (i=0; i<len; i++)
+		buf[i] = data[i];
+	print_table(decl, name, size, buf, len);
+}
+
+
+/* total level table: 'ampl_bits' shifts of the 11-bit rounded exponential,
+   'shift' aligns it (1 for the OPL chips, 2 for the OPM), 'inv' selects ~x
+   instead of -x for the negative entries (YMF262) */
+static int make_tl_tab(int ampl_bits, int shift, int inv)
+{
+	signed int i,x;
+	signed int n;
+	double m;
+
+	for (x=0; x<TL_RES_LEN; x++)
+	{
+		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
+		m = floor(m);
+
+		/* we never reach (1<<16) here due to the (x+1) */
+		/* result fits within 16 bits at maximum */
+
+		n = (int)m;		/* 16 bits here */
+		n >>= 4;		/* 12 bits here */
+		if (n&1)		/* round to nearest */
+			n = (n>>1)+1;
+		else
+			n = n>>1;
+						/* 11 bits here (rounded) */
+		n <<= shift;	/* 12 or 13 bits here (as in real chip) */
+		tl_tab[ x*2 + 0 ] = n;
+		tl_tab[ x*2 + 1 ] = inv ? ~n : -n;
+
+		for (i=1; i<ampl_bits; i++)
+		{
+			n = tl_tab[ x*2+0 ]>>i;
+			tl_tab[ x*2+0 + i*2*TL_RES_LEN ] = n;
+			tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = inv ? ~n : -n;
+		}
+	}
+
+	return ampl_bits*2*TL_RES_LEN;
+}
+
+/* waveform 0 in 'decibel' scale */
+static void make_sin_tab(void)
+{
+	signed int i;
+	signed int n;
+	double o,m;
+
+	for (i=0; i<SIN_LEN; i++)
+	{
+		/* non-standard sinus */
+		m = sin( ((i*2)+1) * M_PI / SIN_LEN ); /* checked against the real chip */
+
+		/* we never reach zero here due to ((i*2)+1) */
+
+		if (m>0.0)
+			o = 8*log(1.0/m)/log(2.0);	/* convert to 'decibels' */
+		else
+			o = 8*log(-1.0/m)/log(2.0);	/* convert to 'decibels' */
+
+		o = o / (ENV_STEP/4);
+
+		n = (int)(2.0*o);
+		if (n&1)						/* round to nearest */
+			n = (n>>1)+1;
+		else
+			n = n>>1;
+
+		sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
+	}
+}
+
+/* OPL2 waveforms 1-3 and, with 'opl3', the YMF262 waveforms 4-7 */
+static void make_opl_waves(int tl_tab_len, int opl3)
+{
+	signed int i,x;
+
+	for (i=0; i<SIN_LEN; i++)
+	{
+		/* waveform 1:  __      __     */
+		/*             /  \____/  \____*/
+		/* output only first half of the sinus waveform (positive one) */
+
+		if (i & (1<<(SIN_BITS-1)) )
+			sin_tab[1*SIN_LEN+i] = tl_tab_len;
+		else
+			sin_tab[1*SIN_LEN+i] = sin_tab[i];
+
+		/* waveform 2:  __  __  __  __ */
+		/*             /  \/  \/  \/  \*/
+		/* abs(sin) */
+
+		sin_tab[2*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>1) ];
+
+		/* waveform 3:  _   _   _   _  */
+		/*             / |_/ |_/ |_/ |_*/
+		/* abs(output only first quarter of the sinus waveform) */
+
+		if (i & (1<<(SIN_BITS-2)) )
+			sin_tab[3*SIN_LEN+i] = tl_tab_len;
+		else
+			sin_tab[3*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>2)];
+
+		if (!opl3)
+			continue;
+
+		/* waveform 4:                 */
+		/*             /\  ____/\  ____*/
+		/*               \/      \/    */
+		/* output whole sinus waveform in half the cycle(step=2) and output 0 on the other half of cycle */
+
+		if (i & (1<<(SIN_BITS-1)) )
+			sin_tab[4*SIN_LEN+i] = tl_tab_len;
+		else
+			sin_tab[4*SIN_LEN+i] = sin_tab[i*2];
+
+		/* waveform 5:                 */
+		/*             /\/\____/\/\____*/
+		/*                             */
+		/* output abs(whole sinus) waveform in half the cycle(step=2) and output 0 on the other half of cycle */
+
+		if (i & (1<<(SIN_BITS-1)) )
+			sin_tab[5*SIN_LEN+i] = tl_tab_len;
+		else
+			sin_tab[5*SIN_LEN+i] = sin_tab[(i*2) & (SIN_MASK>>1) ];
+
+		/* waveform 6: ____    ____    */
+		/*                             */
+		/*                 ____    ____*/
+		/* output maximum in half the cycle and output minimum on the other half of cycle */
+
+		if (i & (1<<(SIN_BITS-1)) )
+			sin_tab[6*SIN_LEN+i] = 1;	/* negative */
+		else
+			sin_tab[6*SIN_LEN+i] = 0;	/* positive */
+
+		/* waveform 7:                 */
+		/*             |\____  |\____  */
+		/*                   \|      \|*/
+		/* output sawtooth waveform    */
+
+		if (i & (1<<(SIN_BITS-1)) )
+			x = ((SIN_LEN-1)-i)*16 + 1;	/* negative: from 8177 to 1 */
+		else
+			x = i*16;	/*positive: from 0 to 8176 */
+
+		if (x > tl_tab_len)
+			x = tl_tab_len;	/* clip to the allowed range */
+
+		sin_tab[7*SIN_LEN+i] = x;
+	}
+}
+
+
+static void gen_fmopl(void)
+{
+	int len;
+
+	len = make_tl_tab(12, 1, 0);
+	make_sin_tab();
+	make_opl_waves(len, 0);
+
+	print_int_table("signed int", "tl_tab", "TL_TAB_LEN", tl_tab, len);
+	print_uint_table("unsigned int", "sin_tab", "SIN_LEN * 4", sin_tab, SIN_LEN * 4);
+}
+
+static void gen_ymf262(void)
+{
+	int len;
+
+	len = make_tl_tab(13, 1, 1);	/* ~x *is* different from OPL2 (verified on real YMF262) */
+	make_sin_tab();
+	make_opl_waves(len, 1);
+
+	print_int_table("signed int", "tl_tab", "TL_TAB_LEN", tl_tab, len);
+	print_uint_table("unsigned int", "sin_tab", "SIN_LEN * 8", sin_tab, SIN_LEN * 8);
+}
+
+static void gen_ym2151(void)
+{
+	unsigned int d1l_tab[16];
+	double m;
+	int len;
+	int i;
+
+	len = make_tl_tab(13, 2, 0);
+	make_sin_tab();	/* verified on the real chip */
+
+	/* translate from D1L to volume index */
+	for (i=0; i<16; i++)
+	{
+		m = (i!=15 ? i : i+16) * (4.0/ENV_STEP);   /* every 3 'dB' except for all bits = 1 = 45+48 'dB' */
+		d1l_tab[i] = m;
+	}
+
+	print_int_table("signed int", "tl_tab", "TL_TAB_LEN", tl_tab, len);
+	print_uint_table("unsigned int", "sin_tab", "SIN_LEN", sin_tab, SIN_LEN);
+	print_uint_table("UINT32", "d1l_tab", "16", d1l_tab, 16);
+}
+
+
+/* emu2413 */
+#define PG_BITS 10
+#define PG_WIDTH (1 << PG_BITS)
+#define EG_STEP 0.375
+#define TL_BITS 6
+#define TL2EG(d) ((d) << 1)
+
+#define dB2(x) ((x) * 2)
+static const double kl_table[16] = {
+	dB2(0.000),  dB2(9.000),  dB2(12.000), dB2(13.875),
+	dB2(15.000), dB2(16.125), dB2(16.875), dB2(17.625),
+	dB2(18.000), dB2(18.750), dB2(19.125), dB2(19.500),
+	dB2(19.875), dB2(20.250), dB2(20.625), dB2(21.000)};
+
+static void gen_emu2413(void)
+{
+	static long tll_table[8 * 16][1 << TL_BITS][4];
+	long fullsin_table[PG_WIDTH];
+	long halfsin_table[PG_WIDTH];
+	long rks_table[8 * 2][2];
+	int x;
+	int fnum, block, TL, KL, fnum8;
+	int tmp;
+
+	/* fullsin_table[x] = round(-log2(sin((x + 0.5) * PI / (PG_WIDTH / 4) / 2)) * 256) */
+	for (x = 0; x < PG_WIDTH / 4; x++)
+		fullsin_table[x] = (long)floor(-log(sin((x + 0.5) * M_PI / (PG_WIDTH / 4) / 2)) / log(2.0) * 256 + 0.5);
+
+	for (x = 0; x < PG_WIDTH / 4; x++)
+		fullsin_table[PG_WIDTH / 4 + x] = fullsin_table[PG_WIDTH / 4 - x - 1];
+
+	for (x = 0; x < PG_WIDTH / 2; x++)
+		fullsin_table[PG_WIDTH / 2 + x] = 0x8000 | fullsin_table[x];
+
+	for (x = 0; x < PG_WIDTH / 2; x++)
+		halfsin_table[x] = fullsin_table[x];
+
+	for (x = PG_WIDTH / 2; x < PG_WIDTH; x++)
+		halfsin_table[x] = 0xfff;
+
+	for (fnum = 0; fnum < 16; fnum++) {
+		for (block = 0; block < 8; block++) {
+			for (TL = 0; TL < 64; TL++) {
+				for (KL = 0; KL < 4; KL++) {
+					if (KL == 0) {
+						tll_table[(block << 4) | fnum][TL][KL] = TL2EG(TL);
+					} else {
+						tmp = (int)(kl_table[fnum] - dB2(3.000) * (7 - block));
+						if (tmp <= 0)
+							tll_table[(block << 4) | fnum][TL][KL] = TL2EG(TL);
+						else
+							tll_table[(block << 4) | fnum][TL][KL] =
+								(unsigned int)((tmp >> (3 - KL)) / EG_STEP) + TL2EG(TL);
+					}
+				}
+			}
+		}
+	}
+
+	for (fnum8 = 0; fnum8 < 2; fnum8++)
+		for (block = 0; block < 8; block++) {
+			rks_table[(block << 1) | fnum8][1] = (block << 1) + fnum8;
+			rks_table[(block << 1) | fnum8][0] = block >> 1;
+		}
+
+	print_table("uint16_t", "fullsin_table", "PG_WIDTH", fullsin_table, PG_WIDTH);
+	print_table("uint16_t", "halfsin_table", "PG_WIDTH", halfsin_table, PG_WIDTH);
+
+	printf("static const uint32_t tll_table[8 * 16][1 << TL_BITS][4] = {\n");
+	print_values(&tll_table[0][0][0], 8 * 16 * (1 << TL_BITS) * 4, 4, 1 << TL_BITS);
+	printf("};\n\n");
+
+	printf("static const int32_t rks_table[8 * 2][2] = {\n");
+	print_values(&rks_table[0][0], 8 * 2 * 2, 2, 0);
+	printf("};\n\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc == 2 && !strcmp(argv[1], "fmopl"))
+		gen_fmopl();
+	else if (argc == 2 && !strcmp(argv[1], "ymf262"))
+		gen_ymf262();
+	else if (argc == 2 && !strcmp(argv[1], "ym2151"))
+		gen_ym2151();
+	else if (argc == 2 && !strcmp(argv[1], "emu2413"))
+		gen_emu2413();
+	else
+	{
+		fprintf(stderr, "usage: %s fmopl|ymf262|ym2151|emu2413\n", argv[0]);
+		return 1;
+	}
+
+	return 0;
+}
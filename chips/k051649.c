@@ -29,13 +29,20 @@
 //#include "streams.h"
 #include "k051649.h"
 
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__clang__)
+// the AVX2 kernel is compiled per function and selected at runtime
+#define SCC_AVX2
+#include <immintrin.h>
+#endif
+
 #define FREQ_BITS	16
 #define DEF_GAIN	8
+#define VOICES		5
 
 /* this structure defines the parameters for a channel */
 typedef struct
 {
-	unsigned long counter;
+	UINT32 counter;
 	int frequency;
 	int volume;
 	int key;
@@ -52,17 +59,11 @@ struct _k051649_state
 	//sound_stream * stream;
 	int mclock,rate;
 
-	/* mixer tables and internal buffers */
-	INT16 *mixer_table;
-	INT16 *mixer_lookup;
-	short *mixer_buffer;
-
 	int cur_reg;
 	UINT8 test;
 };
 
-#define MAX_CHIPS	0x02
-static k051649_state SCC1Data[MAX_CHIPS];
+extern UINT8 SimdLevel;
 
 /*INLINE k051649_state *get_safe_token(running_device *device)
 {
@@ -71,92 +72,150 @@ static k051649_state SCC1Data[MAX_CHIPS];
 	return (k051649_state *)downcast<legacy_device_base *>(device)->token();
 }*/
 
-/* build a table to divide by the number of voices */
-static void make_mixer_table(/*running_machine *machine,*/ k051649_state *info, int voices)
+/* the voices that are rendered in one k051649_update call */
+typedef struct
 {
-	int count = voices * 256;
-	int i;
+	UINT8 count;
+	INT32 wave[VOICES][32];	/* waveram * volume, as added to the mix */
+	UINT32 counter[VOICES];
+	UINT32 step[VOICES];
+} k051649_voice_block;
+
+typedef void (*k051649_render_func)(INT32 *buffer, int samples, k051649_voice_block *vb);
+
+/* The mix of all 5 voices used to go through a table holding
+   i * DEF_GAIN * 16 / 5 (truncated towards zero); this is the same. */
+#define MIX_GAIN(x)	((x) * DEF_GAIN * 16 / VOICES)
+
+static void k051649_render_C(INT32 *buffer, int samples, k051649_voice_block *vb)
+{
+	int i, j;
+
+	memset(buffer, 0, samples * sizeof(INT32));
+	for (j = 0; j < vb->count; j++)
+	{
+		const INT32 *w = vb->wave[j];
+		UINT32 c = vb->counter[j];
+		UINT32 step = vb->step[j];
+
+		for (i = 0; i < samples; i++)
+		{
+			c += step;
+			buffer[i] += w[(c >> FREQ_BITS) & 0x1f];
+		}
+		vb->counter[j] = c;
+	}
 
-	/* allocate memory */
-	//info->mixer_table = auto_alloc_array(machine, INT16, 512 * voices);
-	info->mixer_table = (INT16*)malloc(sizeof(INT16) * 2 * count);
+	for (i = 0; i < samples; i++)
+		buffer[i] = MIX_GAIN(buffer[i]);
+}
 
-	/* find the middle of the table */
-	info->mixer_lookup = info->mixer_table + count;
+#ifdef SCC_AVX2
+/* 8 samples per pass, each lane running its own copy of the voice counters;
+   the wave samples are gathered and the voices summed in registers. */
+__attribute__((target("avx2")))
+static void k051649_render_AVX2(INT32 *buffer, int samples, k051649_voice_block *vb)
+{
+	const __m256i lane = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+	const __m256i mask = _mm256_set1_epi32(0x1f);
+	const __m256 gain_div = _mm256_set1_ps((float)VOICES);
+	__m256i cnt[VOICES];
+	__m256i inc[VOICES];
+	__m256i acc, idx;
+	int i, j;
+
+	for (j = 0; j < vb->count; j++)
+	{
+		cnt[j] = _mm256_add_epi32(_mm256_set1_epi32(vb->counter[j]),
+					_mm256_mullo_epi32(_mm256_set1_epi32(vb->step[j]), lane));
+		inc[j] = _mm256_set1_epi32(vb->step[j] * 8);
+	}
 
-	/* fill in the table - 16 bit case */
-	for (i = 0; i < count; i++)
+	for (i = 0; i + 8 <= samples; i += 8)
 	{
-		int val = i * DEF_GAIN * 16 / voices;
-		//if (val > 32767) val = 32767;
-		if (val > 32768) val = 32768;
-		info->mixer_lookup[ i] = val;
-		info->mixer_lookup[-i] = -val;
+		acc = _mm256_setzero_si256();
+		for (j = 0; j < vb->count; j++)
+		{
+			idx = _mm256_and_si256(_mm256_srli_epi32(cnt[j], FREQ_BITS), mask);
+			acc = _mm256_add_epi32(acc,
+					_mm256_i32gather_epi32((const int *)vb->wave[j], idx, 4));
+			cnt[j] = _mm256_add_epi32(cnt[j], inc[j]);
+		}
+		// exact: the quotient never lies within float rounding of an integer
+		acc = _mm256_slli_epi32(acc, 7);	// DEF_GAIN * 16
+		acc = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(acc), gain_div));
+		_mm256_storeu_si256((__m256i *)&buffer[i], acc);
 	}
+	_mm256_zeroupper();
+
+	for (j = 0; j < vb->count; j++)
+		vb->counter[j] += vb->step[j] * i;
+	k051649_render_C(&buffer[i], samples - i, vb);
 }
+#endif
+
+static k051649_render_func k051649_render = k051649_render_C;
 
 
 /* generate sound to the mix buffer */
 //static STREAM_UPDATE( k051649_update )
-void k051649_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
+// outputs[1] may be NULL to request mono output
+void k051649_update(void *param, stream_sample_t **outputs, int samples)
 {
-	//k051649_state *info = (k051649_state *)param;
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	k051649_sound_channel *voice=info->channel_list;
-	stream_sample_t *buffer = outputs[0];
-	stream_sample_t *buffer2 = outputs[1];
-	short *mix;
+	k051649_voice_block vb;
+	UINT8 vch[VOICES];
 	int i,j;
 
-	// zap the contents of the mixer buffer
-	memset(info->mixer_buffer, 0, samples * sizeof(short));
-
+	vb.count = 0;
 	for (j=0; j<5; j++) {
 		// channel is halted for freq < 9
 		if (voice[j].frequency > 8 && ! voice[j].Muted)
 		{
 			const signed char *w = voice[j].waveram;			/* 19991207.CAB */
 			int v=voice[j].volume * voice[j].key;
-			int c=voice[j].counter;
 			/* Amuse source:  Cab suggests this method gives greater resolution */
 			/* Sean Young 20010417: the formula is really: f = clock/(16*(f+1))*/
 			INT64 denominator = (INT64)(voice[j].frequency + 1) * 16 * (info->rate / 32);
 			int step = (int)((((INT64)info->mclock * (1 << FREQ_BITS)) + (denominator / 2)) / denominator);
 
-			mix = info->mixer_buffer;
-
-			// add our contribution
-			for (i = 0; i < samples; i++)
+			if (! v)
 			{
-				int offs;
-
-				c += step;
-				offs = (c >> FREQ_BITS) & 0x1f;
-				*mix++ += (w[offs] * v)>>3;
+				// silent, only the counter moves on
+				voice[j].counter += (UINT32)step * samples;
+				continue;
 			}
-
-			// update the counter for this voice
-			voice[j].counter = c;
+			for (i = 0; i < 32; i++)
+				vb.wave[vb.count][i] = (w[i] * v)>>3;
+			vb.counter[vb.count] = voice[j].counter;
+			vb.step[vb.count] = step;
+			vch[vb.count] = j;
+			vb.count++;
 		}
 	}
 
-	// mix it down
-	mix = info->mixer_buffer;
-	for (i = 0; i < samples; i++)
-		*buffer++ = *buffer2++ = info->mixer_lookup[*mix++];
+	k051649_render(outputs[0], samples, &vb);
+
+	// update the counters of the rendered voices
+	for (j = 0; j < vb.count; j++)
+		voice[vch[j]].counter = vb.counter[j];
+
+	if (outputs[1] != NULL)
+		memcpy(outputs[1], outputs[0], samples * sizeof(stream_sample_t));
 }
 
 //static DEVICE_START( k051649 )
-int device_start_k051649(UINT8 ChipID, int clock)
+int device_start_k051649(void **param, int clock)
 {
 	//k051649_state *info = get_safe_token(device);
 	k051649_state *info;
 	UINT8 CurChn;
 
-	if (ChipID >= MAX_CHIPS)
+	info = (k051649_state *)calloc(1, sizeof(k051649_state));
+	if (info == NULL)
 		return 0;
-	
-	info = &SCC1Data[ChipID];
+	*param = info;
 	/* get stream channels */
 	//info->rate = device->clock()/16;
 	//info->stream = stream_create(device, 0, 1, info->rate, info, k051649_update);
@@ -164,13 +223,11 @@ int device_start_k051649(UINT8 ChipID, int clock)
 	info->mclock = clock & 0x7FFFFFFF;
 	info->rate = info->mclock / 16;
 
-	/* allocate a buffer to mix into - 1 second's worth should be more than enough */
-	//info->mixer_buffer = auto_alloc_array(device->machine, short, 2 * info->rate);
-	info->mixer_buffer = (short*)malloc(sizeof(short) * info->rate);
-
-	/* build the mixer table */
-	//make_mixer_table(device->machine, info, 5);
-	make_mixer_table(info, 5);
+	k051649_render = k051649_render_C;
+#ifdef SCC_AVX2
+	if (SimdLevel >= SIMD_AVX2)
+		k051649_render = k051649_render_AVX2;
+#endif
 	
 	for (CurChn = 0; CurChn < 5; CurChn ++)
 		info->channel_list[CurChn].Muted = 0x00;
@@ -178,21 +235,18 @@ int device_start_k051649(UINT8 ChipID, int clock)
 	return info->rate;
 }
 
-void device_stop_k051649(UINT8 ChipID)
+void device_stop_k051649(void *param)
 {
-	k051649_state *info = &SCC1Data[ChipID];
-	
-	free(info->mixer_buffer);
-	free(info->mixer_table);
+	free(param);
 	
 	return;
 }
 
 //static DEVICE_RESET( k051649 )
-void device_reset_k051649(UINT8 ChipID)
+void device_reset_k051649(void *param)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	k051649_sound_channel *voice = info->channel_list;
 	int i;
 
@@ -212,13 +266,30 @@ void device_reset_k051649(UINT8 ChipID)
 	return;
 }
 
+UINT32 device_save_state_k051649(void *param, void *Data)
+{
+	k051649_state *info = (k051649_state *)param;
+	
+	if (Data != NULL)
+		memcpy(Data, info, sizeof(k051649_state));
+	return sizeof(k051649_state);
+}
+
+UINT32 device_load_state_k051649(void *param, const void *Data)
+{
+	k051649_state *info = (k051649_state *)param;
+	
+	memcpy(info, Data, sizeof(k051649_state));
+	return sizeof(k051649_state);
+}
+
 /********************************************************************************/
 
 //WRITE8_DEVICE_HANDLER( k051649_waveform_w )
-void k051649_waveform_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_waveform_w(void *param, offs_t offset, UINT8 data)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	
 	// waveram is read-only?
 	if (info->test & 0x40 || (info->test & 0x80 && offset >= 0x60))
@@ -237,10 +308,10 @@ void k051649_waveform_w(UINT8 ChipID, offs_t offset, UINT8 data)
 }
 
 //READ8_DEVICE_HANDLER ( k051649_waveform_r )
-UINT8 k051649_waveform_r(UINT8 ChipID, offs_t offset)
+UINT8 k051649_waveform_r(void *param, offs_t offset)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	
 	// test-register bits 6/7 expose the internal counter
 	if (info->test & 0xc0)
@@ -257,24 +328,26 @@ UINT8 k051649_waveform_r(UINT8 ChipID, offs_t offset)
 
 /* SY 20001114: Channel 5 doesn't share the waveform with channel 4 on this chip */
 //WRITE8_DEVICE_HANDLER( k052539_waveform_w )
-void k052539_waveform_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k052539_waveform_w(void *param, offs_t offset, UINT8 data)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	
 	// waveram is read-only?
 	if (info->test & 0x40)
 		return;
+	if ((offset >> 5) >= VOICES)	// no channel behind the register
+		return;
 
 	//stream_update(info->stream);
 	info->channel_list[offset>>5].waveram[offset&0x1f]=data;
 }
 
 //READ8_DEVICE_HANDLER ( k052539_waveform_r )
-UINT8 k052539_waveform_r(UINT8 ChipID, offs_t offset)
+UINT8 k052539_waveform_r(void *param, offs_t offset)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	
 	// test-register bit 6 exposes the internal counter
 	if (info->test & 0x40)
@@ -286,21 +359,26 @@ UINT8 k052539_waveform_r(UINT8 ChipID, offs_t offset)
 }
 
 //WRITE8_DEVICE_HANDLER( k051649_volume_w )
-void k051649_volume_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_volume_w(void *param, offs_t offset, UINT8 data)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
+	if ((offset & 0x7) >= VOICES)	// no channel behind the register
+		return;
 	//stream_update(info->stream);
 	info->channel_list[offset&0x7].volume=data&0xf;
 }
 
 //WRITE8_DEVICE_HANDLER( k051649_frequency_w )
-void k051649_frequency_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_frequency_w(void *param, offs_t offset, UINT8 data)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
-	k051649_sound_channel* chn = &info->channel_list[offset >> 1];
+	k051649_state *info = (k051649_state *)param;
+	k051649_sound_channel* chn;
 
+	if ((offset >> 1) >= VOICES)	// no channel behind the register
+		return;
+	chn = &info->channel_list[offset >> 1];
 	//stream_update(info->stream);
 	
 	// test-register bit 5 resets the internal counter
@@ -318,10 +396,10 @@ void k051649_frequency_w(UINT8 ChipID, offs_t offset, UINT8 data)
 }
 
 //WRITE8_DEVICE_HANDLER( k051649_keyonoff_w )
-void k051649_keyonoff_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_keyonoff_w(void *param, offs_t offset, UINT8 data)
 {
 	//k051649_state *info = get_safe_token(device);
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	int i;
 	//stream_update(info->stream);
 	
@@ -333,25 +411,25 @@ void k051649_keyonoff_w(UINT8 ChipID, offs_t offset, UINT8 data)
 }
 
 //WRITE8_MEMBER( k051649_device::k051649_test_w )
-void k051649_test_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_test_w(void *param, offs_t offset, UINT8 data)
 {
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	info->test = data;
 }
 
 
 //READ8_MEMBER ( k051649_device::k051649_test_r )
-UINT8 k051649_test_r(UINT8 ChipID, offs_t offset)
+UINT8 k051649_test_r(void *param, offs_t offset)
 {
 	// reading the test register sets it to $ff!
-	k051649_test_w(ChipID, offset, 0xff);
+	k051649_test_w(param, offset, 0xff);
 	return 0xff;
 }
 
 
-void k051649_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void k051649_w(void *param, offs_t offset, UINT8 data)
 {
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	
 	switch(offset & 1)
 	{
@@ -362,22 +440,22 @@ void k051649_w(UINT8 ChipID, offs_t offset, UINT8 data)
 		switch(offset >> 1)
 		{
 		case 0x00:
-			k051649_waveform_w(ChipID, info->cur_reg, data);
+			k051649_waveform_w(param, info->cur_reg, data);
 			break;
 		case 0x01:
-			k051649_frequency_w(ChipID, info->cur_reg, data);
+			k051649_frequency_w(param, info->cur_reg, data);
 			break;
 		case 0x02:
-			k051649_volume_w(ChipID, info->cur_reg, data);
+			k051649_volume_w(param, info->cur_reg, data);
 			break;
 		case 0x03:
-			k051649_keyonoff_w(ChipID, info->cur_reg, data);
+			k051649_keyonoff_w(param, info->cur_reg, data);
 			break;
 		case 0x04:
-			k052539_waveform_w(ChipID, info->cur_reg, data);
+			k052539_waveform_w(param, info->cur_reg, data);
 			break;
 		case 0x05:
-			k051649_test_w(ChipID, info->cur_reg, data);
+			k051649_test_w(param, info->cur_reg, data);
 			break;
 		}
 		break;
@@ -387,9 +465,9 @@ void k051649_w(UINT8 ChipID, offs_t offset, UINT8 data)
 }
 
 
-void k051649_set_mute_mask(UINT8 ChipID, UINT32 MuteMask)
+void k051649_set_mute_mask(void *param, UINT32 MuteMask)
 {
-	k051649_state *info = &SCC1Data[ChipID];
+	k051649_state *info = (k051649_state *)param;
 	UINT8 CurChn;
 	
 	for (CurChn = 0; CurChn < 5; CurChn ++)
@@ -28,8 +28,9 @@
  */
 
 #include <math.h>
-#include <stdlib.h> // rand
+#include <stdlib.h> // random_r
 #include <string.h> // for memset
+#include <pthread.h>
 // #include "dosbox.h"
 #include "../VGMSXPlay.h"
 #include "opl.h"
@@ -45,9 +46,8 @@ static Bit32s trem_table[TREMTAB_SIZE * 2];
 static Bit32s vibval_const[BLOCKBUF_SIZE];
 static Bit32s tremval_const[BLOCKBUF_SIZE];
 
-// vibrato value tables (used per-operator)
-static Bit32s vibval_var1[BLOCKBUF_SIZE];
-static Bit32s vibval_var2[BLOCKBUF_SIZE];
+// the tables above are shared by all chips and filled once
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
 
 // key scale level lookup table
 static const fltype kslmul[4] = {
@@ -108,6 +108,13 @@ static fltype attackconst[4] = {(fltype)(1 / 2.82624), (fltype)(1 / 2.25280),
 static fltype decrelconst[4] = {(fltype)(1 / 39.28064), (fltype)(1 / 31.41608),
                                 (fltype)(1 / 26.17344), (fltype)(1 / 22.44608)};
 
+#if defined(OPL_FIXEDPT)
+// amp * k (rounded), amp >= 0, k <= 1.0
+INLINE envtype env_mulhi(envtype amp, multype k) {
+  return (envtype)ENV_ROUND((INT128)amp * k, RATE_FRAC);
+}
+#endif
+
 INLINE void operator_advance(OPL_DATA *chip, op_type *op_pt, Bit32s vib) {
   op_pt->wfpos = op_pt->tcount; // waveform position
 
@@ -127,7 +134,11 @@ INLINE void operator_advance_drums(OPL_DATA *chip, op_type *op_pt1, Bit32s vib1,
       (((c1 & 0x88) ^ ((c1 << 5) & 0x80)) | ((c3 ^ (c3 << 2)) & 0x20)) ? 0x02
                                                                        : 0x00;
 
-  Bit32u noisebit = rand() & 1;
+  int32_t noiseval;
+  Bit32u noisebit;
+
+  random_r(&chip->noise_rng, &noiseval);
+  noisebit = noiseval & 1;
 
   Bit32u snare_phase_bit = (((Bitu)((op_pt1->tcount / FIXEDPT) / 0x100)) & 1);
 
@@ -169,9 +180,23 @@ INLINE void operator_output(op_type *op_pt, Bit32s modulator, Bit32s trem) {
     // step_amp: 0.0 to 1.0
     // vol  : 1/2^14 to 1/2^29 (/0x4000; /1../0x8000)
 
+#if defined(OPL_FIXEDPT)
+    {
+      // envelope * volume in 2^-75 units, wform * trem < 2^30
+      INT64 envvol = (INT64)(((UINT128)op_pt->step_amp * op_pt->vol) >>
+                             (ENV_FRAC + VOL_FRAC - ENVVOL_FRAC));
+      INT128 val =
+          (INT128)envvol * (op_pt->cur_wform[i & op_pt->cur_wmask] * trem);
+      // shift rounding towards zero like the (Bit32s) cast of the double
+      // core, -Os would call a library function for the division
+      val += (val >> 127) & (((INT128)1 << (ENVVOL_FRAC + 4)) - 1);
+      op_pt->cval = (Bit32s)(val >> (ENVVOL_FRAC + 4));
+    }
+#else
     op_pt->cval =
         (Bit32s)(op_pt->step_amp * op_pt->vol *
                  op_pt->cur_wform[i & op_pt->cur_wmask] * trem / 16.0);
+#endif
   }
 }
 
@@ -197,9 +222,9 @@ static void operator_release(op_type *op_pt) {
   Bit32u ct;
 
   // ??? boundary?
-  if (op_pt->amp > 0.00000001) {
+  if (op_pt->amp > ENV_MIN) {
     // release phase
-    op_pt->amp *= op_pt->releasemul;
+    op_pt->amp = ENV_SCALE(op_pt->amp, op_pt->releasemul);
   }
 
   num_steps_add =
@@ -207,9 +232,9 @@ static void operator_release(op_type *op_pt) {
   for (ct = 0; ct < num_steps_add; ct++) {
     op_pt->cur_env_step++; // sample counter
     if ((op_pt->cur_env_step & op_pt->env_step_r) == 0) {
-      if (op_pt->amp <= 0.00000001) {
+      if (op_pt->amp <= ENV_MIN) {
         // release phase finished, turn off this operator
-        op_pt->amp = 0.0;
+        op_pt->amp = 0;
         if (op_pt->op_state == OF_TYPE_REL) {
           op_pt->op_state = OF_TYPE_OFF;
         }
@@ -229,7 +254,7 @@ static void operator_decay(op_type *op_pt) {
 
   if (op_pt->amp > op_pt->sustain_level) {
     // decay phase
-    op_pt->amp *= op_pt->decaymul;
+    op_pt->amp = ENV_SCALE(op_pt->amp, op_pt->decaymul);
   }
 
   num_steps_add =
@@ -260,9 +285,22 @@ static void operator_attack(op_type *op_pt) {
   Bit32u num_steps_add;
   Bit32u ct;
 
+#if defined(OPL_FIXEDPT)
+  if (op_pt->attackmul != ATTACK_INSTANT) {
+    multype g = ATTACK_CONST(7.42);
+    g = ENV_ROUND((INT128)g * op_pt->amp, ENV_FRAC) + ATTACK_CONST(-17.57);
+    g = ENV_ROUND((INT128)g * op_pt->amp, ENV_FRAC) + ATTACK_CONST(10.73);
+    g = ENV_ROUND((INT128)g * op_pt->amp, ENV_FRAC) + ATTACK_CONST(0.0377);
+    op_pt->amp += ENV_ROUND((INT128)op_pt->attackmul * g,
+                            RATE_FRAC + ATTACK_FRAC - ENV_FRAC);
+  } else {
+    op_pt->amp = ENV_CONST(2.0);
+  }
+#else
   op_pt->amp = ((op_pt->a3 * op_pt->amp + op_pt->a2) * op_pt->amp + op_pt->a1) *
                    op_pt->amp +
                op_pt->a0;
+#endif
 
   num_steps_add =
       op_pt->generator_pos / FIXEDPT; // number of (standardized) samples
@@ -270,11 +308,11 @@ static void operator_attack(op_type *op_pt) {
     op_pt->cur_env_step++; // next sample
     if ((op_pt->cur_env_step & op_pt->env_step_a) ==
         0) { // check if next step already reached
-      if (op_pt->amp > 1.0) {
+      if (op_pt->amp > ENV_ONE) {
         // attack phase finished, next: decay
         op_pt->op_state = OF_TYPE_DEC;
-        op_pt->amp = 1.0;
-        op_pt->step_amp = 1.0;
+        op_pt->amp = ENV_ONE;
+        op_pt->step_amp = ENV_ONE;
       }
       op_pt->step_skip_pos_a <<= 1;
       if (op_pt->step_skip_pos_a == 0)
@@ -291,11 +329,15 @@ static void operator_attack(op_type *op_pt) {
 static void operator_eg_attack_check(op_type *op_pt) {
   if (((op_pt->cur_env_step + 1) & op_pt->env_step_a) == 0) {
     // check if next step already reached
+#if defined(OPL_FIXEDPT)
+    if (op_pt->attackmul == ATTACK_INSTANT) {
+#else
     if (op_pt->a0 >= 1.0) {
+#endif
       // attack phase finished, next: decay
       op_pt->op_state = OF_TYPE_DEC;
-      op_pt->amp = 1.0;
-      op_pt->step_amp = 1.0;
+      op_pt->amp = ENV_ONE;
+      op_pt->step_amp = ENV_ONE;
     }
   }
 }
@@ -319,10 +361,14 @@ static void change_attackrate(OPL_DATA *chip, Bitu regbase, op_type *op_pt) {
     fltype f = (fltype)(pow(FL2, (fltype)attackrate + (op_pt->toff >> 2) - 1) *
                         attackconst[op_pt->toff & 3] * chip->recipsamp);
     // attack rate coefficients
+#if defined(OPL_FIXEDPT)
+    op_pt->attackmul = RATE_CONST(f);
+#else
     op_pt->a0 = (fltype)(0.0377 * f);
     op_pt->a1 = (fltype)(10.73 * f + 1);
     op_pt->a2 = (fltype)(-17.57 * f);
     op_pt->a3 = (fltype)(7.42 * f);
+#endif
 
     step_skip = attackrate * 4 + op_pt->toff;
     steps = step_skip >> 2;
@@ -337,18 +383,26 @@ static void change_attackrate(OPL_DATA *chip, Bitu regbase, op_type *op_pt) {
     if (step_skip >= 62)
 #endif
     {
+#if defined(OPL_FIXEDPT)
+      op_pt->attackmul = ATTACK_INSTANT;
+#else
       op_pt->a0 = (fltype)(2.0); // something that triggers an immediate
                                  // transition to amp:=1.0
       op_pt->a1 = (fltype)(0.0);
       op_pt->a2 = (fltype)(0.0);
       op_pt->a3 = (fltype)(0.0);
+#endif
     }
   } else {
     // attack disabled
+#if defined(OPL_FIXEDPT)
+    op_pt->attackmul = 0;
+#else
     op_pt->a0 = 0.0;
     op_pt->a1 = 1.0;
     op_pt->a2 = 0.0;
     op_pt->a3 = 0.0;
+#endif
     op_pt->env_step_a = 0;
     op_pt->env_step_skip_a = 0;
   }
@@ -362,12 +416,12 @@ static void change_decayrate(OPL_DATA *chip, Bitu regbase, op_type *op_pt) {
 
     fltype f =
         (fltype)(-7.4493 * decrelconst[op_pt->toff & 3] * chip->recipsamp);
-    op_pt->decaymul = (fltype)(pow(
+    op_pt->decaymul = MUL_CONST(pow(
         FL2, f * pow(FL2, (fltype)(decayrate + (op_pt->toff >> 2)))));
     steps = (decayrate * 4 + op_pt->toff) >> 2;
     op_pt->env_step_d = (1 << (steps <= 12 ? 12 - steps : 0)) - 1;
   } else {
-    op_pt->decaymul = 1.0;
+    op_pt->decaymul = MUL_CONST(1.0);
     op_pt->env_step_d = 0;
   }
 }
@@ -380,12 +434,12 @@ static void change_releaserate(OPL_DATA *chip, Bitu regbase, op_type *op_pt) {
 
     fltype f =
         (fltype)(-7.4493 * decrelconst[op_pt->toff & 3] * chip->recipsamp);
-    op_pt->releasemul = (fltype)(pow(
+    op_pt->releasemul = MUL_CONST(pow(
         FL2, f * pow(FL2, (fltype)(releaserate + (op_pt->toff >> 2)))));
     steps = (releaserate * 4 + op_pt->toff) >> 2;
     op_pt->env_step_r = (1 << (steps <= 12 ? 12 - steps : 0)) - 1;
   } else {
-    op_pt->releasemul = 1.0;
+    op_pt->releasemul = MUL_CONST(1.0);
     op_pt->env_step_r = 0;
   }
 }
@@ -394,9 +448,10 @@ static void change_sustainlevel(OPL_DATA *chip, Bitu regbase, op_type *op_pt) {
   Bits sustainlevel = chip->adlibreg[ARC_SUSL_RELR + regbase] >> 4;
   // sustainlevel should be 0.0 when sustainlevel==15 (max)
   if (sustainlevel < 15) {
-    op_pt->sustain_level = (fltype)(pow(FL2, (fltype)sustainlevel * (-FL05)));
+    op_pt->sustain_level =
+        ENV_CONST(pow(FL2, (fltype)sustainlevel * (-FL05)));
   } else {
-    op_pt->sustain_level = 0.0;
+    op_pt->sustain_level = 0;
   }
 }
 
@@ -468,7 +523,7 @@ static void change_frequency(OPL_DATA *chip, Bitu chanbase, Bitu regbase,
   vol_in = (fltype)((fltype)(chip->adlibreg[ARC_KSL_OUTLEV + regbase] & 63) +
                     kslmul[chip->adlibreg[ARC_KSL_OUTLEV + regbase] >> 6] *
                         kslev[oct][frn >> 6]);
-  op_pt->vol = (fltype)(pow(FL2, (fltype)(vol_in * -0.125 - 14)));
+  op_pt->vol = VOL_CONST(pow(FL2, (fltype)(vol_in * -0.125 - 14)));
 
   // operator frequency changed, care about features that depend on it
   change_attackrate(chip, regbase, op_pt);
@@ -503,15 +558,95 @@ static void disable_operator(op_type *op_pt, Bit32u act_type) {
   }
 }
 
+// fills the vibrato/tremolo, waveform and key scale level tables
+static void init_tables(void) {
+  Bits i, j, oct;
+  Bit32s trem_table_int[TREMTAB_SIZE];
+
+  // create vibrato table
+  vib_table[0] = 8;
+  vib_table[1] = 4;
+  vib_table[2] = 0;
+  vib_table[3] = -4;
+  for (i = 4; i < VIBTAB_SIZE; i++)
+    vib_table[i] = vib_table[i - 4] * -1;
+
+  for (i = 0; i < BLOCKBUF_SIZE; i++)
+    vibval_const[i] = 0;
+
+  // create tremolo table
+  for (i = 0; i < 14; i++)
+    trem_table_int[i] = i - 13; // upwards (13 to 26 -> -0.5/6 to 0)
+  for (i = 14; i < 41; i++)
+    trem_table_int[i] = -i + 14; // downwards (26 to 0 -> 0 to -1/6)
+  for (i = 41; i < 53; i++)
+    trem_table_int[i] = i - 40 - 26; // upwards (1 to 12 -> -1/6 to -0.5/6)
+
+  for (i = 0; i < TREMTAB_SIZE; i++) {
+    // 0.0 .. -26/26*4.8/6 == [0.0 .. -0.8], 4/53 steps == [1 .. 0.57]
+    fltype trem_val1 =
+        (fltype)(((fltype)trem_table_int[i]) * 4.8 / 26.0 / 6.0); // 4.8db
+    fltype trem_val2 = (fltype)((fltype)((Bit32s)(trem_table_int[i] / 4)) *
+                                1.2 / 6.0 / 6.0); // 1.2db (larger stepping)
+
+    trem_table[i] = (Bit32s)(pow(FL2, trem_val1) * FIXEDPT);
+    trem_table[TREMTAB_SIZE + i] = (Bit32s)(pow(FL2, trem_val2) * FIXEDPT);
+  }
+
+  for (i = 0; i < BLOCKBUF_SIZE; i++)
+    tremval_const[i] = FIXEDPT;
+
+  // create waveform tables
+  for (i = 0; i < (WAVEPREC >> 1); i++) {
+    wavtable[(i << 1) + WAVEPREC] =
+        (Bit16s)(16384 * sin((fltype)((i << 1)) * PI * 2 / WAVEPREC));
+    wavtable[(i << 1) + 1 + WAVEPREC] =
+        (Bit16s)(16384 * sin((fltype)((i << 1) + 1) * PI * 2 / WAVEPREC));
+    wavtable[i] = wavtable[(i << 1) + WAVEPREC];
+    // alternative: (zero-less)
+    /*			wavtable[(i<<1)  +WAVEPREC]	=
+       (Bit16s)(16384*sin((fltype)((i<<2)+1)*PI/WAVEPREC));
+                            wavtable[(i<<1)+1+WAVEPREC]	=
+       (Bit16s)(16384*sin((fltype)((i<<2)+3)*PI/WAVEPREC)); wavtable[i]
+       = wavtable[(i<<1)-1+WAVEPREC]; */
+  }
+  for (i = 0; i < (WAVEPREC >> 3); i++) {
+    wavtable[i + (WAVEPREC << 1)] = wavtable[i + (WAVEPREC >> 3)] - 16384;
+    wavtable[i + ((WAVEPREC * 17) >> 3)] =
+        wavtable[i + (WAVEPREC >> 2)] + 16384;
+  }
+
+  // key scale level table verified ([table in book]*8/3)
+  kslev[7][0] = 0;
+  kslev[7][1] = 24;
+  kslev[7][2] = 32;
+  kslev[7][3] = 37;
+  kslev[7][4] = 40;
+  kslev[7][5] = 43;
+  kslev[7][6] = 45;
+  kslev[7][7] = 47;
+  kslev[7][8] = 48;
+  for (i = 9; i < 16; i++)
+    kslev[7][i] = (Bit8u)(i + 41);
+  for (j = 6; j >= 0; j--) {
+    for (i = 0; i < 16; i++) {
+      oct = (Bits)kslev[j + 1][i] - 8;
+      if (oct < 0)
+        oct = 0;
+      kslev[j][i] = (Bit8u)oct;
+    }
+  }
+}
+
 // void adlib_init(Bit32u samplerate)
 void *ADLIBEMU(init)(UINT32 clock, UINT32 samplerate,
                      ADL_UPDATEHANDLER UpdateHandler, void *param) {
   OPL_DATA *OPL;
   // op_type* op;
 
-  Bits i, j, oct;
-  // Bit32s trem_table_int[TREMTAB_SIZE];
-  static Bitu initfirstime = 0;
+  Bits i;
+
+  pthread_once(&tables_once, init_tables);
 
   OPL = (OPL_DATA *)malloc(sizeof(OPL_DATA));
   OPL->chip_clock = clock;
@@ -520,6 +655,8 @@ void *ADLIBEMU(init)(UINT32 clock, UINT32 samplerate,
   OPL->UpdateParam = param;
 
   OPL->generator_add = (Bit32u)(INTFREQU * FIXEDPT / OPL->int_samplerate);
+  memset(&OPL->noise_rng, 0x00, sizeof(OPL->noise_rng));
+  initstate_r(1, OPL->noise_state, sizeof(OPL->noise_state), &OPL->noise_rng);
 
   OPL->recipsamp = 1.0 / (fltype)OPL->int_samplerate;
   for (i = 15; i >= 0; i--) {
@@ -530,101 +667,17 @@ void *ADLIBEMU(init)(UINT32 clock, UINT32 samplerate,
   // OPL->status = 0;
   // OPL->opl_index = 0;
 
-  if (!initfirstime) {
-    // create vibrato table
-    vib_table[0] = 8;
-    vib_table[1] = 4;
-    vib_table[2] = 0;
-    vib_table[3] = -4;
-    for (i = 4; i < VIBTAB_SIZE; i++)
-      vib_table[i] = vib_table[i - 4] * -1;
-  }
-
   // vibrato at ~6.1 ?? (opl3 docs say 6.1, opl4 docs say 6.0, y8950 docs
   // say 6.4)
   OPL->vibtab_add = (Bit32u)(VIBTAB_SIZE * FIXEDPT_LFO / 8192 * INTFREQU /
                              OPL->int_samplerate);
   OPL->vibtab_pos = 0;
 
-  if (!initfirstime) {
-    Bit32s trem_table_int[TREMTAB_SIZE];
-
-    for (i = 0; i < BLOCKBUF_SIZE; i++)
-      vibval_const[i] = 0;
-
-    // create tremolo table
-    for (i = 0; i < 14; i++)
-      trem_table_int[i] = i - 13; // upwards (13 to 26 -> -0.5/6 to 0)
-    for (i = 14; i < 41; i++)
-      trem_table_int[i] = -i + 14; // downwards (26 to 0 -> 0 to -1/6)
-    for (i = 41; i < 53; i++)
-      trem_table_int[i] = i - 40 - 26; // upwards (1 to 12 -> -1/6 to -0.5/6)
-
-    for (i = 0; i < TREMTAB_SIZE; i++) {
-      // 0.0 .. -26/26*4.8/6 == [0.0 .. -0.8], 4/53 steps == [1 .. 0.57]
-      fltype trem_val1 =
-          (fltype)(((fltype)trem_table_int[i]) * 4.8 / 26.0 / 6.0); // 4.8db
-      fltype trem_val2 = (fltype)((fltype)((Bit32s)(trem_table_int[i] / 4)) *
-                                  1.2 / 6.0 / 6.0); // 1.2db (larger stepping)
-
-      trem_table[i] = (Bit32s)(pow(FL2, trem_val1) * FIXEDPT);
-      trem_table[TREMTAB_SIZE + i] = (Bit32s)(pow(FL2, trem_val2) * FIXEDPT);
-    }
-  }
-
   // tremolo at 3.7hz
   OPL->tremtab_add = (Bit32u)((fltype)TREMTAB_SIZE * TREM_FREQ * FIXEDPT_LFO /
                               (fltype)OPL->int_samplerate);
   OPL->tremtab_pos = 0;
 
-  if (!initfirstime) {
-    initfirstime = 1;
-
-    for (i = 0; i < BLOCKBUF_SIZE; i++)
-      tremval_const[i] = FIXEDPT;
-
-    // create waveform tables
-    for (i = 0; i < (WAVEPREC >> 1); i++) {
-      wavtable[(i << 1) + WAVEPREC] =
-          (Bit16s)(16384 * sin((fltype)((i << 1)) * PI * 2 / WAVEPREC));
-      wavtable[(i << 1) + 1 + WAVEPREC] =
-          (Bit16s)(16384 * sin((fltype)((i << 1) + 1) * PI * 2 / WAVEPREC));
-      wavtable[i] = wavtable[(i << 1) + WAVEPREC];
-      // alternative: (zero-less)
-      /*			wavtable[(i<<1)  +WAVEPREC]	=
-         (Bit16s)(16384*sin((fltype)((i<<2)+1)*PI/WAVEPREC));
-                              wavtable[(i<<1)+1+WAVEPREC]	=
-         (Bit16s)(16384*sin((fltype)((i<<2)+3)*PI/WAVEPREC)); wavtable[i]
-         = wavtable[(i<<1)-1+WAVEPREC]; */
-    }
-    for (i = 0; i < (WAVEPREC >> 3); i++) {
-      wavtable[i + (WAVEPREC << 1)] = wavtable[i + (WAVEPREC >> 3)] - 16384;
-      wavtable[i + ((WAVEPREC * 17) >> 3)] =
-          wavtable[i + (WAVEPREC >> 2)] + 16384;
-    }
-
-    // key scale level table verified ([table in book]*8/3)
-    kslev[7][0] = 0;
-    kslev[7][1] = 24;
-    kslev[7][2] = 32;
-    kslev[7][3] = 37;
-    kslev[7][4] = 40;
-    kslev[7][5] = 43;
-    kslev[7][6] = 45;
-    kslev[7][7] = 47;
-    kslev[7][8] = 48;
-    for (i = 9; i < 16; i++)
-      kslev[7][i] = (Bit8u)(i + 41);
-    for (j = 6; j >= 0; j--) {
-      for (i = 0; i < 16; i++) {
-        oct = (Bits)kslev[j + 1][i] - 8;
-        if (oct < 0)
-          oct = 0;
-        kslev[j][i] = (Bit8u)oct;
-      }
-    }
-  }
-
   return OPL;
 }
 
@@ -648,9 +701,9 @@ void ADLIBEMU(reset)(void *chip) {
 
     op->op_state = OF_TYPE_OFF;
     op->act_state = OP_ACT_OFF;
-    op->amp = 0.0;
-    op->step_amp = 0.0;
-    op->vol = 0.0;
+    op->amp = 0;
+    op->step_amp = 0;
+    op->vol = 0;
     op->tcount = 0;
     op->tinc = 0;
     op->toff = 0;
@@ -1080,13 +1133,16 @@ void ADLIBEMU(getsample)(void *chip, INT32 **sndptr, INT32 numsamples) {
   // second output buffer (right channel for opl3 stereo)
   // Bit32s outbufr[BLOCKBUF_SIZE];
 #endif
-  Bit32s *outbufl = sndptr[0];
-  Bit32s *outbufr = sndptr[1];
+  Bit32s *outbufl;
+  Bit32s *outbufr;
 
   // vibrato/tremolo lookup tables (global, to possibly be used by all
   // operators)
   Bit32s vib_lut[BLOCKBUF_SIZE];
   Bit32s trem_lut[BLOCKBUF_SIZE];
+  // vibrato value tables (used per-operator)
+  Bit32s vibval_var1[BLOCKBUF_SIZE];
+  Bit32s vibval_var2[BLOCKBUF_SIZE];
 
   Bits samples_to_process = numsamples;
 
@@ -1128,9 +1184,30 @@ void ADLIBEMU(getsample)(void *chip, INT32 **sndptr, INT32 numsamples) {
     return;
   }
 
+  // all operators off: nothing is audible and only the vibrato/tremolo
+  // positions move (same wrap-around as in the table loop below)
+  for (i = 0; i < MAXOPERATORS; i++) {
+    if (OPL->op[i].op_state != OF_TYPE_OFF)
+      break;
+  }
+  if (i == MAXOPERATORS) {
+    memset(sndptr[0], 0, samples_to_process * sizeof(Bit32s));
+    memset(sndptr[1], 0, samples_to_process * sizeof(Bit32s));
+    OPL->vibtab_pos = (Bit32u)(((UINT64)OPL->vibtab_add * samples_to_process +
+                                OPL->vibtab_pos) %
+                               (VIBTAB_SIZE * FIXEDPT_LFO));
+    OPL->tremtab_pos = (Bit32u)(((UINT64)OPL->tremtab_add * samples_to_process +
+                                 OPL->tremtab_pos) %
+                                (TREMTAB_SIZE * FIXEDPT_LFO));
+    return;
+  }
+
   for (cursmp = 0; cursmp < samples_to_process; cursmp += endsamples) {
     endsamples = samples_to_process - cursmp;
-    // if (endsamples>BLOCKBUF_SIZE) endsamples = BLOCKBUF_SIZE;
+    if (endsamples > BLOCKBUF_SIZE)
+      endsamples = BLOCKBUF_SIZE;
+    outbufl = sndptr[0] + cursmp;
+    outbufr = sndptr[1] + cursmp;
 
     memset(outbufl, 0, endsamples * sizeof(Bit32s));
     // #if defined(OPLTYPE_IS_OPL3)
@@ -1806,3 +1883,14 @@ void ADLIBEMU(set_mute_mask)(void *chip, UINT32 MuteMask) {
 
   return;
 }
+
+UINT32 ADLIBEMU(save_state)(void *chip, void *Data) {
+  if (Data != NULL)
+    memcpy(Data, chip, sizeof(OPL_DATA));
+  return sizeof(OPL_DATA);
+}
+
+UINT32 ADLIBEMU(load_state)(void *chip, const void *Data) {
+  memcpy(chip, Data, sizeof(OPL_DATA));
+  return sizeof(OPL_DATA);
+}
@@ -75,6 +75,57 @@ typedef INT8		Bit8s;
 #define FIXEDPT			0x10000		// fixed-point calculations using 16+16
 #define FIXEDPT_LFO		0x1000000	// fixed-point calculations using 8+24
 
+/*
+	OPL_FIXEDPT builds the integer variant of the core. The envelope runs in
+	4.60 fixed point and the volume in 2^-62 units, so the per-sample
+	operator code does no floating point math; register writes still derive
+	the rates in double precision.
+	Decay/release store 1-mul and the attack stores only the rate factor f
+	(the polynomial is amp + f*(0.0377 + 10.73amp - 17.57amp^2 + 7.42amp^3)),
+	both in 4.60 fixed point, as a multiplier close to 1.0 would lose the
+	precision of the slow rates. The products are taken in 128 bits.
+	The precision has to come close to the double core's: an output sample
+	that rounds the other way is fed back into the phase (FM feedback and
+	modulation), and a gain error of 1e-7 already makes notes diverge. The
+	envelope also has to resolve the 1e-8 release threshold: the operator
+	switching off decides whether its channel is computed at all.
+*/
+#if defined(OPL_FIXEDPT)
+#define ENV_FRAC		60
+#define RATE_FRAC		60
+#define VOL_FRAC		62
+#define ENVVOL_FRAC		75			// envelope * volume (< 2^62)
+
+typedef INT64			envtype;	// envelope level (amp, step_amp, sustain_level)
+typedef INT64			multype;	// decay/release rate (1-mul) and attack rate
+typedef INT64			voltype;	// volume
+__extension__ typedef __int128 INT128;
+__extension__ typedef unsigned __int128 UINT128;
+
+#define ENV_ROUND(x,f)	(((x) + ((INT128)1 << ((f) - 1))) >> (f))
+#define ENV_CONST(x)	((envtype)((x) * (fltype)((INT64)1 << ENV_FRAC)))
+#define RATE_CONST(x)	((multype)((x) * (fltype)((INT64)1 << RATE_FRAC) + 0.5))
+#define MUL_CONST(x)	RATE_CONST(1.0 - (x))
+#define VOL_CONST(x)	((voltype)((x) * (fltype)((INT64)1 << VOL_FRAC)))
+#define ENV_SCALE(a,m)	((a) - env_mulhi(a, m))
+
+#define ATTACK_FRAC		57			// coefficients in the attack polynomial
+#define ATTACK_CONST(x)	((multype)((x) * (fltype)((INT64)1 << ATTACK_FRAC)))
+#define ATTACK_INSTANT	((multype)-1)	// immediate transition to amp:=1.0
+#else
+typedef fltype			envtype;
+typedef fltype			multype;
+typedef fltype			voltype;
+
+#define ENV_CONST(x)	((fltype)(x))
+#define MUL_CONST(x)	((fltype)(x))
+#define VOL_CONST(x)	((fltype)(x))
+#define ENV_SCALE(a,m)	((a) * (m))
+#endif
+
+#define ENV_ONE			ENV_CONST(1.0)
+#define ENV_MIN			ENV_CONST(0.00000001)	// release is finished below this level
+
 #define WAVEPREC		1024		// waveform precision (10 bits)
 
 //#define INTFREQU		((fltype)(14318180.0 / 288.0))		// clocking of the chip
@@ -136,12 +187,16 @@ typedef INT8		Bit8s;
 typedef struct operator_struct {
 	Bit32s cval, lastcval;			// current output/last output (used for feedback)
 	Bit32u tcount, wfpos, tinc;		// time (position in waveform) and time increment
-	fltype amp, step_amp;			// and amplification (envelope)
-	fltype vol;						// volume
-	fltype sustain_level;			// sustain level
+	envtype amp, step_amp;			// and amplification (envelope)
+	voltype vol;					// volume
+	envtype sustain_level;			// sustain level
 	Bit32s mfbi;					// feedback amount
+#if defined(OPL_FIXEDPT)
+	multype attackmul;				// attack rate function factor
+#else
 	fltype a0, a1, a2, a3;			// attack rate function coefficients
-	fltype decaymul, releasemul;	// decay/release rate functions
+#endif
+	multype decaymul, releasemul;	// decay/release rate functions
 	Bit32u op_state;				// current state of operator (attack/decay/sustain/release/off)
 	Bit32u toff;
 	Bit32s freq_high;				// highest three bits of the frequency, used for vibrato calculations
@@ -194,6 +249,10 @@ typedef struct opl_chip
 	
 	Bit32u generator_add;	// should be a chip parameter
 	
+	// rhythm noise, same sequence as rand() but private to the chip
+	struct random_data noise_rng;
+	char noise_state[128];
+	
 	fltype recipsamp;	// inverse of sampling rate
 	fltype frqmul[16];
 	
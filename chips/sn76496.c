@@ -128,11 +128,13 @@
 #include <string.h>	// for memset
 #include <stddef.h>	// for NULL
 #include "sn76496.h"
+#include "blep.h"
 
 
 //#define MAX_OUTPUT 0x7fff
 #define MAX_OUTPUT 0x8000
 #define NOISEMODE (R->Register[6]&4)?1:0
+#define BLEP_GETA_BITS 24
 
 
 typedef struct _sn76496_state sn76496_state;
@@ -160,12 +162,14 @@ struct _sn76496_state
 	UINT32 MuteMsk[4];
 	UINT8 NgpFlags;		/* bit 7 - NGP Mode on/off, bit 0 - is 2nd NGP chip */
 	sn76496_state* NgpChip2;	/* Pointer to other Chip */
+	UINT16 FNumLimit;	/* periods below this are above the output Nyquist rate */
+	UINT32 BlepIncr;	/* chip ticks per output sample (8.24 fixed point), 0 = no BLEP */
+	UINT32 BlepCount;	/* tick fraction carried over to the next sample */
+	UINT64 BlepRecip;	/* (BLEP_PHASES << 32) / BlepIncr */
+	BLEP Blep;
 };
 
 
-static sn76496_state* LastChipInit = NULL;
-static unsigned short int FNumLimit;
-
 /*INLINE sn76496_state *get_safe_token(running_device *device)
 {
 	assert(device != NULL);
@@ -276,24 +280,263 @@ void sn76496_write_reg(void *chip, offs_t offset, UINT8 data)
 	}
 }
 
+INLINE void sn76496_noise_step(sn76496_state *R)
+{
+// if noisemode is 1, both taps are enabled
+// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
+	if (((R->RNG & R->WhitenoiseTap1)?1:0) ^ ((((R->RNG & R->WhitenoiseTap2)?1:0))*(NOISEMODE)))
+	{
+		R->RNG >>= 1;
+		R->RNG |= R->FeedbackMask;
+	}
+	else
+	{
+		R->RNG >>= 1;
+	}
+	R->Output[3] = R->RNG & 1;
+
+	R->Count[3] = R->Period[3];
+}
+
+// final output levels for the current channel states
+INLINE void sn76496_output(sn76496_state *R, INT32 *lout, INT32 *rout)
+{
+	sn76496_state *R2 = R->NgpChip2;
+	INT32 out, out2;
+	INT32 vol[4];
+	INT32 ggst[2];
+	int i;
+
+	ggst[0] = 0x01;
+	ggst[1] = 0x01;
+	// the NGP code below was written with i left at 3 by the tone loop
+	i = 3;
+	// --- CUSTOM CODE START --
+	out = out2 = 0;
+	if (! R->NgpFlags)
+	{
+		for (i = 0; i < 4; i ++)
+		{
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->Output[i] ? +1 : -1;
+			
+			// Disable high frequencies (> SampleRate / 2) for tone channels
+			// Freq. 0/1 isn't disabled becaus it would also disable PCM
+			if (i != 3)
+			{
+				if (R->Period[i] <= R->FNumLimit && R->Period[i] > 1)
+					vol[i] = 0;
+			}
+			vol[i] &= R->MuteMsk[i];
+			// --- Preparation End ---
+			
+			if (R->Stereo)
+			{
+				ggst[0] = (R->StereoMask & (0x10 << i)) ? 0x01 : 0x00;
+				ggst[1] = (R->StereoMask & (0x01 << i)) ? 0x01 : 0x00;
+			}
+			if (R->Period[i] > 1 || i == 3)
+			{
+				out += vol[i] * R->Volume[i] * ggst[0];
+				out2 += vol[i] * R->Volume[i] * ggst[1];
+			}
+			else if (R->MuteMsk[i])
+			{
+				// Make Bipolar Output with PCM possible
+				//out += (2 * R->Volume[i] - R->VolTable[5]) * ggst[0];
+				//out2 += (2 * R->Volume[i] - R->VolTable[5]) * ggst[1];
+				out += R->Volume[i] * ggst[0];
+				out2 += R->Volume[i] * ggst[1];
+			}
+		}
+	}
+	else
+	{
+		if (! (R->NgpFlags & 0x01))
+		{
+			// Tone Channel 1-3
+			if (R->Stereo)
+			{
+				ggst[0] = (R->StereoMask & (0x10 << i)) ? 0x01 : 0x00;
+				ggst[1] = (R->StereoMask & (0x01 << i)) ? 0x01 : 0x00;
+			}
+			for (i = 0; i < 3; i ++)
+			{
+				// --- Preparation Start ---
+				// Bipolar output
+				vol[i] = R->Output[i] ? +1 : -1;
+				
+				// Disable high frequencies (> SampleRate / 2) for tone channels
+				// Freq. 0 isn't disabled becaus it would also disable PCM
+				if (R->Period[i] <= R->FNumLimit && R->Period[i])
+					vol[i] = 0;
+				vol[i] &= R->MuteMsk[i];
+				// --- Preparation End ---
+				
+				//out += vol[i] * R->Volume[i];
+				//out2 += vol[i] * R2->Volume[i];
+				if (R->Period[i])
+				{
+					out += vol[i] * R->Volume[i] * ggst[0];
+					out2 += vol[i] * R2->Volume[i] * ggst[1];
+				}
+				else if (R->MuteMsk[i])
+				{
+					// Make Bipolar Output with PCM possible
+					out += R->Volume[i] * ggst[0];
+					out2 += R2->Volume[i] * ggst[1];
+				}
+			}
+		}
+		else
+		{
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->Output[i] ? +1 : -1;
+			
+			//vol[i] &= R->MuteMsk[i];
+			vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
+			// --- Preparation End ---
+			
+			// Noise Channel
+			if (R->Stereo)
+			{
+				ggst[0] = (R->StereoMask & 0x80) ? 0x01 : 0x00;
+				ggst[1] = (R->StereoMask & 0x08) ? 0x01 : 0x00;
+			}
+			else
+			{
+				ggst[0] = 0x01;
+				ggst[1] = 0x01;
+			}
+			//out += vol[3] * R2->Volume[3];
+			//out2 += vol[3] * R->Volume[3];
+			out += vol[3] * R2->Volume[3] * ggst[0];
+			out2 += vol[3] * R->Volume[3] * ggst[1];
+		}
+	}
+	// --- CUSTOM CODE END --
+	
+	if(R->Negate) { out = -out; out2 = -out2; }
+
+	*lout = out >> 1;	// Output is Bipolar
+	*rout = out2 >> 1;
+}
+
+// whether toggling tone channel i can change the output
+INLINE bool sn76496_tone_audible(sn76496_state *R, int i)
+{
+	if (R->NgpFlags)
+		return true;
+	return R->Period[i] > 1 && R->Period[i] > R->FNumLimit &&
+			R->Volume[i] && R->MuteMsk[i];
+}
+
+// number of ticks until the next one that may change the output
+INLINE INT32 sn76496_next_edge(sn76496_state *R)
+{
+	INT32 next;
+	int i;
+
+	next = (R->Count[3] > 1) ? R->Count[3] : 1;
+	for (i = 0; i < 3; i ++)
+	{
+		if (R->Count[i] < next && sn76496_tone_audible(R, i))
+			next = (R->Count[i] > 1) ? R->Count[i] : 1;
+	}
+	return next;
+}
+
+// Same as 'ticks' passes of the loop in SN76496Update, as long as the
+// noise counter expires no earlier than the last of them.
+INLINE void sn76496_advance(sn76496_state *R, INT32 ticks)
+{
+	INT32 first, period, n;
+	int i;
+
+	if (R->CyclestoREADY > ticks)
+		R->CyclestoREADY -= ticks;
+	else
+		R->CyclestoREADY = 0;
+
+	for (i = 0; i < 3; i ++)
+	{
+		// toggles after 'first' ticks and then every 'period' ticks
+		first = (R->Count[i] > 1) ? R->Count[i] : 1;
+		if (ticks < first)
+		{
+			R->Count[i] -= ticks;
+			continue;
+		}
+		period = (R->Period[i] > 1) ? R->Period[i] : 1;
+		n = (ticks - first) / period;
+		R->Output[i] ^= (n + 1) & 1;
+		R->Count[i] = R->Period[i] - (ticks - first - n * period);
+	}
+
+	R->Count[3] -= ticks;
+	if (R->Count[3] <= 0)
+		sn76496_noise_step(R);
+}
+
+// Band-limited step synthesis at the output rate. Without 'run' (the speed
+// hack found nothing audible) the chip state is kept and the output decays.
+static void SN76496UpdateBlep(sn76496_state *R, stream_sample_t *lbuffer,
+								stream_sample_t *rbuffer, int samples, bool run)
+{
+	UINT32 start;
+	INT32 ticks, t, k;
+	INT32 out[2];
+	int i;
+
+	for (i = 0; i < samples; i ++)
+	{
+		start = R->BlepCount;
+		R->BlepCount += R->BlepIncr;
+		ticks = R->BlepCount >> BLEP_GETA_BITS;
+		R->BlepCount &= (1 << BLEP_GETA_BITS) - 1;
+
+		if (! run)
+		{
+			if (blep_changed(&R->Blep, 0, 0))
+				blep_step(&R->Blep, BLEP_PHASES - 1, 0, 0);
+		}
+		else
+		{
+			for (t = 0; t < ticks; t += k)
+			{
+				k = sn76496_next_edge(R);
+				if (k > ticks - t)
+					k = ticks - t;
+				sn76496_advance(R, k);
+				sn76496_output(R, &out[0], &out[1]);
+				if (blep_changed(&R->Blep, out[0], out[1]))
+					blep_step(&R->Blep, blep_phase(((UINT32)(t + k) << BLEP_GETA_BITS) - start,
+												R->BlepRecip), out[0], out[1]);
+			}
+		}
+
+		blep_read(&R->Blep, out);
+		lbuffer[i] = out[0];
+		rbuffer[i] = out[1];
+	}
+}
+
 //static STREAM_UPDATE( SN76496Update )
 void SN76496Update(void *chip, stream_sample_t **outputs, int samples)
 {
 	int i;
 	//sn76496_state *R = (sn76496_state *)param;
 	sn76496_state *R = (sn76496_state*)chip;
-	sn76496_state *R2;
 	stream_sample_t *lbuffer = outputs[0];
 	//stream_sample_t *rbuffer = (R->Stereo)?outputs[1]:NULL;
 	stream_sample_t *rbuffer = outputs[1];
 	INT32 out = 0;
 	INT32 out2 = 0;
-	INT32 vol[4];
 	UINT8 NGPMode;
-	INT32 ggst[2];
 
 	NGPMode = (R->NgpFlags >> 7) & 0x01;
-	R2 = R->NgpChip2;
 
 	if (! NGPMode)
 	{
@@ -309,16 +552,23 @@ void SN76496Update(void *chip, stream_sample_t **outputs, int samples)
 		}
 		if (R->Volume[3])
 			out = 1;
-		if (! out)
+		if (! out && ! R->BlepIncr)
 		{
 			memset(lbuffer, 0x00, sizeof(stream_sample_t) * samples);
 			memset(rbuffer, 0x00, sizeof(stream_sample_t) * samples);
 			return;
 		}
 	}
+	else
+	{
+		out = 1;
+	}
+	if (R->BlepIncr)
+	{
+		SN76496UpdateBlep(R, lbuffer, rbuffer, samples, out);
+		return;
+	}
 	
-	ggst[0] = 0x01;
-	ggst[1] = 0x01;
 	while (samples > 0)
 	{
 		/* Speed Patch */
@@ -347,22 +597,7 @@ void SN76496Update(void *chip, stream_sample_t **outputs, int samples)
 			// handle channel 3
 			R->Count[3]--;
 			if (R->Count[3] <= 0)
-			{
-			// if noisemode is 1, both taps are enabled
-			// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
-				if (((R->RNG & R->WhitenoiseTap1)?1:0) ^ ((((R->RNG & R->WhitenoiseTap2)?1:0))*(NOISEMODE)))
-				{
-					R->RNG >>= 1;
-					R->RNG |= R->FeedbackMask;
-				}
-				else
-				{
-					R->RNG >>= 1;
-				}
-				R->Output[3] = R->RNG & 1;
-
-				R->Count[3] = R->Period[3];
-			}
+				sn76496_noise_step(R);
 		//}
 
 
@@ -386,118 +621,11 @@ void SN76496Update(void *chip, stream_sample_t **outputs, int samples)
 				+(R->Output[3]?R->Volume[3]:0);
 		}*/
 
-		// --- CUSTOM CODE START --
-		out = out2 = 0;
-		if (! R->NgpFlags)
-		{
-			for (i = 0; i < 4; i ++)
-			{
-				// --- Preparation Start ---
-				// Bipolar output
-				vol[i] = R->Output[i] ? +1 : -1;
-				
-				// Disable high frequencies (> SampleRate / 2) for tone channels
-				// Freq. 0/1 isn't disabled becaus it would also disable PCM
-				if (i != 3)
-				{
-					if (R->Period[i] <= FNumLimit && R->Period[i] > 1)
-						vol[i] = 0;
-				}
-				vol[i] &= R->MuteMsk[i];
-				// --- Preparation End ---
-				
-				if (R->Stereo)
-				{
-					ggst[0] = (R->StereoMask & (0x10 << i)) ? 0x01 : 0x00;
-					ggst[1] = (R->StereoMask & (0x01 << i)) ? 0x01 : 0x00;
-				}
-				if (R->Period[i] > 1 || i == 3)
-				{
-					out += vol[i] * R->Volume[i] * ggst[0];
-					out2 += vol[i] * R->Volume[i] * ggst[1];
-				}
-				else if (R->MuteMsk[i])
-				{
-					// Make Bipolar Output with PCM possible
-					//out += (2 * R->Volume[i] - R->VolTable[5]) * ggst[0];
-					//out2 += (2 * R->Volume[i] - R->VolTable[5]) * ggst[1];
-					out += R->Volume[i] * ggst[0];
-					out2 += R->Volume[i] * ggst[1];
-				}
-			}
-		}
-		else
-		{
-			if (! (R->NgpFlags & 0x01))
-			{
-				// Tone Channel 1-3
-				if (R->Stereo)
-				{
-					ggst[0] = (R->StereoMask & (0x10 << i)) ? 0x01 : 0x00;
-					ggst[1] = (R->StereoMask & (0x01 << i)) ? 0x01 : 0x00;
-				}
-				for (i = 0; i < 3; i ++)
-				{
-					// --- Preparation Start ---
-					// Bipolar output
-					vol[i] = R->Output[i] ? +1 : -1;
-					
-					// Disable high frequencies (> SampleRate / 2) for tone channels
-					// Freq. 0 isn't disabled becaus it would also disable PCM
-					if (R->Period[i] <= FNumLimit && R->Period[i])
-						vol[i] = 0;
-					vol[i] &= R->MuteMsk[i];
-					// --- Preparation End ---
-					
-					//out += vol[i] * R->Volume[i];
-					//out2 += vol[i] * R2->Volume[i];
-					if (R->Period[i])
-					{
-						out += vol[i] * R->Volume[i] * ggst[0];
-						out2 += vol[i] * R2->Volume[i] * ggst[1];
-					}
-					else if (R->MuteMsk[i])
-					{
-						// Make Bipolar Output with PCM possible
-						out += R->Volume[i] * ggst[0];
-						out2 += R2->Volume[i] * ggst[1];
-					}
-				}
-			}
-			else
-			{
-				// --- Preparation Start ---
-				// Bipolar output
-				vol[i] = R->Output[i] ? +1 : -1;
-				
-				//vol[i] &= R->MuteMsk[i];
-				vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
-				// --- Preparation End ---
-				
-				// Noise Channel
-				if (R->Stereo)
-				{
-					ggst[0] = (R->StereoMask & 0x80) ? 0x01 : 0x00;
-					ggst[1] = (R->StereoMask & 0x08) ? 0x01 : 0x00;
-				}
-				else
-				{
-					ggst[0] = 0x01;
-					ggst[1] = 0x01;
-				}
-				//out += vol[3] * R2->Volume[3];
-				//out2 += vol[3] * R->Volume[3];
-				out += vol[3] * R2->Volume[3] * ggst[0];
-				out2 += vol[3] * R->Volume[3] * ggst[1];
-			}
-		}
-		// --- CUSTOM CODE END --
-		
-		if(R->Negate) { out = -out; out2 = -out2; }
+		sn76496_output(R, &out, &out2);
 
-		*(lbuffer++) = out >> 1;	// Output is Bipolar
+		*(lbuffer++) = out;
 		//if (R->Stereo) *(rbuffer++) = out2;
-		*(rbuffer++) = out2 >> 1;
+		*(rbuffer++) = out2;
 		samples--;
 	}
 }
@@ -584,25 +712,11 @@ static int generic_start(sn76496_state *chip, int clock, int feedbackmask, int n
 	
 	//sn76496_state *chip = get_safe_token(device);
 	//sn76496_state *chip;
-	sn76496_state *chip2;
 	
 	//if (SN76496_init(device,chip,stereo) != 0)
 	//	fatalerror("Error creating SN76496 chip");
+	// NeoGeoPocket Mode is activated by sn76496_connect_ngp
 	sample_rate = SN76496_init(clock & 0x7FFFFFFF, chip, stereo);
-	if ((clock & 0x80000000) && LastChipInit != NULL)
-	{
-		// Activate special NeoGeoPocket Mode
-		chip2 = LastChipInit;
-		chip2->NgpFlags = 0x80 | 0x00;
-		chip->NgpFlags = 0x80 | 0x01;
-		chip->NgpChip2 = chip2;
-		chip2->NgpChip2 = chip;
-		LastChipInit = NULL;
-	}
-	else
-	{
-		LastChipInit = chip;
-	}
 	SN76496_set_gain(chip, 0);
 	
 	chip->FeedbackMask = feedbackmask;
@@ -713,9 +827,37 @@ void sn76496_reset(void *chip)
 	return;
 }
 
-void sn76496_freq_limiter(int clock, int clockdiv, int sample_rate)
+void sn76496_set_blep(void *chip, UINT32 tick_rate, UINT32 sample_rate)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	
+	// run at sample_rate and let SN76496UpdateBlep do the band-limiting
+	R->BlepIncr = (UINT32)(((UINT64)tick_rate << BLEP_GETA_BITS) / sample_rate);
+	R->BlepCount = 0;
+	R->BlepRecip = R->BlepIncr ? ((UINT64)BLEP_PHASES << 32) / R->BlepIncr : 0;
+	
+	return;
+}
+
+void sn76496_freq_limiter(void *chip, int clock, int clockdiv, int sample_rate)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	
+	R->FNumLimit = (UINT16)((clock / (clockdiv ? 2.0 : 16.0)) / sample_rate);
+	
+	return;
+}
+
+void sn76496_connect_ngp(void *chip1, void *chip2)
 {
-	FNumLimit = (unsigned short int)((clock / (clockdiv ? 2.0 : 16.0)) / sample_rate);
+	sn76496_state *R1 = (sn76496_state*)chip1;
+	sn76496_state *R2 = (sn76496_state*)chip2;
+	
+	// Activate special NeoGeoPocket Mode
+	R1->NgpFlags = 0x80 | 0x00;
+	R2->NgpFlags = 0x80 | 0x01;
+	R2->NgpChip2 = R1;
+	R1->NgpChip2 = R2;
 	
 	return;
 }
@@ -731,6 +873,19 @@ void sn76496_set_mutemask(void *chip, UINT32 MuteMask)
 	return;
 }
 
+UINT32 sn76496_save_state(void *chip, void *Data)
+{
+	if (Data != NULL)
+		memcpy(Data, chip, sizeof(sn76496_state));
+	return sizeof(sn76496_state);
+}
+
+UINT32 sn76496_load_state(void *chip, const void *Data)
+{
+	memcpy(chip, Data, sizeof(sn76496_state));
+	return sizeof(sn76496_state);
+}
+
 // function parameters: device, feedback destination tap, feedback source taps,
 // normal(false)/invert(true), mono(false)/stereo(true), clock divider factor
 
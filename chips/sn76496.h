@@ -31,5 +31,9 @@ unsigned long int sn76496_start(void **chip, int clock, int shiftregwidth, int n
 								int negate, int stereo, int clockdivider, int freq0);
 void sn76496_shutdown(void *chip);
 void sn76496_reset(void *chip);
-void sn76496_freq_limiter(int clock, int clockdiv, int sample_rate);
+void sn76496_set_blep(void *chip, UINT32 tick_rate, UINT32 sample_rate);
+void sn76496_freq_limiter(void *chip, int clock, int clockdiv, int sample_rate);
+void sn76496_connect_ngp(void *chip1, void *chip2);
 void sn76496_set_mutemask(void *chip, UINT32 MuteMask);
+UINT32 sn76496_save_state(void *chip, void *Data);
+UINT32 sn76496_load_state(void *chip, const void *Data);
@@ -6,6 +6,7 @@
 
 #include "../VGMSXPlay.h"
 #include <stddef.h> // for NULL
+#include <stdlib.h> // for calloc/free
 // #include "sndintrf.h"
 // #include "streams.h"
 #include "sn76496.h"
@@ -25,12 +26,11 @@ struct _sn764xx_state {
 static UINT8 EMU_CORE = 0x00;
 
 extern UINT32 SampleRate;
-#define MAX_CHIPS 0x02
-static sn764xx_state SN764xxData[MAX_CHIPS];
+extern bool PSGBlep;
 
-void sn764xx_stream_update(UINT8 ChipID, stream_sample_t **outputs,
+void sn764xx_stream_update(void *param, stream_sample_t **outputs,
                            int samples) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     SN76496Update(info->chip, outputs, samples);
@@ -43,39 +43,52 @@ void sn764xx_stream_update(UINT8 ChipID, stream_sample_t **outputs,
   }
 }
 
-int device_start_sn764xx(UINT8 ChipID, int clock, int shiftregwidth,
+int device_start_sn764xx(void **param, int clock, int shiftregwidth,
                          int noisetaps, int negate, int stereo,
                          int clockdivider, int freq0) {
   sn764xx_state *info;
   int rate = 0;
 
-  if (ChipID >= MAX_CHIPS)
+  info = (sn764xx_state *)calloc(1, sizeof(sn764xx_state));
+  if (info == NULL)
     return 0;
-
-  info = &SN764xxData[ChipID];
+  *param = info;
   /* emulator create */
   switch (EMU_CORE) {
   case EC_MAME:
     rate = sn76496_start(&info->chip, clock, shiftregwidth, noisetaps, negate,
                          stereo, clockdivider, freq0);
-    sn76496_freq_limiter(clock & 0x3FFFFFFF, clockdivider, SampleRate);
+    if (info->chip == NULL)
+      break;
+    sn76496_freq_limiter(info->chip, clock & 0x3FFFFFFF, clockdivider,
+                         SampleRate);
+    // with band-limited steps the chip renders at the output rate directly
+    if (PSGBlep && rate > (int)SampleRate) {
+      sn76496_set_blep(info->chip, rate, SampleRate);
+      rate = SampleRate;
+    }
     break;
 #ifdef ENABLE_ALL_CORES
   case EC_MAXIM:
     rate = SampleRate;
     info->chip = SN76489_Init(clock, rate);
     if (info->chip == NULL)
-      return 0;
+      break;
     SN76489_Config((SN76489_Context *)info->chip, noisetaps, shiftregwidth, 0);
     break;
 #endif
   }
+  if (info->chip == NULL) {
+    free(info);
+    *param = NULL;
+    return 0;
+  }
 
   return rate;
 }
 
-void device_stop_sn764xx(UINT8 ChipID) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+void device_stop_sn764xx(void *param) {
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     sn76496_shutdown(info->chip);
@@ -86,10 +99,11 @@ void device_stop_sn764xx(UINT8 ChipID) {
     break;
 #endif
   }
+  free(info);
 }
 
-void device_reset_sn764xx(UINT8 ChipID) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+void device_reset_sn764xx(void *param) {
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     sn76496_reset(info->chip);
@@ -102,8 +116,38 @@ void device_reset_sn764xx(UINT8 ChipID) {
   }
 }
 
-void sn764xx_w(UINT8 ChipID, offs_t offset, UINT8 data) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+UINT32 device_save_state_sn764xx(void *param, void *Data) {
+  sn764xx_state *info = (sn764xx_state *)param;
+  switch (EMU_CORE) {
+  case EC_MAME:
+    return sn76496_save_state(info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
+UINT32 device_load_state_sn764xx(void *param, const void *Data) {
+  sn764xx_state *info = (sn764xx_state *)param;
+  switch (EMU_CORE) {
+  case EC_MAME:
+    return sn76496_load_state(info->chip, Data);
+  default:
+    return 0;
+  }
+}
+
+void sn764xx_connect_ngp(void *param1, void *param2) {
+  sn764xx_state *info1 = (sn764xx_state *)param1;
+  sn764xx_state *info2 = (sn764xx_state *)param2;
+  switch (EMU_CORE) {
+  case EC_MAME:
+    sn76496_connect_ngp(info1->chip, info2->chip);
+    break;
+  }
+}
+
+void sn764xx_w(void *param, offs_t offset, UINT8 data) {
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     switch (offset) {
@@ -140,8 +184,8 @@ void sn764xx_set_emu_core(UINT8 Emulator) {
   return;
 }
 
-void sn764xx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+void sn764xx_set_mute_mask(void *param, UINT32 MuteMask) {
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     sn76496_set_mutemask(info->chip, MuteMask);
@@ -156,8 +200,8 @@ void sn764xx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask) {
   return;
 }
 
-void sn764xx_set_panning(UINT8 ChipID, INT16 *PanVals) {
-  sn764xx_state *info = &SN764xxData[ChipID];
+void sn764xx_set_panning(void *param, INT16 *PanVals) {
+  sn764xx_state *info = (sn764xx_state *)param;
   switch (EMU_CORE) {
   case EC_MAME:
     break;
@@ -8,15 +8,19 @@ WRITE8_DEVICE_HANDLER( ym2413_data_port_w );
 DEVICE_GET_INFO( ym2413 );
 #define SOUND_YM2413 DEVICE_GET_INFO_NAME( ym2413 )*/
 
-void sn764xx_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
+void sn764xx_stream_update(void *param, stream_sample_t **outputs, int samples);
 
-int device_start_sn764xx(UINT8 ChipID, int clock, int shiftregwidth, int noisetaps,
+int device_start_sn764xx(void **param, int clock, int shiftregwidth, int noisetaps,
 						 int negate, int stereo, int clockdivider, int freq0);
-void device_stop_sn764xx(UINT8 ChipID);
-void device_reset_sn764xx(UINT8 ChipID);
+void device_stop_sn764xx(void *param);
+void device_reset_sn764xx(void *param);
+UINT32 device_save_state_sn764xx(void *param, void *Data);
+UINT32 device_load_state_sn764xx(void *param, const void *Data);
 
-void sn764xx_w(UINT8 ChipID, offs_t offset, UINT8 data);
+void sn764xx_connect_ngp(void *param1, void *param2);
+
+void sn764xx_w(void *param, offs_t offset, UINT8 data);
 
 void sn764xx_set_emu_core(UINT8 Emulator);
-void sn764xx_set_mute_mask(UINT8 ChipID, UINT32 MuteMask);
-void sn764xx_set_panning(UINT8 ChipID, INT16* PanVals);
+void sn764xx_set_mute_mask(void *param, UINT32 MuteMask);
+void sn764xx_set_panning(void *param, INT16* PanVals);
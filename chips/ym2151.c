@@ -15,6 +15,11 @@
 //#include "streams.h"
 #include "ym2151.h"
 
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__clang__)
+// the AVX2 channel pass has its own function target, ym2151_init selects it
+#define YM2151_AVX2
+#include <immintrin.h>
+#endif
 
 /* undef this to not use MAME timer system */
 //#define USE_MAME_TIMERS
@@ -32,7 +37,6 @@
 
 /* struct describing a single operator */
 typedef struct{
-	UINT32		phase;					/* accumulated operator phase */
 	UINT32		freq;					/* operator frequency count */
 	INT32		dt1;					/* current DT1 (detune 1 phase inc/decrement) value */
 	UINT32		mul;					/* frequency count multiply */
@@ -43,24 +47,16 @@ typedef struct{
 
 	/* only M1 (operator 0) is filled with this data: */
 	signed int *mem_connect;			/* where to put the delayed sample (MEM) */
-	INT32		mem_value;				/* delayed sample (MEM) value */
 
 	/* channel specific data; note: each operator number 0 contains channel specific data */
-	UINT32		fb_shift;				/* feedback shift value for operators 0 in each channel */
-	INT32		fb_out_curr;			/* operator feedback value (used only by operators 0) */
-	INT32		fb_out_prev;			/* previous feedback value (used only by operators 0) */
 	UINT32		kc;						/* channel KC (copied to all operators) */
 	UINT32		kc_i;					/* just for speedup */
 	UINT32		pms;					/* channel PMS */
-	UINT32		ams;					/* channel AMS */
 	/* end of channel specific data */
 
-	UINT32		AMmask;					/* LFO Amplitude Modulation enable mask */
 	UINT32		state;					/* Envelope state: 4-attack(AR) 3-decay(D1R) 2-sustain(D2R) 1-release(RR) 0-off */
 	UINT8		eg_sh_ar;				/*  (attack state) */
 	UINT8		eg_sel_ar;				/*  (attack state) */
-	UINT32		tl;						/* Total attenuation Level */
-	INT32		volume;					/* current envelope attenuation level */
 	UINT8		eg_sh_d1r;				/*  (decay state) */
 	UINT8		eg_sel_d1r;				/*  (decay state) */
 	UINT32		d1l;					/* envelope switches to sustain state after reaching this level */
@@ -77,18 +73,36 @@ typedef struct{
 	UINT32		d2r;					/* sustain rate */
 	UINT32		rr;						/* release rate */
 
-	UINT32		reserved0;				/**/
-	UINT32		reserved1;				/**/
-
 } YM2151Operator;
 
+/* per sample operator state, operator s (M1, M2, C1, C2) of channel c at [s][c] */
+typedef struct
+{
+	UINT32		phase[4][8];			/* accumulated operator phase */
+	INT32		volume[4][8];			/* current envelope attenuation level */
+	UINT32		tl[4][8];				/* Total attenuation Level */
+	UINT32		AMmask[4][8];			/* LFO Amplitude Modulation enable mask */
+
+	/* channel specific data, kept by M1 */
+	UINT32		ams[8];					/* channel AMS */
+	UINT32		fb_shift[8];			/* feedback shift value */
+	INT32		fb_out_curr[8];			/* operator feedback value */
+	INT32		fb_out_prev[8];			/* previous feedback value */
+	INT32		mem_value[8];			/* delayed sample (MEM) value */
+} YM2151_OPS;
+
 
 typedef struct
 {
 	YM2151Operator	oper[32];			/* the 32 operators */
+	YM2151_OPS	op;						/* per sample state of the 32 operators */
+
+	signed int	chanout[8];				/* channel outputs of the current sample */
+	signed int	m2,c1,c2;				/* Phase Modulation input for operators 2,3,4 */
+	signed int	mem;					/* one sample delay memory */
 
 	UINT32		pan[16];				/* channels output masks (0xffffffff = enable) */
-	UINT8		Muted[8];				/* used for muting */
+	UINT32		MuteChn;				/* bit n set: channel n is muted */
 
 	UINT32		eg_cnt;					/* global envelope generator counter */
 	UINT32		eg_timer;				/* global envelope generator counter works at frequency = chipclock/64/3 */
@@ -219,16 +233,13 @@ typedef struct
 *   TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (13*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
 
 #define ENV_QUIET		(TL_TAB_LEN>>3)
 
-/* sin waveform table in 'decibel' scale */
-static unsigned int sin_tab[SIN_LEN];
-
-
-/* translate from D1L to volume index (16 D1L levels) */
-static UINT32 d1l_tab[16];
+/* tl_tab[TL_TAB_LEN], the sin waveform table in 'decibel' scale,
+   sin_tab[SIN_LEN], and d1l_tab[16], which translates from D1L to volume
+   index (16 D1L levels), are generated at build time by gentables.c */
+#include "ym2151_tables.h"
 
 
 #define RATE_STEPS (8)
@@ -483,13 +494,15 @@ static const UINT8 lfo_noise_waveform[256] = {
 };
 
 
+extern UINT8 SimdLevel;
 
-/* these variables stay here for speedup purposes only */
-static YM2151 * PSG;
-static signed int chanout[8];
-static signed int m2,c1,c2; /* Phase Modulation input for operators 2,3,4 */
-static signed int mem;		/* one sample delay memory */
-
+/* calculate the channels set in 'chns', selected by ym2151_init */
+typedef void (*YM2151_CALC_FUNC)(YM2151 *chip, UINT32 chns);
+static void calc_channels_C(YM2151 *chip, UINT32 chns);
+#ifdef YM2151_AVX2
+static void calc_channels_AVX2(YM2151 *chip, UINT32 chns);
+#endif
+static YM2151_CALC_FUNC calc_channels = calc_channels_C;
 
 /* save output as raw 16-bit sample */
 // #define SAVE_SAMPLE
@@ -503,95 +516,6 @@ static FILE *sample[9];
 
 
 
-static void init_tables(void)
-{
-	signed int i,x,n;
-	double o,m;
-
-	for (x=0; x<TL_RES_LEN; x++)
-	{
-		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
-		m = floor(m);
-
-		/* we never reach (1<<16) here due to the (x+1) */
-		/* result fits within 16 bits at maximum */
-
-		n = (int)m;		/* 16 bits here */
-		n >>= 4;		/* 12 bits here */
-		if (n&1)		/* round to closest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-						/* 11 bits here (rounded) */
-		n <<= 2;		/* 13 bits here (as in real chip) */
-		tl_tab[ x*2 + 0 ] = n;
-		tl_tab[ x*2 + 1 ] = -tl_tab[ x*2 + 0 ];
-
-		for (i=1; i<13; i++)
-		{
-			tl_tab[ x*2+0 + i*2*TL_RES_LEN ] =  tl_tab[ x*2+0 ]>>i;
-			tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = -tl_tab[ x*2+0 + i*2*TL_RES_LEN ];
-		}
-	#if 0
-		logerror("tl %04i", x*2);
-		for (i=0; i<13; i++)
-			logerror(", [%02i] %4i", i*2, tl_tab[ x*2 /*+1*/ + i*2*TL_RES_LEN ]);
-		logerror("\n");
-	#endif
-	}
-	/*logerror("TL_TAB_LEN = %i (%i bytes)\n",TL_TAB_LEN, (int)sizeof(tl_tab));*/
-	/*logerror("ENV_QUIET= %i\n",ENV_QUIET );*/
-
-
-	for (i=0; i<SIN_LEN; i++)
-	{
-		/* non-standard sinus */
-		m = sin( ((i*2)+1) * M_PI / SIN_LEN ); /* verified on the real chip */
-
-		/* we never reach zero here due to ((i*2)+1) */
-
-		if (m>0.0)
-			o = 8*log(1.0/m)/log(2.0);	/* convert to 'decibels' */
-		else
-			o = 8*log(-1.0/m)/log(2.0);	/* convert to 'decibels' */
-
-		o = o / (ENV_STEP/4);
-
-		n = (int)(2.0*o);
-		if (n&1)						/* round to closest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-
-		sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
-		/*logerror("sin [0x%4x]= %4i (tl_tab value=%8x)\n", i, sin_tab[i],tl_tab[sin_tab[i]]);*/
-	}
-
-
-	/* calculate d1l_tab table */
-	for (i=0; i<16; i++)
-	{
-		m = (i!=15 ? i : i+16) * (4.0/ENV_STEP);   /* every 3 'dB' except for all bits = 1 = 45+48 'dB' */
-		d1l_tab[i] = m;
-		/*logerror("d1l_tab[%02x]=%08x\n",i,d1l_tab[i] );*/
-	}
-
-#ifdef SAVE_SAMPLE
-	sample[8]=fopen("sampsum.pcm","wb");
-#endif
-#ifdef SAVE_SEPARATE_CHANNELS
-	sample[0]=fopen("samp0.pcm","wb");
-	sample[1]=fopen("samp1.pcm","wb");
-	sample[2]=fopen("samp2.pcm","wb");
-	sample[3]=fopen("samp3.pcm","wb");
-	sample[4]=fopen("samp4.pcm","wb");
-	sample[5]=fopen("samp5.pcm","wb");
-	sample[6]=fopen("samp6.pcm","wb");
-	sample[7]=fopen("samp7.pcm","wb");
-#endif
-}
-
-
 static void init_chip_tables(YM2151 *chip)
 {
 	int i,j;
@@ -738,21 +662,23 @@ static void init_chip_tables(YM2151 *chip)
 	}
 }
 
-#define KEY_ON(op, key_set){									\
-		if (!(op)->key)											\
+#define KEY_ON(chip, c, s, key_set){								\
+		YM2151Operator *op_ = &(chip)->oper[(c)*4+(s)];			\
+		INT32 *vol_ = &(chip)->op.volume[s][c];					\
+		if (!op_->key)											\
 		{														\
-			(op)->phase = 0;			/* clear phase */		\
-			(op)->state = EG_ATT;		/* KEY ON = attack */	\
-			(op)->volume += (~(op)->volume *					\
-                           (eg_inc[(op)->eg_sel_ar + ((PSG->eg_cnt>>(op)->eg_sh_ar)&7)])	\
+			(chip)->op.phase[s][c] = 0;	/* clear phase */		\
+			op_->state = EG_ATT;		/* KEY ON = attack */	\
+			*vol_ += (~*vol_ *									\
+                           (eg_inc[op_->eg_sel_ar + (((chip)->eg_cnt>>op_->eg_sh_ar)&7)])	\
                           ) >>4;								\
-			if ((op)->volume <= MIN_ATT_INDEX)					\
+			if (*vol_ <= MIN_ATT_INDEX)							\
 			{													\
-				(op)->volume = MIN_ATT_INDEX;					\
-				(op)->state = EG_DEC;							\
+				*vol_ = MIN_ATT_INDEX;							\
+				op_->state = EG_DEC;							\
 			}													\
 		}														\
-		(op)->key |= key_set;									\
+		op_->key |= key_set;									\
 }
 
 #define KEY_OFF(op, key_clr){									\
@@ -767,25 +693,27 @@ static void init_chip_tables(YM2151 *chip)
 		}														\
 }
 
-INLINE void envelope_KONKOFF(YM2151Operator * op, int v)
+INLINE void envelope_KONKOFF(YM2151 *chip, int c, int v)
 {
+	YM2151Operator *op = &chip->oper[c*4];
+
 	if (v&0x08)	/* M1 */
-		KEY_ON (op+0, 1)
+		KEY_ON (chip, c, 0, 1)
 	else
 		KEY_OFF(op+0,~1)
 
 	if (v&0x20)	/* M2 */
-		KEY_ON (op+1, 1)
+		KEY_ON (chip, c, 1, 1)
 	else
 		KEY_OFF(op+1,~1)
 
 	if (v&0x10)	/* C1 */
-		KEY_ON (op+2, 1)
+		KEY_ON (chip, c, 2, 1)
 	else
 		KEY_OFF(op+2,~1)
 
 	if (v&0x40)	/* C2 */
-		KEY_ON (op+3, 1)
+		KEY_ON (chip, c, 3, 1)
 	else
 		KEY_OFF(op+3,~1)
 }
@@ -871,8 +799,9 @@ static TIMER_CALLBACK( timer_callback_chip_busy )
 
 
 
-INLINE void set_connect( YM2151Operator *om1, int cha, int v)
+INLINE void set_connect( YM2151 *chip, int cha, int v)
 {
+	YM2151Operator *om1 = &chip->oper[cha*4];
 	YM2151Operator *om2 = om1+1;
 	YM2151Operator *oc1 = om1+2;
 
@@ -884,47 +813,47 @@ INLINE void set_connect( YM2151Operator *om1, int cha, int v)
 	{
 	case 0:
 		/* M1---C1---MEM---M2---C2---OUT */
-		om1->connect = &c1;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
+		om1->connect = &chip->c1;
+		oc1->connect = &chip->mem;
+		om2->connect = &chip->c2;
+		om1->mem_connect = &chip->m2;
 		break;
 
 	case 1:
 		/* M1------+-MEM---M2---C2---OUT */
 		/*      C1-+                     */
-		om1->connect = &mem;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
+		om1->connect = &chip->mem;
+		oc1->connect = &chip->mem;
+		om2->connect = &chip->c2;
+		om1->mem_connect = &chip->m2;
 		break;
 
 	case 2:
 		/* M1-----------------+-C2---OUT */
 		/*      C1---MEM---M2-+          */
-		om1->connect = &c2;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &m2;
+		om1->connect = &chip->c2;
+		oc1->connect = &chip->mem;
+		om2->connect = &chip->c2;
+		om1->mem_connect = &chip->m2;
 		break;
 
 	case 3:
 		/* M1---C1---MEM------+-C2---OUT */
 		/*                 M2-+          */
-		om1->connect = &c1;
-		oc1->connect = &mem;
-		om2->connect = &c2;
-		om1->mem_connect = &c2;
+		om1->connect = &chip->c1;
+		oc1->connect = &chip->mem;
+		om2->connect = &chip->c2;
+		om1->mem_connect = &chip->c2;
 		break;
 
 	case 4:
 		/* M1---C1-+-OUT */
 		/* M2---C2-+     */
 		/* MEM: not used */
-		om1->connect = &c1;
-		oc1->connect = &chanout[cha];
-		om2->connect = &c2;
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
+		om1->connect = &chip->c1;
+		oc1->connect = &chip->chanout[cha];
+		om2->connect = &chip->c2;
+		om1->mem_connect = &chip->mem;	/* store it anywhere where it will not be used */
 		break;
 
 	case 5:
@@ -932,9 +861,9 @@ INLINE void set_connect( YM2151Operator *om1, int cha, int v)
 		/* M1-+-MEM---M2-+-OUT */
 		/*    +----C2----+     */
 		om1->connect = 0;	/* special mark */
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &m2;
+		oc1->connect = &chip->chanout[cha];
+		om2->connect = &chip->chanout[cha];
+		om1->mem_connect = &chip->m2;
 		break;
 
 	case 6:
@@ -942,10 +871,10 @@ INLINE void set_connect( YM2151Operator *om1, int cha, int v)
 		/*      M2-+-OUT */
 		/*      C2-+     */
 		/* MEM: not used */
-		om1->connect = &c1;
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
+		om1->connect = &chip->c1;
+		oc1->connect = &chip->chanout[cha];
+		om2->connect = &chip->chanout[cha];
+		om1->mem_connect = &chip->mem;	/* store it anywhere where it will not be used */
 		break;
 
 	case 7:
@@ -954,10 +883,10 @@ INLINE void set_connect( YM2151Operator *om1, int cha, int v)
 		/* M2-+     */
 		/* C2-+     */
 		/* MEM: not used*/
-		om1->connect = &chanout[cha];
-		oc1->connect = &chanout[cha];
-		om2->connect = &chanout[cha];
-		om1->mem_connect = &mem;	/* store it anywhere where it will not be used */
+		om1->connect = &chip->chanout[cha];
+		oc1->connect = &chip->chanout[cha];
+		om2->connect = &chip->chanout[cha];
+		om1->mem_connect = &chip->mem;	/* store it anywhere where it will not be used */
 		break;
 	}
 }
@@ -1086,8 +1015,7 @@ void ym2151_write_reg(void *_chip, int r, int v)
 			break;
 
 		case 0x08:
-			PSG = chip; /* PSG is used in KEY_ON macro */
-			envelope_KONKOFF(&chip->oper[ (v&7)*4 ], v );
+			envelope_KONKOFF(chip, v&7, v );
 			break;
 
 		case 0x0f:	/* noise mode enable, noise period */
@@ -1218,11 +1146,11 @@ void ym2151_write_reg(void *_chip, int r, int v)
 		op = &chip->oper[ (r&7) * 4 ];
 		switch(r & 0x18){
 		case 0x00:	/* RL enable, Feedback, Connection */
-			op->fb_shift = ((v>>3)&7) ? ((v>>3)&7)+6:0;
+			chip->op.fb_shift[r&7] = ((v>>3)&7) ? ((v>>3)&7)+6:0;
 			chip->pan[ (r&7)*2    ] = (v & 0x40) ? ~0 : 0;
 			chip->pan[ (r&7)*2 +1 ] = (v & 0x80) ? ~0 : 0;
 			chip->connect[r&7] = v&7;
-			set_connect(op, r&7, v&7);
+			set_connect(chip, r&7, v&7);
 			break;
 
 		case 0x08:	/* Key Code */
@@ -1285,7 +1213,7 @@ void ym2151_write_reg(void *_chip, int r, int v)
 
 		case 0x18:	/* PMS, AMS */
 			op->pms = (v>>4) & 7;
-			op->ams = (v & 3);
+			chip->op.ams[r&7] = (v & 3);
 			break;
 		}
 		break;
@@ -1307,7 +1235,7 @@ void ym2151_write_reg(void *_chip, int r, int v)
 		break;
 
 	case 0x60:		/* TL */
-		op->tl = (v&0x7f)<<(ENV_BITS-7); /* 7bit TL */
+		chip->op.tl[(r&0x18)>>3][r&7] = (v&0x7f)<<(ENV_BITS-7); /* 7bit TL */
 		break;
 
 	case 0x80:		/* KS, AR */
@@ -1345,7 +1273,7 @@ void ym2151_write_reg(void *_chip, int r, int v)
 		break;
 
 	case 0xa0:		/* LFO AM enable, D1R */
-		op->AMmask = (v&0x80) ? ~0 : 0;
+		chip->op.AMmask[(r&0x18)>>3][r&7] = (v&0x80) ? ~0 : 0;
 		op->d1r    = (v&0x1f) ? 32 + ((v&0x1f)<<1) : 0;
 		op->eg_sh_d1r = eg_rate_shift [op->d1r + (op->kc>>op->ks) ];
 		op->eg_sel_d1r= eg_rate_select[op->d1r + (op->kc>>op->ks) ];
@@ -1521,7 +1449,6 @@ static void ym2151_state_save_register( YM2151 *chip, const device_config *devic
 void * ym2151_init(int clock, int rate)
 {
 	YM2151 *PSG;
-	int chn;
 
 	PSG = (YM2151 *)malloc(sizeof(YM2151));
 	if (PSG == NULL)
@@ -1531,7 +1458,19 @@ void * ym2151_init(int clock, int rate)
 
 	//ym2151_state_save_register( PSG, device );
 
-	init_tables();
+#ifdef SAVE_SAMPLE
+	sample[8]=fopen("sampsum.pcm","wb");
+#endif
+#ifdef SAVE_SEPARATE_CHANNELS
+	sample[0]=fopen("samp0.pcm","wb");
+	sample[1]=fopen("samp1.pcm","wb");
+	sample[2]=fopen("samp2.pcm","wb");
+	sample[3]=fopen("samp3.pcm","wb");
+	sample[4]=fopen("samp4.pcm","wb");
+	sample[5]=fopen("samp5.pcm","wb");
+	sample[6]=fopen("samp6.pcm","wb");
+	sample[7]=fopen("samp7.pcm","wb");
+#endif
 
 	//PSG->device = device;
 	PSG->clock = clock;
@@ -1555,8 +1494,12 @@ void * ym2151_init(int clock, int rate)
 	PSG->tim_A      = 0;
 	PSG->tim_B      = 0;
 #endif
-	for (chn = 0; chn < 8; chn ++)
-		PSG->Muted[chn] = 0x00;
+	PSG->MuteChn = 0x00;
+	calc_channels = calc_channels_C;
+#ifdef YM2151_AVX2
+	if (SimdLevel >= SIMD_AVX2)
+		calc_channels = calc_channels_AVX2;
+#endif
 	//ym2151_reset_chip(PSG);
 	/*logerror("YM2151[init] clock=%i sampfreq=%i\n", PSG->clock, PSG->sampfreq);*/
 
@@ -1612,10 +1555,11 @@ void ym2151_reset_chip(void *_chip)
 
 
 	/* initialize hardware registers */
+	memset(&chip->op,'\0',sizeof(YM2151_OPS));
 	for (i=0; i<32; i++)
 	{
 		memset(&chip->oper[i],'\0',sizeof(YM2151Operator));
-		chip->oper[i].volume = MAX_ATT_INDEX;
+		chip->op.volume[i&3][i>>2] = MAX_ATT_INDEX;
 	        chip->oper[i].kc_i = 768; /* min kc_i value */
 	}
 
@@ -1667,12 +1611,12 @@ void ym2151_reset_chip(void *_chip)
 
 
 
-INLINE signed int op_calc(YM2151Operator * OP, unsigned int env, signed int pm)
+INLINE signed int op_calc(UINT32 phase, unsigned int env, signed int pm)
 {
 	UINT32 p;
 
 
-	p = (env<<3) + sin_tab[ ( ((signed int)((OP->phase & ~FREQ_MASK) + (pm<<15))) >> FREQ_SH ) & SIN_MASK ];
+	p = (env<<3) + sin_tab[ ( ((signed int)((phase & ~FREQ_MASK) + (pm<<15))) >> FREQ_SH ) & SIN_MASK ];
 
 	if (p >= TL_TAB_LEN)
 		return 0;
@@ -1680,15 +1624,15 @@ INLINE signed int op_calc(YM2151Operator * OP, unsigned int env, signed int pm)
 	return tl_tab[p];
 }
 
-INLINE signed int op_calc1(YM2151Operator * OP, unsigned int env, signed int pm)
+INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
 {
 	UINT32 p;
 	INT32  i;
 
 
-	i = (OP->phase & ~FREQ_MASK) + pm;
+	i = (phase & ~FREQ_MASK) + pm;
 
-/*logerror("i=%08x (i>>16)&511=%8i phase=%i [pm=%08x] ",i, (i>>16)&511, OP->phase>>FREQ_SH, pm);*/
+/*logerror("i=%08x (i>>16)&511=%8i phase=%i [pm=%08x] ",i, (i>>16)&511, phase>>FREQ_SH, pm);*/
 
 	p = (env<<3) + sin_tab[ (i>>FREQ_SH) & SIN_MASK];
 
@@ -1702,128 +1646,280 @@ INLINE signed int op_calc1(YM2151Operator * OP, unsigned int env, signed int pm)
 
 
 
-#define volume_calc(OP) ((OP)->tl + ((UINT32)(OP)->volume) + (AM & (OP)->AMmask))
+#define volume_calc(s,c) (ops->tl[s][c] + ((UINT32)ops->volume[s][c]) + (AM & ops->AMmask[s][c]))
 
-INLINE void chan_calc(unsigned int chan)
+INLINE void chan_calc(YM2151 *chip, unsigned int chan)
 {
+	YM2151_OPS *ops = &chip->op;
 	YM2151Operator *op;
 	unsigned int env;
 	UINT32 AM = 0;
 
-	if (PSG->Muted[chan])
-		return;
-	
-	m2 = c1 = c2 = mem = 0;
-	op = &PSG->oper[chan*4];	/* M1 */
+	chip->m2 = chip->c1 = chip->c2 = chip->mem = 0;
+	chip->chanout[chan] = 0;
+	op = &chip->oper[chan*4];	/* M1 */
 
-	*op->mem_connect = op->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
+	*op->mem_connect = ops->mem_value[chan];	/* restore delayed sample (MEM) value to m2 or c2 */
 
-	if (op->ams)
-		AM = PSG->lfa << (op->ams-1);
-	env = volume_calc(op);
+	if (ops->ams[chan])
+		AM = chip->lfa << (ops->ams[chan]-1);
+	env = volume_calc(0, chan);
 	{
-		INT32 out = op->fb_out_prev + op->fb_out_curr;
-		op->fb_out_prev = op->fb_out_curr;
+		INT32 out = ops->fb_out_prev[chan] + ops->fb_out_curr[chan];
+		ops->fb_out_prev[chan] = ops->fb_out_curr[chan];
 
 		if (!op->connect)
 			/* algorithm 5 */
-			mem = c1 = c2 = op->fb_out_prev;
+			chip->mem = chip->c1 = chip->c2 = ops->fb_out_prev[chan];
 		else
 			/* other algorithms */
-			*op->connect = op->fb_out_prev;
+			*op->connect = ops->fb_out_prev[chan];
 
-		op->fb_out_curr = 0;
+		ops->fb_out_curr[chan] = 0;
 		if (env < ENV_QUIET)
 		{
-			if (!op->fb_shift)
+			if (!ops->fb_shift[chan])
 				out=0;
-			op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
+			ops->fb_out_curr[chan] = op_calc1(ops->phase[0][chan], env, (out<<ops->fb_shift[chan]) );
 		}
 	}
 
-	env = volume_calc(op+1);	/* M2 */
+	env = volume_calc(1, chan);	/* M2 */
 	if (env < ENV_QUIET)
-		*(op+1)->connect += op_calc(op+1, env, m2);
+		*(op+1)->connect += op_calc(ops->phase[1][chan], env, chip->m2);
 
-	env = volume_calc(op+2);	/* C1 */
+	env = volume_calc(2, chan);	/* C1 */
 	if (env < ENV_QUIET)
-		*(op+2)->connect += op_calc(op+2, env, c1);
+		*(op+2)->connect += op_calc(ops->phase[2][chan], env, chip->c1);
 
-	env = volume_calc(op+3);	/* C2 */
+	env = volume_calc(3, chan);	/* C2 */
 	if (env < ENV_QUIET)
-		chanout[chan]    += op_calc(op+3, env, c2);
-	if (chanout[chan] > +16384)			chanout[chan] = +16384;
-	else if (chanout[chan] < -16384)	chanout[chan] = -16384;
+		chip->chanout[chan] += op_calc(ops->phase[3][chan], env, chip->c2);
+	if (chip->chanout[chan] > +16384)			chip->chanout[chan] = +16384;
+	else if (chip->chanout[chan] < -16384)	chip->chanout[chan] = -16384;
 
 	/* M1 */
-	op->mem_value = mem;
+	ops->mem_value[chan] = chip->mem;
 }
-INLINE void chan7_calc(void)
+INLINE void chan7_calc(YM2151 *chip)
 {
+	YM2151_OPS *ops = &chip->op;
 	YM2151Operator *op;
 	unsigned int env;
 	UINT32 AM = 0;
 
-	if (PSG->Muted[7])
-		return;
-	
-	m2 = c1 = c2 = mem = 0;
-	op = &PSG->oper[7*4];		/* M1 */
+	chip->m2 = chip->c1 = chip->c2 = chip->mem = 0;
+	chip->chanout[7] = 0;
+	op = &chip->oper[7*4];	/* M1 */
 
-	*op->mem_connect = op->mem_value;	/* restore delayed sample (MEM) value to m2 or c2 */
+	*op->mem_connect = ops->mem_value[7];	/* restore delayed sample (MEM) value to m2 or c2 */
 
-	if (op->ams)
-		AM = PSG->lfa << (op->ams-1);
-	env = volume_calc(op);
+	if (ops->ams[7])
+		AM = chip->lfa << (ops->ams[7]-1);
+	env = volume_calc(0, 7);
 	{
-		INT32 out = op->fb_out_prev + op->fb_out_curr;
-		op->fb_out_prev = op->fb_out_curr;
+		INT32 out = ops->fb_out_prev[7] + ops->fb_out_curr[7];
+		ops->fb_out_prev[7] = ops->fb_out_curr[7];
 
 		if (!op->connect)
 			/* algorithm 5 */
-			mem = c1 = c2 = op->fb_out_prev;
+			chip->mem = chip->c1 = chip->c2 = ops->fb_out_prev[7];
 		else
 			/* other algorithms */
-			*op->connect = op->fb_out_prev;
+			*op->connect = ops->fb_out_prev[7];
 
-		op->fb_out_curr = 0;
+		ops->fb_out_curr[7] = 0;
 		if (env < ENV_QUIET)
 		{
-			if (!op->fb_shift)
+			if (!ops->fb_shift[7])
 				out=0;
-			op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
+			ops->fb_out_curr[7] = op_calc1(ops->phase[0][7], env, (out<<ops->fb_shift[7]) );
 		}
 	}
 
-	env = volume_calc(op+1);	/* M2 */
+	env = volume_calc(1, 7);	/* M2 */
 	if (env < ENV_QUIET)
-		*(op+1)->connect += op_calc(op+1, env, m2);
+		*(op+1)->connect += op_calc(ops->phase[1][7], env, chip->m2);
 
-	env = volume_calc(op+2);	/* C1 */
+	env = volume_calc(2, 7);	/* C1 */
 	if (env < ENV_QUIET)
-		*(op+2)->connect += op_calc(op+2, env, c1);
+		*(op+2)->connect += op_calc(ops->phase[2][7], env, chip->c1);
 
-	env = volume_calc(op+3);	/* C2 */
-	if (PSG->noise & 0x80)
+	env = volume_calc(3, 7);	/* C2 */
+	if (chip->noise & 0x80)
 	{
 		INT32 noiseout;
 
 		noiseout = 0;
 		if (env < 0x3ff)
 			noiseout = (env ^ 0x3ff) * 2;	/* range of the YM2151 noise output is -2044 to 2040 */
-		chanout[7] += ((PSG->noise_rng&0x10000) ? noiseout: -noiseout); /* bit 16 -> output */
+		chip->chanout[7] += ((chip->noise_rng&0x10000) ? noiseout: -noiseout); /* bit 16 -> output */
 	}
 	else
 	{
 		if (env < ENV_QUIET)
-			chanout[7] += op_calc(op+3, env, c2);
+			chip->chanout[7] += op_calc(ops->phase[3][7], env, chip->c2);
 	}
-	if (chanout[7] > +16384)		chanout[7] = +16384;
-	else if (chanout[7] < -16384)	chanout[7] = -16384;
+	if (chip->chanout[7] > +16384)		chip->chanout[7] = +16384;
+	else if (chip->chanout[7] < -16384)	chip->chanout[7] = -16384;
 	/* M1 */
-	op->mem_value = mem;
+	ops->mem_value[7] = chip->mem;
+}
+
+static void calc_channels_C(YM2151 *chip, UINT32 chns)
+{
+	if (chns & 0x01) chan_calc(chip, 0);
+	if (chns & 0x02) chan_calc(chip, 1);
+	if (chns & 0x04) chan_calc(chip, 2);
+	if (chns & 0x08) chan_calc(chip, 3);
+	if (chns & 0x10) chan_calc(chip, 4);
+	if (chns & 0x20) chan_calc(chip, 5);
+	if (chns & 0x40) chan_calc(chip, 6);
+	if (chns & 0x80) chan7_calc(chip);
+}
+
+#ifdef YM2151_AVX2
+/* where the outputs of an algorithm go, one flag word per connection type */
+#define RT_M1_C1	0x001	/* M1 modulates C1 */
+#define RT_M1_MEM	0x002	/* M1 goes to MEM */
+#define RT_M1_C2	0x004	/* M1 modulates C2 */
+#define RT_M1_OUT	0x008	/* M1 goes to the output */
+#define RT_MEM_M2	0x010	/* MEM modulates M2 */
+#define RT_MEM_C2	0x020	/* MEM modulates C2 */
+#define RT_MEM_KEEP	0x040	/* MEM is not used and keeps its value */
+#define RT_M2_OUT	0x080	/* M2 goes to the output, else modulates C2 */
+#define RT_C1_OUT	0x100	/* C1 goes to the output, else to MEM */
+
+static const INT32 connect_route[8] =
+{
+	RT_M1_C1  | RT_MEM_M2,								/* 0 */
+	RT_M1_MEM | RT_MEM_M2,								/* 1 */
+	RT_M1_C2  | RT_MEM_M2,								/* 2 */
+	RT_M1_C1  | RT_MEM_C2,								/* 3 */
+	RT_M1_C1  | RT_MEM_KEEP | RT_C1_OUT,				/* 4 */
+	RT_M1_C1  | RT_M1_MEM | RT_M1_C2 | RT_MEM_M2 | RT_M2_OUT | RT_C1_OUT,	/* 5 */
+	RT_M1_C1  | RT_MEM_KEEP | RT_M2_OUT | RT_C1_OUT,	/* 6 */
+	RT_M1_OUT | RT_MEM_KEEP | RT_M2_OUT | RT_C1_OUT		/* 7 */
+};
+
+/* op_calc1 (pm as is) for the operators in 'on', the others give 0 */
+__attribute__((target("avx2")))
+INLINE __m256i op_calc_AVX2(__m256i phase, __m256i env, __m256i pm, __m256i on)
+{
+	__m256i p;
+
+	if (_mm256_testz_si256(on, on))
+		return _mm256_setzero_si256();
+	p = _mm256_add_epi32(_mm256_and_si256(phase, _mm256_set1_epi32(~FREQ_MASK)), pm);
+	p = _mm256_and_si256(_mm256_srli_epi32(p, FREQ_SH), _mm256_set1_epi32(SIN_MASK));
+	p = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)sin_tab, p, on, 4);
+	p = _mm256_add_epi32(_mm256_slli_epi32(env, 3), p);
+
+	on = _mm256_and_si256(on, _mm256_cmpgt_epi32(_mm256_set1_epi32(TL_TAB_LEN), p));
+	return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tl_tab, p, on, 4);
 }
 
+#define LOAD8(x) _mm256_loadu_si256((const __m256i *)(x))
+#define ROUTE(f) _mm256_cmpeq_epi32(_mm256_and_si256(route, _mm256_set1_epi32(f)), _mm256_set1_epi32(f))
+
+/* all 8 channels with a lane per channel, operator by operator */
+__attribute__((target("avx2")))
+static void calc_channels_AVX2(YM2151 *chip, UINT32 chns)
+{
+	YM2151_OPS *ops = &chip->op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bits = _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+	const __m256i quiet = _mm256_set1_epi32(ENV_QUIET);
+	__m256i run, route, am, env[4], on[4], mem_val, prev, curr, fb, pm;
+	__m256i res, m2, c1, c2, mem, out;
+	INT32 noiseout;
+	int s;
+
+	run = _mm256_and_si256(_mm256_set1_epi32(chns), bits);
+	run = _mm256_cmpeq_epi32(run, bits);
+	/* AM = lfa << (ams-1), a shift count of -1 gives 0 for AMS 0 */
+	am = _mm256_sllv_epi32(_mm256_set1_epi32(chip->lfa),
+					_mm256_sub_epi32(LOAD8(ops->ams), _mm256_set1_epi32(1)));
+	for (s = 0; s < 4; s ++)
+	{
+		env[s] = _mm256_add_epi32(LOAD8(ops->tl[s]), LOAD8(ops->volume[s]));
+		env[s] = _mm256_add_epi32(env[s], _mm256_and_si256(am, LOAD8(ops->AMmask[s])));
+		on[s] = _mm256_and_si256(run, _mm256_cmpgt_epi32(quiet, env[s]));
+	}
+
+	/* C2 of channel 7 outputs noise instead when it is enabled */
+	noiseout = 0;
+	if ((chip->noise & 0x80) && (chns & 0x80))
+	{
+		UINT32 env7 = _mm256_extract_epi32(env[3], 7);
+
+		on[3] = _mm256_blend_epi32(on[3], zero, 0x80);
+		if (env7 < 0x3ff)
+			noiseout = (env7 ^ 0x3ff) * 2;	/* range of the YM2151 noise output is -2044 to 2040 */
+		if (! (chip->noise_rng&0x10000))	/* bit 16 -> output */
+			noiseout = -noiseout;
+	}
+
+	/* the gathers of a vector pass cost about as much as 20 operators in the scalar code */
+	s = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(on[0]))) +
+		__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(on[1]))) +
+		__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(on[2]))) +
+		__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(on[3])));
+	if (s < 20)
+	{
+		_mm256_zeroupper();
+		calc_channels_C(chip, chns);
+		return;
+	}
+
+	route = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)chip->connect));
+	route = _mm256_permutevar8x32_epi32(LOAD8(connect_route), route);
+
+	/* restore the delayed sample (MEM) */
+	mem_val = LOAD8(ops->mem_value);
+	m2 = _mm256_and_si256(mem_val, ROUTE(RT_MEM_M2));
+	c2 = _mm256_and_si256(mem_val, ROUTE(RT_MEM_C2));
+	mem = _mm256_and_si256(mem_val, ROUTE(RT_MEM_KEEP));
+
+	/* M1 (feedback from the last two outputs) */
+	prev = LOAD8(ops->fb_out_prev);
+	curr = LOAD8(ops->fb_out_curr);
+	c1 = _mm256_and_si256(curr, ROUTE(RT_M1_C1));
+	mem = _mm256_add_epi32(mem, _mm256_and_si256(curr, ROUTE(RT_M1_MEM)));
+	c2 = _mm256_add_epi32(c2, _mm256_and_si256(curr, ROUTE(RT_M1_C2)));
+	out = _mm256_and_si256(curr, ROUTE(RT_M1_OUT));
+	fb = LOAD8(ops->fb_shift);
+	pm = _mm256_sllv_epi32(_mm256_add_epi32(prev, curr), fb);
+	pm = _mm256_andnot_si256(_mm256_cmpeq_epi32(fb, zero), pm);
+	res = op_calc_AVX2(LOAD8(ops->phase[0]), env[0], pm, on[0]);
+	_mm256_storeu_si256((__m256i *)ops->fb_out_prev, _mm256_blendv_epi8(prev, curr, run));
+	_mm256_storeu_si256((__m256i *)ops->fb_out_curr, _mm256_blendv_epi8(curr, res, run));
+
+	/* M2 */
+	res = op_calc_AVX2(LOAD8(ops->phase[1]), env[1], _mm256_slli_epi32(m2, 15), on[1]);
+	pm = ROUTE(RT_M2_OUT);
+	out = _mm256_add_epi32(out, _mm256_and_si256(pm, res));
+	c2 = _mm256_add_epi32(c2, _mm256_andnot_si256(pm, res));
+
+	/* C1 */
+	res = op_calc_AVX2(LOAD8(ops->phase[2]), env[2], _mm256_slli_epi32(c1, 15), on[2]);
+	pm = ROUTE(RT_C1_OUT);
+	out = _mm256_add_epi32(out, _mm256_and_si256(pm, res));
+	mem = _mm256_add_epi32(mem, _mm256_andnot_si256(pm, res));
+	_mm256_storeu_si256((__m256i *)ops->mem_value, _mm256_blendv_epi8(mem_val, mem, run));
+
+	/* C2 */
+	res = op_calc_AVX2(LOAD8(ops->phase[3]), env[3], _mm256_slli_epi32(c2, 15), on[3]);
+	out = _mm256_add_epi32(out, res);
+	out = _mm256_add_epi32(out, _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, noiseout));
+
+	out = _mm256_min_epi32(out, _mm256_set1_epi32(+16384));
+	out = _mm256_max_epi32(out, _mm256_set1_epi32(-16384));
+	_mm256_storeu_si256((__m256i *)chip->chanout, _mm256_and_si256(out, run));
+	_mm256_zeroupper();
+}
+#endif
+
 
 
 
@@ -2033,38 +2129,40 @@ rate 11 1         |
                                  --
 */
 
-INLINE void advance_eg(void)
+INLINE void advance_eg(YM2151 *chip)
 {
 	YM2151Operator *op;
+	INT32 *volume;
 	unsigned int i;
 
 
 
-	PSG->eg_timer += PSG->eg_timer_add;
+	chip->eg_timer += chip->eg_timer_add;
 
-	while (PSG->eg_timer >= PSG->eg_timer_overflow)
+	while (chip->eg_timer >= chip->eg_timer_overflow)
 	{
-		PSG->eg_timer -= PSG->eg_timer_overflow;
+		chip->eg_timer -= chip->eg_timer_overflow;
 
-		PSG->eg_cnt++;
+		chip->eg_cnt++;
 
 		/* envelope generator */
-		op = &PSG->oper[0];	/* CH 0 M1 */
-		i = 32;
+		op = &chip->oper[0];	/* CH 0 M1 */
+		i = 0;
 		do
 		{
+			volume = &chip->op.volume[i&3][i>>2];
 			switch(op->state)
 			{
 			case EG_ATT:	/* attack phase */
-				if ( !(PSG->eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
+				if ( !(chip->eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
 				{
-					op->volume += (~op->volume *
-                                   (eg_inc[op->eg_sel_ar + ((PSG->eg_cnt>>op->eg_sh_ar)&7)])
+					*volume += (~*volume *
+                                   (eg_inc[op->eg_sel_ar + ((chip->eg_cnt>>op->eg_sh_ar)&7)])
                                   ) >>4;
 
-					if (op->volume <= MIN_ATT_INDEX)
+					if (*volume <= MIN_ATT_INDEX)
 					{
-						op->volume = MIN_ATT_INDEX;
+						*volume = MIN_ATT_INDEX;
 						op->state = EG_DEC;
 					}
 
@@ -2072,24 +2170,24 @@ INLINE void advance_eg(void)
 			break;
 
 			case EG_DEC:	/* decay phase */
-				if ( !(PSG->eg_cnt & ((1<<op->eg_sh_d1r)-1) ) )
+				if ( !(chip->eg_cnt & ((1<<op->eg_sh_d1r)-1) ) )
 				{
-					op->volume += eg_inc[op->eg_sel_d1r + ((PSG->eg_cnt>>op->eg_sh_d1r)&7)];
+					*volume += eg_inc[op->eg_sel_d1r + ((chip->eg_cnt>>op->eg_sh_d1r)&7)];
 
-					if ( op->volume >= op->d1l )
+					if ( *volume >= op->d1l )
 						op->state = EG_SUS;
 
 				}
 			break;
 
 			case EG_SUS:	/* sustain phase */
-				if ( !(PSG->eg_cnt & ((1<<op->eg_sh_d2r)-1) ) )
+				if ( !(chip->eg_cnt & ((1<<op->eg_sh_d2r)-1) ) )
 				{
-					op->volume += eg_inc[op->eg_sel_d2r + ((PSG->eg_cnt>>op->eg_sh_d2r)&7)];
+					*volume += eg_inc[op->eg_sel_d2r + ((chip->eg_cnt>>op->eg_sh_d2r)&7)];
 
-					if ( op->volume >= MAX_ATT_INDEX )
+					if ( *volume >= MAX_ATT_INDEX )
 					{
-						op->volume = MAX_ATT_INDEX;
+						*volume = MAX_ATT_INDEX;
 						op->state = EG_OFF;
 					}
 
@@ -2097,13 +2195,13 @@ INLINE void advance_eg(void)
 			break;
 
 			case EG_REL:	/* release phase */
-				if ( !(PSG->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
+				if ( !(chip->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 				{
-					op->volume += eg_inc[op->eg_sel_rr + ((PSG->eg_cnt>>op->eg_sh_rr)&7)];
+					*volume += eg_inc[op->eg_sel_rr + ((chip->eg_cnt>>op->eg_sh_rr)&7)];
 
-					if ( op->volume >= MAX_ATT_INDEX )
+					if ( *volume >= MAX_ATT_INDEX )
 					{
-						op->volume = MAX_ATT_INDEX;
+						*volume = MAX_ATT_INDEX;
 						op->state = EG_OFF;
 					}
 
@@ -2111,93 +2209,109 @@ INLINE void advance_eg(void)
 			break;
 			}
 			op++;
-			i--;
-		}while (i);
+			i++;
+		}while (i < 32);
 	}
 }
 
 
-INLINE void advance(void)
+/*  LFO and noise generator for the next 'length' samples, they only depend
+*   on registers that can't change within an update.
+*   lfa[n], lfp[n] and rng[n] receive the LFO AM/PM output and the noise
+*   shift register after sample n, the chip takes them over sample by sample.
+*/
+static void advance_lfo_noise(YM2151 *chip, int length, UINT32 *lfa, INT32 *lfp, UINT32 *rng)
 {
-	YM2151Operator *op;
-	unsigned int i;
+	UINT32 i;
+	UINT32 noise_rng;
+	int n;
 	int a,p;
 
-	/* LFO */
-	if (PSG->test&2)
-		PSG->lfo_phase = 0;
-	else
+	i = ~0;	/* the waveform is recalculated on the first sample */
+	a = p = 0;
+	for (n=0; n<length; n++)
 	{
-		PSG->lfo_timer += PSG->lfo_timer_add;
-		if (PSG->lfo_timer >= PSG->lfo_overflow)
+		/* LFO */
+		if (chip->test&2)
+			chip->lfo_phase = 0;
+		else
 		{
-			PSG->lfo_timer   -= PSG->lfo_overflow;
-			PSG->lfo_counter += PSG->lfo_counter_add;
-			PSG->lfo_phase   += (PSG->lfo_counter>>4);
-			PSG->lfo_phase   &= 255;
-			PSG->lfo_counter &= 15;
+			chip->lfo_timer += chip->lfo_timer_add;
+			if (chip->lfo_timer >= chip->lfo_overflow)
+			{
+				chip->lfo_timer   -= chip->lfo_overflow;
+				chip->lfo_counter += chip->lfo_counter_add;
+				chip->lfo_phase   += (chip->lfo_counter>>4);
+				chip->lfo_phase   &= 255;
+				chip->lfo_counter &= 15;
+			}
 		}
-	}
 
-	i = PSG->lfo_phase;
-	/* calculate LFO AM and PM waveform value (all verified on real chip, except for noise algorithm which is impossible to analyse)*/
-	switch (PSG->lfo_wsel)
-	{
-	case 0:
-		/* saw */
-		/* AM: 255 down to 0 */
-		/* PM: 0 to 127, -127 to 0 (at PMD=127: LFP = 0 to 126, -126 to 0) */
-		a = 255 - i;
-		if (i<128)
-			p = i;
-		else
-			p = i - 255;
-		break;
-	case 1:
-		/* square */
-		/* AM: 255, 0 */
-		/* PM: 128,-128 (LFP = exactly +PMD, -PMD) */
-		if (i<128){
-			a = 255;
-			p = 128;
-		}else{
-			a = 0;
-			p = -128;
+		if (i != chip->lfo_phase)
+		{
+			i = chip->lfo_phase;
+			/* calculate LFO AM and PM waveform value (all verified on real chip, except for noise algorithm which is impossible to analyse)*/
+			switch (chip->lfo_wsel)
+			{
+			case 0:
+				/* saw */
+				/* AM: 255 down to 0 */
+				/* PM: 0 to 127, -127 to 0 (at PMD=127: LFP = 0 to 126, -126 to 0) */
+				a = 255 - i;
+				if (i<128)
+					p = i;
+				else
+					p = i - 255;
+				break;
+			case 1:
+				/* square */
+				/* AM: 255, 0 */
+				/* PM: 128,-128 (LFP = exactly +PMD, -PMD) */
+				if (i<128){
+					a = 255;
+					p = 128;
+				}else{
+					a = 0;
+					p = -128;
+				}
+				break;
+			case 2:
+				/* triangle */
+				/* AM: 255 down to 1 step -2; 0 up to 254 step +2 */
+				/* PM: 0 to 126 step +2, 127 to 1 step -2, 0 to -126 step -2, -127 to -1 step +2*/
+				if (i<128)
+					a = 255 - (i*2);
+				else
+					a = (i*2) - 256;
+
+				if (i<64)						/* i = 0..63 */
+					p = i*2;					/* 0 to 126 step +2 */
+				else if (i<128)					/* i = 64..127 */
+						p = 255 - i*2;			/* 127 to 1 step -2 */
+					else if (i<192)				/* i = 128..191 */
+							p = 256 - i*2;		/* 0 to -126 step -2*/
+						else					/* i = 192..255 */
+							p = i*2 - 511;		/*-127 to -1 step +2*/
+				break;
+			case 3:
+			default:	/*keep the compiler happy*/
+				/* random */
+				/* the real algorithm is unknown !!!
+	            We just use a snapshot of data from real chip */
+
+				/* AM: range 0 to 255    */
+				/* PM: range -128 to 127 */
+
+				a = lfo_noise_waveform[i];
+				p = a-128;
+				break;
+			}
+			a = a * chip->amd / 128;
+			p = p * chip->pmd / 128;
 		}
-		break;
-	case 2:
-		/* triangle */
-		/* AM: 255 down to 1 step -2; 0 up to 254 step +2 */
-		/* PM: 0 to 126 step +2, 127 to 1 step -2, 0 to -126 step -2, -127 to -1 step +2*/
-		if (i<128)
-			a = 255 - (i*2);
-		else
-			a = (i*2) - 256;
-
-		if (i<64)						/* i = 0..63 */
-			p = i*2;					/* 0 to 126 step +2 */
-		else if (i<128)					/* i = 64..127 */
-				p = 255 - i*2;			/* 127 to 1 step -2 */
-			else if (i<192)				/* i = 128..191 */
-					p = 256 - i*2;		/* 0 to -126 step -2*/
-				else					/* i = 192..255 */
-					p = i*2 - 511;		/*-127 to -1 step +2*/
-		break;
-	case 3:
-	default:	/*keep the compiler happy*/
-		/* random */
-		/* the real algorithm is unknown !!!
-            We just use a snapshot of data from real chip */
-
-		/* AM: range 0 to 255    */
-		/* PM: range -128 to 127 */
-
-		a = lfo_noise_waveform[i];
-		p = a-128;
-		break;
+		lfa[n] = a;
+		lfp[n] = p;
 	}
-	PSG->lfa = a * PSG->amd / 128;
-	PSG->lfp = p * PSG->pmd / 128;
 
 
 	/*  The Noise Generator of the YM2151 is 17-bit shift register.
@@ -2205,26 +2319,38 @@ INLINE void advance(void)
     *   Output of the register is negated (bit0 XOR bit3).
     *   Simply use bit16 as the noise output.
     */
-	PSG->noise_p += PSG->noise_f;
-	i = (PSG->noise_p>>16);		/* number of events (shifts of the shift register) */
-	PSG->noise_p &= 0xffff;
-	while (i)
+	noise_rng = chip->noise_rng;
+	for (n=0; n<length; n++)
 	{
-		UINT32 j;
-		j = ( (PSG->noise_rng ^ (PSG->noise_rng>>3) ) & 1) ^ 1;
-		PSG->noise_rng = (j<<16) | (PSG->noise_rng>>1);
-		i--;
+		chip->noise_p += chip->noise_f;
+		i = (chip->noise_p>>16);		/* number of events (shifts of the shift register) */
+		chip->noise_p &= 0xffff;
+		while (i)
+		{
+			UINT32 j;
+			j = ( (noise_rng ^ (noise_rng>>3) ) & 1) ^ 1;
+			noise_rng = (j<<16) | (noise_rng>>1);
+			i--;
+		}
+		rng[n] = noise_rng;
 	}
+}
+
 
+INLINE void advance(YM2151 *chip)
+{
+	YM2151_OPS *ops = &chip->op;
+	YM2151Operator *op;
+	unsigned int i;
 
 	/* phase generator */
-	op = &PSG->oper[0];	/* CH 0 M1 */
-	i = 8;
+	op = &chip->oper[0];	/* CH 0 M1 */
+	i = 0;
 	do
 	{
 		if (op->pms)	/* only when phase modulation from LFO is enabled for this channel */
 		{
-			INT32 mod_ind = PSG->lfp;		/* -128..+127 (8bits signed) */
+			INT32 mod_ind = chip->lfp;		/* -128..+127 (8bits signed) */
 			if (op->pms < 6)
 				mod_ind >>= (6 - op->pms);
 			else
@@ -2233,30 +2359,30 @@ INLINE void advance(void)
 			if (mod_ind)
 			{
 				UINT32 kc_channel =	op->kc_i + mod_ind;
-				(op+0)->phase += ( (PSG->freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
-				(op+1)->phase += ( (PSG->freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
-				(op+2)->phase += ( (PSG->freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
-				(op+3)->phase += ( (PSG->freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
+				ops->phase[0][i] += ( (chip->freq[ kc_channel + (op+0)->dt2 ] + (op+0)->dt1) * (op+0)->mul ) >> 1;
+				ops->phase[1][i] += ( (chip->freq[ kc_channel + (op+1)->dt2 ] + (op+1)->dt1) * (op+1)->mul ) >> 1;
+				ops->phase[2][i] += ( (chip->freq[ kc_channel + (op+2)->dt2 ] + (op+2)->dt1) * (op+2)->mul ) >> 1;
+				ops->phase[3][i] += ( (chip->freq[ kc_channel + (op+3)->dt2 ] + (op+3)->dt1) * (op+3)->mul ) >> 1;
 			}
 			else		/* phase modulation from LFO is equal to zero */
 			{
-				(op+0)->phase += (op+0)->freq;
-				(op+1)->phase += (op+1)->freq;
-				(op+2)->phase += (op+2)->freq;
-				(op+3)->phase += (op+3)->freq;
+				ops->phase[0][i] += (op+0)->freq;
+				ops->phase[1][i] += (op+1)->freq;
+				ops->phase[2][i] += (op+2)->freq;
+				ops->phase[3][i] += (op+3)->freq;
 			}
 		}
 		else			/* phase modulation from LFO is disabled */
 		{
-			(op+0)->phase += (op+0)->freq;
-			(op+1)->phase += (op+1)->freq;
-			(op+2)->phase += (op+2)->freq;
-			(op+3)->phase += (op+3)->freq;
+			ops->phase[0][i] += (op+0)->freq;
+			ops->phase[1][i] += (op+1)->freq;
+			ops->phase[2][i] += (op+2)->freq;
+			ops->phase[3][i] += (op+3)->freq;
 		}
 
 		op+=4;
-		i--;
-	}while (i);
+		i++;
+	}while (i < 8);
 
 
 	/* CSM is calculated *after* the phase generator calculations (verified on real chip)
@@ -2268,23 +2394,21 @@ INLINE void advance(void)
     * the sound played is the same as after normal KEY ON.
     */
 
-	if (PSG->csm_req)			/* CSM KEYON/KEYOFF seqeunce request */
+	if (chip->csm_req)			/* CSM KEYON/KEYOFF seqeunce request */
 	{
-		if (PSG->csm_req==2)	/* KEY ON */
+		if (chip->csm_req==2)	/* KEY ON */
 		{
-			op = &PSG->oper[0];	/* CH 0 M1 */
-			i = 32;
+			i = 0;
 			do
 			{
-				KEY_ON(op, 2);
-				op++;
-				i--;
-			}while (i);
-			PSG->csm_req = 1;
+				KEY_ON(chip, i>>2, i&3, 2);
+				i++;
+			}while (i < 32);
+			chip->csm_req = 1;
 		}
 		else					/* KEY OFF */
 		{
-			op = &PSG->oper[0];	/* CH 0 M1 */
+			op = &chip->oper[0];	/* CH 0 M1 */
 			i = 32;
 			do
 			{
@@ -2292,7 +2416,7 @@ INLINE void advance(void)
 				op++;
 				i--;
 			}while (i);
-			PSG->csm_req = 0;
+			chip->csm_req = 0;
 		}
 	}
 }
@@ -2338,7 +2462,7 @@ INLINE signed int acc_calc(signed int value)
 #if 0	/*MONO*/
 	#ifdef SAVE_SEPARATE_CHANNELS
 	  #define SAVE_SINGLE_CHANNEL(j) \
-	  {	signed int pom= -(chanout[j] & PSG->pan[j*2]); \
+	  {	signed int pom= -(chip->chanout[j] & chip->pan[j*2]); \
 		if (pom > 32767) pom = 32767; else if (pom < -32768) pom = -32768; \
 		fputc((unsigned short)pom&0xff,sample[j]); \
 		fputc(((unsigned short)pom>>8)&0xff,sample[j]); \
@@ -2349,11 +2473,11 @@ INLINE signed int acc_calc(signed int value)
 #else	/*STEREO*/
 	#ifdef SAVE_SEPARATE_CHANNELS
 	  #define SAVE_SINGLE_CHANNEL(j) \
-	  {	signed int pom = -(chanout[j] & PSG->pan[j*2]); \
+	  {	signed int pom = -(chip->chanout[j] & chip->pan[j*2]); \
 		if (pom > 32767) pom = 32767; else if (pom < -32768) pom = -32768; \
 		fputc((unsigned short)pom&0xff,sample[j]); \
 		fputc(((unsigned short)pom>>8)&0xff,sample[j]); \
-		pom = -(chanout[j] & PSG->pan[j*2+1]); \
+		pom = -(chip->chanout[j] & chip->pan[j*2+1]); \
 		if (pom > 32767) pom = 32767; else if (pom < -32768) pom = -32768; \
 		fputc((unsigned short)pom&0xff,sample[j]); \
 		fputc(((unsigned short)pom>>8)&0xff,sample[j]); \
@@ -2393,122 +2517,173 @@ INLINE signed int acc_calc(signed int value)
 #endif
 
 
+/* calculate timer A (one sample) */
+INLINE void advance_timer_A(YM2151 *chip)
+{
+#ifdef USE_MAME_TIMERS
+	/* ASG 980324 - handled by real timers now */
+#else
+	if (chip->tim_A)
+	{
+		chip->tim_A_val -= ( 1 << TIMER_SH );
+		if (chip->tim_A_val <= 0)
+		{
+			chip->tim_A_val += chip->tim_A_tab[ chip->timer_A_index ];
+			if (chip->irq_enable & 0x04)
+			{
+				int oldstate = chip->status & 3;
+				chip->status |= 1;
+				//if ((!oldstate) && (chip->irqhandler)) (*chip->irqhandler)(chip->device, 1);
+			}
+			if (chip->irq_enable & 0x80)
+				chip->csm_req = 2;	/* request KEY ON / KEY OFF sequence */
+		}
+	}
+#endif
+}
+
+/*  Idle channel tracking
+*
+*   An operator in EG_OFF is silent and can only be woken up by a key-on.
+*   Channels with all four operators off and an empty feedback and MEM
+*   history stay silent for a whole update, unless CSM mode keys them on
+*   from timer A within the update.
+*
+*   Returns a mask with bit n set when channel n has to be calculated.
+*/
+static UINT32 ym2151_active_channels(YM2151 *chip)
+{
+	YM2151Operator *op;
+	UINT32 active = 0;
+	unsigned int chan;
+
+	if (chip->tim_A && (chip->irq_enable & 0x80))
+		return 0xFF;
+
+	for (chan=0; chan<8; chan++)
+	{
+		op = &chip->oper[chan*4];
+		if (op[0].state != EG_OFF || op[1].state != EG_OFF ||
+			op[2].state != EG_OFF || op[3].state != EG_OFF ||
+			(chip->op.fb_out_prev[chan] | chip->op.fb_out_curr[chan] | chip->op.mem_value[chan]))
+			active |= 1 << chan;
+	}
+
+	return active;
+}
+
+
 /*  Generate samples for one of the YM2151's
 *
 *   'num' is the number of virtual YM2151
 *   '**buffers' is table of pointers to the buffers: left and right
 *   'length' is the number of samples that should be generated
+*
+*   The samples are generated in blocks of up to LFO_BLOCK samples, with the
+*   LFO and noise output of a block calculated in advance.
 */
-void ym2151_update_one(void *chip, SAMP **buffers, int length)
+#define LFO_BLOCK	64
+
+void ym2151_update_one(void *_chip, SAMP **buffers, int length)
 {
-	int i, chn;
+	YM2151 *chip = (YM2151 *)_chip;
+	int i, j, blk;
 	signed int outl,outr;
 	SAMP *bufL, *bufR;
+	UINT32 chns;
+	UINT32 lfa[LFO_BLOCK];
+	INT32 lfp[LFO_BLOCK];
+	UINT32 rng[LFO_BLOCK];
 
 	bufL = buffers[0];
 	bufR = buffers[1];
 
-	PSG = (YM2151 *)chip;
-
 #ifdef USE_MAME_TIMERS
 		/* ASG 980324 - handled by real timers now */
 #else
-	if (PSG->tim_B)
+	if (chip->tim_B)
 	{
-		PSG->tim_B_val -= ( length << TIMER_SH );
-		if (PSG->tim_B_val<=0)
+		chip->tim_B_val -= ( length << TIMER_SH );
+		if (chip->tim_B_val<=0)
 		{
-			PSG->tim_B_val += PSG->tim_B_tab[ PSG->timer_B_index ];
-			if ( PSG->irq_enable & 0x08 )
+			chip->tim_B_val += chip->tim_B_tab[ chip->timer_B_index ];
+			if ( chip->irq_enable & 0x08 )
 			{
-				int oldstate = PSG->status & 3;
-				PSG->status |= 2;
-				//if ((!oldstate) && (PSG->irqhandler)) (*PSG->irqhandler)(chip->device, 1);
+				int oldstate = chip->status & 3;
+				chip->status |= 2;
+				//if ((!oldstate) && (chip->irqhandler)) (*chip->irqhandler)(chip->device, 1);
 			}
 		}
 	}
 #endif
 
-	for (i=0; i<length; i++)
+	chns = ym2151_active_channels(chip) & ~chip->MuteChn;
+	if (! chns)
 	{
-		advance_eg();
-
-		chanout[0] = 0;
-		chanout[1] = 0;
-		chanout[2] = 0;
-		chanout[3] = 0;
-		chanout[4] = 0;
-		chanout[5] = 0;
-		chanout[6] = 0;
-		chanout[7] = 0;
-
-		chan_calc(0);
-		SAVE_SINGLE_CHANNEL(0)
-		chan_calc(1);
-		SAVE_SINGLE_CHANNEL(1)
-		chan_calc(2);
-		SAVE_SINGLE_CHANNEL(2)
-		chan_calc(3);
-		SAVE_SINGLE_CHANNEL(3)
-		chan_calc(4);
-		SAVE_SINGLE_CHANNEL(4)
-		chan_calc(5);
-		SAVE_SINGLE_CHANNEL(5)
-		chan_calc(6);
-		SAVE_SINGLE_CHANNEL(6)
-		chan7_calc();
-		SAVE_SINGLE_CHANNEL(7)
-
-		outl = chanout[0] & PSG->pan[0];
-		outr = chanout[0] & PSG->pan[1];
-		outl += (chanout[1] & PSG->pan[2]);
-		outr += (chanout[1] & PSG->pan[3]);
-		outl += (chanout[2] & PSG->pan[4]);
-		outr += (chanout[2] & PSG->pan[5]);
-		outl += (chanout[3] & PSG->pan[6]);
-		outr += (chanout[3] & PSG->pan[7]);
-		outl += (chanout[4] & PSG->pan[8]);
-		outr += (chanout[4] & PSG->pan[9]);
-		outl += (chanout[5] & PSG->pan[10]);
-		outr += (chanout[5] & PSG->pan[11]);
-		outl += (chanout[6] & PSG->pan[12]);
-		outr += (chanout[6] & PSG->pan[13]);
-		outl += (chanout[7] & PSG->pan[14]);
-		outr += (chanout[7] & PSG->pan[15]);
-
-		outl >>= FINAL_SH;
-		outr >>= FINAL_SH;
-		//if (outl > MAXOUT) outl = MAXOUT;
-		//	else if (outl < MINOUT) outl = MINOUT;
-		//if (outr > MAXOUT) outr = MAXOUT;
-		//	else if (outr < MINOUT) outr = MINOUT;
-		((SAMP*)bufL)[i] = (SAMP)outl;
-		((SAMP*)bufR)[i] = (SAMP)outr;
-
-		SAVE_ALL_CHANNELS
+		/* nothing to calculate, the chip is silent */
+		memset(bufL, 0x00, length * sizeof(SAMP));
+		memset(bufR, 0x00, length * sizeof(SAMP));
+	}
 
-#ifdef USE_MAME_TIMERS
-		/* ASG 980324 - handled by real timers now */
-#else
-		/* calculate timer A */
-		if (PSG->tim_A)
+	memset(chip->chanout, 0x00, sizeof(chip->chanout));
+	for (i=0; i<length; i+=blk)
+	{
+		blk = length - i;
+		if (blk > LFO_BLOCK)
+			blk = LFO_BLOCK;
+		advance_lfo_noise(chip, blk, lfa, lfp, rng);
+
+		for (j=0; j<blk; j++)
 		{
-			PSG->tim_A_val -= ( 1 << TIMER_SH );
-			if (PSG->tim_A_val <= 0)
+			advance_eg(chip);
+
+			if (chns)
 			{
-				PSG->tim_A_val += PSG->tim_A_tab[ PSG->timer_A_index ];
-				if (PSG->irq_enable & 0x04)
-				{
-					int oldstate = PSG->status & 3;
-					PSG->status |= 1;
-					//if ((!oldstate) && (PSG->irqhandler)) (*PSG->irqhandler)(chip->device, 1);
-				}
-				if (PSG->irq_enable & 0x80)
-					PSG->csm_req = 2;	/* request KEY ON / KEY OFF sequence */
+				calc_channels(chip, chns);
+				SAVE_SINGLE_CHANNEL(0)
+				SAVE_SINGLE_CHANNEL(1)
+				SAVE_SINGLE_CHANNEL(2)
+				SAVE_SINGLE_CHANNEL(3)
+				SAVE_SINGLE_CHANNEL(4)
+				SAVE_SINGLE_CHANNEL(5)
+				SAVE_SINGLE_CHANNEL(6)
+				SAVE_SINGLE_CHANNEL(7)
+
+				outl = chip->chanout[0] & chip->pan[0];
+				outr = chip->chanout[0] & chip->pan[1];
+				outl += (chip->chanout[1] & chip->pan[2]);
+				outr += (chip->chanout[1] & chip->pan[3]);
+				outl += (chip->chanout[2] & chip->pan[4]);
+				outr += (chip->chanout[2] & chip->pan[5]);
+				outl += (chip->chanout[3] & chip->pan[6]);
+				outr += (chip->chanout[3] & chip->pan[7]);
+				outl += (chip->chanout[4] & chip->pan[8]);
+				outr += (chip->chanout[4] & chip->pan[9]);
+				outl += (chip->chanout[5] & chip->pan[10]);
+				outr += (chip->chanout[5] & chip->pan[11]);
+				outl += (chip->chanout[6] & chip->pan[12]);
+				outr += (chip->chanout[6] & chip->pan[13]);
+				outl += (chip->chanout[7] & chip->pan[14]);
+				outr += (chip->chanout[7] & chip->pan[15]);
+
+				outl >>= FINAL_SH;
+				outr >>= FINAL_SH;
+				//if (outl > MAXOUT) outl = MAXOUT;
+				//	else if (outl < MINOUT) outl = MINOUT;
+				//if (outr > MAXOUT) outr = MAXOUT;
+				//	else if (outr < MINOUT) outr = MINOUT;
+				((SAMP*)bufL)[i+j] = (SAMP)outl;
+				((SAMP*)bufR)[i+j] = (SAMP)outr;
+
+				SAVE_ALL_CHANNELS
 			}
+
+			advance_timer_A(chip);
+			chip->lfa = lfa[j];
+			chip->lfp = lfp[j];
+			chip->noise_rng = rng[j];
+			advance(chip);
 		}
-#endif
-		advance();
 	}
 }
 
@@ -2527,11 +2702,22 @@ void ym2151_set_port_write_handler(void *chip, write8_device_func handler)
 void ym2151_set_mutemask(void *chip, UINT32 MuteMask)
 {
 	YM2151 *PSG = (YM2151 *)chip;
-	UINT8 CurChn;
-	
-	for (CurChn = 0; CurChn < 8; CurChn ++)
-		PSG->Muted[CurChn] = (MuteMask >> CurChn) & 0x01;
+
+	PSG->MuteChn = MuteMask & 0xFF;
 	
 	return;
 }
 
+UINT32 ym2151_save_state(void *chip, void *Data)
+{
+	if (Data != NULL)
+		memcpy(Data, chip, sizeof(YM2151));
+	return sizeof(YM2151);
+}
+
+UINT32 ym2151_load_state(void *chip, const void *Data)
+{
+	memcpy(chip, Data, sizeof(YM2151));
+	return sizeof(YM2151);
+}
+
@@ -85,3 +85,5 @@ int ym2151_read_status(void *chip);
 void ym2151_postload(void *param);
 
 void ym2151_set_mutemask(void *chip, UINT32 MuteMask);
+UINT32 ym2151_save_state(void *chip, void *Data);
+UINT32 ym2151_load_state(void *chip, const void *Data);
@@ -64,6 +64,8 @@
 
 #include "../VGMSXPlay.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 //#include "sndintrf.h"
 #include "ymdeltat.h"
 
@@ -89,6 +91,106 @@ static const INT32 ym_deltat_decode_tableB2[16] = {
   57,  57,  57,  57, 77, 102, 128, 153
 };
 
+/* selects the cache entry for a play from the start address */
+static YM_DELTAT_CACHE_ENTRY *YM_DELTAT_cache_start(YM_DELTAT *DELTAT)
+{
+	YM_DELTAT_CACHE *cache = DELTAT->cache;
+	YM_DELTAT_CACHE_ENTRY *ce;
+	YM_DELTAT_CACHE_ENTRY *oldest;
+	UINT32 addr = DELTAT->start << 1;
+	int i;
+
+	if (cache == NULL)
+	{
+		cache = (YM_DELTAT_CACHE *)calloc(1, sizeof(YM_DELTAT_CACHE));
+		DELTAT->cache = cache;
+		if (cache == NULL)
+			return NULL;
+	}
+
+	oldest = &cache->entry[0];
+	for (i = 0; i < YM_DELTAT_CACHE_ENTRIES; i++)
+	{
+		ce = &cache->entry[i];
+		if (ce->len && ce->addr == addr)
+			break;
+		if (ce->last_use < oldest->last_use)
+			oldest = ce;
+	}
+	if (i == YM_DELTAT_CACHE_ENTRIES)
+	{
+		ce = oldest;
+		ce->addr = addr;
+		ce->len = 0;
+	}
+	ce->last_use = ++cache->use_cnt;
+
+	cache->cur = ce;
+	cache->pos = 0;
+	return ce;
+}
+
+/* appends the decoder state after the nibble at 'pos', returns 0 if the entry is full */
+static int YM_DELTAT_cache_append(YM_DELTAT *DELTAT, YM_DELTAT_CACHE_ENTRY *ce)
+{
+	UINT32 alloc;
+	INT16 *acc;
+	UINT16 *adpcmd;
+
+	if (ce->len == ce->alloc)
+	{
+		if (ce->alloc >= YM_DELTAT_CACHE_MAX)
+			return 0;
+		alloc = ce->alloc ? ce->alloc * 2 : 0x400;
+		acc = (INT16 *)realloc(ce->acc, alloc * sizeof(INT16));
+		if (acc == NULL)
+			return 0;
+		ce->acc = acc;
+		adpcmd = (UINT16 *)realloc(ce->adpcmd, alloc * sizeof(UINT16));
+		if (adpcmd == NULL)
+			return 0;
+		ce->adpcmd = adpcmd;
+		ce->alloc = alloc;
+	}
+	ce->acc[ce->len] = (INT16)DELTAT->acc;
+	ce->adpcmd[ce->len] = (UINT16)DELTAT->adpcmd;
+	ce->len++;
+	return 1;
+}
+
+/* has to be called whenever the memory changes */
+void YM_DELTAT_cache_invalidate(YM_DELTAT *DELTAT)
+{
+	YM_DELTAT_CACHE *cache = DELTAT->cache;
+	int i;
+
+	if (cache == NULL)
+		return;
+	for (i = 0; i < YM_DELTAT_CACHE_ENTRIES; i++)
+	{
+		cache->entry[i].len = 0;
+		cache->entry[i].last_use = 0;
+	}
+	cache->cur = NULL;
+	cache->use_cnt = 0;
+}
+
+void YM_DELTAT_cache_free(YM_DELTAT *DELTAT)
+{
+	YM_DELTAT_CACHE *cache = DELTAT->cache;
+	int i;
+
+	if (cache == NULL)
+		return;
+	for (i = 0; i < YM_DELTAT_CACHE_ENTRIES; i++)
+	{
+		free(cache->entry[i].acc);
+		free(cache->entry[i].adpcmd);
+	}
+	free(cache);
+	DELTAT->cache = NULL;
+}
+
 #if 0
 void YM_DELTAT_BRDY_callback(YM_DELTAT *DELTAT)
 {
@@ -271,6 +373,11 @@ value:   START, REC, MEMDAT, REPEAT, SPOFF, x,x,RESET   meaning:
 				if(DELTAT->status_change_BRDY_bit)
 					(DELTAT->status_set_handler)(DELTAT->status_change_which_chip, DELTAT->status_change_BRDY_bit);
 		}
+
+		if( (DELTAT->portstate & 0xe0)==0xa0 )	/* synthesis from external memory starts at 'start' */
+			YM_DELTAT_cache_start(DELTAT);
+		else if (DELTAT->cache != NULL)
+			DELTAT->cache->cur = NULL;
 		break;
 	case 0x01:	/* L,R,-,-,SAMPLE,DA/AD,RAMTYPE,ROM */
 		/* handle emulation mode */
@@ -347,6 +454,7 @@ value:   START, REC, MEMDAT, REPEAT, SPOFF, x,x,RESET   meaning:
 			{
 				DELTAT->memory[DELTAT->now_addr>>1] = v;
 				DELTAT->now_addr+=2; /* two nibbles at a time */
+				YM_DELTAT_cache_invalidate(DELTAT);
 
 				/* reset BRDY bit in status register, which means we are processing the write */
 				if(DELTAT->status_reset_handler)
@@ -487,16 +595,28 @@ INLINE void YM_DELTAT_synthesis_from_external_memory(YM_DELTAT *DELTAT)
 {
 	UINT32 step;
 	int data;
+	YM_DELTAT_CACHE_ENTRY *ce;	/* decoded nibbles of the current play */
+	UINT32 pos;
 
 	DELTAT->now_step += DELTAT->step;
 	if ( DELTAT->now_step >= (1<<YM_DELTAT_SHIFT) )
 	{
 		step = DELTAT->now_step >> YM_DELTAT_SHIFT;
 		DELTAT->now_step &= (1<<YM_DELTAT_SHIFT)-1;
+		ce = NULL;
+		pos = 0;
+		if (DELTAT->cache != NULL)
+		{
+			ce = DELTAT->cache->cur;
+			pos = DELTAT->cache->pos;
+		}
 		do{
 
 			if ( DELTAT->now_addr == (DELTAT->limit<<1) )
+			{
 				DELTAT->now_addr = 0;
+				ce = NULL;	/* the cache only covers the straight run from 'start' */
+			}
 
 			if ( DELTAT->now_addr == (DELTAT->end<<1) ) {	/* 12-06-2001 JB: corrected comparison. Was > instead of == */
 				if( DELTAT->portstate&0x10 ){
@@ -505,6 +625,8 @@ INLINE void YM_DELTAT_synthesis_from_external_memory(YM_DELTAT *DELTAT)
 					DELTAT->acc      = 0;
 					DELTAT->adpcmd   = YM_DELTAT_DELTA_DEF;
 					DELTAT->prev_acc = 0;
+					ce = YM_DELTAT_cache_start(DELTAT);
+					pos = 0;
 				}else{
 					/* set EOS bit in status register */
 					if(DELTAT->status_set_handler)
@@ -517,10 +639,29 @@ INLINE void YM_DELTAT_synthesis_from_external_memory(YM_DELTAT *DELTAT)
 					DELTAT->portstate = 0;
 					DELTAT->adpcml = 0;
 					DELTAT->prev_acc = 0;
+					if (DELTAT->cache != NULL)
+						DELTAT->cache->cur = NULL;
 					return;
 				}
 			}
 
+			if (ce != NULL && pos < ce->len)
+			{
+				/* decoded before: only the position and the data latch move */
+				if( ! (DELTAT->now_addr&1) )
+					DELTAT->now_data = *(DELTAT->memory + (DELTAT->now_addr>>1));
+				DELTAT->now_addr++;
+				DELTAT->now_addr &= DELTAT->memory_mask;
+
+				DELTAT->prev_acc = DELTAT->acc;
+				DELTAT->acc = ce->acc[pos];
+				DELTAT->adpcmd = ce->adpcmd[pos];
+				pos++;
+				if (! DELTAT->now_addr)
+					ce = NULL;	/* wrapped around the memory */
+				continue;
+			}
+
 			if( DELTAT->now_addr&1 ) data = DELTAT->now_data & 0x0f;
 			else
 			{
@@ -552,8 +693,21 @@ INLINE void YM_DELTAT_synthesis_from_external_memory(YM_DELTAT *DELTAT)
 			/* ElSemi: Fix interpolator. */
 			/*DELTAT->prev_acc = prev_acc + ((DELTAT->acc - prev_acc) / 2 );*/
 
+			if (ce != NULL)
+			{
+				if (DELTAT->now_addr && YM_DELTAT_cache_append(DELTAT, ce))
+					pos++;
+				else
+					ce = NULL;
+			}
+
 		}while(--step);
 
+		if (DELTAT->cache != NULL)
+		{
+			DELTAT->cache->cur = ce;
+			DELTAT->cache->pos = pos;
+		}
 	}
 
 	/* ElSemi: Fix interpolator. */
@@ -8,10 +8,34 @@
 
 typedef void (*STATUS_CHANGE_HANDLER)(void *chip, UINT8 status_bits);
 
+/* Decoded ADPCM from external memory. The decoder always restarts at the
+** start address with the same state, so each played region decodes to the
+** same values every time. Each entry holds the accumulator and delta after
+** every nibble decoded so far from its start address. */
+#define YM_DELTAT_CACHE_ENTRIES	8
+#define YM_DELTAT_CACHE_MAX		0x20000	/* nibbles per entry, the rest is decoded as it plays */
+
+typedef struct deltat_cache_entry {
+	UINT32	addr;			/* start address (nibbles) */
+	UINT32	len;			/* nibbles decoded */
+	UINT32	alloc;
+	UINT32	last_use;
+	INT16	*acc;
+	UINT16	*adpcmd;
+} YM_DELTAT_CACHE_ENTRY;
+
+typedef struct deltat_cache {
+	YM_DELTAT_CACHE_ENTRY	entry[YM_DELTAT_CACHE_ENTRIES];
+	YM_DELTAT_CACHE_ENTRY	*cur;	/* region being played, NULL when decoding without the cache */
+	UINT32	pos;					/* nibbles played from the start of cur */
+	UINT32	use_cnt;
+} YM_DELTAT_CACHE;
+
 
 /* DELTA-T (adpcm type B) struct */
 typedef struct deltat_adpcm_state {     /* AT: rearranged and tigntened structure */
 	UINT8	*memory;
+	YM_DELTAT_CACHE	*cache;	/* not part of the state, like the memory */
 	INT32	*output_pointer;/* pointer of output pointers   */
 	INT32	*pan;			/* pan : &output_pointer[pan]   */
 	double	freqbase;
@@ -80,4 +104,6 @@ void YM_DELTAT_ADPCM_CALC(YM_DELTAT *DELTAT);
 //void YM_DELTAT_savestate(const device_config *device,YM_DELTAT *DELTAT);
 void YM_DELTAT_savestate(YM_DELTAT *DELTAT);*/
 
-void YM_DELTAT_calc_mem_mask(YM_DELTAT* DELTAT);
\ No newline at end of file
+void YM_DELTAT_calc_mem_mask(YM_DELTAT* DELTAT);
+void YM_DELTAT_cache_invalidate(YM_DELTAT* DELTAT);
+void YM_DELTAT_cache_free(YM_DELTAT* DELTAT);
\ No newline at end of file
@@ -61,6 +61,12 @@ differences between OPL2 and OPL3 shown in datasheets:
 //#include "sndintrf.h"
 #include "ymf262.h"
 
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__clang__)
+// the AVX2 channel pass is built with a function target, OPL3Create picks it
+#define OPL3_AVX2
+#include <immintrin.h>
+#endif
+
 
 /* output final shift */
 #if (OPL3_SAMPLE_BITS==16)
@@ -154,20 +160,14 @@ typedef struct{
 	UINT8	ksr;		/* key scale rate: kcode>>KSR   */
 	UINT8	mul;		/* multiple: mul_tab[ML]        */
 
-	/* Phase Generator */
-	UINT32	Cnt;		/* frequency counter            */
-	UINT32	Incr;		/* frequency counter step       */
-	UINT8   FB;			/* feedback shift value         */
+	/* connection */
 	INT32   *connect;	/* slot output pointer          */
-	INT32   op1_out[2];	/* slot1 output for feedback    */
 	UINT8   CON;		/* connection (algorithm) type  */
 
 	/* Envelope Generator */
 	UINT8	eg_type;	/* percussive/non-percussive mode */
 	UINT8	state;		/* phase type                   */
 	UINT32	TL;			/* total level: TL << 2         */
-	INT32	TLL;		/* adjusted now TL              */
-	INT32	volume;		/* envelope counter             */
 	UINT32	sl;			/* sustain level: sl_tab[SL]    */
 
 	UINT32	eg_m_ar;	/* (attack state)               */
@@ -182,16 +182,8 @@ typedef struct{
 
 	UINT32	key;		/* 0 = KEY OFF, >0 = KEY ON     */
 
-	/* LFO */
-	UINT32	AMmask;		/* LFO Amplitude Modulation enable mask */
-	UINT8	vib;		/* LFO Phase Modulation enable flag (active high)*/
-
 	/* waveform select */
 	UINT8	waveform_number;
-	unsigned int wavetable;
-
-//unsigned char reserved[128-84];//speedup: pump up the struct size to power of 2
-unsigned char reserved[128-100];//speedup: pump up the struct size to power of 2
 
 } OPL3_SLOT;
 
@@ -214,18 +206,42 @@ typedef struct{
         11 and 14
     */
 	UINT8	extended;	/* set to 1 if this channel forms up a 4op channel with another channel(only used by first of pair of channels, ie 0,1,2 and 9,10,11) */
-	UINT8	Muted;
-
-unsigned char reserved[512-272];//speedup:pump up the struct size to power of 2
 
 } OPL3_CH;
 
+/* per sample operator state of all slots, slot s of channel c at [s][c] */
+typedef struct
+{
+	/* Phase Generator */
+	UINT32	Cnt[2][18];		/* frequency counter            */
+	UINT32	Incr[2][18];	/* frequency counter step       */
+
+	/* Envelope Generator */
+	INT32	TLL[2][18];		/* adjusted now TL              */
+	INT32	volume[2][18];	/* envelope counter             */
+	UINT32	AMmask[2][18];	/* LFO Amplitude Modulation enable mask */
+	UINT32	wavetable[2][18];	/* waveform select: wave * SIN_LEN */
+
+	/* LFO */
+	UINT64	vib;			/* LFO Phase Modulation enable, bit ch*2+slot */
+
+	/* slot1 feedback, per channel */
+	INT32	op1_out[2][18];	/* slot1 output for feedback    */
+	UINT32	FB[18];			/* feedback shift value         */
+
+	/* slot routing of each channel, follows the 'connect' pointers */
+	UINT32	to_out[18];		/* ~0: slot1 goes to the output, else to phase_modulation */
+	UINT32	to_pm2[18];		/* ~0: slot2 goes to phase_modulation2, else to the output */
+} OPL3_OPS;
+
 /* OPL3 state */
 typedef struct {
 	OPL3_CH	P_CH[18];				/* OPL3 chips have 18 channels  */
+	OPL3_OPS op;					/* operator state of all slots  */
 
 	UINT32	pan[18*4];				/* channels output masks (0xffffffff = enable); 4 masks per one channel */
 	UINT32	pan_ctrl_value[18];		/* output control values 1 per one channel (1 value contains 4 masks) */
+	UINT32	MuteChn;				/* bit n set: channel n is muted */
 	UINT8	MuteSpc[5];				/* for the 5 Rhythm Channels */
 
 	signed int chanout[18];			/* 18 channels */
@@ -481,13 +497,13 @@ static const UINT8 mul_tab[16]= {
 *   TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (13*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
 
 #define ENV_QUIET		(TL_TAB_LEN>>4)
 
-/* sin waveform table in 'decibel' scale */
-/* there are eight waveforms on OPL3 chips */
-static unsigned int sin_tab[SIN_LEN * 8];
+/* tl_tab[TL_TAB_LEN] and the sin waveform table in 'decibel' scale,
+   sin_tab[SIN_LEN * 8] (there are eight waveforms on OPL3 chips), are
+   generated at build time by gentables.c */
+#include "ymf262_tables.h"
 
 
 /* LFO Amplitude Modulation table (verified on real YM3812)
@@ -600,11 +616,7 @@ static const INT8 lfo_pm_table[8*8*2] = {
 /* lock level of common table */
 static int num_lock = 0;
 
-/* work table */
-#define SLOT7_1 (&chip->P_CH[7].SLOT[SLOT1])
-#define SLOT7_2 (&chip->P_CH[7].SLOT[SLOT2])
-#define SLOT8_1 (&chip->P_CH[8].SLOT[SLOT1])
-#define SLOT8_2 (&chip->P_CH[8].SLOT[SLOT2])
+extern UINT8 SimdLevel;
 
 
 
@@ -681,11 +693,56 @@ INLINE void advance_lfo(OPL3 *chip)
 	chip->LFO_PM = ((chip->lfo_pm_cnt>>LFO_SH) & 7) | chip->lfo_pm_depth_range;
 }
 
-/* advance to next sample */
-INLINE void advance(OPL3 *chip)
+/* LFO phase modulation of a slot, applied on top of its regular step
+   ('i' is the slot number: channel i/2, slot i&1) */
+INLINE void advance_vib_phase(OPL3 *chip, int i)
+{
+	OPL3_CH *CH = &chip->P_CH[i/2];
+	UINT8 block;
+	unsigned int block_fnum = CH->block_fnum;
+
+	unsigned int fnum_lfo   = (block_fnum&0x0380) >> 7;
+
+	signed int lfo_fn_table_index_offset = lfo_pm_table[chip->LFO_PM + 16*fnum_lfo ];
+
+	if (lfo_fn_table_index_offset)	/* LFO phase modulation active */
+	{
+		block_fnum += lfo_fn_table_index_offset;
+		block = (block_fnum&0x1c00) >> 10;
+		chip->op.Cnt[i&1][i/2] += (chip->fn_tab[block_fnum&0x03ff] >> (7-block)) * CH->SLOT[i&1].mul
+								- chip->op.Incr[i&1][i/2];
+	}
+	/* else LFO phase modulation = zero, the regular step stays */
+}
+
+/* phase generator step of all slots */
+INLINE void advance_phase(OPL3 *chip)
+{
+	OPL3_OPS *ops = &chip->op;
+	UINT64 vib;
+	int i;
+
+	for (i=0; i<18; i++)
+	{
+		ops->Cnt[SLOT1][i] += ops->Incr[SLOT1][i];
+		ops->Cnt[SLOT2][i] += ops->Incr[SLOT2][i];
+	}
+	for (i=0, vib=ops->vib; vib; i++, vib>>=1)
+	{
+		if (vib & 1)
+			advance_vib_phase(chip, i);
+	}
+}
+
+/* advance to next sample
+   ('eg_slots' has bit ch*2+slot set for the slots the EG can change) */
+INLINE void advance(OPL3 *chip, UINT64 eg_slots)
 {
+	OPL3_OPS *ops = &chip->op;
 	OPL3_CH *CH;
 	OPL3_SLOT *op;
+	INT32 *volume;
+	UINT64 m;
 	int i;
 
 	chip->eg_timer += chip->eg_timer_add;
@@ -696,10 +753,13 @@ INLINE void advance(OPL3 *chip)
 
 		chip->eg_cnt++;
 
-		for (i=0; i<9*2*2; i++)
+		for (i=0, m=eg_slots; m; i++, m>>=1)
 		{
+			if (! (m & 1))
+				continue;
 			CH  = &chip->P_CH[i/2];
 			op  = &CH->SLOT[i&1];
+			volume = &ops->volume[i&1][i/2];
 #if 1
 			/* Envelope Generator */
 			switch(op->state)
@@ -708,13 +768,13 @@ INLINE void advance(OPL3 *chip)
 //              if ( !(chip->eg_cnt & ((1<<op->eg_sh_ar)-1) ) )
 				if ( !(chip->eg_cnt & op->eg_m_ar) )
 				{
-					op->volume += (~op->volume *
+					*volume += (~*volume *
 							   (eg_inc[op->eg_sel_ar + ((chip->eg_cnt>>op->eg_sh_ar)&7)])
 							  ) >>3;
 
-					if (op->volume <= MIN_ATT_INDEX)
+					if (*volume <= MIN_ATT_INDEX)
 					{
-						op->volume = MIN_ATT_INDEX;
+						*volume = MIN_ATT_INDEX;
 						op->state = EG_DEC;
 					}
 
@@ -725,9 +785,9 @@ INLINE void advance(OPL3 *chip)
 //              if ( !(chip->eg_cnt & ((1<<op->eg_sh_dr)-1) ) )
 				if ( !(chip->eg_cnt & op->eg_m_dr) )
 				{
-					op->volume += eg_inc[op->eg_sel_dr + ((chip->eg_cnt>>op->eg_sh_dr)&7)];
+					*volume += eg_inc[op->eg_sel_dr + ((chip->eg_cnt>>op->eg_sh_dr)&7)];
 
-					if ( op->volume >= op->sl )
+					if ( *volume >= op->sl )
 						op->state = EG_SUS;
 
 				}
@@ -749,10 +809,10 @@ INLINE void advance(OPL3 *chip)
 //                  if ( !(chip->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 					if ( !(chip->eg_cnt & op->eg_m_rr) )
 					{
-						op->volume += eg_inc[op->eg_sel_rr + ((chip->eg_cnt>>op->eg_sh_rr)&7)];
+						*volume += eg_inc[op->eg_sel_rr + ((chip->eg_cnt>>op->eg_sh_rr)&7)];
 
-						if ( op->volume >= MAX_ATT_INDEX )
-							op->volume = MAX_ATT_INDEX;
+						if ( *volume >= MAX_ATT_INDEX )
+							*volume = MAX_ATT_INDEX;
 					}
 					/* else do nothing in sustain phase */
 				}
@@ -762,11 +822,11 @@ INLINE void advance(OPL3 *chip)
 //              if ( !(chip->eg_cnt & ((1<<op->eg_sh_rr)-1) ) )
 				if ( !(chip->eg_cnt & op->eg_m_rr) )
 				{
-					op->volume += eg_inc[op->eg_sel_rr + ((chip->eg_cnt>>op->eg_sh_rr)&7)];
+					*volume += eg_inc[op->eg_sel_rr + ((chip->eg_cnt>>op->eg_sh_rr)&7)];
 
-					if ( op->volume >= MAX_ATT_INDEX )
+					if ( *volume >= MAX_ATT_INDEX )
 					{
-						op->volume = MAX_ATT_INDEX;
+						*volume = MAX_ATT_INDEX;
 						op->state = EG_OFF;
 					}
 
@@ -780,37 +840,7 @@ INLINE void advance(OPL3 *chip)
 		}
 	}
 
-	for (i=0; i<9*2*2; i++)
-	{
-		CH  = &chip->P_CH[i/2];
-		op  = &CH->SLOT[i&1];
-
-		/* Phase Generator */
-		if(op->vib)
-		{
-			UINT8 block;
-			unsigned int block_fnum = CH->block_fnum;
-
-			unsigned int fnum_lfo   = (block_fnum&0x0380) >> 7;
-
-			signed int lfo_fn_table_index_offset = lfo_pm_table[chip->LFO_PM + 16*fnum_lfo ];
-
-			if (lfo_fn_table_index_offset)	/* LFO phase modulation active */
-			{
-				block_fnum += lfo_fn_table_index_offset;
-				block = (block_fnum&0x1c00) >> 10;
-				op->Cnt += (chip->fn_tab[block_fnum&0x03ff] >> (7-block)) * op->mul;
-			}
-			else	/* LFO phase modulation  = zero */
-			{
-				op->Cnt += op->Incr;
-			}
-		}
-		else	/* LFO phase modulation disabled for this operator */
-		{
-			op->Cnt += op->Incr;
-		}
-	}
+	advance_phase(chip);
 
 	/*  The Noise Generator of the YM3812 is 23-bit shift register.
     *   Period is equal to 2^23-2 samples.
@@ -850,6 +880,114 @@ INLINE void advance(OPL3 *chip)
 }
 
 
+/* Idle channel tracking
+** A slot in EG_OFF is silent and can only be woken up by a key-on, which is
+** a register write and never happens in the middle of an update. Channels
+** with both slots off and a drained feedback history are therefore skipped
+** for a whole update, and a chip without any active channel only advances
+** its counters. */
+
+/* bit n set: channel n can produce output during the current update */
+static UINT32 OPL3_active_channels(OPL3 *chip)
+{
+	OPL3_CH *CH;
+	UINT32 active = 0;
+	int c;
+
+	for (c=0; c<18; c++)
+	{
+		CH = &chip->P_CH[c];
+		if (CH->SLOT[SLOT1].state != EG_OFF || CH->SLOT[SLOT2].state != EG_OFF ||
+			(chip->op.op1_out[0][c] | chip->op.op1_out[1][c]))
+			active |= 1 << c;
+	}
+
+	/* both halves of a 4-op channel are calculated together */
+	for (c=0; c<18; c++)
+	{
+		if (c%9 < 3 && chip->P_CH[c].extended && (active & (0x09 << c)))
+			active |= 0x09 << c;
+	}
+
+	return active;
+}
+
+/* slots the envelope generator can change during the current update:
+   all but the ones that are off or hold a non-percussive sustain (only
+   a register write moves them) */
+static UINT64 OPL3_eg_slots(OPL3 *chip)
+{
+	OPL3_SLOT *op;
+	UINT64 eg_slots = 0;
+	int i;
+
+	for (i=0; i<9*2*2; i++)
+	{
+		op = &chip->P_CH[i/2].SLOT[i&1];
+		if (op->state != EG_OFF && ! (op->state == EG_SUS && op->eg_type))
+			eg_slots |= (UINT64)1 << i;
+	}
+
+	return eg_slots;
+}
+
+/* advance 'length' samples while no channel is active
+   (same result as 'length' calls of advance_lfo() and advance()) */
+static void advance_idle(OPL3 *chip, int length)
+{
+	OPL3_OPS *ops = &chip->op;
+	UINT64 vib = ops->vib;
+	UINT64 t;
+	int i, s;
+
+	/* envelope generator: all slots are off, only the counter moves */
+	t = chip->eg_timer + (UINT64)chip->eg_timer_add * length;
+	chip->eg_cnt += (UINT32)(t / chip->eg_timer_overflow);
+	chip->eg_timer = (UINT32)(t % chip->eg_timer_overflow);
+
+	/* phase generator (the phase of an idle slot is still used by the
+	   rhythm section) */
+	for (i=0; i<9*2*2; i++)
+	{
+		if (! (vib & ((UINT64)1 << i)))
+			ops->Cnt[i&1][i/2] += ops->Incr[i&1][i/2] * length;
+	}
+
+	if (vib)
+	{
+		/* LFO phase modulation follows the LFO sample by sample */
+		for (s=0; s<length; s++)
+		{
+			advance_lfo(chip);
+			for (i=0; i<9*2*2; i++)
+			{
+				if (vib & ((UINT64)1 << i))
+				{
+					ops->Cnt[i&1][i/2] += ops->Incr[i&1][i/2];
+					advance_vib_phase(chip, i);
+				}
+			}
+		}
+	}
+	else
+	{
+		t = chip->lfo_am_cnt + (UINT64)chip->lfo_am_inc * (length-1);
+		chip->lfo_am_cnt = (UINT32)(t % ((UINT32)LFO_AM_TAB_ELEMENTS<<LFO_SH));
+		chip->lfo_pm_cnt += chip->lfo_pm_inc * (length-1);
+		advance_lfo(chip);
+	}
+
+	/* noise generator */
+	t = chip->noise_p + (UINT64)chip->noise_f * length;
+	chip->noise_p = (UINT32)t & FREQ_MASK;
+	for (t >>= FREQ_SH; t; t--)
+	{
+		if (chip->noise_rng & 1) chip->noise_rng ^= 0x800302;
+		chip->noise_rng >>= 1;
+	}
+}
+
+
 INLINE signed int op_calc(UINT32 phase, unsigned int env, signed int pm, unsigned int wave_tab)
 {
 	UINT32 p;
@@ -873,72 +1011,215 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm, unsign
 }
 
 
-#define volume_calc(OP) ((OP)->TLL + ((UINT32)(OP)->volume) + (chip->LFO_AM & (OP)->AMmask))
+#define volume_calc(s,c) (ops->TLL[s][c] + ((UINT32)ops->volume[s][c]) + (chip->LFO_AM & ops->AMmask[s][c]))
 
 /* calculate output of a standard 2 operator channel
  (or 1st part of a 4-op channel) */
-INLINE void chan_calc( OPL3 *chip, OPL3_CH *CH )
+INLINE void chan_calc( OPL3 *chip, int c )
 {
-	OPL3_SLOT *SLOT;
+	OPL3_CH *CH = &chip->P_CH[c];
+	OPL3_OPS *ops = &chip->op;
 	unsigned int env;
 	signed int out;
 
-	if (CH->Muted)
-		return;
-
 	chip->phase_modulation = 0;
 	chip->phase_modulation2= 0;
 
 	/* SLOT 1 */
-	SLOT = &CH->SLOT[SLOT1];
-	env  = volume_calc(SLOT);
-	out  = SLOT->op1_out[0] + SLOT->op1_out[1];
-	SLOT->op1_out[0] = SLOT->op1_out[1];
-	SLOT->op1_out[1] = 0;
+	env  = volume_calc(SLOT1, c);
+	out  = ops->op1_out[0][c] + ops->op1_out[1][c];
+	ops->op1_out[0][c] = ops->op1_out[1][c];
+	ops->op1_out[1][c] = 0;
 	if( env < ENV_QUIET )
 	{
-		if (!SLOT->FB)
+		if (!ops->FB[c])
 			out = 0;
-		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+		ops->op1_out[1][c] = op_calc1(ops->Cnt[SLOT1][c], env, (out<<ops->FB[c]), ops->wavetable[SLOT1][c] );
 	}
-	*SLOT->connect += SLOT->op1_out[1];
-//logerror("out0=%5i vol0=%4i ", SLOT->op1_out[1], env );
+	*CH->SLOT[SLOT1].connect += ops->op1_out[1][c];
+//logerror("out0=%5i vol0=%4i ", ops->op1_out[1][c], env );
 
 	/* SLOT 2 */
-	SLOT++;
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT2, c);
 	if( env < ENV_QUIET )
-		*SLOT->connect += op_calc(SLOT->Cnt, env, chip->phase_modulation, SLOT->wavetable);
+		*CH->SLOT[SLOT2].connect += op_calc(ops->Cnt[SLOT2][c], env, chip->phase_modulation, ops->wavetable[SLOT2][c]);
 
-//logerror("out1=%5i vol1=%4i\n", op_calc(SLOT->Cnt, env, chip->phase_modulation, SLOT->wavetable), env );
+//logerror("out1=%5i vol1=%4i\n", op_calc(ops->Cnt[SLOT2][c], env, chip->phase_modulation, ops->wavetable[SLOT2][c]), env );
 
 }
 
 /* calculate output of a 2nd part of 4-op channel */
-INLINE void chan_calc_ext( OPL3 *chip, OPL3_CH *CH )
+INLINE void chan_calc_ext( OPL3 *chip, int c )
 {
-	OPL3_SLOT *SLOT;
+	OPL3_CH *CH = &chip->P_CH[c];
+	OPL3_OPS *ops = &chip->op;
 	unsigned int env;
 
-	if (CH->Muted)
-		return;
-
 	chip->phase_modulation = 0;
 
 	/* SLOT 1 */
-	SLOT = &CH->SLOT[SLOT1];
-	env  = volume_calc(SLOT);
+	env  = volume_calc(SLOT1, c);
 	if( env < ENV_QUIET )
-		*SLOT->connect += op_calc(SLOT->Cnt, env, chip->phase_modulation2, SLOT->wavetable );
+		*CH->SLOT[SLOT1].connect += op_calc(ops->Cnt[SLOT1][c], env, chip->phase_modulation2, ops->wavetable[SLOT1][c] );
 
 	/* SLOT 2 */
-	SLOT++;
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT2, c);
 	if( env < ENV_QUIET )
-		*SLOT->connect += op_calc(SLOT->Cnt, env, chip->phase_modulation, SLOT->wavetable);
+		*CH->SLOT[SLOT2].connect += op_calc(ops->Cnt[SLOT2][c], env, chip->phase_modulation, ops->wavetable[SLOT2][c]);
+
+}
+
+/* channels in the order of the chip: the 2nd half of a 4-op channel takes
+   phase_modulation2 from its 1st half calculated right before it */
+static const UINT8 calc_order[18] =
+{
+	0, 3, 1, 4, 2, 5, 6, 7, 8,
+	9, 12, 10, 13, 11, 14, 15, 16, 17
+};
+
+/* calculate the melodic channels set in 'chns', the ones set in 'ext' as the
+   2nd half of a 4-op channel */
+typedef void (*OPL3_CALC_FUNC)(OPL3 *chip, UINT32 chns, UINT32 ext);
+
+static void OPL3_CALC_CHANNELS_C(OPL3 *chip, UINT32 chns, UINT32 ext)
+{
+	int i, c;
+
+	for (i = 0; chns; i ++)
+	{
+		c = calc_order[i];
+		if (! (chns & (1 << c)))
+			continue;
+		chns &= ~(1 << c);
+		if (ext & (1 << c))
+			chan_calc_ext(chip, c);
+		else
+			chan_calc(chip, c);
+	}
+}
 
+#ifdef OPL3_AVX2
+/* op_calc/op_calc1 for the 8 operators in 'run', silent ones (env >= ENV_QUIET) give 0 */
+__attribute__((target("avx2")))
+INLINE __m256i op_calc_AVX2(__m256i phase, __m256i env, __m256i pm, __m256i wave_tab, __m256i run)
+{
+	__m256i on, p;
+
+	on = _mm256_and_si256(run, _mm256_cmpgt_epi32(_mm256_set1_epi32(ENV_QUIET), env));
+	p = _mm256_add_epi32(_mm256_and_si256(phase, _mm256_set1_epi32(~FREQ_MASK)), pm);
+	p = _mm256_and_si256(_mm256_srli_epi32(p, FREQ_SH), _mm256_set1_epi32(SIN_MASK));
+	p = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)sin_tab,
+					_mm256_add_epi32(wave_tab, p), on, 4);
+	p = _mm256_add_epi32(_mm256_slli_epi32(env, 4), p);
+
+	on = _mm256_and_si256(on, _mm256_cmpgt_epi32(_mm256_set1_epi32(TL_TAB_LEN), p));
+	return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tl_tab, p, on, 4);
 }
 
+#define LOAD8(x) _mm256_loadu_si256((const __m256i *)(x))
+
+/* lanes of the channels c0 to c0+7 in the order of calc_order[] */
+static const UINT8 block_order[2][8] =
+{
+	{ 0, 3, 1, 4, 2, 5, 6, 7 },	/* channels 0-7 */
+	{ 0, 1, 4, 2, 5, 3, 6, 7 }	/* channels 8-15 */
+};
+
+/* channels c0 to c0+7 with a lane per channel ('chns' and 'ext' are lane
+   masks): the 2-op channels and 1st halves of 4-op channels in the vector,
+   then the 2nd halves (three lanes above their 1st half) one by one, as
+   their slots wait for the 1st half and a vector of them is mostly empty */
+__attribute__((target("avx2")))
+static void OPL3_CALC_BLOCK_AVX2(OPL3 *chip, int c0, UINT32 chns, UINT32 ext)
+{
+	OPL3_OPS *ops = &chip->op;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bits = _mm256_setr_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+	const __m256i lfo_am = _mm256_set1_epi32(chip->LFO_AM);
+	__m256i run, out0, out1, fb, env1, env2, to_out, to_pm2;
+	__m256i res, pm, pm2, sum;
+	INT32 lane_pm2[8];
+	int i;
+
+	run = _mm256_and_si256(_mm256_set1_epi32(chns & ~ext), bits);
+	run = _mm256_cmpeq_epi32(run, bits);
+
+	env1 = _mm256_add_epi32(LOAD8(&ops->TLL[SLOT1][c0]), LOAD8(&ops->volume[SLOT1][c0]));
+	env1 = _mm256_add_epi32(env1, _mm256_and_si256(lfo_am, LOAD8(&ops->AMmask[SLOT1][c0])));
+	env2 = _mm256_add_epi32(LOAD8(&ops->TLL[SLOT2][c0]), LOAD8(&ops->volume[SLOT2][c0]));
+	env2 = _mm256_add_epi32(env2, _mm256_and_si256(lfo_am, LOAD8(&ops->AMmask[SLOT2][c0])));
+	to_out = LOAD8(&ops->to_out[c0]);
+	to_pm2 = LOAD8(&ops->to_pm2[c0]);
+
+	/* SLOT 1 (feedback from the last two outputs) */
+	out0 = LOAD8(&ops->op1_out[0][c0]);
+	out1 = LOAD8(&ops->op1_out[1][c0]);
+	fb = LOAD8(&ops->FB[c0]);
+	pm = _mm256_add_epi32(out0, out1);
+	pm = _mm256_andnot_si256(_mm256_cmpeq_epi32(fb, zero), _mm256_sllv_epi32(pm, fb));
+	res = op_calc_AVX2(LOAD8(&ops->Cnt[SLOT1][c0]), env1, pm, LOAD8(&ops->wavetable[SLOT1][c0]), run);
+	_mm256_storeu_si256((__m256i *)&ops->op1_out[0][c0], _mm256_blendv_epi8(out0, out1, run));
+	_mm256_storeu_si256((__m256i *)&ops->op1_out[1][c0], _mm256_blendv_epi8(out1, res, run));
+	sum = _mm256_and_si256(to_out, res);
+	pm = _mm256_andnot_si256(to_out, res);
+
+	/* SLOT 2 */
+	res = op_calc_AVX2(LOAD8(&ops->Cnt[SLOT2][c0]), env2, _mm256_slli_epi32(pm, 16),
+						LOAD8(&ops->wavetable[SLOT2][c0]), run);
+	pm2 = _mm256_and_si256(to_pm2, res);
+	sum = _mm256_add_epi32(sum, _mm256_andnot_si256(to_pm2, res));
+
+	_mm256_storeu_si256((__m256i *)&chip->chanout[c0], sum);
+	_mm256_storeu_si256((__m256i *)lane_pm2, pm2);
+	_mm256_zeroupper();
+
+	/* the 2nd halves of the 4-op channels, modulated by slot 2 of their 1st half */
+	for (i = 3; i < 8; i ++)
+	{
+		if (ext & (1 << i))
+		{
+			chip->phase_modulation2 = lane_pm2[i - 3];
+			chan_calc_ext(chip, c0 + i);
+		}
+	}
+
+	/* phase_modulation2 is left as the last chan_calc() of the block sets it */
+	if (chns & ~ext)
+	{
+		for (i = 7; ! ((chns & ~ext) & (1 << block_order[c0 >> 3][i])); i --)
+			;
+		chip->phase_modulation2 = lane_pm2[block_order[c0 >> 3][i]];
+	}
+}
+
+/* channels 0-7 and 8-15 in one pass each, channels 16 and 17 on their own */
+__attribute__((target("avx2")))
+static void OPL3_CALC_CHANNELS_AVX2(OPL3 *chip, UINT32 chns, UINT32 ext)
+{
+	UINT32 blk, blk_ext, few;
+	int c0;
+
+	for (c0 = 0; c0 < 16; c0 += 8)
+	{
+		blk = (chns >> c0) & 0xFF;
+		blk_ext = (ext >> c0) & blk;
+
+		/* with fewer than 3 channels in the vector the scalar code is faster,
+		   a 2nd half without its (muted) 1st half needs the scalar order */
+		few = blk & ~blk_ext;
+		few &= few - 1;
+		if (! (few & (few - 1)) || (blk_ext & ~(blk << 3)))
+			OPL3_CALC_CHANNELS_C(chip, blk << c0, ext);
+		else
+			OPL3_CALC_BLOCK_AVX2(chip, c0, blk, blk_ext);
+	}
+	if (chns & 0x30000)
+		OPL3_CALC_CHANNELS_C(chip, chns & 0x30000, ext);
+}
+#endif
+
+static OPL3_CALC_FUNC OPL3_CALC_CHANNELS = OPL3_CALC_CHANNELS_C;
+
 /*
     operators used in the rhythm sounds generation process:
 
@@ -976,9 +1257,9 @@ number   number    BLK/FNUM2 FNUM    Drum  Hat   Drum  Tom  Cymbal
 
 /* calculate rhythm */
 
-INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
+INLINE void chan_calc_rhythm( OPL3 *chip, unsigned int noise )
 {
-	OPL3_SLOT *SLOT;
+	OPL3_OPS *ops = &chip->op;
 	signed int *chanout = chip->chanout;
 	signed int out;
 	unsigned int env;
@@ -994,29 +1275,27 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 	chip->phase_modulation = 0;
 
 	/* SLOT 1 */
-	SLOT = &CH[6].SLOT[SLOT1];
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT1, 6);
 
-	out = SLOT->op1_out[0] + SLOT->op1_out[1];
-	SLOT->op1_out[0] = SLOT->op1_out[1];
+	out = ops->op1_out[0][6] + ops->op1_out[1][6];
+	ops->op1_out[0][6] = ops->op1_out[1][6];
 
-	if (!SLOT->CON)
-		chip->phase_modulation = SLOT->op1_out[0];
+	if (!chip->P_CH[6].SLOT[SLOT1].CON)
+		chip->phase_modulation = ops->op1_out[0][6];
 	//else ignore output of operator 1
 
-	SLOT->op1_out[1] = 0;
+	ops->op1_out[1][6] = 0;
 	if( env < ENV_QUIET )
 	{
-		if (!SLOT->FB)
+		if (!ops->FB[6])
 			out = 0;
-		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+		ops->op1_out[1][6] = op_calc1(ops->Cnt[SLOT1][6], env, (out<<ops->FB[6]), ops->wavetable[SLOT1][6] );
 	}
 
 	/* SLOT 2 */
-	SLOT++;
-	env = volume_calc(SLOT);
+	env = volume_calc(SLOT2, 6);
 	if( env < ENV_QUIET && ! chip->MuteSpc[0] )
-		chanout[6] += op_calc(SLOT->Cnt, env, chip->phase_modulation, SLOT->wavetable) * 2;
+		chanout[6] += op_calc(ops->Cnt[SLOT2][6], env, chip->phase_modulation, ops->wavetable[SLOT2][6]) * 2;
 
 
 	/* Phase generation is based on: */
@@ -1037,7 +1316,7 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
     */
 
 	/* High Hat (verified on real YM3812) */
-	env = volume_calc(SLOT7_1);
+	env = volume_calc(SLOT1, 7);
 	if( env < ENV_QUIET && ! chip->MuteSpc[4] )
 	{
 
@@ -1047,9 +1326,9 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
         */
 
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit7 = ((SLOT7_1->Cnt>>FREQ_SH)>>7)&1;
-		unsigned char bit3 = ((SLOT7_1->Cnt>>FREQ_SH)>>3)&1;
-		unsigned char bit2 = ((SLOT7_1->Cnt>>FREQ_SH)>>2)&1;
+		unsigned char bit7 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>7)&1;
+		unsigned char bit3 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>3)&1;
+		unsigned char bit2 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>2)&1;
 
 		unsigned char res1 = (bit2 ^ bit7) | bit3;
 
@@ -1058,8 +1337,8 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 		UINT32 phase = res1 ? (0x200|(0xd0>>2)) : 0xd0;
 
 		/* enable gate based on frequency of operator 2 in channel 8 */
-		unsigned char bit5e= ((SLOT8_2->Cnt>>FREQ_SH)>>5)&1;
-		unsigned char bit3e= ((SLOT8_2->Cnt>>FREQ_SH)>>3)&1;
+		unsigned char bit5e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>5)&1;
+		unsigned char bit3e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>3)&1;
 
 		unsigned char res2 = (bit3e ^ bit5e);
 
@@ -1084,15 +1363,15 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 				phase = 0xd0>>2;
 		}
 
-		chanout[7] += op_calc(phase<<FREQ_SH, env, 0, SLOT7_1->wavetable) * 2;
+		chanout[7] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT1][7]) * 2;
 	}
 
 	/* Snare Drum (verified on real YM3812) */
-	env = volume_calc(SLOT7_2);
+	env = volume_calc(SLOT2, 7);
 	if( env < ENV_QUIET && ! chip->MuteSpc[1] )
 	{
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit8 = ((SLOT7_1->Cnt>>FREQ_SH)>>8)&1;
+		unsigned char bit8 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>8)&1;
 
 		/* when bit8 = 0 phase = 0x100; */
 		/* when bit8 = 1 phase = 0x200; */
@@ -1105,22 +1384,22 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 		if (noise)
 			phase ^= 0x100;
 
-		chanout[7] += op_calc(phase<<FREQ_SH, env, 0, SLOT7_2->wavetable) * 2;
+		chanout[7] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT2][7]) * 2;
 	}
 
 	/* Tom Tom (verified on real YM3812) */
-	env = volume_calc(SLOT8_1);
+	env = volume_calc(SLOT1, 8);
 	if( env < ENV_QUIET && ! chip->MuteSpc[2] )
-		chanout[8] += op_calc(SLOT8_1->Cnt, env, 0, SLOT8_1->wavetable) * 2;
+		chanout[8] += op_calc(ops->Cnt[SLOT1][8], env, 0, ops->wavetable[SLOT1][8]) * 2;
 
 	/* Top Cymbal (verified on real YM3812) */
-	env = volume_calc(SLOT8_2);
+	env = volume_calc(SLOT2, 8);
 	if( env < ENV_QUIET && ! chip->MuteSpc[3] )
 	{
 		/* base frequency derived from operator 1 in channel 7 */
-		unsigned char bit7 = ((SLOT7_1->Cnt>>FREQ_SH)>>7)&1;
-		unsigned char bit3 = ((SLOT7_1->Cnt>>FREQ_SH)>>3)&1;
-		unsigned char bit2 = ((SLOT7_1->Cnt>>FREQ_SH)>>2)&1;
+		unsigned char bit7 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>7)&1;
+		unsigned char bit3 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>3)&1;
+		unsigned char bit2 = ((ops->Cnt[SLOT1][7]>>FREQ_SH)>>2)&1;
 
 		unsigned char res1 = (bit2 ^ bit7) | bit3;
 
@@ -1129,8 +1408,8 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 		UINT32 phase = res1 ? 0x300 : 0x100;
 
 		/* enable gate based on frequency of operator 2 in channel 8 */
-		unsigned char bit5e= ((SLOT8_2->Cnt>>FREQ_SH)>>5)&1;
-		unsigned char bit3e= ((SLOT8_2->Cnt>>FREQ_SH)>>3)&1;
+		unsigned char bit5e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>5)&1;
+		unsigned char bit3e= ((ops->Cnt[SLOT2][8]>>FREQ_SH)>>3)&1;
 
 		unsigned char res2 = (bit3e ^ bit5e);
 		/* when res2 = 0 pass the phase from calculation above (res1); */
@@ -1138,171 +1417,12 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 		if (res2)
 			phase = 0x300;
 
-		chanout[8] += op_calc(phase<<FREQ_SH, env, 0, SLOT8_2->wavetable) * 2;
+		chanout[8] += op_calc(phase<<FREQ_SH, env, 0, ops->wavetable[SLOT2][8]) * 2;
 	}
 
 }
 
 
-/* generic table initialize */
-static int init_tables(void)
-{
-	signed int i,x;
-	signed int n;
-	double o,m;
-
-
-	for (x=0; x<TL_RES_LEN; x++)
-	{
-		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
-		m = floor(m);
-
-		/* we never reach (1<<16) here due to the (x+1) */
-		/* result fits within 16 bits at maximum */
-
-		n = (int)m;		/* 16 bits here */
-		n >>= 4;		/* 12 bits here */
-		if (n&1)		/* round to nearest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-						/* 11 bits here (rounded) */
-		n <<= 1;		/* 12 bits here (as in real chip) */
-		tl_tab[ x*2 + 0 ] = n;
-		tl_tab[ x*2 + 1 ] = ~tl_tab[ x*2 + 0 ]; /* this *is* different from OPL2 (verified on real YMF262) */
-
-		for (i=1; i<13; i++)
-		{
-			tl_tab[ x*2+0 + i*2*TL_RES_LEN ] =  tl_tab[ x*2+0 ]>>i;
-			tl_tab[ x*2+1 + i*2*TL_RES_LEN ] = ~tl_tab[ x*2+0 + i*2*TL_RES_LEN ];  /* this *is* different from OPL2 (verified on real YMF262) */
-		}
-	#if 0
-			logerror("tl %04i", x*2);
-			for (i=0; i<13; i++)
-				logerror(", [%02i] %5i", i*2, tl_tab[ x*2 +0 + i*2*TL_RES_LEN ] ); /* positive */
-			logerror("\n");
-
-			logerror("tl %04i", x*2);
-			for (i=0; i<13; i++)
-				logerror(", [%02i] %5i", i*2, tl_tab[ x*2 +1 + i*2*TL_RES_LEN ] ); /* negative */
-			logerror("\n");
-	#endif
-	}
-
-	for (i=0; i<SIN_LEN; i++)
-	{
-		/* non-standard sinus */
-		m = sin( ((i*2)+1) * M_PI / SIN_LEN ); /* checked against the real chip */
-
-		/* we never reach zero here due to ((i*2)+1) */
-
-		if (m>0.0)
-			o = 8*log(1.0/m)/log(2.0);	/* convert to 'decibels' */
-		else
-			o = 8*log(-1.0/m)/log(2.0);	/* convert to 'decibels' */
-
-		o = o / (ENV_STEP/4);
-
-		n = (int)(2.0*o);
-		if (n&1)						/* round to nearest */
-			n = (n>>1)+1;
-		else
-			n = n>>1;
-
-		sin_tab[ i ] = n*2 + (m>=0.0? 0: 1 );
-
-		/*logerror("YMF262.C: sin [%4i (hex=%03x)]= %4i (tl_tab value=%5i)\n", i, i, sin_tab[i], tl_tab[sin_tab[i]] );*/
-	}
-
-	for (i=0; i<SIN_LEN; i++)
-	{
-		/* these 'pictures' represent _two_ cycles */
-		/* waveform 1:  __      __     */
-		/*             /  \____/  \____*/
-		/* output only first half of the sinus waveform (positive one) */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			sin_tab[1*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[1*SIN_LEN+i] = sin_tab[i];
-
-		/* waveform 2:  __  __  __  __ */
-		/*             /  \/  \/  \/  \*/
-		/* abs(sin) */
-
-		sin_tab[2*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>1) ];
-
-		/* waveform 3:  _   _   _   _  */
-		/*             / |_/ |_/ |_/ |_*/
-		/* abs(output only first quarter of the sinus waveform) */
-
-		if (i & (1<<(SIN_BITS-2)) )
-			sin_tab[3*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[3*SIN_LEN+i] = sin_tab[i & (SIN_MASK>>2)];
-
-		/* waveform 4:                 */
-		/*             /\  ____/\  ____*/
-		/*               \/      \/    */
-		/* output whole sinus waveform in half the cycle(step=2) and output 0 on the other half of cycle */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			sin_tab[4*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[4*SIN_LEN+i] = sin_tab[i*2];
-
-		/* waveform 5:                 */
-		/*             /\/\____/\/\____*/
-		/*                             */
-		/* output abs(whole sinus) waveform in half the cycle(step=2) and output 0 on the other half of cycle */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			sin_tab[5*SIN_LEN+i] = TL_TAB_LEN;
-		else
-			sin_tab[5*SIN_LEN+i] = sin_tab[(i*2) & (SIN_MASK>>1) ];
-
-		/* waveform 6: ____    ____    */
-		/*                             */
-		/*                 ____    ____*/
-		/* output maximum in half the cycle and output minimum on the other half of cycle */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			sin_tab[6*SIN_LEN+i] = 1;	/* negative */
-		else
-			sin_tab[6*SIN_LEN+i] = 0;	/* positive */
-
-		/* waveform 7:                 */
-		/*             |\____  |\____  */
-		/*                   \|      \|*/
-		/* output sawtooth waveform    */
-
-		if (i & (1<<(SIN_BITS-1)) )
-			x = ((SIN_LEN-1)-i)*16 + 1;	/* negative: from 8177 to 1 */
-		else
-			x = i*16;	/*positive: from 0 to 8176 */
-
-		if (x > TL_TAB_LEN)
-			x = TL_TAB_LEN;	/* clip to the allowed range */
-
-		sin_tab[7*SIN_LEN+i] = x;
-
-		//logerror("YMF262.C: sin1[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[1*SIN_LEN+i], tl_tab[sin_tab[1*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin2[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[2*SIN_LEN+i], tl_tab[sin_tab[2*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin3[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[3*SIN_LEN+i], tl_tab[sin_tab[3*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin4[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[4*SIN_LEN+i], tl_tab[sin_tab[4*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin5[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[5*SIN_LEN+i], tl_tab[sin_tab[5*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin6[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[6*SIN_LEN+i], tl_tab[sin_tab[6*SIN_LEN+i]] );
-		//logerror("YMF262.C: sin7[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[7*SIN_LEN+i], tl_tab[sin_tab[7*SIN_LEN+i]] );
-	}
-	/*logerror("YMF262.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-#ifdef SAVE_SAMPLE
-	sample[0]=fopen("sampsum.pcm","wb");
-#endif
-
-	return 1;
-}
-
 static void OPLCloseTable( void )
 {
 #ifdef SAVE_SAMPLE
@@ -1376,12 +1496,14 @@ static void OPL3_initalize(OPL3 *chip)
 
 }
 
-INLINE void FM_KEYON(OPL3_SLOT *SLOT, UINT32 key_set)
+INLINE void FM_KEYON(OPL3 *chip, int c, int s, UINT32 key_set)
 {
+	OPL3_SLOT *SLOT = &chip->P_CH[c].SLOT[s];
+
 	if( !SLOT->key )
 	{
 		/* restart Phase Generator */
-		SLOT->Cnt = 0;
+		chip->op.Cnt[s][c] = 0;
 		/* phase -> Attack */
 		SLOT->state = EG_ATT;
 	}
@@ -1403,13 +1525,15 @@ INLINE void FM_KEYOFF(OPL3_SLOT *SLOT, UINT32 key_clr)
 	}
 }
 
-/* update phase increment counter of operator (also update the EG rates if necessary) */
-INLINE void CALC_FCSLOT(OPL3_CH *CH,OPL3_SLOT *SLOT)
+/* update phase increment counter of operator (also update the EG rates if necessary)
+   ('CH' gives the frequency, 'c' and 's' select the slot) */
+INLINE void CALC_FCSLOT(OPL3 *chip,OPL3_CH *CH,int c,int s)
 {
+	OPL3_SLOT *SLOT = &chip->P_CH[c].SLOT[s];
 	int ksr;
 
 	/* (frequency) phase increment counter */
-	SLOT->Incr = CH->fc * SLOT->mul;
+	chip->op.Incr[s][c] = CH->fc * SLOT->mul;
 	ksr = CH->kcode >> SLOT->KSR;
 
 	if( SLOT->ksr != ksr )
@@ -1447,8 +1571,11 @@ INLINE void set_mul(OPL3 *chip,int slot,int v)
 	SLOT->mul     = mul_tab[v&0x0f];
 	SLOT->KSR     = (v&0x10) ? 0 : 2;
 	SLOT->eg_type = (v&0x20);
-	SLOT->vib     = (v&0x40);
-	SLOT->AMmask  = (v&0x80) ? ~0 : 0;
+	if (v&0x40)
+		chip->op.vib |= (UINT64)1 << slot;
+	else
+		chip->op.vib &= ~((UINT64)1 << slot);
+	chip->op.AMmask[slot&1][slot/2] = (v&0x80) ? ~0 : 0;
 
 	if (chip->OPL3_mode & 1)
 	{
@@ -1470,12 +1597,12 @@ INLINE void set_mul(OPL3 *chip,int slot,int v)
 			if (CH->extended)
 			{
 				/* normal */
-				CALC_FCSLOT(CH,SLOT);
+				CALC_FCSLOT(chip,CH,slot/2,slot&1);
 			}
 			else
 			{
 				/* normal */
-				CALC_FCSLOT(CH,SLOT);
+				CALC_FCSLOT(chip,CH,slot/2,slot&1);
 			}
 		break;
 		case 3: case 4: case 5:
@@ -1483,24 +1610,24 @@ INLINE void set_mul(OPL3 *chip,int slot,int v)
 			if ((CH-3)->extended)
 			{
 				/* update this SLOT using frequency data for 1st channel of a pair */
-				CALC_FCSLOT(CH-3,SLOT);
+				CALC_FCSLOT(chip,CH-3,slot/2,slot&1);
 			}
 			else
 			{
 				/* normal */
-				CALC_FCSLOT(CH,SLOT);
+				CALC_FCSLOT(chip,CH,slot/2,slot&1);
 			}
 		break;
 		default:
 				/* normal */
-				CALC_FCSLOT(CH,SLOT);
+				CALC_FCSLOT(chip,CH,slot/2,slot&1);
 		break;
 		}
 	}
 	else
 	{
 		/* in OPL2 mode */
-		CALC_FCSLOT(CH,SLOT);
+		CALC_FCSLOT(chip,CH,slot/2,slot&1);
 	}
 }
 
@@ -1533,12 +1660,12 @@ INLINE void set_ksl_tl(OPL3 *chip,int slot,int v)
 			if (CH->extended)
 			{
 				/* normal */
-				SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+				chip->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 			}
 			else
 			{
 				/* normal */
-				SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+				chip->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 			}
 		break;
 		case 3: case 4: case 5:
@@ -1546,24 +1673,24 @@ INLINE void set_ksl_tl(OPL3 *chip,int slot,int v)
 			if ((CH-3)->extended)
 			{
 				/* update this SLOT using frequency data for 1st channel of a pair */
-				SLOT->TLL = SLOT->TL + ((CH-3)->ksl_base>>SLOT->ksl);
+				chip->op.TLL[slot&1][slot/2] = SLOT->TL + ((CH-3)->ksl_base>>SLOT->ksl);
 			}
 			else
 			{
 				/* normal */
-				SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+				chip->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 			}
 		break;
 		default:
 				/* normal */
-				SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+				chip->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 		break;
 		}
 	}
 	else
 	{
 		/* in OPL2 mode */
-		SLOT->TLL = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
+		chip->op.TLL[slot&1][slot/2] = SLOT->TL + (CH->ksl_base>>SLOT->ksl);
 	}
 
 }
@@ -1624,6 +1751,22 @@ static void update_channels(OPL3 *chip, OPL3_CH *CH)
 
 }
 
+/* refresh the routing masks of the channel calculation from the 'connect'
+   pointers (slot 1 feeds the output or phase_modulation, slot 2 the output
+   or phase_modulation2) */
+static void update_routing(OPL3 *chip)
+{
+	OPL3_CH *CH;
+	int c;
+
+	for (c=0; c<18; c++)
+	{
+		CH = &chip->P_CH[c];
+		chip->op.to_out[c] = (CH->SLOT[SLOT1].connect == &chip->phase_modulation) ? 0 : ~0;
+		chip->op.to_pm2[c] = (CH->SLOT[SLOT2].connect == &chip->phase_modulation2) ? ~0 : 0;
+	}
+}
+
 /* write a value v to register r on OPL chip */
 static void OPL3WriteReg(OPL3 *chip, int r, int v)
 {
@@ -1632,6 +1775,7 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 	unsigned int ch_offset = 0;
 	int slot;
 	int block_fnum;
+	int chan_no;
 
 
 
@@ -1811,8 +1955,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 				/* BD key on/off */
 				if(v&0x10)
 				{
-					FM_KEYON (&chip->P_CH[6].SLOT[SLOT1], 2);
-					FM_KEYON (&chip->P_CH[6].SLOT[SLOT2], 2);
+					FM_KEYON (chip, 6, SLOT1, 2);
+					FM_KEYON (chip, 6, SLOT2, 2);
 				}
 				else
 				{
@@ -1820,16 +1964,16 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 					FM_KEYOFF(&chip->P_CH[6].SLOT[SLOT2],~2);
 				}
 				/* HH key on/off */
-				if(v&0x01) FM_KEYON (&chip->P_CH[7].SLOT[SLOT1], 2);
+				if(v&0x01) FM_KEYON (chip, 7, SLOT1, 2);
 				else       FM_KEYOFF(&chip->P_CH[7].SLOT[SLOT1],~2);
 				/* SD key on/off */
-				if(v&0x08) FM_KEYON (&chip->P_CH[7].SLOT[SLOT2], 2);
+				if(v&0x08) FM_KEYON (chip, 7, SLOT2, 2);
 				else       FM_KEYOFF(&chip->P_CH[7].SLOT[SLOT2],~2);
 				/* TOM key on/off */
-				if(v&0x04) FM_KEYON (&chip->P_CH[8].SLOT[SLOT1], 2);
+				if(v&0x04) FM_KEYON (chip, 8, SLOT1, 2);
 				else       FM_KEYOFF(&chip->P_CH[8].SLOT[SLOT1],~2);
 				/* TOP-CY key on/off */
-				if(v&0x02) FM_KEYON (&chip->P_CH[8].SLOT[SLOT2], 2);
+				if(v&0x02) FM_KEYON (chip, 8, SLOT2, 2);
 				else       FM_KEYOFF(&chip->P_CH[8].SLOT[SLOT2],~2);
 			}
 			else
@@ -1851,7 +1995,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 
 		/* keyon,block,fnum */
 		if( (r&0x0f) > 8) return;
-		CH = &chip->P_CH[(r&0x0f) + ch_offset];
+		chan_no = (r&0x0f) + ch_offset;
+		CH = &chip->P_CH[chan_no];
 
 		if(!(r&0x10))
 		{	/* a0-a8 */
@@ -1863,7 +2008,6 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 
 			if (chip->OPL3_mode & 1)
 			{
-				int chan_no = (r&0x0f) + ch_offset;
 
 				/* in OPL3 mode */
 				//DO THIS:
@@ -1883,10 +2027,10 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 						//ALSO keyon/off slots of 2nd channel forming up 4-op channel
 						if(v&0x20)
 						{
-							FM_KEYON (&CH->SLOT[SLOT1], 1);
-							FM_KEYON (&CH->SLOT[SLOT2], 1);
-							FM_KEYON (&(CH+3)->SLOT[SLOT1], 1);
-							FM_KEYON (&(CH+3)->SLOT[SLOT2], 1);
+							FM_KEYON (chip, chan_no, SLOT1, 1);
+							FM_KEYON (chip, chan_no, SLOT2, 1);
+							FM_KEYON (chip, chan_no+3, SLOT1, 1);
+							FM_KEYON (chip, chan_no+3, SLOT2, 1);
 						}
 						else
 						{
@@ -1901,8 +2045,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 						//else normal 2 operator function keyon/off
 						if(v&0x20)
 						{
-							FM_KEYON (&CH->SLOT[SLOT1], 1);
-							FM_KEYON (&CH->SLOT[SLOT2], 1);
+							FM_KEYON (chip, chan_no, SLOT1, 1);
+							FM_KEYON (chip, chan_no, SLOT2, 1);
 						}
 						else
 						{
@@ -1923,8 +2067,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 						//else normal 2 operator function keyon/off
 						if(v&0x20)
 						{
-							FM_KEYON (&CH->SLOT[SLOT1], 1);
-							FM_KEYON (&CH->SLOT[SLOT2], 1);
+							FM_KEYON (chip, chan_no, SLOT1, 1);
+							FM_KEYON (chip, chan_no, SLOT2, 1);
 						}
 						else
 						{
@@ -1937,8 +2081,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 				default:
 					if(v&0x20)
 					{
-						FM_KEYON (&CH->SLOT[SLOT1], 1);
-						FM_KEYON (&CH->SLOT[SLOT2], 1);
+						FM_KEYON (chip, chan_no, SLOT1, 1);
+						FM_KEYON (chip, chan_no, SLOT2, 1);
 					}
 					else
 					{
@@ -1952,8 +2096,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 			{
 				if(v&0x20)
 				{
-					FM_KEYON (&CH->SLOT[SLOT1], 1);
-					FM_KEYON (&CH->SLOT[SLOT2], 1);
+					FM_KEYON (chip, chan_no, SLOT1, 1);
+					FM_KEYON (chip, chan_no, SLOT2, 1);
 				}
 				else
 				{
@@ -1985,7 +2129,6 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 
 			if (chip->OPL3_mode & 1)
 			{
-				int chan_no = (r&0x0f) + ch_offset;
 				/* in OPL3 mode */
 				//DO THIS:
 				//if this is 1st channel forming up a 4-op channel
@@ -2004,27 +2147,27 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 						//ALSO update slots of 2nd channel forming up 4-op channel
 
 						/* refresh Total Level in FOUR SLOTs of this channel and channel+3 using data from THIS channel */
-						CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-						CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
-						(CH+3)->SLOT[SLOT1].TLL = (CH+3)->SLOT[SLOT1].TL + (CH->ksl_base>>(CH+3)->SLOT[SLOT1].ksl);
-						(CH+3)->SLOT[SLOT2].TLL = (CH+3)->SLOT[SLOT2].TL + (CH->ksl_base>>(CH+3)->SLOT[SLOT2].ksl);
+						chip->op.TLL[SLOT1][chan_no] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+						chip->op.TLL[SLOT2][chan_no] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+						chip->op.TLL[SLOT1][chan_no+3] = (CH+3)->SLOT[SLOT1].TL + (CH->ksl_base>>(CH+3)->SLOT[SLOT1].ksl);
+						chip->op.TLL[SLOT2][chan_no+3] = (CH+3)->SLOT[SLOT2].TL + (CH->ksl_base>>(CH+3)->SLOT[SLOT2].ksl);
 
 						/* refresh frequency counter in FOUR SLOTs of this channel and channel+3 using data from THIS channel */
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
-						CALC_FCSLOT(CH,&(CH+3)->SLOT[SLOT1]);
-						CALC_FCSLOT(CH,&(CH+3)->SLOT[SLOT2]);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT1);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT2);
+						CALC_FCSLOT(chip,CH,chan_no+3,SLOT1);
+						CALC_FCSLOT(chip,CH,chan_no+3,SLOT2);
 					}
 					else
 					{
 						//else normal 2 operator function
 						/* refresh Total Level in both SLOTs of this channel */
-						CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-						CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+						chip->op.TLL[SLOT1][chan_no] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+						chip->op.TLL[SLOT2][chan_no] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
 
 						/* refresh frequency counter in both SLOTs of this channel */
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT1);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT2);
 					}
 				break;
 
@@ -2038,23 +2181,23 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 					{
 						//else normal 2 operator function
 						/* refresh Total Level in both SLOTs of this channel */
-						CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-						CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+						chip->op.TLL[SLOT1][chan_no] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+						chip->op.TLL[SLOT2][chan_no] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
 
 						/* refresh frequency counter in both SLOTs of this channel */
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-						CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT1);
+						CALC_FCSLOT(chip,CH,chan_no,SLOT2);
 					}
 				break;
 
 				default:
 					/* refresh Total Level in both SLOTs of this channel */
-					CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-					CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+					chip->op.TLL[SLOT1][chan_no] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+					chip->op.TLL[SLOT2][chan_no] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
 
 					/* refresh frequency counter in both SLOTs of this channel */
-					CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-					CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
+					CALC_FCSLOT(chip,CH,chan_no,SLOT1);
+					CALC_FCSLOT(chip,CH,chan_no,SLOT2);
 				break;
 				}
 			}
@@ -2063,12 +2206,12 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 				/* in OPL2 mode */
 
 				/* refresh Total Level in both SLOTs of this channel */
-				CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
-				CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
+				chip->op.TLL[SLOT1][chan_no] = CH->SLOT[SLOT1].TL + (CH->ksl_base>>CH->SLOT[SLOT1].ksl);
+				chip->op.TLL[SLOT2][chan_no] = CH->SLOT[SLOT2].TL + (CH->ksl_base>>CH->SLOT[SLOT2].ksl);
 
 				/* refresh frequency counter in both SLOTs of this channel */
-				CALC_FCSLOT(CH,&CH->SLOT[SLOT1]);
-				CALC_FCSLOT(CH,&CH->SLOT[SLOT2]);
+				CALC_FCSLOT(chip,CH,chan_no,SLOT1);
+				CALC_FCSLOT(chip,CH,chan_no,SLOT2);
 			}
 		}
 	break;
@@ -2077,7 +2220,8 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 		/* CH.D, CH.C, CH.B, CH.A, FB(3bits), C */
 		if( (r&0xf) > 8) return;
 
-		CH = &chip->P_CH[(r&0xf) + ch_offset];
+		chan_no = (r&0x0f) + ch_offset;
+		CH = &chip->P_CH[chan_no];
 
 		if( chip->OPL3_mode & 1 )
 		{
@@ -2102,13 +2246,11 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 
 		chip->pan_ctrl_value[ (r&0xf) + ch_offset ] = v;	/* store control value for OPL3/OPL2 mode switching on the fly */
 
-		CH->SLOT[SLOT1].FB  = (v>>1)&7 ? ((v>>1)&7) + 7 : 0;
+		chip->op.FB[chan_no] = (v>>1)&7 ? ((v>>1)&7) + 7 : 0;
 		CH->SLOT[SLOT1].CON = v&1;
 
 		if( chip->OPL3_mode & 1 )
 		{
-			int chan_no = (r&0x0f) + ch_offset;
-
 			switch(chan_no)
 			{
 			case 0: case 1: case 2:
@@ -2228,6 +2370,7 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 			CH->SLOT[SLOT1].connect = CH->SLOT[SLOT1].CON ? &chanout[(r&0xf)+ch_offset] : &chip->phase_modulation;
 			CH->SLOT[SLOT2].connect = &chanout[(r&0xf)+ch_offset];
 		}
+		update_routing(chip);
 	break;
 
 	case 0xe0: /* waveform select */
@@ -2248,7 +2391,7 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 		{
 			v &= 3; /* we're in OPL2 mode */
 		}
-		CH->SLOT[slot&1].wavetable = v * SIN_LEN;
+		chip->op.wavetable[slot&1][slot/2] = v * SIN_LEN;
 	break;
 	}
 }
@@ -2269,11 +2412,10 @@ static int OPL3_LockTable()
 
 	/* first time */
 
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
+	/* the total level and sin tables are static const (gentables.c) */
+#ifdef SAVE_SAMPLE
+	sample[0]=fopen("sampsum.pcm","wb");
+#endif
 
 	/*if (LOG_CYM_FILE)
 	{
@@ -2338,7 +2480,7 @@ static void OPL3ResetChip(OPL3 *chip)
 		for(s = 0 ; s < 2 ; s++ )
 		{
 			CH->SLOT[s].state     = EG_OFF;
-			CH->SLOT[s].volume    = MAX_ATT_INDEX;
+			chip->op.volume[s][c] = MAX_ATT_INDEX;
 		}
 	}
 }
@@ -2368,6 +2510,12 @@ static OPL3 *OPL3Create(int clock, int rate, int type)
 	/* init global tables */
 	OPL3_initalize(chip);
 
+	OPL3_CALC_CHANNELS = OPL3_CALC_CHANNELS_C;
+#ifdef OPL3_AVX2
+	if (SimdLevel >= SIMD_AVX2)
+		OPL3_CALC_CHANNELS = OPL3_CALC_CHANNELS_AVX2;
+#endif
+
 	/* reset chip */
 	OPL3ResetChip(chip);
 	return chip;
@@ -2533,14 +2681,26 @@ void ymf262_set_mutemask(void *chip, UINT32 MuteMask)
 	OPL3 *opl3 = (OPL3 *)chip;
 	UINT8 CurChn;
 	
-	for (CurChn = 0; CurChn < 18; CurChn ++)
-		opl3->P_CH[CurChn].Muted = (MuteMask >> CurChn) & 0x01;
+	opl3->MuteChn = MuteMask & 0x3FFFF;
 	for (CurChn = 0; CurChn < 5; CurChn ++)
 		opl3->MuteSpc[CurChn] = (MuteMask >> (CurChn + 18)) & 0x01;
 	
 	return;
 }
 
+UINT32 ymf262_save_state(void *chip, void *Data)
+{
+	if (Data != NULL)
+		memcpy(Data, chip, sizeof(OPL3));
+	return sizeof(OPL3);
+}
+
+UINT32 ymf262_load_state(void *chip, const void *Data)
+{
+	memcpy(chip, Data, sizeof(OPL3));
+	return sizeof(OPL3);
+}
+
 
 /*
 ** Generate samples for one of the YMF262's
@@ -2559,80 +2719,55 @@ void ymf262_update_one(void *_chip, OPL3SAMPLE **buffers, int length)
 	//OPL3SAMPLE	*ch_c = buffers[2];
 	//OPL3SAMPLE	*ch_d = buffers[3];
 
+	UINT32		active;
+	UINT32		chns;
+	UINT32		ext;
+	UINT64		eg_slots;
 	int i;
 	int chn;
 
-	for( i=0; i < length ; i++ )
+	active = OPL3_active_channels(chip);
+	if (! active && length)
 	{
-		int a,b,c,d;
-
-
-		advance_lfo(chip);
-
-		/* clear channel outputs */
-		memset(chip->chanout, 0, sizeof(signed int) * 18);
-
-#if 1
-	/* register set #1 */
-		chan_calc(chip, &chip->P_CH[0]);			/* extended 4op ch#0 part 1 or 2op ch#0 */
-		if (chip->P_CH[0].extended)
-			chan_calc_ext(chip, &chip->P_CH[3]);	/* extended 4op ch#0 part 2 */
-		else
-			chan_calc(chip, &chip->P_CH[3]);		/* standard 2op ch#3 */
-
-
-		chan_calc(chip, &chip->P_CH[1]);			/* extended 4op ch#1 part 1 or 2op ch#1 */
-		if (chip->P_CH[1].extended)
-			chan_calc_ext(chip, &chip->P_CH[4]);	/* extended 4op ch#1 part 2 */
-		else
-			chan_calc(chip, &chip->P_CH[4]);		/* standard 2op ch#4 */
-
+		/* nothing to calculate, the chip is silent */
+		memset(ch_a, 0x00, length * sizeof(OPL3SAMPLE));
+		memset(ch_b, 0x00, length * sizeof(OPL3SAMPLE));
+		advance_idle(chip, length);
+		return;
+	}
 
-		chan_calc(chip, &chip->P_CH[2]);			/* extended 4op ch#2 part 1 or 2op ch#2 */
-		if (chip->P_CH[2].extended)
-			chan_calc_ext(chip, &chip->P_CH[5]);	/* extended 4op ch#2 part 2 */
-		else
-			chan_calc(chip, &chip->P_CH[5]);		/* standard 2op ch#5 */
+	eg_slots = OPL3_eg_slots(chip);
 
+	/* melodic channels, the rhythm part is calculated on its own */
+	chns = active & ~chip->MuteChn;
+	if (rhythm)
+		chns &= ~0x001C0;
 
-		if(!rhythm)
-		{
-			chan_calc(chip, &chip->P_CH[6]);
-			chan_calc(chip, &chip->P_CH[7]);
-			chan_calc(chip, &chip->P_CH[8]);
-		}
-		else		/* Rhythm part */
+	/* 2nd halves of the 4-op channels (ch#3-5 and ch#12-14) */
+	ext = 0;
+	for (chn = 0; chn < 18; chn += 9)
+	{
+		for (i = 0; i < 3; i ++)
 		{
-			chan_calc_rhythm(chip, &chip->P_CH[0], (chip->noise_rng>>0)&1 );
+			if (chip->P_CH[chn + i].extended)
+				ext |= 0x08 << (chn + i);
 		}
+	}
 
-	/* register set #2 */
-		chan_calc(chip, &chip->P_CH[ 9]);
-		if (chip->P_CH[9].extended)
-			chan_calc_ext(chip, &chip->P_CH[12]);
-		else
-			chan_calc(chip, &chip->P_CH[12]);
-
+	for( i=0; i < length ; i++ )
+	{
+		int a,b,c,d;
 
-		chan_calc(chip, &chip->P_CH[10]);
-		if (chip->P_CH[10].extended)
-			chan_calc_ext(chip, &chip->P_CH[13]);
-		else
-			chan_calc(chip, &chip->P_CH[13]);
 
+		advance_lfo(chip);
 
-		chan_calc(chip, &chip->P_CH[11]);
-		if (chip->P_CH[11].extended)
-			chan_calc_ext(chip, &chip->P_CH[14]);
-		else
-			chan_calc(chip, &chip->P_CH[14]);
+		/* clear channel outputs */
+		memset(chip->chanout, 0, sizeof(signed int) * 18);
 
+		OPL3_CALC_CHANNELS(chip, chns, ext);
 
-        /* channels 15,16,17 are fixed 2-operator channels only */
-		chan_calc(chip, &chip->P_CH[15]);
-		chan_calc(chip, &chip->P_CH[16]);
-		chan_calc(chip, &chip->P_CH[17]);
-#endif
+		if (rhythm && (active & 0x001C0))		/* Rhythm part */
+			chan_calc_rhythm(chip, (chip->noise_rng>>0)&1 );
 
 		/* accumulator register set #1 */
 		a =  chip->chanout[0] & chip->pan[0];
@@ -2739,7 +2874,7 @@ void ymf262_update_one(void *_chip, OPL3SAMPLE **buffers, int length)
 		//ch_c[i] = c;
 		//ch_d[i] = d;
 
-		advance(chip);
+		advance(chip, eg_slots);
 	}
 
 }
@@ -46,4 +46,6 @@ void ymf262_set_update_handler(void *chip, OPL3_UPDATEHANDLER UpdateHandler, voi
 
 void ymf262_set_emu_core(UINT8 Emulator);
 void ymf262_set_mutemask(void *chip, UINT32 MuteMask);
+UINT32 ymf262_save_state(void *chip, void *Data);
+UINT32 ymf262_load_state(void *chip, const void *Data);
 
@@ -68,9 +68,18 @@
 #include <stddef.h>	// for NULL
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>	// for mmap
+#include <pthread.h>
+#include <sys/stat.h>
 #include "ymf262.h"
 #include "ymf278b.h"
 
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(__clang__)
+// the AVX2 mixer has its own function target, device_start_ymf278b selects it
+#define YMF278B_AVX2
+#include <immintrin.h>
+#endif
+
 typedef struct
 {
 	UINT32 startaddr;
@@ -142,6 +151,7 @@ typedef struct
 	UINT8 *rom;
 	UINT32 RAMSize;
 	UINT8 *ram;
+	UINT8 RAMWritten;	// RAM was written through the memory data register
 	int clock;
 
 	INT32 volume[256*4];			// precalculated attenuation values with some marging for enveloppe and pan levels
@@ -155,13 +165,27 @@ typedef struct
 
 extern UINT8 CHIP_SAMPLING_MODE;
 extern INT32 CHIP_SAMPLE_RATE;
-#define MAX_CHIPS	0x10
-static YMF278BChip YMF278BData[MAX_CHIPS];
 static UINT32 ROMFileSize = 0x00;
-static UINT8* ROMFile = NULL;
+static UINT8* ROMFile = NULL;	// shared by all chips, read-only
+static pthread_once_t ROMFileOnce = PTHREAD_ONCE_INIT;
 
 char* FindFile(const char* FileName);	// from VGMPlay_Intf.h/VGMPlay.c
 
+extern UINT8 SimdLevel;
+
+// samples that a slot decodes in one go before they are mixed
+#define YMF278B_BLOCK	64
+
+typedef void (*ymf278b_mix_func)(stream_sample_t* outL, stream_sample_t* outR, const INT32* smp, int samples,
+								 INT32 volL, INT32 volR);
+static void ymf278b_mix_C(stream_sample_t* outL, stream_sample_t* outR, const INT32* smp, int samples,
+						  INT32 volL, INT32 volR);
+#ifdef YMF278B_AVX2
+static void ymf278b_mix_AVX2(stream_sample_t* outL, stream_sample_t* outR, const INT32* smp, int samples,
+							 INT32 volL, INT32 volR);
+#endif
+static ymf278b_mix_func ymf278b_mix = ymf278b_mix_C;
+
 
 #define EG_SH	16	// 16.16 fixed point (EG timing)
 #define EG_TIMER_OVERFLOW	(1 << EG_SH)
@@ -380,172 +404,140 @@ INLINE void ymf278b_slot_set_lfo(YMF278BSlot* slot, int newlfo)
 	slot->lfo_max = lfo_period[slot->lfo];
 }
 
-INLINE void ymf278b_advance(YMF278BChip* chip)
+INLINE void ymf278b_slot_lfo_step(YMF278BSlot* op)
 {
-	YMF278BSlot* op;
-	int i;
-	UINT8 rate;
+	op->lfo_cnt ++;
+	if (op->lfo_cnt < op->lfo_max)
+	{
+		op->lfo_step ++;
+	}
+	else if (op->lfo_cnt < (op->lfo_max * 3))
+	{
+		op->lfo_step --;
+	}
+	else
+	{
+		op->lfo_step ++;
+		if (op->lfo_cnt == (op->lfo_max * 4))
+			op->lfo_cnt = 0;
+	}
+}
+
+// envelope rate of the current phase, -1 if the envelope doesn't move
+INLINE int ymf278b_slot_eg_rate(YMF278BSlot* op)
+{
+	int rate;
+	
+	switch(op->state)
+	{
+	case EG_ATT:	// attack phase
+		rate = ymf278b_slot_compute_rate(op, op->AR);
+		break;
+	case EG_DEC:	// decay phase
+		rate = ymf278b_slot_compute_rate(op, op->D1R);
+		break;
+	case EG_SUS:	// sustain phase
+		rate = ymf278b_slot_compute_rate(op, op->D2R);
+		break;
+	case EG_REL:	// release phase
+		rate = ymf278b_slot_compute_rate(op, op->RR);
+		break;
+	case EG_REV:	// pseudo reverb
+		// TODO improve env_vol update
+		return ymf278b_slot_compute_rate(op, 5);
+	case EG_DMP:	// damping
+		// TODO improve env_vol update, damp is just fastest decay now
+		return 56;
+	default:	// EG_OFF
+		return -1;
+	}
+	return (rate < 4) ? -1 : rate;
+}
+
+// Envelope Generator, eg_cnt is the global counter after this sample's increment
+INLINE void ymf278b_slot_eg_step(YMF278BSlot* op, UINT32 eg_cnt)
+{
+	int rate;
 	UINT8 shift;
 	UINT8 select;
 	
-	chip->eg_cnt ++;
-	for (i = 0; i < 24; i ++)
+	rate = ymf278b_slot_eg_rate(op);
+	if (rate < 0)
+		return;
+	shift = eg_rate_shift[rate];
+	if (eg_cnt & ((1 << shift) - 1))
+		return;
+	
+	select = eg_rate_select[rate];
+	switch(op->state)
 	{
-		op = &chip->slots[i];
-
-		if (op->lfo_active)
+	case EG_ATT:	// attack phase
+		op->env_vol += (~op->env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;	// -VB
+		if (op->env_vol <= MIN_ATT_INDEX)
 		{
-			op->lfo_cnt ++;
-			if (op->lfo_cnt < op->lfo_max)
-			{
-				op->lfo_step ++;
-			}
-			else if (op->lfo_cnt < (op->lfo_max * 3))
-			{
-				op->lfo_step --;
-			}
+			op->env_vol = MIN_ATT_INDEX;
+			if (op->DL)
+				op->state = EG_DEC;
 			else
-			{
-				op->lfo_step ++;
-				if (op->lfo_cnt == (op->lfo_max * 4))
-					op->lfo_cnt = 0;
-			}
+				op->state = EG_SUS;
 		}
+		break;
+	case EG_DEC:	// decay phase
+		op->env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
 
-		// Envelope Generator
-		switch(op->state)
+		if ((op->env_vol > dl_tab[6]) && op->PRVB)
+			op->state = EG_REV;
+		else
 		{
-		case EG_ATT:	// attack phase
-			rate = ymf278b_slot_compute_rate(op, op->AR);
-			if (rate < 4)
-				break;
-			
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
-			{
-				select = eg_rate_select[rate];
-				op->env_vol += (~op->env_vol * eg_inc[select + ((chip->eg_cnt >> shift) & 7)]) >> 4;	// -VB
-				if (op->env_vol <= MIN_ATT_INDEX)
-				{
-					op->env_vol = MIN_ATT_INDEX;
-					if (op->DL)
-						op->state = EG_DEC;
-					else
-						op->state = EG_SUS;
-				}
-			}
-			break;
-		case EG_DEC:	// decay phase
-			rate = ymf278b_slot_compute_rate(op, op->D1R);
-			if (rate < 4)
-				break;
-			
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
-			{
-				select = eg_rate_select[rate];
-				op->env_vol += eg_inc[select + ((chip->eg_cnt >> shift) & 7)];
-
-				if ((op->env_vol > dl_tab[6]) && op->PRVB)
-					op->state = EG_REV;
-				else
-				{
-					if (op->env_vol >= op->DL)
-						op->state = EG_SUS;
-				}
-			}
-			break;
-		case EG_SUS:	// sustain phase
-			rate = ymf278b_slot_compute_rate(op, op->D2R);
-			if (rate < 4)
-				break;
-			
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
-			{
-				select = eg_rate_select[rate];
-				op->env_vol += eg_inc[select + ((chip->eg_cnt >> shift) & 7)];
-
-				if ((op->env_vol > dl_tab[6]) && op->PRVB)
-					op->state = EG_REV;
-				else
-				{
-					if (op->env_vol >= MAX_ATT_INDEX)
-					{
-						op->env_vol = MAX_ATT_INDEX;
-						op->active = 0;
-					}
-				}
-			}
-			break;
-		case EG_REL:	// release phase
-			rate = ymf278b_slot_compute_rate(op, op->RR);
-			if (rate < 4)
-				break;
-			
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
-			{
-				select = eg_rate_select[rate];
-				op->env_vol += eg_inc[select + ((chip->eg_cnt >> shift) & 7)];
+			if (op->env_vol >= op->DL)
+				op->state = EG_SUS;
+		}
+		break;
+	case EG_SUS:	// sustain phase
+	case EG_REL:	// release phase
+		op->env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
 
-				if ((op->env_vol > dl_tab[6]) && op->PRVB)
-					op->state = EG_REV;
-				else
-				{
-					if (op->env_vol >= MAX_ATT_INDEX)
-					{
-						op->env_vol = MAX_ATT_INDEX;
-						op->active = 0;
-					}
-				}
-			}
-			break;
-		case EG_REV:	// pseudo reverb
-			// TODO improve env_vol update
-			rate = ymf278b_slot_compute_rate(op, 5);
-			//if (rate < 4)
-			//	break;
-			
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
+		if ((op->env_vol > dl_tab[6]) && op->PRVB)
+			op->state = EG_REV;
+		else
+		{
+			if (op->env_vol >= MAX_ATT_INDEX)
 			{
-				select = eg_rate_select[rate];
-				op->env_vol += eg_inc[select + ((chip->eg_cnt >> shift) & 7)];
-
-				if (op->env_vol >= MAX_ATT_INDEX)
-				{
-					op->env_vol = MAX_ATT_INDEX;
-					op->active = 0;
-				}
+				op->env_vol = MAX_ATT_INDEX;
+				op->active = 0;
 			}
-			break;
-		case EG_DMP:	// damping
-			// TODO improve env_vol update, damp is just fastest decay now
-			rate = 56;
-			shift = eg_rate_shift[rate];
-			if (! (chip->eg_cnt & ((1 << shift) - 1)))
-			{
-				select = eg_rate_select[rate];
-				op->env_vol += eg_inc[select + ((chip->eg_cnt >> shift) & 7)];
-
-				if (op->env_vol >= MAX_ATT_INDEX)
-				{
-					op->env_vol = MAX_ATT_INDEX;
-					op->active = 0;
-				}
-			}
-			break;
-		case EG_OFF:
-			// nothing
-			break;
+		}
+		break;
+	case EG_REV:	// pseudo reverb
+	case EG_DMP:	// damping
+		op->env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
 
-		default:
-#ifdef _DEBUG
-			//logerror(...);
-#endif
-			break;
+		if (op->env_vol >= MAX_ATT_INDEX)
+		{
+			op->env_vol = MAX_ATT_INDEX;
+			op->active = 0;
 		}
+		break;
+	}
+}
+
+// A slot that is off stays at MAX_ATT_INDEX, unless pseudo reverb still has
+// to move it to EG_REV (or clamp it there).
+INLINE int ymf278b_slot_eg_settled(YMF278BSlot* op)
+{
+	if (op->env_vol != MAX_ATT_INDEX)
+		return 0;
+	switch(op->state)
+	{
+	case EG_SUS:
+	case EG_REL:
+		return ! op->PRVB;
+	case EG_REV:
+	case EG_DMP:
+	case EG_OFF:
+		return 1;
+	default:
+		return 0;
 	}
 }
 
@@ -574,7 +566,10 @@ INLINE void ymf278b_writeMem(YMF278BChip* chip, offs_t address, UINT8 value)
 	if (address < chip->ROMSize)
 		return; // can't write to ROM
 	else if (address < chip->ROMSize + chip->RAMSize)
+	{
 		chip->ram[address - chip->ROMSize] = value;
+		chip->RAMWritten = 0x01;
+	}
 	else
 		return;	// can't write to unmapped memory
 	
@@ -616,25 +611,234 @@ INLINE INT16 ymf278b_getSample(YMF278BChip* chip, YMF278BSlot* op)
 	return sample;
 }
 
-int ymf278b_anyActive(YMF278BChip* chip)
+// load the next sample pair after stepptr passed a sample boundary
+INLINE void ymf278b_slot_next(YMF278BChip* chip, YMF278BSlot* sl)
 {
-	int i;
+	sl->sample1 = sl->sample2;
 	
-	for (i = 0; i < 24; i ++)
+	sl->sample2 = ymf278b_getSample(chip, sl);
+	sl->pos += (sl->stepptr >> 16);
+	sl->stepptr &= 0xFFFF;
+	if (sl->pos > sl->endaddr)
+		sl->pos = sl->pos - sl->endaddr + sl->loopaddr - 1;
+}
+
+// Walks a slot through its sample data at a fixed step and stores the
+// interpolated samples (smp can be NULL when only the position matters).
+static void ymf278b_slot_decode(YMF278BChip* chip, YMF278BSlot* sl, INT32* smp, int samples, UINT32 step)
+{
+	UINT32 ptr = sl->stepptr;
+	INT32 s1 = sl->sample1;
+	INT32 s2 = sl->sample2;
+	INT16 sample;
+	int j;
+	
+	for (j = 0; j < samples; j ++)
+	{
+		if (smp != NULL)
+		{
+			sample = (s1 * (0x10000 - ptr) + s2 * ptr) >> 16;
+			smp[j] = sample;
+		}
+		ptr += step;
+		if (ptr >= 0x10000)
+		{
+			sl->stepptr = ptr;
+			ymf278b_slot_next(chip, sl);
+			ptr = sl->stepptr;
+			s1 = sl->sample1;
+			s2 = sl->sample2;
+		}
+	}
+	sl->stepptr = ptr;
+}
+
+static void ymf278b_mix_C(stream_sample_t* outL, stream_sample_t* outR, const INT32* smp, int samples,
+						  INT32 volL, INT32 volR)
+{
+	int j;
+	
+	for (j = 0; j < samples; j ++)
 	{
-		if (chip->slots[i].active)
-			return 1;
+		outL[j] += (smp[j] * volL) >> 17;
+		outR[j] += (smp[j] * volR) >> 17;
 	}
-	return 0;
 }
 
-void ymf278b_pcm_update(UINT8 ChipID, stream_sample_t** outputs, int samples)
+#ifdef YMF278B_AVX2
+__attribute__((target("avx2")))
+static void ymf278b_mix_AVX2(stream_sample_t* outL, stream_sample_t* outR, const INT32* smp, int samples,
+							 INT32 volL, INT32 volR)
 {
-	YMF278BChip* chip = &YMF278BData[ChipID];
+	const __m256i vl = _mm256_set1_epi32(volL);
+	const __m256i vr = _mm256_set1_epi32(volR);
+	__m256i s;
+	int j;
+	
+	for (j = 0; j + 8 <= samples; j += 8)
+	{
+		s = _mm256_loadu_si256((const __m256i*)&smp[j]);
+		_mm256_storeu_si256((__m256i*)&outL[j], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&outL[j]),
+							_mm256_srai_epi32(_mm256_mullo_epi32(s, vl), 17)));
+		_mm256_storeu_si256((__m256i*)&outR[j], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&outR[j]),
+							_mm256_srai_epi32(_mm256_mullo_epi32(s, vr), 17)));
+	}
+	_mm256_zeroupper();
+	
+	ymf278b_mix_C(&outL[j], &outR[j], &smp[j], samples - j, volL, volR);
+}
+#endif
+
+// Renders a keyed on slot until it finished its release or the buffer ends and
+// returns the number of samples it stayed active for.
+// The envelope only moves on the samples where eg_cnt hits its rate's period,
+// so the slot is rendered in runs that end with an envelope step. Without
+// LFO modulation, the volume and the pitch are constant over such a run.
+static int ymf278b_slot_render(YMF278BChip* chip, YMF278BSlot* sl, stream_sample_t** outputs, int samples,
+							   INT32 vl, INT32 vr)
+{
+	INT32 smp[YMF278B_BLOCK];
+	int j, k;
+	int run;
+	int len;
+	int rate;
+	INT16 sample;
+	int vol;
+	int volLeft;
+	int volRight;
+	
+	j = 0;
+	while (j < samples)
+	{
+		run = samples - j;
+		rate = ymf278b_slot_eg_rate(sl);
+		if (rate >= 0)
+		{
+			k = (-(chip->eg_cnt + j + 1) & ((1 << eg_rate_shift[rate]) - 1)) + 1;
+			if (run > k)
+				run = k;
+		}
+		
+		if (sl->Muted)
+		{
+			//outputs[0][j] += 0;
+			//outputs[1][j] += 0;
+			if (sl->lfo_active)
+			{
+				for (k = 0; k < run; k ++)
+					ymf278b_slot_lfo_step(sl);
+			}
+		}
+		else if (sl->lfo_active && (sl->AM || sl->vib))
+		{
+			for (k = j; k < j + run; k ++)
+			{
+				sample = (sl->sample1 * (0x10000 - sl->stepptr) +
+							sl->sample2 * sl->stepptr) >> 16;
+				vol = sl->TL + (sl->env_vol >> 2) + ymf278b_slot_compute_am(sl);
+				
+				volLeft  = vol + pan_left [sl->pan] + vl;
+				volRight = vol + pan_right[sl->pan] + vr;
+				volLeft &= 0x3FF;	// catch negative Volume values in a hardware-like way
+				volRight &= 0x3FF;	// (anything beyond 0x100 results in *0)
+				
+				outputs[0][k] += (sample * chip->volume[volLeft] ) >> 17;
+				outputs[1][k] += (sample * chip->volume[volRight]) >> 17;
+				
+				if (sl->vib)
+				{
+					int oct;
+					unsigned int step;
+					
+					oct = sl->OCT;
+					if (oct & 8)
+						oct |= -8;
+					oct += 5;
+					step = (sl->FN | 1024) + ymf278b_slot_compute_vib(sl);
+					if (oct >= 0)
+						step <<= oct;
+					else
+						step >>= -oct;
+					sl->stepptr += step;
+				}
+				else
+					sl->stepptr += sl->step;
+				
+				if (sl->stepptr >= 0x10000)
+					ymf278b_slot_next(chip, sl);
+				ymf278b_slot_lfo_step(sl);
+			}
+		}
+		else
+		{
+			vol = sl->TL + (sl->env_vol >> 2);
+			
+			volLeft  = (vol + pan_left [sl->pan] + vl) & 0x3FF;
+			volRight = (vol + pan_right[sl->pan] + vr) & 0x3FF;
+			volLeft  = chip->volume[volLeft];
+			volRight = chip->volume[volRight];
+			if (volLeft | volRight)
+			{
+				for (k = 0; k < run; k += len)
+				{
+					len = run - k;
+					if (len > YMF278B_BLOCK)
+						len = YMF278B_BLOCK;
+					ymf278b_slot_decode(chip, sl, smp, len, sl->step);
+					ymf278b_mix(&outputs[0][j + k], &outputs[1][j + k], smp, len, volLeft, volRight);
+				}
+			}
+			else
+			{
+				ymf278b_slot_decode(chip, sl, NULL, run, sl->step);
+			}
+			if (sl->lfo_active)
+			{
+				for (k = 0; k < run; k ++)
+					ymf278b_slot_lfo_step(sl);
+			}
+		}
+		
+		j += run;
+		if (rate >= 0)
+		{
+			ymf278b_slot_eg_step(sl, chip->eg_cnt + j);
+			if (! sl->active)
+				return j;
+		}
+	}
+	
+	return samples;
+}
+
+// Runs the envelope and LFO of a slot that is not (or no longer) keyed on
+// from sample 'start' to 'end'.
+static void ymf278b_slot_idle(YMF278BChip* chip, YMF278BSlot* sl, int start, int end)
+{
+	int j;
+	
+	for (j = start; j < end && ! ymf278b_slot_eg_settled(sl); j ++)
+	{
+		if (sl->lfo_active)
+			ymf278b_slot_lfo_step(sl);
+		ymf278b_slot_eg_step(sl, chip->eg_cnt + j + 1);
+	}
+	if (sl->lfo_active)
+	{
+		for (; j < end; j ++)
+			ymf278b_slot_lfo_step(sl);
+	}
+}
+
+void ymf278b_pcm_update(void *param, stream_sample_t** outputs, int samples)
+{
+	YMF278BChip* chip = (YMF278BChip*)param;
 	int i;
 	unsigned int j;
 	INT32 vl;
 	INT32 vr;
+	int slot_end[24];
+	int end;
 	
 	if (chip->FMEnabled)
 	{
@@ -657,80 +861,32 @@ void ymf278b_pcm_update(UINT8 ChipID, stream_sample_t** outputs, int samples)
 		memset(outputs[1], 0x00, samples * sizeof(stream_sample_t));
 	}
 	
-	if (! ymf278b_anyActive(chip))
+	// Slots can only be keyed on by register writes, so the slots that are
+	// active now are the only ones that have to be rendered in this update.
+	// Each of them is rendered on its own up to the point where it ends.
+	vl = mix_level[chip->pcm_l];
+	vr = mix_level[chip->pcm_r];
+	end = 0;
+	for (i = 0; i < 24; i ++)
+	{
+		slot_end[i] = 0;
+		if (! chip->slots[i].active)
+			continue;
+		slot_end[i] = ymf278b_slot_render(chip, &chip->slots[i], outputs, samples, vl, vr);
+		if (end < slot_end[i])
+			end = slot_end[i];
+	}
+	if (! end)
 	{
 		// TODO update internal state, even if muted
 		// TODO also mute individual channels
 		return;
 	}
-
-	vl = mix_level[chip->pcm_l];
-	vr = mix_level[chip->pcm_r];
-	for (j = 0; j < samples; j ++)
-	{
-		for (i = 0; i < 24; i ++)
-		{
-			YMF278BSlot* sl;
-			INT16 sample;
-			int vol;
-			int volLeft;
-			int volRight;
-			
-			sl = &chip->slots[i];
-			if (! sl->active || sl->Muted)
-			{
-				//outputs[0][j] += 0;
-				//outputs[1][j] += 0;
-				continue;
-			}
-
-			sample = (sl->sample1 * (0x10000 - sl->stepptr) +
-						sl->sample2 * sl->stepptr) >> 16;
-			vol = sl->TL + (sl->env_vol >> 2) + ymf278b_slot_compute_am(sl);
-
-			volLeft  = vol + pan_left [sl->pan] + vl;
-			volRight = vol + pan_right[sl->pan] + vr;
-			// TODO prob doesn't happen in real chip
-			//volLeft  = std::max(0, volLeft);
-			//volRight = std::max(0, volRight);
-			volLeft &= 0x3FF;	// catch negative Volume values in a hardware-like way
-			volRight &= 0x3FF;	// (anything beyond 0x100 results in *0)
-
-			outputs[0][j] += (sample * chip->volume[volLeft] ) >> 17;
-			outputs[1][j] += (sample * chip->volume[volRight]) >> 17;
-
-			if (sl->lfo_active && sl->vib)
-			{
-				int oct;
-				unsigned int step;
-				
-				oct = sl->OCT;
-				if (oct & 8)
-					oct |= -8;
-				oct += 5;
-				step = (sl->FN | 1024) + ymf278b_slot_compute_vib(sl);
-				if (oct >= 0)
-					step <<= oct;
-				else
-					step >>= -oct;
-				sl->stepptr += step;
-			}
-			else
-				sl->stepptr += sl->step;
-
-			if (sl->stepptr >= 0x10000)
-			{
-				sl->sample1 = sl->sample2;
-				
-				sl->sample2 = ymf278b_getSample(chip, sl);
-				sl->pos += (sl->stepptr >> 16);
-				sl->stepptr &= 0xFFFF;
-				if (sl->pos > sl->endaddr)
-					sl->pos = sl->pos - sl->endaddr + sl->loopaddr - 1;
-			}
-		}
-		ymf278b_advance(chip);
-	}
+	
+	// the envelope/LFO clock stops along with the last active slot
+	for (i = 0; i < 24; i ++)
+		ymf278b_slot_idle(chip, &chip->slots[i], slot_end[i], end);
+	chip->eg_cnt += end;
 }
 
 INLINE void ymf278b_keyOnHelper(YMF278BChip* chip, YMF278BSlot* slot)
@@ -1067,10 +1223,10 @@ UINT8 ymf278b_readStatus(YMF278BChip* chip)
 }
 
 //WRITE8_DEVICE_HANDLER( ymf278b_w )
-void ymf278b_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ymf278b_w(void *param, offs_t offset, UINT8 data)
 {
 	//YMF278BChip *chip = get_safe_token(device);
-	YMF278BChip *chip = &YMF278BData[ChipID];
+	YMF278BChip *chip = (YMF278BChip*)param;
 
 	switch (offset)
 	{
@@ -1117,45 +1273,84 @@ void ymf278b_clearRam(YMF278BChip* chip)
 	memset(chip->ram, 0, chip->RAMSize);
 }
 
-static void ymf278b_load_rom(YMF278BChip *chip)
+// The sample RAM is an anonymous mapping, so it starts out zeroed and only the
+// pages that get written are committed.
+static void ymf278b_alloc_ram(YMF278BChip* chip, UINT32 RAMSize)
+{
+	void* ram;
+	
+	ram = mmap(NULL, RAMSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ram == MAP_FAILED)
+	{
+		// no RAM: reads return 0xFF, writes are dropped
+		chip->ram = NULL;
+		chip->RAMSize = 0x00;
+		return;
+	}
+	chip->ram = (UINT8*)ram;
+	chip->RAMSize = RAMSize;
+	
+	return;
+}
+
+// loads the sample ROM once, it is shared by all chips of all players
+static void ymf278b_load_rom_file(void)
 {
 	const char* ROM_FILENAME = "yrw801.rom";
 	char* FileName;
 	FILE* hFile;
 	size_t RetVal;
+	struct stat FileStat;
+	void* FileMap;
+	
+	ROMFileSize = 0x00200000;
 	
-	if (! ROMFileSize)
+	FileName = FindFile(ROM_FILENAME);
+	if (FileName != NULL)
 	{
-		ROMFileSize = 0x00200000;
-		ROMFile = (UINT8*)malloc(ROMFileSize);
-		memset(ROMFile, 0xFF, ROMFileSize);
-		
-		FileName = FindFile(ROM_FILENAME);
-		if (FileName != NULL)
-		{
-			hFile = fopen(FileName, "rb");
-			free(FileName);
-		}
-		else
+		hFile = fopen(FileName, "rb");
+		free(FileName);
+	}
+	else
+	{
+		hFile = NULL;
+	}
+	if (hFile != NULL)
+	{
+		// a complete image is mapped, so its pages are shared through the page cache
+		if (! fstat(fileno(hFile), &FileStat) && FileStat.st_size >= ROMFileSize)
 		{
-			hFile = NULL;
+			FileMap = mmap(NULL, ROMFileSize, PROT_READ, MAP_SHARED, fileno(hFile), 0);
+			if (FileMap != MAP_FAILED)
+				ROMFile = (UINT8*)FileMap;
 		}
-		if (hFile != NULL)
+		if (ROMFile == NULL)
 		{
+			ROMFile = (UINT8*)malloc(ROMFileSize);
+			memset(ROMFile, 0xFF, ROMFileSize);
 			RetVal = fread(ROMFile, 0x01, ROMFileSize, hFile);
-			fclose(hFile);
 			if (RetVal != ROMFileSize)
 				fprintf(stderr, "Error while reading OPL4 Sample ROM (%s)!\n", ROM_FILENAME);
 		}
-		else
-		{
-			fprintf(stderr, "Warning! OPL4 Sample ROM (%s) not found!\n", ROM_FILENAME);
-		}
+		fclose(hFile);
+	}
+	else
+	{
+		ROMFile = (UINT8*)malloc(ROMFileSize);
+		memset(ROMFile, 0xFF, ROMFileSize);
+		fprintf(stderr, "Warning! OPL4 Sample ROM (%s) not found!\n", ROM_FILENAME);
 	}
 	
+	return;
+}
+
+static void ymf278b_load_rom(YMF278BChip *chip)
+{
+	pthread_once(&ROMFileOnce, ymf278b_load_rom_file);
+	
+	// ymf278b_write_rom makes a private copy before it changes anything
 	chip->ROMSize = ROMFileSize;
-	chip->rom = (UINT8*)malloc(chip->ROMSize);
-	memcpy(chip->rom, ROMFile, chip->ROMSize);
+	chip->rom = ROMFile;
 	
 	return;
 }
@@ -1178,15 +1373,14 @@ static int ymf278b_init(YMF278BChip *chip, int clock, void (*cb)(int))
 	chip->clock = clock;
 
 	ymf278b_load_rom(chip);
-	chip->RAMSize = 0x00080000;
-	chip->ram = (UINT8*)malloc(chip->RAMSize);
-	ymf278b_clearRam(chip);
+	ymf278b_alloc_ram(chip, 0x00080000);
+	chip->RAMWritten = 0x00;
 
 	return rate;
 }
 
 //static DEVICE_START( ymf278b )
-int device_start_ymf278b(UINT8 ChipID, int clock)
+int device_start_ymf278b(void **param, int clock)
 {
 	static const ymf278b_interface defintrf = { 0 };
 	const ymf278b_interface *intf;
@@ -1194,10 +1388,10 @@ int device_start_ymf278b(UINT8 ChipID, int clock)
 	YMF278BChip *chip;
 	int rate;
 
-	if (ChipID >= MAX_CHIPS)
+	chip = (YMF278BChip*)calloc(1, sizeof(YMF278BChip));
+	if (chip == NULL)
 		return 0;
-	
-	chip = &YMF278BData[ChipID];
+	*param = chip;
 	
 	//chip->device = device;
 	//intf = (device->static_config != NULL) ? (const ymf278b_interface *)device->static_config : &defintrf;
@@ -1220,24 +1414,34 @@ int device_start_ymf278b(UINT8 ChipID, int clock)
 	for (i = 0; i < 24; i ++)
 		chip->slots[i].Muted = 0x00;;
 
+	ymf278b_mix = ymf278b_mix_C;
+#ifdef YMF278B_AVX2
+	if (SimdLevel >= SIMD_AVX2)
+		ymf278b_mix = ymf278b_mix_AVX2;
+#endif
+
 	return rate;
 }
 
 //static DEVICE_STOP( ymf278 )
-void device_stop_ymf278b(UINT8 ChipID)
+void device_stop_ymf278b(void *param)
 {
-	YMF278BChip* chip = &YMF278BData[ChipID];
+	YMF278BChip* chip = (YMF278BChip*)param;
 	
 	ymf262_shutdown(chip->fmchip);
-	free(chip->rom);	chip->rom = NULL;
-	free(chip->ram);	chip->ram = NULL;
+	if (chip->rom != ROMFile)
+		free(chip->rom);
+	chip->rom = NULL;
+	if (chip->ram != NULL)
+		munmap(chip->ram, chip->RAMSize);
+	free(chip);
 	
 	return;
 }
 
-void device_reset_ymf278b(UINT8 ChipID)
+void device_reset_ymf278b(void *param)
 {
-	YMF278BChip* chip = &YMF278BData[ChipID];
+	YMF278BChip* chip = (YMF278BChip*)param;
 	int i;
 	
 	ymf262_reset_chip(chip->fmchip);
@@ -1257,16 +1461,71 @@ void device_reset_ymf278b(UINT8 ChipID)
 	//loadTime = time;
 }
 
-void ymf278b_write_rom(UINT8 ChipID, offs_t ROMSize, offs_t DataStart, offs_t DataLength,
+// The state consists of the chip structure, the FM part and - only if it was
+// modified by the sound driver - the sample RAM.
+// ROM and RAM images from data blocks are not part of the state.
+UINT32 device_save_state_ymf278b(void *param, void *Data)
+{
+	YMF278BChip* chip = (YMF278BChip*)param;
+	UINT8* DataPtr = (UINT8*)Data;
+	UINT32 StateSize;
+	
+	StateSize = sizeof(YMF278BChip);
+	if (DataPtr != NULL)
+		memcpy(DataPtr, chip, sizeof(YMF278BChip));
+	StateSize += ymf262_save_state(chip->fmchip, DataPtr ? DataPtr + StateSize : NULL);
+	if (chip->RAMWritten)
+	{
+		if (DataPtr != NULL)
+			memcpy(DataPtr + StateSize, chip->ram, chip->RAMSize);
+		StateSize += chip->RAMSize;
+	}
+	
+	return StateSize;
+}
+
+UINT32 device_load_state_ymf278b(void *param, const void *Data)
+{
+	YMF278BChip* chip = (YMF278BChip*)param;
+	const UINT8* DataPtr = (const UINT8*)Data;
+	UINT32 StateSize;
+	UINT32 ROMSize = chip->ROMSize;
+	UINT8* rom = chip->rom;
+	UINT32 RAMSize = chip->RAMSize;
+	UINT8* ram = chip->ram;
+	
+	memcpy(chip, DataPtr, sizeof(YMF278BChip));
+	chip->ROMSize = ROMSize;	chip->rom = rom;
+	chip->RAMSize = RAMSize;	chip->ram = ram;
+	StateSize = sizeof(YMF278BChip);
+	StateSize += ymf262_load_state(chip->fmchip, DataPtr + StateSize);
+	if (chip->RAMWritten)
+	{
+		memcpy(chip->ram, DataPtr + StateSize, chip->RAMSize);
+		StateSize += chip->RAMSize;
+	}
+	
+	return StateSize;
+}
+
+void ymf278b_write_rom(void *param, offs_t ROMSize, offs_t DataStart, offs_t DataLength,
 					  const UINT8* ROMData)
 {
-	YMF278BChip *chip = &YMF278BData[ChipID];
+	YMF278BChip *chip = (YMF278BChip*)param;
+	UINT8* rom;
 	
-	if (chip->ROMSize != ROMSize)
+	if (chip->ROMSize != ROMSize || chip->rom == ROMFile)
 	{
-		chip->rom = (UINT8*)realloc(chip->rom, ROMSize);
+		// data blocks never go into the shared ROM image
+		rom = (UINT8*)malloc(ROMSize);
+		if (chip->ROMSize == ROMSize)
+			memcpy(rom, chip->rom, ROMSize);
+		else
+			memset(rom, 0xFF, ROMSize);
+		if (chip->rom != ROMFile)
+			free(chip->rom);
+		chip->rom = rom;
 		chip->ROMSize = ROMSize;
-		memset(chip->rom, 0xFF, ROMSize);
 	}
 	if (DataStart > ROMSize)
 		return;
@@ -1278,9 +1537,9 @@ void ymf278b_write_rom(UINT8 ChipID, offs_t ROMSize, offs_t DataStart, offs_t Da
 	return;
 }
 
-void ymf278b_write_ram(UINT8 ChipID, offs_t DataStart, offs_t DataLength, const UINT8* RAMData)
+void ymf278b_write_ram(void *param, offs_t DataStart, offs_t DataLength, const UINT8* RAMData)
 {
-	YMF278BChip *chip = &YMF278BData[ChipID];
+	YMF278BChip *chip = (YMF278BChip*)param;
 	
 	if (DataStart >= chip->RAMSize)
 		return;
@@ -1293,9 +1552,9 @@ void ymf278b_write_ram(UINT8 ChipID, offs_t DataStart, offs_t DataLength, const
 }
 
 
-void ymf278b_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskWT)
+void ymf278b_set_mute_mask(void *param, UINT32 MuteMaskFM, UINT32 MuteMaskWT)
 {
-	YMF278BChip *chip = &YMF278BData[ChipID];
+	YMF278BChip *chip = (YMF278BChip*)param;
 	UINT8 CurChn;
 	
 	ymf262_set_mutemask(chip->fmchip, MuteMaskFM);
@@ -16,16 +16,18 @@ WRITE8_DEVICE_HANDLER( ymf278b_w );
 DEVICE_GET_INFO( ymf278b );
 #define SOUND_YMF278B DEVICE_GET_INFO_NAME( ymf278b )*/
 
-void ymf278b_pcm_update(UINT8 ChipID, stream_sample_t **outputs, int samples);
-int device_start_ymf278b(UINT8 ChipID, int clock);
-void device_stop_ymf278b(UINT8 ChipID);
-void device_reset_ymf278b(UINT8 ChipID);
-
-UINT8 ymf278b_r(UINT8 ChipID, offs_t offset);
-void ymf278b_w(UINT8 ChipID, offs_t offset, UINT8 data);
-void ymf278b_write_rom(UINT8 ChipID, offs_t ROMSize, offs_t DataStart, offs_t DataLength,
+void ymf278b_pcm_update(void *param, stream_sample_t **outputs, int samples);
+int device_start_ymf278b(void **param, int clock);
+void device_stop_ymf278b(void *param);
+void device_reset_ymf278b(void *param);
+UINT32 device_save_state_ymf278b(void *param, void *Data);
+UINT32 device_load_state_ymf278b(void *param, const void *Data);
+
+UINT8 ymf278b_r(void *param, offs_t offset);
+void ymf278b_w(void *param, offs_t offset, UINT8 data);
+void ymf278b_write_rom(void *param, offs_t ROMSize, offs_t DataStart, offs_t DataLength,
 					   const UINT8* ROMData);
-void ymf278b_write_ram(UINT8 ChipID, offs_t DataStart, offs_t DataLength, const UINT8* RAMData);
+void ymf278b_write_ram(void *param, offs_t DataStart, offs_t DataLength, const UINT8* RAMData);
 
-void ymf278b_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskWT);
+void ymf278b_set_mute_mask(void *param, UINT32 MuteMaskFM, UINT32 MuteMaskWT);
 